@@ -0,0 +1,141 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "CastLatencyTracer.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+static const TCHAR* CastTracePointNames[]{
+	TEXT("CastReleased"), TEXT("EndCast"), TEXT("SpellApplied"),
+	TEXT("LaunchPressed"), TEXT("LaunchTick"), TEXT("LaunchSpell"), TEXT("SpawnActor"), TEXT("SpellSetup"), TEXT("LaunchDone")
+};
+static_assert(UE_ARRAY_COUNT(CastTracePointNames) == static_cast<int32>(ECastTracePoint::Num), "Every ECastTracePoint needs a name");
+
+static const TCHAR* CastLatencyChainNames[]{ TEXT("Apply"), TEXT("Launch") };
+static_assert(UE_ARRAY_COUNT(CastLatencyChainNames) == static_cast<int32>(ECastLatencyChain::Num), "Every ECastLatencyChain needs a name");
+
+// Where each chain's processing time is measured from - the point the game acts on the input
+static const ECastTracePoint CastLatencyProcessingPoints[]{ ECastTracePoint::CastReleased, ECastTracePoint::LaunchTick };
+static_assert(UE_ARRAY_COUNT(CastLatencyProcessingPoints) == static_cast<int32>(ECastLatencyChain::Num), "Every ECastLatencyChain needs a processing point");
+
+void FLatencyHistogram::Add(double Seconds)
+{
+	const int32 Bucket{ FMath::Clamp(static_cast<int32>(Seconds / BucketWidth), 0, NumBuckets - 1) };
+	Buckets[Bucket]++;
+	Count++;
+	Total += Seconds;
+	Max = FMath::Max(Max, Seconds);
+}
+
+double FLatencyHistogram::GetPercentile(double Fraction) const
+{
+	const int32 Target{ FMath::CeilToInt(Fraction * Count) };
+	int32 Seen{ 0 };
+	for (int32 i{ 0 }; i < NumBuckets; i++) {
+		Seen += Buckets[i];
+		if (Seen >= Target && Seen > 0) {
+			return (i + 1) * BucketWidth;
+		}
+	}
+	return Max;
+}
+
+int32 FLatencyHistogram::CountBelow(double Seconds) const
+{
+	int32 Below{ 0 };
+	for (int32 i{ 0 }; i < NumBuckets && (i + 1) * BucketWidth <= Seconds; i++) {
+		Below += Buckets[i];
+	}
+	return Below;
+}
+
+FCastLatencyTracer& FCastLatencyTracer::Get()
+{
+	static FCastLatencyTracer Tracer{};
+	return Tracer;
+}
+
+void FCastLatencyTracer::Begin(ECastLatencyChain Chain, ECastTracePoint Point)
+{
+	FChainTrace& Trace{ Traces[static_cast<int32>(Chain)] };
+	Trace = FChainTrace{};
+	Trace.isActive = true;
+	Mark(Chain, Point);
+}
+
+void FCastLatencyTracer::Mark(ECastLatencyChain Chain, ECastTracePoint Point)
+{
+	FChainTrace& Trace{ Traces[static_cast<int32>(Chain)] };
+	if (!Trace.isActive) {
+		return;
+	}
+	Trace.PointTimes[static_cast<int32>(Point)] = FPlatformTime::Seconds();
+	TRACE_BOOKMARK(TEXT("Cast %s: %s"), CastLatencyChainNames[static_cast<int32>(Chain)], CastTracePointNames[static_cast<int32>(Point)]);
+}
+
+void FCastLatencyTracer::End(ECastLatencyChain Chain, ECastTracePoint Point, SpellID Spell, ECastTracePoint RequiredPoint)
+{
+	FChainTrace& Trace{ Traces[static_cast<int32>(Chain)] };
+	if (!Trace.isActive) {
+		return;
+	}
+	Mark(Chain, Point);
+	Trace.isActive = false;
+
+	if (Trace.PointTimes[static_cast<int32>(RequiredPoint)] == 0.0 || Spell < 0 || Spell >= NumSpellIDs) {
+		return; // Nothing happened in game (e.g. no spell to launch)
+	}
+
+	// The first point marked is where the chain began
+	double StartTime{ 0.0 };
+	for (const double Time : Trace.PointTimes) {
+		if (Time > 0.0 && (StartTime == 0.0 || Time < StartTime)) {
+			StartTime = Time;
+		}
+	}
+	const double EndTime{ Trace.PointTimes[static_cast<int32>(Point)] };
+	const double ProcessingTime{ Trace.PointTimes[static_cast<int32>(CastLatencyProcessingPoints[static_cast<int32>(Chain)])] };
+	TotalHistograms[static_cast<int32>(Chain)][Spell].Add(EndTime - StartTime);
+	ProcessingHistograms[static_cast<int32>(Chain)][Spell].Add(EndTime - (ProcessingTime > 0.0 ? ProcessingTime : StartTime));
+}
+
+static constexpr double CastLatencyFrameTime{ 1.0 / 90.0 }; // One VR frame
+
+bool FCastLatencyTracer::SaveHistograms(const FString& FilePath) const
+{
+	FString Output{ TEXT("Chain,Spell,Measure,Count,MeanMs,P50Ms,P95Ms,P99Ms,MaxMs,InOneFramePct") };
+	for (int32 Bucket{ 0 }; Bucket < FLatencyHistogram::NumBuckets; Bucket++) {
+		Output += FString::Printf(TEXT(",<%.1fms"), (Bucket + 1) * FLatencyHistogram::BucketWidth * 1000.0);
+	}
+	Output += TEXT("\n");
+
+	bool hasData{ false };
+	for (int32 Chain{ 0 }; Chain < NumChains; Chain++) {
+		for (int32 Spell{ 0 }; Spell < NumSpellIDs; Spell++) {
+			if (TotalHistograms[Chain][Spell].Count == 0) {
+				continue;
+			}
+			hasData = true;
+			SaveHistogramRow(Output, TEXT("Total"), Chain, Spell, TotalHistograms[Chain][Spell]);
+			SaveHistogramRow(Output, TEXT("Processing"), Chain, Spell, ProcessingHistograms[Chain][Spell]);
+		}
+	}
+	return hasData && FFileHelper::SaveStringToFile(Output, *FilePath);
+}
+
+void FCastLatencyTracer::SaveHistogramRow(FString& Output, const TCHAR* Measure, int32 Chain, int32 Spell, const FLatencyHistogram& Histogram) const
+{
+	const FString SpellName{ UEnum::GetValueAsString(static_cast<SpellID>(Spell)) };
+	const double InFramePct{ 100.0 * Histogram.CountBelow(CastLatencyFrameTime) / Histogram.Count };
+	Output += FString::Printf(TEXT("%s,%s,%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f"), CastLatencyChainNames[Chain], *SpellName, Measure, Histogram.Count,
+		Histogram.GetMean() * 1000.0, Histogram.GetPercentile(0.5) * 1000.0, Histogram.GetPercentile(0.95) * 1000.0,
+		Histogram.GetPercentile(0.99) * 1000.0, Histogram.Max * 1000.0, InFramePct);
+	for (const int32 BucketCount : Histogram.Buckets) {
+		Output += FString::Printf(TEXT(",%d"), BucketCount);
+	}
+	Output += TEXT("\n");
+
+	UE_LOG(LogTemp, Warning, TEXT("Cast latency %s %s (%s): %d casts, mean %.2f ms, p95 %.2f ms, max %.2f ms, %.1f%% inside one frame"),
+		CastLatencyChainNames[Chain], *SpellName, Measure, Histogram.Count, Histogram.GetMean() * 1000.0, Histogram.GetPercentile(0.95) * 1000.0, Histogram.Max * 1000.0, InFramePct);
+}
@@ -0,0 +1,87 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Cast latency tracing - how long it takes from the player's input until the spell happens in game
+* Two chains are traced, each with timestamped trace points (also sent to Unreal Insights as bookmarks):
+*	Apply:	A/X released (RightHandStopCast) -> EndCast -> spell applied to the hand (ApplyRHSpell)
+*	Launch:	Trigger pressed (RightHandLaunch) -> picked up by TickComponent -> LaunchRHSpell -> SpawnActor -> ASpell::SpellSetup
+* Every finished chain is added to two per-spell histograms - SaveHistograms() writes them out as csv:
+*	Total:		From the input to the last point
+*	Processing:	From when the game acted on the input - a one handed launch waits up to MAX_DUAL_HAND_DELAY for the other hand first (by design)
+* NOTE: A launch ends once the spell actor is spawned and set up, i.e. it is drawn in the frame being built - the render/display time is not included
+* NOTE: Game thread only
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpellContainer.h"
+
+enum class ECastLatencyChain : uint8 {
+	Apply,
+	Launch,
+	Num
+};
+
+enum class ECastTracePoint : uint8 {
+	CastReleased, // Apply chain
+	EndCast,
+	SpellApplied,
+	LaunchPressed, // Launch chain
+	LaunchTick,
+	LaunchSpell,
+	SpawnActor,
+	SpellSetup,
+	LaunchDone,
+	Num
+};
+
+// Fixed bucket latency histogram - cheap enough to add to every cast
+struct FLatencyHistogram {
+	static constexpr int32 NumBuckets{ 68 };
+	static constexpr double BucketWidth{ 0.5e-3 }; // Seconds - 68 buckets covers 34 ms (about three 90 Hz frames), slower goes in the last bucket
+
+	int32 Buckets[NumBuckets]{};
+	int32 Count{ 0 };
+	double Total{ 0.0 };
+	double Max{ 0.0 };
+
+	void Add(double Seconds);
+	double GetMean() const { return Count > 0 ? Total / Count : 0.0; }
+	double GetPercentile(double Fraction) const; // Upper edge of the bucket the percentile falls in
+	int32 CountBelow(double Seconds) const; // Whole buckets only
+};
+
+class FCastLatencyTracer {
+public:
+	static FCastLatencyTracer& Get();
+
+	// Starts (or restarts) a chain
+	void Begin(ECastLatencyChain Chain, ECastTracePoint Point);
+	// Marks a point on a chain that has begun - does nothing otherwise, so it is safe to call from anywhere (e.g. demo spells)
+	void Mark(ECastLatencyChain Chain, ECastTracePoint Point);
+	// Ends a chain and adds it to the Spell histograms - only if RequiredPoint was marked, otherwise the chain is thrown away
+	void End(ECastLatencyChain Chain, ECastTracePoint Point, SpellID Spell, ECastTracePoint RequiredPoint);
+
+	const FLatencyHistogram& GetTotalHistogram(ECastLatencyChain Chain, SpellID Spell) const { return TotalHistograms[static_cast<int32>(Chain)][Spell]; }
+	const FLatencyHistogram& GetProcessingHistogram(ECastLatencyChain Chain, SpellID Spell) const { return ProcessingHistograms[static_cast<int32>(Chain)][Spell]; }
+
+	// Writes every histogram that has anything in it to FilePath (csv) and a summary to the log
+	bool SaveHistograms(const FString& FilePath) const;
+
+private:
+	static constexpr int32 NumChains{ static_cast<int32>(ECastLatencyChain::Num) };
+	static constexpr int32 NumPoints{ static_cast<int32>(ECastTracePoint::Num) };
+	static constexpr int32 NumSpellIDs{ SpellID::Multiple + 1 };
+
+	struct FChainTrace {
+		double PointTimes[NumPoints]{}; // FPlatformTime::Seconds(), 0 if the point was not reached
+		bool isActive{ false };
+	};
+
+	FChainTrace Traces[NumChains]{};
+	FLatencyHistogram TotalHistograms[NumChains][NumSpellIDs]{};
+	FLatencyHistogram ProcessingHistograms[NumChains][NumSpellIDs]{};
+
+	void SaveHistogramRow(FString& Output, const TCHAR* Measure, int32 Chain, int32 Spell, const FLatencyHistogram& Histogram) const;
+};
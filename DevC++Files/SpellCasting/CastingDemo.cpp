@@ -3,12 +3,15 @@
 
 #include "CastingDemo.h"
 #include "Components/TextRenderComponent.h"
+#include "TickSleep.h"
+#include "Recognition/RecognizerMath.h"
 
 // Sets default values
 ACastingDemo::ACastingDemo()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false; // Nothing to show until initDemo()
 
 	DisplayPillar = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Display Pillar"));
 	DisplayPillar->SetupAttachment(GetRootComponent());
@@ -37,6 +40,9 @@ void ACastingDemo::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	// Nobody looking - keep the hands going at a few ticks a second, so the demo is still mid move when someone looks again
+	SetActorTickInterval(WasRecentlyRendered(OffscreenTickInterval) ? 0.f : OffscreenTickInterval);
+
 	if (&DemoSpell && SecondsPerMove != 0) { // Once spell demo has been set
 		UpdateDemoHands(CurrentTime / SecondsPerMove);
 
@@ -57,6 +63,8 @@ void ACastingDemo::initDemo(FSpellData SpellToDemo)
 	LHand->SetRelativeRotation(DemoSpell.KeyPoints[0].LHRotation);
 	RHand->SetRelativeLocation(RHandStartPos);
 	RHand->SetRelativeRotation(DemoSpell.KeyPoints[0].RHRotation);
+
+	WakeTick(this);
 }
 
 void ACastingDemo::UpdateDemoHands(float MoveCompletionFactor)
@@ -75,8 +83,25 @@ void ACastingDemo::UpdateDemoHands(float MoveCompletionFactor)
 	}
 }
 
+// Arcs go round their circle rather than straight across
+static FVector GetDemoArcPosition(const FVector& StartPos, const FVector& EndPos, MoveType Motion, float MoveCompletionFactor) {
+	const SpellRecognition::FVec3 position{ SpellRecognition::GetArcPosition(
+		SpellRecognition::FVec3{ StartPos.X, StartPos.Y, StartPos.Z },
+		SpellRecognition::FVec3{ EndPos.X, EndPos.Y, EndPos.Z },
+		static_cast<SpellRecognition::EMotion>(Motion), MoveCompletionFactor) };
+	return FVector{ position.X, position.Y, position.Z };
+}
+
 void ACastingDemo::SetFactoredLocation(float MoveCompletionFactor)
 {
+	const FKeyPoint& PrevKeyPoint{ DemoSpell.KeyPoints[CurrentMove - 1] };
+	const FKeyPoint& KeyPoint{ DemoSpell.KeyPoints[CurrentMove] };
+	if (KeyPoint.Motion == MoveType::Arc1 || KeyPoint.Motion == MoveType::Arc2) {
+		LHand->SetRelativeLocation(LHandStartPos + GetDemoArcPosition(PrevKeyPoint.LHPosition, KeyPoint.LHPosition, KeyPoint.Motion, MoveCompletionFactor) * DemoSize);
+		RHand->SetRelativeLocation(RHandStartPos + GetDemoArcPosition(PrevKeyPoint.RHPosition, KeyPoint.RHPosition, KeyPoint.Motion, MoveCompletionFactor) * DemoSize);
+		return;
+	}
+
 	LHand->SetRelativeLocation(
 		LHandStartPos + 
 		(DemoSpell.KeyPoints[CurrentMove - 1].LHPosition * DemoSize) +
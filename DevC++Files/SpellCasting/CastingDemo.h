@@ -21,7 +21,7 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
+	// Called every frame once initDemo() has given it a spell - slower while off screen
 	virtual void Tick(float DeltaTime) override;
 	
 	void initDemo(FSpellData SpellToDemo);
@@ -51,6 +51,8 @@ private:
 		float HandSeparation{ 0 };
 	UPROPERTY(EditAnywhere, category = "Default Variables")
 		float SecondsPerMove{ 3 };
+	UPROPERTY(EditAnywhere, category = "Default Variables")
+		float OffscreenTickInterval{ 0.5f };
 
 private:
 
@@ -2,6 +2,7 @@
 
 
 #include "EarthBeamSpikePlate.h"
+#include "TickSleep.h"
 
 // Sets default values
 AEarthBeamSpikePlate::AEarthBeamSpikePlate()
@@ -47,5 +48,8 @@ void AEarthBeamSpikePlate::UpdateSpikeExtension()
 		if (RelativeSpikePos.Z > 0) RelativeSpikePos.Z = 0;
 		Spikes->SetRelativeLocation(RelativeSpikePos);
 	}
+	else {
+		SleepTick(this); // Fully extended - wake again once retracting is in
+	}
 }
 
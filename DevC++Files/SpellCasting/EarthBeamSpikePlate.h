@@ -20,7 +20,7 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
+	// Called every frame until the spikes are fully extended
 	virtual void Tick(float DeltaTime) override;
 
 	void SetupPlate(UMaterialInterface* BasePlateMaterial, UMaterialInterface* SpikeMaterial);
@@ -0,0 +1,26 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "AllocationCounter.h"
+
+namespace SpellRecognition {
+
+// Plain thread_local integer - no constructor, so counting never allocates (or recurses into the hook)
+static thread_local uint64_t ThreadAllocationCount{ 0 };
+
+void CountAllocation()
+{
+	ThreadAllocationCount++;
+}
+
+uint64_t GetAllocationCount()
+{
+	return ThreadAllocationCount;
+}
+
+void UncountAllocations(uint64_t Count)
+{
+	ThreadAllocationCount -= Count;
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,55 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Allocation counter - how many heap allocations the calling thread has made, to check the recognition hot path makes none
+* Nothing is counted unless something hooks the allocator and calls CountAllocation():
+*	In game - the counting FMalloc (see SpellAllocationCheck.h), checked by USpellComponent::isAllocationCheckEnabled
+*	In the tools - a replacement operator new (see Tools/TrajectoryReplay)
+* Steady state means after the first cast - SpellSetup(), UpdateSpellStates(), FRecognitionBatch and DTW matching keep their storage
+* between casts, so once every buffer has grown to size a cast allocates nothing
+* NOTE: Counts are per thread - batch workers count on their own threads, so check the tick on the game thread and the batch in the tools
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace SpellRecognition {
+
+// Called by the allocator hook for every allocation (and every realloc, which may move the block) - cheap enough to leave in a debug allocator
+void CountAllocation();
+
+// Allocations made by the calling thread since it started
+uint64_t GetAllocationCount();
+
+// Takes Count back off the calling thread's count - only for FUncountedScope
+void UncountAllocations(uint64_t Count);
+
+// Adds the allocations the calling thread makes while it is alive to Total
+class FAllocationScope {
+public:
+	explicit FAllocationScope(uint64_t& NewTotal) : Total{ NewTotal }, Start{ GetAllocationCount() } {}
+	~FAllocationScope() { Total += GetAllocationCount() - Start; }
+
+	FAllocationScope(const FAllocationScope&) = delete;
+	FAllocationScope& operator=(const FAllocationScope&) = delete;
+
+private:
+	uint64_t& Total;
+	uint64_t Start{ 0 };
+};
+
+// Allocations the calling thread makes while it is alive are not seen by any FAllocationScope - for engine work called from counted code
+class FUncountedScope {
+public:
+	FUncountedScope() : Start{ GetAllocationCount() } {}
+	~FUncountedScope() { UncountAllocations(GetAllocationCount() - Start); }
+
+	FUncountedScope(const FUncountedScope&) = delete;
+	FUncountedScope& operator=(const FUncountedScope&) = delete;
+
+private:
+	uint64_t Start{ 0 };
+};
+
+} // namespace SpellRecognition
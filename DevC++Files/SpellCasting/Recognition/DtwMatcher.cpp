@@ -0,0 +1,372 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "DtwMatcher.h"
+#include "KernelOps.h"
+#include "RecognizerMath.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace SpellRecognition {
+
+// Templates and rows are padded by this many floats so the kernels can always load a whole vector
+constexpr int32_t DtwPadding{ 8 };
+static_assert(DtwPadding % FKernelOps::Width == 0, "DTW padding must be a multiple of the kernel width");
+
+// Cost of a cell no path can reach - large but finite so it survives fast-math builds
+constexpr float DtwNoPath{ 3.0e38f };
+
+// Feature values of one hand in the order the features are stored
+static void GetDtwFeatures(const FVec3& Position, const FRot3& Rotation, float* Out) {
+	Out[0] = Position.X;
+	Out[1] = Position.Y;
+	Out[2] = Position.Z;
+	Out[3] = Rotation.Pitch;
+	Out[4] = Rotation.Yaw;
+	Out[5] = Rotation.Roll;
+}
+
+static float GetDtwWeight(float Tolerance) {
+	return (Tolerance == 0) ? 0.f : 1.f / Tolerance;
+}
+
+static float GetDtwScale(float MaxMove) {
+	return (MaxMove > 0) ? MaxMove : 1.f; // A spell that never moves stays in unit space
+}
+
+FDtwMatcher::FDtwMatcher(FSharedSpellSet NewSpellSet, const FDtwSettings& NewSettings)
+	: SpellSet{ NewSpellSet ? std::move(NewSpellSet) : GetEmptySpellSet() }
+{
+	SetSettings(NewSettings);
+}
+
+FDtwMatcher::FDtwMatcher(const std::vector<FSpellDef>& SpellDefs, const FDtwSettings& NewSettings)
+	: FDtwMatcher{ MakeSpellSet(SpellDefs), NewSettings }
+{
+}
+
+void FDtwMatcher::SetSpells(FSharedSpellSet NewSpellSet)
+{
+	SpellSet = NewSpellSet ? std::move(NewSpellSet) : GetEmptySpellSet();
+	BuildTemplates();
+}
+
+void FDtwMatcher::SetSpells(const std::vector<FSpellDef>& SpellDefs)
+{
+	SetSpells(MakeSpellSet(SpellDefs));
+}
+
+void FDtwMatcher::SetSettings(const FDtwSettings& NewSettings)
+{
+	Settings = NewSettings;
+	Settings.TemplateLength = std::max(Settings.TemplateLength, 2);
+	Settings.Band = std::max(Settings.Band, 0);
+	BuildTemplates(); // Template length and envelopes depend on the settings
+}
+
+void FDtwMatcher::BuildTemplates()
+{
+	const int32_t length{ Settings.TemplateLength };
+	Stride = (length + DtwPadding - 1) / DtwPadding * DtwPadding + DtwPadding;
+
+	const std::vector<FSpellDef>& spells{ SpellSet->GetSpells() };
+	Templates.assign(spells.size(), FTemplate{});
+	for (size_t i{ 0 }; i < spells.size(); i++) {
+		BuildTemplate(spells[i], Templates[i]);
+	}
+
+	Query.assign(static_cast<size_t>(FeatureCount) * Stride, 0.f);
+	DistanceRow.assign(Stride, 0.f);
+	PrevCosts.assign(Stride, DtwNoPath);
+	Costs.assign(Stride, DtwNoPath);
+	LowerBounds.reserve(spells.size());
+}
+
+void FDtwMatcher::BuildTemplate(const FSpellDef& Spell, FTemplate& Template) const
+{
+	const int32_t length{ Settings.TemplateLength };
+	Template.ID = Spell.ID;
+	Template.isDualOnly = Spell.isDualOnly;
+	Template.isEmpty = Spell.KeyPoints.empty();
+	Template.Points.assign(static_cast<size_t>(FeatureCount) * Stride, 0.f);
+	Template.Upper.assign(Template.Points.size(), DtwNoPath); // Padding never adds to a lower bound
+	Template.Lower.assign(Template.Points.size(), -DtwNoPath);
+	if (Template.isEmpty) {
+		return;
+	}
+
+	const float positionWeights[3]{ GetDtwWeight(Spell.PositionalTolerance.X), GetDtwWeight(Spell.PositionalTolerance.Y), GetDtwWeight(Spell.PositionalTolerance.Z) };
+	const float rotationWeights[3]{ GetDtwWeight(Spell.RotationalTolerance.Pitch), GetDtwWeight(Spell.RotationalTolerance.Yaw), GetDtwWeight(Spell.RotationalTolerance.Roll) };
+	for (int32_t hand{ 0 }; hand < 2; hand++) {
+		for (int32_t axis{ 0 }; axis < 3; axis++) {
+			Template.Weights[hand * 6 + axis] = positionWeights[axis];
+			Template.Weights[hand * 6 + 3 + axis] = rotationWeights[axis];
+		}
+	}
+
+	// Keypoint positions relative to keypoint 0 - the cast is recorded relative to the hand start positions
+	const FKeyPointDef& start{ Spell.KeyPoints[0] };
+	float RHMaxMove{ 0.f };
+	float LHMaxMove{ 0.f };
+	for (const FKeyPointDef& kp : Spell.KeyPoints) {
+		RHMaxMove = std::max(RHMaxMove, (kp.RHPosition - start.RHPosition).GetAbsMax());
+		LHMaxMove = std::max(LHMaxMove, (kp.LHPosition - start.LHPosition).GetAbsMax());
+	}
+	Template.RHScale = GetDtwScale(RHMaxMove);
+	Template.LHScale = GetDtwScale(LHMaxMove);
+	Template.DualScale = GetDtwScale(std::max(RHMaxMove, LHMaxMove));
+
+	// Every segment between keypoints gets the same share of the points - DTW takes care of the timing
+	const int32_t segmentCount{ static_cast<int32_t>(Spell.KeyPoints.size()) - 1 };
+	for (int32_t point{ 0 }; point < length; point++) {
+		const float along{ static_cast<float>(point) * segmentCount / (length - 1) };
+		const int32_t segment{ std::min(static_cast<int32_t>(along), std::max(segmentCount - 1, 0)) };
+		const float fraction{ (segmentCount > 0) ? along - segment : 0.f };
+		const FKeyPointDef& from{ Spell.KeyPoints[segment] };
+		const FKeyPointDef& to{ Spell.KeyPoints[std::min(segment + 1, segmentCount)] };
+
+		float fromFeatures[FeatureCount];
+		float toFeatures[FeatureCount];
+		GetDtwFeatures(from.RHPosition - start.RHPosition, from.RHRotation, &fromFeatures[0]);
+		GetDtwFeatures(from.LHPosition - start.LHPosition, from.LHRotation, &fromFeatures[6]);
+		GetDtwFeatures(to.RHPosition - start.RHPosition, to.RHRotation, &toFeatures[0]);
+		GetDtwFeatures(to.LHPosition - start.LHPosition, to.LHRotation, &toFeatures[6]);
+		for (int32_t feature{ 0 }; feature < FeatureCount; feature++) {
+			const float value{ fromFeatures[feature] + (toFeatures[feature] - fromFeatures[feature]) * fraction };
+			Template.Points[feature * Stride + point] = value * Template.Weights[feature];
+		}
+
+		// Arcs follow their circle rather than cutting the corner (rotations still blend straight across)
+		if (IsArc(to.Motion) && segmentCount > 0) {
+			float arcFeatures[FeatureCount];
+			GetDtwFeatures(GetArcPosition(from.RHPosition, to.RHPosition, to.Motion, fraction) - start.RHPosition, FRot3{}, &arcFeatures[0]);
+			GetDtwFeatures(GetArcPosition(from.LHPosition, to.LHPosition, to.Motion, fraction) - start.LHPosition, FRot3{}, &arcFeatures[6]);
+			for (int32_t hand{ 0 }; hand < 2; hand++) {
+				for (int32_t feature{ hand * 6 }; feature < hand * 6 + 3; feature++) {
+					Template.Points[feature * Stride + point] = arcFeatures[feature] * Template.Weights[feature];
+				}
+			}
+		}
+	}
+
+	// Envelope of every point over the band
+	for (int32_t feature{ 0 }; feature < FeatureCount; feature++) {
+		const float* points{ &Template.Points[feature * Stride] };
+		for (int32_t point{ 0 }; point < length; point++) {
+			const int32_t first{ std::max(point - Settings.Band, 0) };
+			const int32_t last{ std::min(point + Settings.Band, length - 1) };
+			Template.Upper[feature * Stride + point] = *std::max_element(points + first, points + last + 1);
+			Template.Lower[feature * Stride + point] = *std::min_element(points + first, points + last + 1);
+		}
+	}
+}
+
+void FDtwMatcher::BeginCast(const FPoseSample& Pose, bool isRHCastingNow, bool isLHCastingNow)
+{
+	if (Samples.capacity() < static_cast<size_t>(DtwMaxSamples)) {
+		Samples.reserve(DtwMaxSamples);
+	}
+	Samples.clear();
+	Samples.push_back(Pose);
+	SampleInterval = 1;
+	SamplesToSkip = 0;
+	RHStartPos = Pose.RH.Position;
+	LHStartPos = Pose.LH.Position;
+	isRHCasting = isRHCastingNow;
+	isLHCasting = isLHCastingNow;
+}
+
+void FDtwMatcher::AddSample(const FPoseSample& Pose)
+{
+	if (SamplesToSkip > 0) {
+		SamplesToSkip--;
+		return;
+	}
+	if (Samples.size() == static_cast<size_t>(DtwMaxSamples)) { // Full - halve the rate, the start pose stays at 0
+		const size_t kept{ (Samples.size() + 1) / 2 };
+		for (size_t i{ 1 }; i < kept; i++) {
+			Samples[i] = Samples[i * 2];
+		}
+		Samples.resize(kept);
+		SampleInterval *= 2;
+	}
+	Samples.push_back(Pose);
+	SamplesToSkip = SampleInterval - 1;
+}
+
+// Resamples the recorded cast to TemplateLength evenly spaced (in time) points, positions divided by Scale
+void FDtwMatcher::ResampleQuery(float Scale)
+{
+	const int32_t length{ Settings.TemplateLength };
+	const int32_t lastSample{ static_cast<int32_t>(Samples.size()) - 1 };
+	for (int32_t point{ 0 }; point < length; point++) {
+		const float along{ static_cast<float>(point) * lastSample / (length - 1) };
+		const int32_t sample{ std::min(static_cast<int32_t>(along), lastSample - 1) };
+		const float fraction{ along - sample };
+		const FPoseSample& from{ Samples[sample] };
+		const FPoseSample& to{ Samples[sample + 1] };
+
+		float fromFeatures[FeatureCount];
+		float toFeatures[FeatureCount];
+		GetDtwFeatures((from.RH.Position - RHStartPos) / Scale, from.RH.Rotation, &fromFeatures[0]);
+		GetDtwFeatures((from.LH.Position - LHStartPos) / Scale, from.LH.Rotation, &fromFeatures[6]);
+		GetDtwFeatures((to.RH.Position - RHStartPos) / Scale, to.RH.Rotation, &toFeatures[0]);
+		GetDtwFeatures((to.LH.Position - LHStartPos) / Scale, to.LH.Rotation, &toFeatures[6]);
+		for (int32_t feature{ 0 }; feature < FeatureCount; feature++) {
+			Query[feature * Stride + point] = fromFeatures[feature] + (toFeatures[feature] - fromFeatures[feature]) * fraction;
+		}
+	}
+}
+
+// Finds the features checked for this cast (casting hands, axes with a tolerance) and what the query must be multiplied by to match the template
+// Returns the number of features
+int32_t FDtwMatcher::GetActiveFeatures(const FTemplate& Template, float (&OutWeights)[FeatureCount], int32_t (&OutFeatures)[FeatureCount]) const
+{
+	const float scale{ (isRHCasting && isLHCasting) ? Template.DualScale : (isRHCasting ? Template.RHScale : Template.LHScale) };
+	int32_t count{ 0 };
+	for (int32_t feature{ 0 }; feature < FeatureCount; feature++) {
+		const bool isRHFeature{ feature < 6 };
+		const bool isPosition{ feature % 6 < 3 };
+		OutWeights[feature] = Template.Weights[feature] * (isPosition ? scale : 1.f);
+		if (OutWeights[feature] != 0 && (isRHFeature ? isRHCasting : isLHCasting)) {
+			OutFeatures[count++] = feature;
+		}
+	}
+	return count;
+}
+
+// LB_Keogh - how far the query is outside the template envelope, never more than the real DTW cost
+float FDtwMatcher::GetLowerBound(const FTemplate& Template, const float (&Weights)[FeatureCount], const int32_t (&Features)[FeatureCount], int32_t NumFeatures)
+{
+	const int32_t length{ Settings.TemplateLength };
+	const VecN zero{ FKernelOps::Set(0.f) };
+	VecN sum{ zero };
+	for (int32_t i{ 0 }; i < NumFeatures; i++) {
+		const int32_t offset{ Features[i] * Stride };
+		const VecN weight{ FKernelOps::Set(Weights[Features[i]]) };
+		for (int32_t point{ 0 }; point < length; point += FKernelOps::Width) {
+			const VecN query{ FKernelOps::Mul(FKernelOps::Load(&Query[offset + point]), weight) };
+			const VecN above{ FKernelOps::Max(FKernelOps::Sub(query, FKernelOps::Load(&Template.Upper[offset + point])), zero) };
+			const VecN below{ FKernelOps::Max(FKernelOps::Sub(FKernelOps::Load(&Template.Lower[offset + point]), query), zero) };
+			const VecN excess{ FKernelOps::Add(above, below) };
+			sum = FKernelOps::Add(sum, FKernelOps::Mul(excess, excess));
+		}
+	}
+
+	float lanes[FKernelOps::Width];
+	FKernelOps::Store(lanes, sum);
+	float total{ 0.f };
+	for (const float lane : lanes) {
+		total += lane;
+	}
+	return total;
+}
+
+// Banded DTW cost of the query against Template - gives up and returns DtwNoPath as soon as it can not beat AbandonCost
+float FDtwMatcher::GetPathCost(const FTemplate& Template, const float (&Weights)[FeatureCount], const int32_t (&Features)[FeatureCount], int32_t NumFeatures, float AbandonCost)
+{
+	const int32_t length{ Settings.TemplateLength };
+	std::fill(PrevCosts.begin(), PrevCosts.end(), DtwNoPath);
+
+	for (int32_t row{ 0 }; row < length; row++) {
+		const int32_t first{ std::max(row - Settings.Band, 0) };
+		const int32_t last{ std::min(row + Settings.Band, length - 1) };
+
+		// Distance from this query point to every template point in the band, a vector of template points at a time
+		float query[FeatureCount];
+		for (int32_t i{ 0 }; i < NumFeatures; i++) {
+			query[i] = Query[Features[i] * Stride + row] * Weights[Features[i]];
+		}
+		for (int32_t point{ first }; point <= last; point += FKernelOps::Width) {
+			VecN distance{ FKernelOps::Set(0.f) };
+			for (int32_t i{ 0 }; i < NumFeatures; i++) {
+				const VecN delta{ FKernelOps::Sub(FKernelOps::Set(query[i]), FKernelOps::Load(&Template.Points[Features[i] * Stride + point])) };
+				distance = FKernelOps::Add(distance, FKernelOps::Mul(delta, delta));
+			}
+			FKernelOps::Store(&DistanceRow[point], distance);
+		}
+
+		// Cheapest way into each cell - from the cell above, the one to the left or diagonally
+		std::fill(Costs.begin(), Costs.end(), DtwNoPath);
+		float rowMin{ DtwNoPath };
+		for (int32_t point{ first }; point <= last; point++) {
+			float best{ PrevCosts[point] };
+			if (point > 0) {
+				best = std::min(best, std::min(PrevCosts[point - 1], Costs[point - 1]));
+			}
+			if (row == 0 && point == 0) {
+				best = 0.f;
+			}
+			if (best < DtwNoPath) {
+				Costs[point] = best + DistanceRow[point];
+				rowMin = std::min(rowMin, Costs[point]);
+			}
+		}
+		if (rowMin >= AbandonCost) {
+			return DtwNoPath; // Every path from here on only gets more expensive
+		}
+		PrevCosts.swap(Costs);
+	}
+	return PrevCosts[length - 1];
+}
+
+bool FDtwMatcher::Match(FDtwMatch& OutMatch)
+{
+	OutMatch = FDtwMatch{};
+	if (Templates.empty() || Samples.size() < 2 || (!isRHCasting && !isLHCasting)) {
+		return false;
+	}
+
+	// Same by axis scaling as FSpellRecognizer - the largest single axis movement of a casting hand, never less than MinMoveScale
+	float maxMove{ Settings.MinMoveScale };
+	for (const FPoseSample& sample : Samples) {
+		if (isRHCasting) maxMove = std::max(maxMove, (sample.RH.Position - RHStartPos).GetAbsMax());
+		if (isLHCasting) maxMove = std::max(maxMove, (sample.LH.Position - LHStartPos).GetAbsMax());
+	}
+	ResampleQuery(maxMove);
+
+	// Cheap lower bound of every spell that can be cast with these hands
+	float weights[FeatureCount];
+	int32_t features[FeatureCount];
+	const float maxCost{ Settings.MaxCost * Settings.TemplateLength };
+	LowerBounds.clear();
+	for (int32_t i{ 0 }; i < static_cast<int32_t>(Templates.size()); i++) {
+		const FTemplate& tmpl{ Templates[i] };
+		if (tmpl.isEmpty || (tmpl.isDualOnly && isRHCasting != isLHCasting)) continue;
+
+		const int32_t numFeatures{ GetActiveFeatures(tmpl, weights, features) };
+		const float lowerBound{ GetLowerBound(tmpl, weights, features, numFeatures) };
+		if (lowerBound <= maxCost) {
+			LowerBounds.emplace_back(lowerBound, i);
+		}
+	}
+
+	// Full comparisons, most promising first - stops once no remaining spell can beat the best match
+	// NOTE: Ties go to spell order, same as a stable sort - std::stable_sort allocates a buffer every call, std::sort never does
+	std::sort(LowerBounds.begin(), LowerBounds.end(),
+		[](const std::pair<float, int32_t>& A, const std::pair<float, int32_t>& B) { return A.first < B.first || (A.first == B.first && A.second < B.second); });
+	float bestCost{ maxCost };
+	int32_t bestSpell{ -1 };
+	for (const std::pair<float, int32_t>& candidate : LowerBounds) {
+		if (candidate.first > bestCost) break;
+
+		const FTemplate& tmpl{ Templates[candidate.second] };
+		const int32_t numFeatures{ GetActiveFeatures(tmpl, weights, features) };
+		const float cost{ GetPathCost(tmpl, weights, features, numFeatures, bestCost) };
+		OutMatch.NumCompared++;
+		if (cost < bestCost) {
+			bestCost = cost;
+			bestSpell = candidate.second;
+		}
+	}
+
+	if (bestSpell < 0) {
+		return false;
+	}
+	OutMatch.SpellID = Templates[bestSpell].ID;
+	OutMatch.Cost = bestCost / Settings.TemplateLength;
+	return true;
+}
+
+} // namespace SpellRecognition
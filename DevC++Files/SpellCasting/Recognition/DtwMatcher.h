@@ -0,0 +1,117 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* DTW (dynamic time warping) spell matching - an alternative to the keypoint tolerance checks in FSpellRecognizer
+* Instead of walking through tolerance boxes keypoint by keypoint, the whole cast is recorded and compared with a reference
+* path made from every spell's keypoints when the cast ends. DTW lines the two paths up however the timing differs, so a
+* player who is sloppy but consistent (slow start, fast finish, a wobble on the way) still matches the spell
+*
+* Every path is resampled to TemplateLength points of 12 features (position & rotation of both hands):
+*	Positions are relative to the hand start position and scaled to the spell's unit space (largest single axis movement)
+*	Every feature is divided by the spell's tolerance for that axis, so a cost of 1 is an axis right on its tolerance
+*	Axes with a tolerance of 0 are ignored, same as the tolerance checks
+* Matching cost is kept down by:
+*	A Sakoe-Chiba band - each query point is only compared with the template points within Band of it
+*	LB_Keogh lower bounds - spells are compared in order of their lower bound and skipped once it is above the best match so far
+*	Early abandoning - a comparison stops as soon as every path through a row costs more than the best match so far
+*	SIMD distance rows - see KernelOps.h
+* NOTE: There is no relative start direction check for dual casts (positions are relative to each hand's own start position)
+* NOTE: Like FSpellRecognizer it does not know where the samples come from, feed it spellcasting grid space poses
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+#include "SpellSet.h"
+
+#include <utility>
+
+namespace SpellRecognition {
+
+// Most samples a cast recording keeps - a longer cast is decimated (see FDtwMatcher::AddSample()), the path is resampled to TemplateLength anyway
+constexpr int32_t DtwMaxSamples{ 2048 };
+
+struct FDtwSettings {
+	int32_t TemplateLength{ 32 }; // Points both paths are resampled to
+	int32_t Band{ 8 }; // Sakoe-Chiba band radius in points
+	float MaxCost{ 1.f }; // Highest average cost per point that is still a match
+	float MinMoveScale{ 8.f }; // Same as FRecognizerSettings::MinMoveScale - smaller casts are not scaled up
+};
+
+// The result of FDtwMatcher::Match()
+struct FDtwMatch {
+	int32_t SpellID{ NoSpell };
+	float Cost{ 0.f }; // Average cost per template point of the best match
+	int32_t NumCompared{ 0 }; // Spells that needed a full DTW comparison (the rest were thrown out by their lower bound)
+};
+
+class FDtwMatcher {
+public:
+	FDtwMatcher() = default;
+	explicit FDtwMatcher(FSharedSpellSet NewSpellSet, const FDtwSettings& NewSettings = FDtwSettings{});
+	explicit FDtwMatcher(const std::vector<FSpellDef>& SpellDefs, const FDtwSettings& NewSettings = FDtwSettings{});
+
+	// Rebuilds every template - the templates are per matcher (they depend on the settings), the definitions are shared (see SpellSet.h)
+	void SetSpells(FSharedSpellSet NewSpellSet);
+	void SetSpells(const std::vector<FSpellDef>& SpellDefs);
+	void SetSettings(const FDtwSettings& NewSettings);
+
+	// Starts recording a new cast - Pose is the start pose, exactly like FSpellRecognizer::SpellSetup()
+	void BeginCast(const FPoseSample& Pose, bool isRHCasting, bool isLHCasting);
+	// Never allocates - a full recording drops every other sample and keeps only every other from then on, so it stays evenly spaced
+	void AddSample(const FPoseSample& Pose);
+	int32_t NumSamples() const { return static_cast<int32_t>(Samples.size()); } // Kept samples, at most DtwMaxSamples
+
+	// Compares the cast so far with every spell that can be cast with the casting hands
+	// Returns true if one is within MaxCost - OutMatch is always filled in
+	bool Match(FDtwMatch& OutMatch);
+
+	const FDtwSettings& GetSettings() const { return Settings; }
+
+private:
+	static constexpr int32_t FeatureCount{ 12 }; // RH X, Y, Z, Pitch, Yaw, Roll, then the same for LH
+
+	// A spell's reference path - Points, Upper and Lower are [Feature * Stride + Point], already divided by the tolerances
+	struct FTemplate {
+		std::vector<float> Points{};
+		std::vector<float> Upper{}; // LB_Keogh envelope - largest/smallest value within Band of each point
+		std::vector<float> Lower{};
+		float Weights[FeatureCount]{}; // 1 / tolerance, 0 for ignored axes
+		float RHScale{ 1.f }; // Largest single axis movement of the keypoints in unit space (when casting with the hand(s) named)
+		float LHScale{ 1.f };
+		float DualScale{ 1.f };
+		int32_t ID{ -1 };
+		bool isDualOnly{ true };
+		bool isEmpty{ true };
+	};
+
+	FDtwSettings Settings{};
+	FSharedSpellSet SpellSet{ GetEmptySpellSet() }; // Kept for rebuilding the templates when the settings change
+	std::vector<FTemplate> Templates{}; // Same order as the spells
+	int32_t Stride{ 0 }; // TemplateLength padded for the SIMD kernels
+
+	// The cast being recorded
+	std::vector<FPoseSample> Samples{};
+	int32_t SampleInterval{ 1 }; // Only every SampleInterval'th sample is kept - doubles every time the recording fills up
+	int32_t SamplesToSkip{ 0 }; // Until the next one that is kept
+	FVec3 RHStartPos{};
+	FVec3 LHStartPos{};
+	bool isRHCasting{ false };
+	bool isLHCasting{ false };
+
+	// Match() scratch space - kept between casts so matching does not allocate
+	std::vector<float> Query{}; // Resampled cast, same layout as FTemplate::Points but not divided by the tolerances
+	std::vector<float> DistanceRow{};
+	std::vector<float> PrevCosts{};
+	std::vector<float> Costs{};
+	std::vector<std::pair<float, int32_t>> LowerBounds{}; // Lower bound and spell index of every spell worth comparing
+
+	void BuildTemplates();
+	void BuildTemplate(const FSpellDef& Spell, FTemplate& Template) const;
+	void ResampleQuery(float Scale);
+	int32_t GetActiveFeatures(const FTemplate& Template, float (&OutWeights)[FeatureCount], int32_t (&OutFeatures)[FeatureCount]) const;
+	float GetLowerBound(const FTemplate& Template, const float (&Weights)[FeatureCount], const int32_t (&Features)[FeatureCount], int32_t NumFeatures);
+	float GetPathCost(const FTemplate& Template, const float (&Weights)[FeatureCount], const int32_t (&Features)[FeatureCount], int32_t NumFeatures, float AbandonCost);
+};
+
+} // namespace SpellRecognition
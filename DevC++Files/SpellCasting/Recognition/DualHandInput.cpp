@@ -0,0 +1,84 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "DualHandInput.h"
+
+namespace SpellRecognition {
+
+EHandIntent FDualHandInput::Press(EHand Hand, double Time)
+{
+	const EHandIntent decided{ Update(Time) };
+
+	if (State == EDualHandState::Idle) {
+		State = EDualHandState::Waiting;
+		FirstHand = Hand;
+		WindowStartTime = Time;
+		SetActive(Hand, true);
+	}
+	else if (State == EDualHandState::Waiting && Hand != FirstHand) {
+		State = EDualHandState::Dual;
+		SetActive(Hand, true);
+		return EHandIntent::Dual;
+	}
+	// Otherwise too late for the other hand (or the same hand again) - ignored
+
+	return decided;
+}
+
+EHandIntent FDualHandInput::Release(EHand Hand, double Time)
+{
+	const EHandIntent decided{ Update(Time) };
+	if (!IsActive(Hand)) {
+		return decided;
+	}
+	SetActive(Hand, false);
+
+	if (State == EDualHandState::Dual) { // The window opens again from the release, for the hand to come back or the other to go on alone
+		State = EDualHandState::Waiting;
+		FirstHand = (Hand == EHand::Right) ? EHand::Left : EHand::Right;
+		WindowStartTime = Time;
+	}
+	else {
+		State = EDualHandState::Idle; // Released while waiting cancels, released while single ends it
+	}
+	return decided;
+}
+
+EHandIntent FDualHandInput::Update(double Time)
+{
+	if (State == EDualHandState::Waiting && Time >= GetWindowEnd()) {
+		State = EDualHandState::Single;
+		return GetIntent();
+	}
+	return EHandIntent::None;
+}
+
+void FDualHandInput::Reset()
+{
+	State = EDualHandState::Idle;
+	isRHActive = false;
+	isLHActive = false;
+}
+
+EHandIntent FDualHandInput::GetIntent() const
+{
+	if (State == EDualHandState::Dual) {
+		return EHandIntent::Dual;
+	}
+	if (State == EDualHandState::Single) {
+		return (FirstHand == EHand::Right) ? EHandIntent::Right : EHandIntent::Left;
+	}
+	return EHandIntent::None;
+}
+
+void FDualHandInput::SetActive(EHand Hand, bool isActive)
+{
+	if (Hand == EHand::Right) {
+		isRHActive = isActive;
+	}
+	else {
+		isLHActive = isActive;
+	}
+}
+
+} // namespace SpellRecognition
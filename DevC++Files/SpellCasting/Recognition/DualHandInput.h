@@ -0,0 +1,71 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Dual hand input - decides from button timestamps whether the player means one hand or both
+* The first press opens a window, a press of the other hand before it closes makes it dual, otherwise it is single handed once it closes:
+*	Idle -> Waiting			First hand pressed
+*	Waiting -> Dual			Other hand pressed within the window (decided right away)
+*	Waiting -> Single		Window closed with one hand (decided at the window end, however late the next event or Update() comes)
+*	Waiting -> Idle			Only hand released before the window closed - nothing was meant
+*	Dual -> Waiting			One hand released - a new window opens from the release: pressed again within it is dual again,
+*							otherwise the other hand carries on on its own once it closes (the same grace USpellComponent always gave)
+*	Single -> Idle			Hand released
+* USpellComponent keeps one for casting (A/X) and one for launching (triggers)
+* NOTE: Only timestamps decide - a window can not be stretched or cut short by the frame rate, a press at 0.19 s is dual even if the frame it is read in ends at 0.25 s
+* NOTE: Times are in seconds on any one clock (FPoseSampler::Now() in game) - events must come in time order
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+
+namespace SpellRecognition {
+
+enum class EHandIntent : uint8_t {
+	None, // Nothing pressed, or still waiting for the other hand
+	Right,
+	Left,
+	Dual
+};
+
+enum class EDualHandState : uint8_t {
+	Idle,
+	Waiting,
+	Single,
+	Dual
+};
+
+class FDualHandInput {
+public:
+	explicit FDualHandInput(double NewWindow = 0.2) : Window{ NewWindow } {}
+
+	void SetWindow(double NewWindow) { Window = NewWindow; }
+	double GetWindow() const { return Window; }
+
+	// Every event first closes the window if Time is past its end, then applies the press/release
+	// Returns the intent decided by the event - None if it decided nothing (a release never decides anything)
+	EHandIntent Press(EHand Hand, double Time);
+	EHandIntent Release(EHand Hand, double Time);
+	EHandIntent Update(double Time);
+
+	// Back to Idle - held buttons are forgotten, their release does nothing
+	void Reset();
+
+	EDualHandState GetState() const { return State; }
+	EHandIntent GetIntent() const; // None until decided
+	bool IsWaiting() const { return State == EDualHandState::Waiting; }
+	bool IsActive(EHand Hand) const { return (Hand == EHand::Right) ? isRHActive : isLHActive; } // Pressed and part of the intent (or waiting on it)
+	double GetWindowEnd() const { return WindowStartTime + Window; } // Only meaningful while IsWaiting()
+
+private:
+	double Window{ 0.2 }; // Seconds the second hand has after the first
+	double WindowStartTime{ 0.0 }; // The first press, or the release of one hand of a dual intent
+	EDualHandState State{ EDualHandState::Idle };
+	EHand FirstHand{ EHand::Right }; // The hand of a single handed intent
+	bool isRHActive{ false };
+	bool isLHActive{ false };
+
+	void SetActive(EHand Hand, bool isActive);
+};
+
+} // namespace SpellRecognition
@@ -0,0 +1,133 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* SIMD wrapper shared by the recognizer's batch kernels (ToleranceKernels.cpp, DtwMatcher.cpp)
+* Only include this from .cpp files - it pulls in the intrinsics headers
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Pick the widest instruction set available at compile time
+// NOTE: Define SPELLRECOGNITION_SCALAR_KERNELS to force the plain C++ version (handy when checking the SIMD versions give the same answers)
+#if !defined(SPELLRECOGNITION_SCALAR_KERNELS) && defined(__AVX__)
+#include <immintrin.h>
+#define SPELLRECOGNITION_KERNELS_AVX 1
+#elif !defined(SPELLRECOGNITION_SCALAR_KERNELS) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SPELLRECOGNITION_KERNELS_SSE2 1
+#elif !defined(SPELLRECOGNITION_SCALAR_KERNELS) && defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define SPELLRECOGNITION_KERNELS_NEON 1
+#endif
+
+namespace SpellRecognition {
+
+/*
+* Instruction set wrappers - each one provides the same handful of operations so the kernels only need writing once
+* V is a vector of Width floats, M is the matching comparison mask - Select() picks A where the mask is set and B where it is not
+*/
+
+#if SPELLRECOGNITION_KERNELS_AVX
+struct FKernelOps {
+	using V = __m256;
+	using M = __m256;
+	static constexpr int32_t Width{ 8 };
+	static constexpr const char* Name{ "AVX" };
+
+	static V Load(const float* Ptr) { return _mm256_loadu_ps(Ptr); }
+	static void Store(float* Ptr, V A) { _mm256_storeu_ps(Ptr, A); }
+	static V Set(float Value) { return _mm256_set1_ps(Value); }
+	static V Add(V A, V B) { return _mm256_add_ps(A, B); }
+	static V Sub(V A, V B) { return _mm256_sub_ps(A, B); }
+	static V Mul(V A, V B) { return _mm256_mul_ps(A, B); }
+	static V Min(V A, V B) { return _mm256_min_ps(A, B); }
+	static V Max(V A, V B) { return _mm256_max_ps(A, B); }
+	static V Abs(V A) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), A); }
+	static V Sqrt(V A) { return _mm256_sqrt_ps(A); }
+	static M LessEqual(V A, V B) { return _mm256_cmp_ps(A, B, _CMP_LE_OQ); }
+	static M And(M A, M B) { return _mm256_and_ps(A, B); }
+	static V Select(M Mask, V A, V B) { return _mm256_blendv_ps(B, A, Mask); }
+	static uint32_t Bits(M A) { return static_cast<uint32_t>(_mm256_movemask_ps(A)); }
+};
+#elif SPELLRECOGNITION_KERNELS_SSE2
+struct FKernelOps {
+	using V = __m128;
+	using M = __m128;
+	static constexpr int32_t Width{ 4 };
+	static constexpr const char* Name{ "SSE2" };
+
+	static V Load(const float* Ptr) { return _mm_loadu_ps(Ptr); }
+	static void Store(float* Ptr, V A) { _mm_storeu_ps(Ptr, A); }
+	static V Set(float Value) { return _mm_set1_ps(Value); }
+	static V Add(V A, V B) { return _mm_add_ps(A, B); }
+	static V Sub(V A, V B) { return _mm_sub_ps(A, B); }
+	static V Mul(V A, V B) { return _mm_mul_ps(A, B); }
+	static V Min(V A, V B) { return _mm_min_ps(A, B); }
+	static V Max(V A, V B) { return _mm_max_ps(A, B); }
+	static V Abs(V A) { return _mm_andnot_ps(_mm_set1_ps(-0.f), A); }
+	static V Sqrt(V A) { return _mm_sqrt_ps(A); }
+	static M LessEqual(V A, V B) { return _mm_cmple_ps(A, B); }
+	static M And(M A, M B) { return _mm_and_ps(A, B); }
+	static V Select(M Mask, V A, V B) { return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B)); }
+	static uint32_t Bits(M A) { return static_cast<uint32_t>(_mm_movemask_ps(A)); }
+};
+#elif SPELLRECOGNITION_KERNELS_NEON
+struct FKernelOps {
+	using V = float32x4_t;
+	using M = uint32x4_t;
+	static constexpr int32_t Width{ 4 };
+	static constexpr const char* Name{ "NEON" };
+
+	static V Load(const float* Ptr) { return vld1q_f32(Ptr); }
+	static void Store(float* Ptr, V A) { vst1q_f32(Ptr, A); }
+	static V Set(float Value) { return vdupq_n_f32(Value); }
+	static V Add(V A, V B) { return vaddq_f32(A, B); }
+	static V Sub(V A, V B) { return vsubq_f32(A, B); }
+	static V Mul(V A, V B) { return vmulq_f32(A, B); }
+	static V Min(V A, V B) { return vminq_f32(A, B); }
+	static V Max(V A, V B) { return vmaxq_f32(A, B); }
+	static V Abs(V A) { return vabsq_f32(A); }
+	static V Sqrt(V A) { return vsqrtq_f32(A); }
+	static M LessEqual(V A, V B) { return vcleq_f32(A, B); }
+	static M And(M A, M B) { return vandq_u32(A, B); }
+	static V Select(M Mask, V A, V B) { return vbslq_f32(Mask, A, B); }
+	static uint32_t Bits(M A) {
+		static const uint32_t laneBits[4]{ 1, 2, 4, 8 };
+		return vaddvq_u32(vandq_u32(A, vld1q_u32(laneBits)));
+	}
+};
+#else
+struct FKernelOps {
+	using V = float;
+	using M = bool;
+	static constexpr int32_t Width{ 1 };
+	static constexpr const char* Name{ "Scalar" };
+
+	static V Load(const float* Ptr) { return *Ptr; }
+	static void Store(float* Ptr, V A) { *Ptr = A; }
+	static V Set(float Value) { return Value; }
+	static V Add(V A, V B) { return A + B; }
+	static V Sub(V A, V B) { return A - B; }
+	static V Mul(V A, V B) { return A * B; }
+	static V Min(V A, V B) { return (A < B) ? A : B; }
+	static V Max(V A, V B) { return (A > B) ? A : B; }
+	static V Abs(V A) { return std::fabs(A); }
+	static V Sqrt(V A) { return std::sqrt(A); }
+	static M LessEqual(V A, V B) { return A <= B; }
+	static M And(M A, M B) { return A && B; }
+	static V Select(M Mask, V A, V B) { return Mask ? A : B; }
+	static uint32_t Bits(M A) { return A ? 1 : 0; }
+};
+#endif
+
+using VecN = FKernelOps::V;
+using MaskN = FKernelOps::M;
+
+} // namespace SpellRecognition
@@ -0,0 +1,65 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Lock-free single producer, single consumer ring buffer - how pose samples get from the sampling thread to the game thread
+* Exactly one thread may Push() and exactly one (other) thread may Pop()/Clear(), nothing ever blocks or allocates
+* NOTE: Capacity must be a power of two. A full buffer rejects the new item rather than overwrite one the consumer may be reading
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace SpellRecognition {
+
+template <typename T, size_t Capacity>
+class TSpscRingBuffer {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "TSpscRingBuffer capacity must be a power of two");
+
+public:
+	// Producer only - returns false (and drops Item) if the buffer is full
+	bool Push(const T& Item) {
+		const size_t head{ Head.load(std::memory_order_relaxed) };
+		if (head - Tail.load(std::memory_order_acquire) == Capacity) {
+			return false;
+		}
+		Items[head & Mask] = Item;
+		Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only - returns false if there is nothing to read
+	bool Pop(T& Out) {
+		const size_t tail{ Tail.load(std::memory_order_relaxed) };
+		if (tail == Head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		Out = Items[tail & Mask];
+		Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only - throws away everything pushed so far
+	void Clear() {
+		Tail.store(Head.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+	// Either thread - only a snapshot, the other thread may already have changed it
+	size_t Num() const {
+		return Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire);
+	}
+
+private:
+	static constexpr size_t Mask{ Capacity - 1 };
+	static constexpr size_t CacheLineSize{ 64 };
+
+	// Head and Tail are padded onto their own cache lines so the two threads do not keep stealing the line from each other
+	std::atomic<size_t> Head{ 0 }; // Next slot to write - only written by the producer
+	char HeadPadding[CacheLineSize - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> Tail{ 0 }; // Next slot to read - only written by the consumer
+	char TailPadding[CacheLineSize - sizeof(std::atomic<size_t>)];
+	T Items[Capacity];
+};
+
+} // namespace SpellRecognition
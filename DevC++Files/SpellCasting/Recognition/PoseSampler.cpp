@@ -0,0 +1,106 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "PoseSampler.h"
+
+#include <chrono>
+
+namespace SpellRecognition {
+
+// Exact compare - a source that has not updated hands back the very same floats
+static bool IsSameSampledPose(const FPoseSample& A, const FPoseSample& B) {
+	const auto isSameHand = [](const FHandPose& HandA, const FHandPose& HandB) {
+		return HandA.Position.X == HandB.Position.X && HandA.Position.Y == HandB.Position.Y && HandA.Position.Z == HandB.Position.Z &&
+			HandA.Rotation.Pitch == HandB.Rotation.Pitch && HandA.Rotation.Yaw == HandB.Rotation.Yaw && HandA.Rotation.Roll == HandB.Rotation.Roll;
+	};
+	return isSameHand(A.RH, B.RH) && isSameHand(A.LH, B.LH);
+}
+
+bool FPoseSampler::Start(IPoseSource* Source, float RateHz)
+{
+	if (IsRunning() || Source == nullptr || !(RateHz > 0.f)) {
+		return false;
+	}
+	Samples.Clear();
+	DroppedCount.store(0, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock{ PauseMutex };
+		isPaused = false;
+	}
+	isRunning.store(true, std::memory_order_release);
+	SampleThread = std::thread{ &FPoseSampler::Run, this, Source, 1.0 / RateHz };
+	return true;
+}
+
+void FPoseSampler::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock{ PauseMutex }; // So a paused thread can not miss the wake up
+		isRunning.store(false, std::memory_order_release);
+	}
+	PauseChanged.notify_one();
+	if (SampleThread.joinable()) {
+		SampleThread.join();
+	}
+}
+
+void FPoseSampler::Pause()
+{
+	std::lock_guard<std::mutex> lock{ PauseMutex };
+	isPaused = true;
+}
+
+void FPoseSampler::Resume()
+{
+	{
+		std::lock_guard<std::mutex> lock{ PauseMutex };
+		isPaused = false;
+	}
+	PauseChanged.notify_one();
+}
+
+double FPoseSampler::Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FPoseSampler::Run(IPoseSource* Source, double Interval)
+{
+	using FClock = std::chrono::steady_clock;
+	const FClock::duration step{ std::chrono::duration_cast<FClock::duration>(std::chrono::duration<double>(Interval)) };
+	FClock::time_point nextSample{ FClock::now() };
+	FPoseSample lastPose{};
+	bool hasLastPose{ false };
+
+	while (isRunning.load(std::memory_order_acquire)) {
+		{
+			std::unique_lock<std::mutex> lock{ PauseMutex };
+			if (isPaused) {
+				PauseChanged.wait(lock, [this] { return !isPaused || !isRunning.load(std::memory_order_acquire); });
+				nextSample = FClock::now();
+				hasLastPose = false;
+				continue;
+			}
+		}
+
+		FTimedPoseSample sample{};
+		sample.Time = Now();
+		if (Source->SamplePose(sample.Pose) && !(hasLastPose && IsSameSampledPose(sample.Pose, lastPose))) {
+			lastPose = sample.Pose;
+			hasLastPose = true;
+			if (!Samples.Push(sample)) {
+				DroppedCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// Keep to the sample rate, but never try to catch up on samples missed while the thread was not scheduled
+		nextSample += step;
+		const FClock::time_point now{ FClock::now() };
+		if (nextSample < now) {
+			nextSample = now;
+		}
+		std::this_thread::sleep_until(nextSample);
+	}
+}
+
+} // namespace SpellRecognition
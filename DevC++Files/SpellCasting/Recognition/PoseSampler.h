@@ -0,0 +1,97 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* High rate pose sampling - polls a pose source on its own thread, much faster than the game ticks
+* At 90 Hz a fast Beam punch only gives a handful of samples and a hand can jump straight over a keypoint's tolerance box,
+* so every sample taken between two ticks is queued here and the game thread feeds all of them to the recognizer:
+*	Start() once, Drain() every tick, Stop() before the source goes away - Pause() and Resume() while nothing needs the samples
+* NOTE: The source is called from the sampling thread - anything it reads must be safe to read off the game thread
+* NOTE: A pose the same as the last one sampled is not queued - a source that only updates once a frame gives one sample per update, not a run of copies
+* NOTE: The keypoint checks can also sweep between samples (see FRecognizerSettings::isSweptKeyPoints), then a lower rate only costs move check accuracy
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+#include "PoseRingBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace SpellRecognition {
+
+// One pose sample and when it was taken
+// NOTE: Time is in seconds on the FPoseSampler::Now() clock, Pose is in whatever space the source samples in
+struct FTimedPoseSample {
+	double Time{ 0.0 };
+	FPoseSample Pose{};
+};
+
+// Where the sampling thread gets its poses from - motion controllers in game, a recording or a script in tests
+class IPoseSource {
+public:
+	virtual ~IPoseSource() = default;
+
+	// Fills OutPose with the current pose of both hands - returns false if there is no pose right now (e.g. lost tracking)
+	virtual bool SamplePose(FPoseSample& OutPose) = 0;
+};
+
+class FPoseSampler {
+public:
+	// 256 samples is a quarter of a second at 1 kHz - more than any sane frame hitch
+	static constexpr size_t SampleCapacity{ 256 };
+	using FSampleBuffer = TSpscRingBuffer<FTimedPoseSample, SampleCapacity>;
+
+	FPoseSampler() = default;
+	~FPoseSampler() { Stop(); }
+	FPoseSampler(const FPoseSampler&) = delete;
+	FPoseSampler& operator=(const FPoseSampler&) = delete;
+
+	// Starts polling Source RateHz times a second - returns false if already running or the arguments are no good
+	// NOTE: Source must outlive the sampling thread, i.e. until Stop()
+	bool Start(IPoseSource* Source, float RateHz);
+	void Stop();
+	bool IsRunning() const { return SampleThread.joinable(); }
+
+	// Game thread - the sampling thread blocks without polling the source until Resume()
+	// NOTE: A sample taken just before Pause() may still be queued, Clear() after Resume() if that matters
+	void Pause();
+	void Resume();
+
+	// Game thread - pops every queued sample in the order they were taken, calling Func(const FTimedPoseSample&) for each
+	// Returns the number of samples popped
+	template <typename FuncType>
+	int32_t Drain(FuncType&& Func) {
+		int32_t count{ 0 };
+		FTimedPoseSample sample{};
+		while (Samples.Pop(sample)) {
+			Func(sample);
+			count++;
+		}
+		return count;
+	}
+
+	// Game thread - throws away every queued sample
+	void Clear() { Samples.Clear(); }
+
+	// Number of samples thrown away because the game thread fell too far behind
+	uint32_t GetDroppedCount() const { return DroppedCount.load(std::memory_order_relaxed); }
+
+	// The clock every sample is stamped with, in seconds
+	static double Now();
+
+private:
+	FSampleBuffer Samples{};
+	std::thread SampleThread{};
+	std::atomic<bool> isRunning{ false };
+	std::atomic<uint32_t> DroppedCount{ 0 };
+	std::mutex PauseMutex{};
+	std::condition_variable PauseChanged{};
+	bool isPaused{ false }; // Guarded by PauseMutex
+
+	void Run(IPoseSource* Source, double Interval);
+};
+
+} // namespace SpellRecognition
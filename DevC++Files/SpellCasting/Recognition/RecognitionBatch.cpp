@@ -0,0 +1,54 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "RecognitionBatch.h"
+#include "SpellRecognizer.h"
+
+namespace SpellRecognition {
+
+FCasterUpdate& FRecognitionBatch::Add(FSpellRecognizer& Recognizer, bool isRHCasting, bool isLHCasting)
+{
+	if (NumCasters == static_cast<int32_t>(Casters.size())) {
+		Casters.emplace_back();
+	}
+	FCasterUpdate& update{ Casters[NumCasters++] };
+	update.Recognizer = &Recognizer;
+	update.Samples.clear();
+	update.Samples.reserve(FPoseSampler::SampleCapacity); // A tick never drains more, so a slot only allocates the first time it is used
+	update.isRHCasting = isRHCasting;
+	update.isLHCasting = isLHCasting;
+	update.NumChecked = 0;
+	update.ActiveSpell = NoSpell;
+	update.isSpellComplete = false;
+	return update;
+}
+
+void FRecognitionBatch::EvaluateCaster(int32_t Index)
+{
+	FCasterUpdate& update{ Casters[Index] };
+	FSpellRecognizer& recognizer{ *update.Recognizer };
+
+	int32_t numChecked{ 0 };
+	bool isSpellComplete{ false };
+	for (const FTimedPoseSample& sample : update.Samples) {
+		numChecked++;
+		if (recognizer.UpdateSpellStates(sample.Pose, update.isRHCasting, update.isLHCasting)) {
+			isSpellComplete = true;
+			break; // Everything after a complete spell is thrown away
+		}
+	}
+
+	// Written once at the end - neighbouring updates are being written by other threads
+	update.NumChecked = numChecked;
+	update.ActiveSpell = recognizer.GetActiveSpells();
+	update.isSpellComplete = isSpellComplete;
+}
+
+void FRecognitionBatch::Evaluate()
+{
+	for (int32_t i{ 0 }; i < NumCasters; i++) {
+		EvaluateCaster(i);
+	}
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,70 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Batch recognition - the spell updates of many casters (players, AI mages, spectator replays) checked together, spread over worker threads
+* Every frame:
+*	Reset(), then Add() every caster with the samples it took since its last update - game thread
+*	Evaluate() - runs FSpellRecognizer::UpdateSpellStates() over each caster's samples, casters in parallel
+*	Read the results back out of every FCasterUpdate - game thread, before any spell is applied
+* NOTE: Casters share nothing (every FSpellRecognizer owns its per-cast state and its rejection counters), so any caster can be
+*	checked on any thread - as long as a recognizer is only in the batch once, and its listener is safe to call off the game thread
+* NOTE: The batch starts no threads of its own, the caller hands Evaluate() its ParallelFor - the task graph in game
+*	(see USpellRecognitionManager), a thread pool in Tools/RecognitionBenchmark
+* NOTE: SpellSetup() is not batched - it moves the spellcasting grid, which only the game thread can do, and only runs once per cast
+*/
+
+#pragma once
+
+#include "PoseSampler.h"
+#include "RecognizerTypes.h"
+
+namespace SpellRecognition {
+
+class FSpellRecognizer;
+
+// One caster's spell update for this frame
+struct FCasterUpdate {
+	FSpellRecognizer* Recognizer{ nullptr };
+	std::vector<FTimedPoseSample> Samples{}; // Spellcasting grid space, in the order they were taken
+	bool isRHCasting{ false };
+	bool isLHCasting{ false };
+
+	// Results - written by Evaluate()
+	// Samples after the one that completed a spell are not checked (same as feeding them one by one and stopping), NumChecked says how many were
+	int32_t NumChecked{ 0 };
+	int32_t ActiveSpell{ NoSpell }; // GetActiveSpells() after the last checked sample
+	bool isSpellComplete{ false };
+};
+
+class FRecognitionBatch {
+public:
+	// Game thread - forgets every caster added last frame, the sample storage is kept for the next
+	void Reset() { NumCasters = 0; }
+
+	// Game thread - adds a caster to this frame's batch, fill in the Samples of the update returned
+	// Allocates only while the batch grows to its most casters yet - after that the storage of every update is reused
+	// NOTE: The reference is only good until the next Add()
+	FCasterUpdate& Add(FSpellRecognizer& Recognizer, bool isRHCasting, bool isLHCasting);
+
+	int32_t Num() const { return NumCasters; }
+	FCasterUpdate& Get(int32_t Index) { return Casters[Index]; }
+	const FCasterUpdate& Get(int32_t Index) const { return Casters[Index]; }
+
+	// Any thread - checks every sample of one caster, different casters can be checked at the same time
+	void EvaluateCaster(int32_t Index);
+
+	// Checks every caster - ParallelFor(Num, Body) must call Body(Index) once for every Index in [0, Num) and only return once all have
+	template <typename ParallelForType>
+	void Evaluate(ParallelForType&& ParallelFor) {
+		ParallelFor(NumCasters, [this](int32_t Index) { EvaluateCaster(Index); });
+	}
+
+	// Checks every caster on the calling thread
+	void Evaluate();
+
+private:
+	std::vector<FCasterUpdate> Casters{}; // Only the first NumCasters are in this frame's batch
+	int32_t NumCasters{ 0 };
+};
+
+} // namespace SpellRecognition
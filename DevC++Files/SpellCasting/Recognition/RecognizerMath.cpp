@@ -0,0 +1,473 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "RecognizerMath.h"
+
+#include <algorithm>
+
+namespace SpellRecognition {
+
+// Checks if a position is within tolerance +/- of another position
+// Ignores axes where tolerance.axis == 0
+bool PointEqual(const FVec3& posToCheck, const FVec3& refPos, const FVec3& posTolerance) {
+	FVec3 RelativePos{ posToCheck - refPos };
+
+	if (posTolerance.X != 0) {
+		if (RelativePos.X > posTolerance.X || RelativePos.X < -posTolerance.X) { // If relative X position is too far away
+			return false;
+		}
+	}
+	if (posTolerance.Y != 0) {
+		if (RelativePos.Y > posTolerance.Y || RelativePos.Y < -posTolerance.Y) { // If relative Y position is too far away
+			return false;
+		}
+	}
+	if (posTolerance.Z != 0) {
+		if (RelativePos.Z > posTolerance.Z || RelativePos.Z < -posTolerance.Z) { // If relative Z position is too far away
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Checks if a rotation is within tolerance +/- of another rotation
+// Ignores axes where tolerance.axis == 0
+bool PointEqual(const FRot3& rotToCheck, const FRot3& refRot, const FRot3& rotTolerance) {
+	
+	FRot3 RelativeRot{ rotToCheck - refRot };
+
+	// The actual check
+	if (rotTolerance.Pitch != 0) {
+		if (RelativeRot.Pitch > rotTolerance.Pitch || RelativeRot.Pitch < -rotTolerance.Pitch) { // If relative Pitch position is too far away
+			//UE_LOG(LogTemp, Error, TEXT("\nPoint pitch tolerance failed!\n     Pitch to check: %f\n     Ref Pitch: %f\n     Tolerance: %f"), rotToCheck.Pitch, refRot.Pitch, rotTolerance.Pitch)
+			return false;
+		}
+	}
+	if (rotTolerance.Yaw != 0) {
+		if (RelativeRot.Yaw > rotTolerance.Yaw || RelativeRot.Yaw < -rotTolerance.Yaw) { // If relative Yaw position is too far away
+			//UE_LOG(LogTemp, Error, TEXT("\nPoint yaw tolerance failed!\n     yaw to check: %f\n     Ref yaw: %f\n     Tolerance: %f"), rotToCheck.Yaw, refRot.Yaw, rotTolerance.Yaw)
+			return false;
+		}
+	}
+	if (rotTolerance.Roll != 0) {
+		if (RelativeRot.Roll > rotTolerance.Roll || RelativeRot.Roll < -rotTolerance.Roll) { // If relative Roll position is too far away
+			//UE_LOG(LogTemp, Error, TEXT("\nPoint Roll tolerance failed!\n     Roll to check: %f\n     Ref Roll: %f\n     Tolerance: %f"), rotToCheck.Roll, refRot.Roll, rotTolerance.Roll)
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Checks if two floats are within tolerance of each other
+bool PointEqual(float PointToCheck, float refPoint, float PointTolerance) {
+	if (PointToCheck > refPoint + PointTolerance ||
+		PointToCheck < refPoint - PointTolerance) {
+		return false;
+	}
+	return true;
+}
+
+// Checks if RotToCheck is within the bounds created by StartRot and EndRot and tolerance
+bool RotationMoveInTolerance(const FRot3& RotToCheck, const FRot3& StartRot, const FRot3& EndRot, const FRot3& RotTolerance) {
+	// Pivot Check (twist your wrist)
+	FRot3 MinRot{};
+	FRot3 MaxRot{};
+	FRot3 PointRelativeRot{ EndRot - StartRot };
+
+	// Check tolerance for each axis
+	if (RotTolerance.Pitch != 0) { // If pitch axis needs checking
+		if (PointRelativeRot.Pitch == 0) { // If there is no movement from A->B in pitch axis
+			MinRot.Pitch = StartRot.Pitch - RotTolerance.Pitch;
+			MaxRot.Pitch = StartRot.Pitch + RotTolerance.Pitch;
+		}
+		else { // If there is movement from point a -> point b in pitch axis
+			if (PointRelativeRot.Pitch < 0) {
+				MinRot.Pitch = EndRot.Pitch - RotTolerance.Pitch;
+				MaxRot.Pitch = StartRot.Pitch + RotTolerance.Pitch;
+			}
+			else { // PointRelativeRot.Pitch > 0
+				MinRot.Pitch = StartRot.Pitch - RotTolerance.Pitch;
+				MaxRot.Pitch = EndRot.Pitch + RotTolerance.Pitch;
+			}
+		}
+		// Return false if out of bounds
+		if (RotToCheck.Pitch < MinRot.Pitch || RotToCheck.Pitch > MaxRot.Pitch) {
+			//UE_LOG(LogTemp, Error, TEXT("Pitch motion rot (%f) out of bounds\n     Min allowed: %f\n     Max allowed: %f"), RotToCheck.Pitch, MinRot.Pitch, MaxRot.Pitch);
+			return false;
+		}
+	}
+
+	if (RotTolerance.Yaw != 0) { // If yaw axis needs checking
+		if (PointRelativeRot.Yaw == 0) { // If there is no movement from A->B in yaw axis
+			MinRot.Yaw = StartRot.Yaw - RotTolerance.Yaw;
+			MaxRot.Yaw = StartRot.Yaw + RotTolerance.Yaw;
+		}
+		else { // If there is movement from point a -> point b in yaw axis
+			if (PointRelativeRot.Yaw < 0) {
+				MinRot.Yaw = EndRot.Yaw - RotTolerance.Yaw;
+				MaxRot.Yaw = StartRot.Yaw + RotTolerance.Yaw;
+			}
+			else { // PointRelativeRot.Yaw > 0
+				MinRot.Yaw = StartRot.Yaw - RotTolerance.Yaw;
+				MaxRot.Yaw = EndRot.Yaw + RotTolerance.Yaw;
+			}
+		}
+		// Return false if out of bounds
+		if (RotToCheck.Yaw < MinRot.Yaw || RotToCheck.Yaw > MaxRot.Yaw) {
+			//UE_LOG(LogTemp, Error, TEXT("Yaw motion rot (%f) out of bounds\n     Min allowed: %f\n     Max allowed: %f"), RotToCheck.Yaw, MinRot.Yaw, MaxRot.Yaw);
+			return false;
+		}
+	}
+
+	if (RotTolerance.Roll != 0) { // If Roll axis needs checking
+		if (PointRelativeRot.Roll == 0) { // If there is no movement from A->B in Roll axis
+			MinRot.Roll = StartRot.Roll - RotTolerance.Roll;
+			MaxRot.Roll = StartRot.Roll + RotTolerance.Roll;
+		}
+		else { // If there is movement from point a -> point b in Roll axis
+			if (PointRelativeRot.Roll < 0) {
+				MinRot.Roll = EndRot.Roll - RotTolerance.Roll;
+				MaxRot.Roll = StartRot.Roll + RotTolerance.Roll;
+			}
+			else { // PointRelativeRot.Roll > 0
+				MinRot.Roll = StartRot.Roll - RotTolerance.Roll;
+				MaxRot.Roll = EndRot.Roll + RotTolerance.Roll;
+			}
+		}
+
+		// Return false if out of bounds
+		if (RotToCheck.Roll < MinRot.Roll || RotToCheck.Roll > MaxRot.Roll) {
+			//UE_LOG(LogTemp, Error, TEXT("Roll motion rot (%f) out of bounds\n     Min allowed: %f\n     Max allowed: %f"), RotToCheck.Roll, MinRot.Roll, MaxRot.Roll);
+			return false;
+		}
+	}
+
+	return true; // passed all rotational movement checks
+}
+
+// Checks if a position is within the bounds created by start pos, end pos and tolerance
+// All passed in values must be in unit co-ordinates (ie (worldsize/scale))
+bool LineMoveInTolerance(const FVec3& PosToCheck, const FVec3& StartPos, const FVec3& EndPos, const FVec3& PosTolerance) {
+	/* This function performs the following logic:
+	* For every axis where tolerance != 0:
+	*	Where it is the only axis that changes from a->b check it is in tolerance
+	*	If it moves along with one other axis check that the relative movement of both of these is in tolerance (i.e. DeltaX = 3, DeltaY = 5)
+	*/
+
+	FVec3 DeltaPos{ EndPos - StartPos }; // The required motion in unit space from startpos
+	FVec3 RelativePos{ PosToCheck - StartPos }; // Relative position in grid space from strartpos
+	
+	FVec3 MinPos{ ((StartPos.X < EndPos.X) ? StartPos.X : EndPos.X) - PosTolerance.X,
+					((StartPos.Y < EndPos.Y) ? StartPos.Y : EndPos.Y) - PosTolerance.Y,
+					((StartPos.Z < EndPos.Z) ? StartPos.Z : EndPos.Z) - PosTolerance.Z };
+	FVec3 MaxPos{ ((StartPos.X > EndPos.X) ? StartPos.X : EndPos.X) + PosTolerance.X,
+					((StartPos.Y > EndPos.Y) ? StartPos.Y : EndPos.Y) + PosTolerance.Y,
+					((StartPos.Z > EndPos.Z) ? StartPos.Z : EndPos.Z) + PosTolerance.Z };
+
+	if (PosTolerance.X != 0) { // If x axis needs checking
+		if (DeltaPos.X == 0) { // If x value does not change during movement
+			if (!PointEqual(PosToCheck.X, StartPos.X, PosTolerance.X)) { // If the tolerance check failes
+				//UE_LOG(LogTemp, Error, TEXT("X Move Point Fail"));
+				return false;
+			}
+		}
+		else { // if X does change, check if any other axis is moving - NOTE: Spell setup states that a maximum of two axes will be moving - therefore no further checks are needed for all three
+			if (PosTolerance.Y != 0 && DeltaPos.Y != 0) { // if the other moving axis is Y axis
+				// If width out of tolerance
+				if (!DiagonalMoveInTolerance(RelativePos.X, RelativePos.Y, MakeLineSegment(DeltaPos.X, DeltaPos.Y), (PosTolerance.X == 0) ? PosTolerance.Y : PosTolerance.X)) {
+					//UE_LOG(LogTemp, Error, TEXT("XY Move Diag Fail\n     RelativePos: %s\n     Delta Pos: %s"), *RelativePos.ToString(), *DeltaPos.ToString());
+					return false;
+				}
+				// If length out of tolerance
+				if (PosToCheck.Y > MaxPos.Y || PosToCheck.Y < MinPos.Y || PosToCheck.X > MaxPos.X || PosToCheck.X < MinPos.X) {
+					//UE_LOG(LogTemp, Error, TEXT("XY Move Diag Length Fail"));
+					return false;
+				}
+			}
+			else if (PosTolerance.Z != 0 && DeltaPos.Z != 0) { // if the other moving axis is Z axis
+				// If width out of tolerance
+				if (!DiagonalMoveInTolerance(RelativePos.X, RelativePos.Z, MakeLineSegment(DeltaPos.X, DeltaPos.Z), (PosTolerance.X == 0) ? PosTolerance.Z : PosTolerance.X)) {
+					//UE_LOG(LogTemp, Error, TEXT("XZ Move Diag Fail"));
+					return false;
+				}
+				// If length out of tolerance
+				if (PosToCheck.Z > MaxPos.Z || PosToCheck.Z < MinPos.Z || PosToCheck.X > MaxPos.X || PosToCheck.X < MinPos.X) {
+					//UE_LOG(LogTemp, Error, TEXT("XZ Move Diag Length Fail\n     RelativePos: %s\n     Delta Pos: %s"), *RelativePos.ToString(), *DeltaPos.ToString());
+					return false;
+				}
+			}
+			else { // if X is the only moving axis - check that movement is not outside max/min
+				if (PosToCheck.X < MinPos.X || PosToCheck.X > MaxPos.X) {
+					//UE_LOG(LogTemp, Error, TEXT("X Move Straight Length Fail"));
+					return false;
+				}
+			}
+		}
+	}
+
+	if (PosTolerance.Y != 0) { // If Y axis needs checking - NOTE: X axis has been checked...
+		if (DeltaPos.Y == 0) { // If Y value does not change during movement
+			if (!PointEqual(PosToCheck.Y, StartPos.Y, PosTolerance.Y)) { // If the tolerance check failes
+				//UE_LOG(LogTemp, Error, TEXT("Y Move Point Fail"));
+				return false;
+			}
+		}
+		else { // Y does change
+			if (PosTolerance.Z != 0 && DeltaPos.Z != 0) { // if the other moving axis is Z (NOTE: X->Y has already been verified)
+				if (!DiagonalMoveInTolerance(RelativePos.Y, RelativePos.Z, MakeLineSegment(DeltaPos.Y, DeltaPos.Z), (PosTolerance.Y == 0) ? PosTolerance.Z : PosTolerance.Y)) {
+					//UE_LOG(LogTemp, Error, TEXT("YZ Move Diag Fail\n     RelativePos: %s\n     Delta Pos: %s"), *RelativePos.ToString(), *DeltaPos.ToString());
+					return false;
+				}
+				// If length out of tolerance
+				if (PosToCheck.Y > MaxPos.Y || PosToCheck.Y < MinPos.Y || PosToCheck.Z > MaxPos.Z || PosToCheck.Z < MinPos.Z) {
+					//UE_LOG(LogTemp, Error, TEXT("YZ Move Diag Length Fail"));
+					return false;
+				}
+			}
+			else if ((PosTolerance.X != 0 && DeltaPos.X == 0) || PosTolerance.X == 0) { // If Y is the only moving axis
+				if (PosToCheck.Y < MinPos.Y || PosToCheck.Y > MaxPos.Y) {
+					//UE_LOG(LogTemp, Error, TEXT("Y Move Straight Length Fail"));
+					return false;
+				}
+			}
+		}
+	}
+
+	if (PosTolerance.Z != 0) { // If Z axis needs checking - NOTE: X && Y have both been checked
+		if (DeltaPos.Z == 0) { // If Z value does not change during movement
+			if (!PointEqual(PosToCheck.Z, StartPos.Z, PosTolerance.Z)) { // If the tolerance check failes
+				//UE_LOG(LogTemp, Error, TEXT("Z Move Point Fail"));
+				return false;
+			}
+		}
+		else { // Z does change
+			// NOTE: X->Z && Y->Z have already been checked
+			if (((PosTolerance.X != 0 && DeltaPos.X == 0) || PosTolerance.X == 0) && 
+				((PosTolerance.Y != 0 && DeltaPos.Y == 0) || PosTolerance.Y == 0)) { // If Z is the only moving axis
+				if (PosToCheck.Z < MinPos.Z || PosToCheck.Z > MaxPos.Z) {
+					//UE_LOG(LogTemp, Error, TEXT("Z Move Straight Length Fail"));
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+// Direction and length of a line with the given deltas - a zero length line has no direction
+FLineSegment MakeLineSegment(float DeltaI, float DeltaJ) {
+	const float length{ std::sqrt((DeltaI * DeltaI) + (DeltaJ * DeltaJ)) };
+	if (length == 0) {
+		return FLineSegment{};
+	}
+	return FLineSegment{ DeltaI / length, DeltaJ / length, length };
+}
+
+// Part of LineMoveInTolerance()
+// No trig - the hand position is projected onto the line, which gives how far along it is and how far off to the side
+bool DiagonalMoveInTolerance(float iPos, float jPos, const FLineSegment& Segment, float WidthTolerance) {
+	const float along{ (iPos * Segment.DirI) + (jPos * Segment.DirJ) };
+	const float across{ (iPos * Segment.DirJ) - (jPos * Segment.DirI) };
+
+	// Off to the side of the line, or further than the width tolerance past either end
+	if (!PointEqual(across, 0.f, WidthTolerance) ||
+		along < -WidthTolerance || along > Segment.Length + WidthTolerance) {
+		return false;
+	}
+
+	return true;
+}
+
+// Checks if a position is within the bounds of a quarter circle from start pos to end pos
+// All passed in values must be in unit co-ordinates (ie (worldsize/scale))
+bool ArcMoveInTolerance(const FVec3& PosToCheck, const FVec3& StartPos, const FVec3& EndPos, const FVec3& PosTolerance, EMotion Arc) {
+	/* This function performs the following logic:
+	* The box around start pos and end pos is the quadrant of the circle the arc sweeps through - check it like a line's length
+	* Then check the distance from the centre of the circle is within tolerance of the radius
+	* No angles are needed - being in the right quadrant at the right distance is being on the arc
+	*/
+
+	const float pos[3]{ PosToCheck.X, PosToCheck.Y, PosToCheck.Z };
+	const float start[3]{ StartPos.X, StartPos.Y, StartPos.Z };
+	const float end[3]{ EndPos.X, EndPos.Y, EndPos.Z };
+	const float tolerance[3]{ PosTolerance.X, PosTolerance.Y, PosTolerance.Z };
+
+	for (int axis{ 0 }; axis < 3; axis++) {
+		if (tolerance[axis] != 0) { // If axis needs checking
+			const float minPos{ ((start[axis] < end[axis]) ? start[axis] : end[axis]) - tolerance[axis] };
+			const float maxPos{ ((start[axis] > end[axis]) ? start[axis] : end[axis]) + tolerance[axis] };
+			if (pos[axis] < minPos || pos[axis] > maxPos) {
+				return false;
+			}
+		}
+	}
+
+	// Width - the two moving axes, checked against the tighter of their tolerances
+	const FVec3 centre{ GetArcCentre(StartPos, EndPos, Arc) };
+	const float centrePos[3]{ centre.X, centre.Y, centre.Z };
+	float relativePos[2]{};
+	float width{ 0.f };
+	int planeAxis{ 0 };
+	for (int axis{ 0 }; axis < 3 && planeAxis < 2; axis++) {
+		if (start[axis] != end[axis]) {
+			relativePos[planeAxis++] = pos[axis] - centrePos[axis];
+			if (tolerance[axis] != 0) {
+				width = (width == 0 || tolerance[axis] < width) ? tolerance[axis] : width;
+			}
+		}
+	}
+	if (width == 0) { // Both moving axes are ignored
+		return true;
+	}
+
+	const float radius{ (StartPos - centre).GetAbsMax() }; // Start is on one axis from the centre
+	return CurveMoveInTolerance(relativePos[0], relativePos[1], radius, width);
+}
+
+// Part of ArcMoveInTolerance()
+bool CurveMoveInTolerance(float iPos, float jPos, float Radius, float WidthTolerance) {
+	float actRadius{ std::sqrt((iPos * iPos) + (jPos * jPos)) }; // Distance of hand from the centre of the circle
+	return PointEqual(actRadius, Radius, WidthTolerance);
+}
+
+// Arc1 sets off along its first moving axis, so the centre is level with the start on that axis and with the end on the second
+// Arc2 is the other way round
+FVec3 GetArcCentre(const FVec3& StartPos, const FVec3& EndPos, EMotion Arc) {
+	const float start[3]{ StartPos.X, StartPos.Y, StartPos.Z };
+	const float end[3]{ EndPos.X, EndPos.Y, EndPos.Z };
+	float centre[3]{ StartPos.X, StartPos.Y, StartPos.Z };
+
+	bool isFirstAxis{ true };
+	for (int axis{ 0 }; axis < 3; axis++) {
+		if (start[axis] != end[axis]) {
+			const bool isLevelWithEnd{ (Arc == EMotion::Arc1) != isFirstAxis };
+			centre[axis] = isLevelWithEnd ? end[axis] : start[axis];
+			isFirstAxis = false;
+		}
+	}
+	return FVec3{ centre[0], centre[1], centre[2] };
+}
+
+// The start and end are a quarter turn apart around the centre, so they make a ready made pair of axes for the circle
+FVec3 GetArcPosition(const FVec3& StartPos, const FVec3& EndPos, EMotion Arc, float Fraction) {
+	const FVec3 centre{ GetArcCentre(StartPos, EndPos, Arc) };
+	const float angle{ Fraction * 1.57079633f }; // Quarter turn in Rad
+	return centre + (StartPos - centre) * std::cos(angle) + (EndPos - centre) * std::sin(angle);
+}
+
+// Same maths as FRotator::Quaternion()
+FQuat4 ToQuat(const FRot3& Rotation) {
+	const float halfDegToRad{ 3.14159265f / 360.f };
+	const float SP{ std::sin(Rotation.Pitch * halfDegToRad) }, CP{ std::cos(Rotation.Pitch * halfDegToRad) };
+	const float SY{ std::sin(Rotation.Yaw * halfDegToRad) }, CY{ std::cos(Rotation.Yaw * halfDegToRad) };
+	const float SR{ std::sin(Rotation.Roll * halfDegToRad) }, CR{ std::cos(Rotation.Roll * halfDegToRad) };
+
+	return FQuat4{
+		CR * SP * SY - SR * CP * CY,
+		-CR * SP * CY - SR * CP * SY,
+		CR * CP * SY - SR * SP * CY,
+		CR * CP * CY + SR * SP * SY };
+}
+
+// Returns 1 / tan^2(half the tolerance), or 0 if the tolerance is ignored
+static float GetSwingTwistLimit(float Tolerance) {
+	if (Tolerance == 0) {
+		return 0.f;
+	}
+	const float tanHalf{ std::tan(Tolerance * 3.14159265f / 360.f) };
+	return 1.f / (tanHalf * tanHalf);
+}
+
+// Pitch swings around the keypoint's unrolled Y axis and yaw around its unrolled Z axis, but the relative rotation is worked
+// out in the keypoint's own (rolled) frame - so the pitch/yaw ellipse is turned by the keypoint's roll to line it up
+FSwingTwistLimits MakeStaticLimits(const FRot3& Rotation, const FRot3& RotTolerance) {
+	const float pitchLimit{ GetSwingTwistLimit(RotTolerance.Pitch) };
+	const float yawLimit{ GetSwingTwistLimit(RotTolerance.Yaw) };
+	const float rollCos{ std::cos(Rotation.Roll * 3.14159265f / 180.f) };
+	const float rollSin{ std::sin(Rotation.Roll * 3.14159265f / 180.f) };
+
+	FSwingTwistLimits limits{};
+	limits.SwingYY = pitchLimit * rollCos * rollCos + yawLimit * rollSin * rollSin;
+	limits.SwingYZ = 2.f * rollCos * rollSin * (pitchLimit - yawLimit);
+	limits.SwingZZ = pitchLimit * rollSin * rollSin + yawLimit * rollCos * rollCos;
+	limits.Twist = GetSwingTwistLimit(RotTolerance.Roll);
+	return limits;
+}
+
+// The roll changes along a lot of moves, which would turn the pitch/yaw ellipse as the hand goes - a circle does not need turning
+// NOTE: Like RotationMoveInTolerance()'s box this is looser than the keypoint checks, an ignored pitch or yaw ignores the whole swing
+FSwingTwistLimits MakeMoveLimits(const FRot3& RotTolerance) {
+	const bool isSwingIgnored{ RotTolerance.Pitch == 0 || RotTolerance.Yaw == 0 };
+	const float swingLimit{ isSwingIgnored ? 0.f : GetSwingTwistLimit(std::max(RotTolerance.Pitch, RotTolerance.Yaw)) };
+
+	FSwingTwistLimits limits{};
+	limits.SwingYY = swingLimit;
+	limits.SwingZZ = swingLimit;
+	limits.Twist = GetSwingTwistLimit(RotTolerance.Roll);
+	return limits;
+}
+
+FOrientationPath MakeOrientationPath(const FQuat4& StartOrientation, const FQuat4& EndOrientation) {
+	FOrientationPath path{};
+	path.Start = StartOrientation;
+	path.End = EndOrientation;
+
+	FQuat4 delta{ StartOrientation.Inverse() * EndOrientation };
+	if (delta.W < 0) { // Take the short way round
+		delta = -delta;
+		path.End = -EndOrientation;
+	}
+
+	const float deltaSin{ std::sqrt(delta.X * delta.X + delta.Y * delta.Y + delta.Z * delta.Z) };
+	if (deltaSin > 1.0e-6f) {
+		path.Path = StartOrientation * FQuat4{ delta.X / deltaSin, delta.Y / deltaSin, delta.Z / deltaSin, 0.f };
+		path.EndCos = std::min(delta.W, 1.f);
+		path.EndSin = deltaSin;
+	}
+	return path;
+}
+
+// Splits Relative into swing (turning the X axis) and twist (around the X axis), then checks both against the limits
+// Everything is squared and the same power of Relative on both sides, so its length and sign do not matter
+bool InSwingTwistLimits(const FQuat4& Relative, const FSwingTwistLimits& Limits) {
+	const float twistSq{ Relative.W * Relative.W + Relative.X * Relative.X };
+	const float swingY{ Relative.Y * Relative.W - Relative.Z * Relative.X };
+	const float swingZ{ Relative.Z * Relative.W + Relative.Y * Relative.X };
+
+	return Limits.SwingYY * swingY * swingY + Limits.SwingYZ * swingY * swingZ + Limits.SwingZZ * swingZ * swingZ <= twistSq * twistSq &&
+		Limits.Twist * Relative.X * Relative.X <= Relative.W * Relative.W;
+}
+
+// Checks if an orientation is within the swing/twist limits of another
+bool OrientationEqual(const FQuat4& OrientationToCheck, const FQuat4& RefOrientation, const FSwingTwistLimits& Limits) {
+	return InSwingTwistLimits(RefOrientation.Inverse() * OrientationToCheck, Limits);
+}
+
+// Checks if an orientation is within the swing/twist limits of the closest orientation on the path
+bool OrientationMoveInTolerance(const FQuat4& OrientationToCheck, const FOrientationPath& Path, const FSwingTwistLimits& Limits) {
+	/* This function performs the following logic:
+	* The path is an arc on the plane through Start and Path, so projecting onto that plane gives the closest orientation on it
+	* If the projection is not between Start and End (either sign, q and -q are the same rotation) the closest end is used instead
+	* The projection is not normalised - InSwingTwistLimits() does not care
+	*/
+	const float alongStart{ OrientationToCheck.Dot(Path.Start) };
+	const float alongPath{ OrientationToCheck.Dot(Path.Path) };
+
+	FQuat4 closest{};
+	if (alongPath * (alongStart * Path.EndSin - alongPath * Path.EndCos) > 0) { // Between Start and End
+		closest = FQuat4{
+			Path.Start.X * alongStart + Path.Path.X * alongPath,
+			Path.Start.Y * alongStart + Path.Path.Y * alongPath,
+			Path.Start.Z * alongStart + Path.Path.Z * alongPath,
+			Path.Start.W * alongStart + Path.Path.W * alongPath };
+	}
+	else {
+		closest = (std::fabs(alongStart) >= std::fabs(OrientationToCheck.Dot(Path.End))) ? Path.Start : Path.End;
+	}
+	return InSwingTwistLimits(closest.Inverse() * OrientationToCheck, Limits);
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,70 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* The maths brains of the spell recognizer - moved here from USpellComponent
+* All functions are stateless, so they can be called from anywhere (including other threads)
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+
+namespace SpellRecognition {
+
+// The I/J part of a line move - only depends on the keypoints, so work it out once and keep it (see FToleranceLanes)
+struct FLineSegment {
+	float DirI{ 0.f }; // Normalised direction
+	float DirJ{ 0.f };
+	float Length{ 0.f }; // Same units as the deltas it was made from
+};
+
+FLineSegment MakeLineSegment(float DeltaI, float DeltaJ);
+
+// Functions dealing with single points
+bool PointEqual(const FVec3& posToCheck, const FVec3& refPos, const FVec3& posTolerance);
+bool PointEqual(const FRot3& rotToCheck, const FRot3& refRot, const FRot3& rotTolerance);
+bool PointEqual(float PointToCheck, float refPoint, float PointTolerance);
+
+// Functions dealing with a movement from point A->B
+bool RotationMoveInTolerance(const FRot3& RotToCheck, const FRot3& StartRot, const FRot3& EndRot, const FRot3& RotTolerance); // NOTE: All units are Deg, there is no rotational scaling required
+bool LineMoveInTolerance(const FVec3& PosToCheck, const FVec3& StartPos, const FVec3& EndPos, const FVec3& PosTolerance); // NOTE: All values must be converted to the unit grid type (cannot be world size co-ordinates)
+bool DiagonalMoveInTolerance(float iPos, float jPos, const FLineSegment& Segment, float WidthTolerance); // Part of LineMoveInTolerance() - i/j are relative to the start, same units as the segment
+bool ArcMoveInTolerance(const FVec3& PosToCheck, const FVec3& StartPos, const FVec3& EndPos, const FVec3& PosTolerance, EMotion Arc); // NOTE: All values must be converted to the unit grid type (cannot be worldsize coordinates)
+bool CurveMoveInTolerance(float iPos, float jPos, float Radius, float WidthTolerance); // Part of ArcMoveInTolerance() - i/j are relative to the centre of the circle
+
+// Quaternion rotation checks - the alternative to the per axis Euler checks above (see FRecognizerSettings::isQuaternionRotation)
+// The hand's rotation relative to the keypoint is split into swing (where the hand points, i.e. pitch & yaw) and twist (roll around
+// where it points), so there is no +/-360 wraparound and nothing goes wrong near gimbal lock
+// All of the limits only depend on the keypoints, so they are worked out once - the checks themselves are a handful of multiply-adds
+struct FSwingTwistLimits {
+	// Swing must stay inside the ellipse SwingYY*y^2 + SwingYZ*y*z + SwingZZ*z^2 <= 1, y/z are the swing's axis scaled by tan(half the angle)
+	// The ellipse is the pitch & yaw tolerance turned by the keypoint's roll, 0 == ignored
+	float SwingYY{ 0.f };
+	float SwingYZ{ 0.f };
+	float SwingZZ{ 0.f };
+	float Twist{ 0.f }; // 1 / tan^2(half the roll tolerance), 0 == ignored
+};
+
+// Start to end of a rotation move - the shortest way round (slerp), stored as two orthogonal quaternions so no trig is needed to follow it
+// Every orientation on the path is Start * cos(a) + Path * sin(a) for 0 <= a <= the angle of End (half the rotation angle)
+struct FOrientationPath {
+	FQuat4 Start{};
+	FQuat4 Path{ 0.f, 0.f, 0.f, 0.f }; // 0 if Start and End are the same
+	FQuat4 End{}; // Same rotation as the end keypoint, sign picked to be on the short way round
+	float EndCos{ 1.f }; // cos/sin of the angle of End
+	float EndSin{ 0.f };
+};
+
+FQuat4 ToQuat(const FRot3& Rotation); // Same as FRotator::Quaternion() - uses trig, keep it out of per spell code
+FSwingTwistLimits MakeStaticLimits(const FRot3& Rotation, const FRot3& RotTolerance); // Keypoint complete checks
+FSwingTwistLimits MakeMoveLimits(const FRot3& RotTolerance); // Move checks - a circle as wide as the looser of pitch & yaw (see OrientationMoveInTolerance())
+FOrientationPath MakeOrientationPath(const FQuat4& StartOrientation, const FQuat4& EndOrientation);
+bool InSwingTwistLimits(const FQuat4& Relative, const FSwingTwistLimits& Limits); // Relative may be any length (it does not need normalising)
+bool OrientationEqual(const FQuat4& OrientationToCheck, const FQuat4& RefOrientation, const FSwingTwistLimits& Limits);
+bool OrientationMoveInTolerance(const FQuat4& OrientationToCheck, const FOrientationPath& Path, const FSwingTwistLimits& Limits);
+
+// Arc geometry - Arc is EMotion::Arc1 or Arc2, the move must follow the spellcrafting rules (see IsQuarterCircle())
+FVec3 GetArcCentre(const FVec3& StartPos, const FVec3& EndPos, EMotion Arc);
+FVec3 GetArcPosition(const FVec3& StartPos, const FVec3& EndPos, EMotion Arc, float Fraction); // Fraction 0 == StartPos, 1 == EndPos - uses trig, keep it out of per frame code
+
+} // namespace SpellRecognition
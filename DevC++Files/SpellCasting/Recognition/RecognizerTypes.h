@@ -0,0 +1,128 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Engine independent data types used by the spell recognizer
+* Nothing in the Recognition folder may include an Unreal header - this is what allows the recognizer to be
+* profiled, benchmarked and tested on any plain C++ box without booting the engine.
+* USpellComponent is responsible for converting Unreal types into these and back again.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+namespace SpellRecognition {
+
+// Plain 3D vector - same axis convention as FVector (X forward/backward, Y right/left, Z up/down)
+struct FVec3 {
+	float X{ 0.f };
+	float Y{ 0.f };
+	float Z{ 0.f };
+
+	FVec3 operator+(const FVec3& Other) const { return FVec3{ X + Other.X, Y + Other.Y, Z + Other.Z }; }
+	FVec3 operator-(const FVec3& Other) const { return FVec3{ X - Other.X, Y - Other.Y, Z - Other.Z }; }
+	FVec3 operator*(float Scale) const { return FVec3{ X * Scale, Y * Scale, Z * Scale }; }
+	FVec3 operator/(float Scale) const { return FVec3{ X / Scale, Y / Scale, Z / Scale }; }
+
+	// Same as FVector::GetAbsMax()
+	float GetAbsMax() const {
+		float Max{ std::fabs(X) };
+		Max = (std::fabs(Y) > Max) ? std::fabs(Y) : Max;
+		return (std::fabs(Z) > Max) ? std::fabs(Z) : Max;
+	}
+
+	float Size() const { return std::sqrt(X * X + Y * Y + Z * Z); }
+};
+
+// Plain rotator - all units are Deg, same convention as FRotator
+struct FRot3 {
+	float Pitch{ 0.f };
+	float Yaw{ 0.f };
+	float Roll{ 0.f };
+
+	FRot3 operator-(const FRot3& Other) const { return FRot3{ Pitch - Other.Pitch, Yaw - Other.Yaw, Roll - Other.Roll }; }
+};
+
+// Plain quaternion - same convention as FQuat, see ToQuat() in RecognizerMath.h for converting an FRot3
+struct FQuat4 {
+	float X{ 0.f };
+	float Y{ 0.f };
+	float Z{ 0.f };
+	float W{ 1.f };
+
+	// Same as FQuat - Other is applied first, then this
+	FQuat4 operator*(const FQuat4& Other) const {
+		return FQuat4{
+			W * Other.X + X * Other.W + Y * Other.Z - Z * Other.Y,
+			W * Other.Y - X * Other.Z + Y * Other.W + Z * Other.X,
+			W * Other.Z + X * Other.Y - Y * Other.X + Z * Other.W,
+			W * Other.W - X * Other.X - Y * Other.Y - Z * Other.Z };
+	}
+	FQuat4 operator-() const { return FQuat4{ -X, -Y, -Z, -W }; } // Same rotation
+
+	FQuat4 Inverse() const { return FQuat4{ -X, -Y, -Z, W }; } // Unit quaternions only
+	float Dot(const FQuat4& Other) const { return X * Other.X + Y * Other.Y + Z * Other.Z + W * Other.W; }
+};
+
+// Mirrors MoveType in SpellContainer.h
+enum class EMotion : uint8_t {
+	Point, // No movement between this keypoint and the previous
+	Line, // Straight line from the previous keypoint (MAX TWO AXES!)
+	// Quarter circle from the previous keypoint - EXACTLY TWO AXES, both moving the same distance (the radius)
+	// The two moving axes are taken in X, Y, Z order, e.g. for a YZ arc Y is the first axis and Z the second
+	Arc1, // Sets off along the first axis and curves round onto the second
+	Arc2 // Sets off along the second axis and curves round onto the first
+};
+
+constexpr bool IsArc(EMotion Motion) { return Motion == EMotion::Arc1 || Motion == EMotion::Arc2; }
+
+// Engine independent FKeyPoint - definition data only, no per-cast state
+struct FKeyPointDef {
+	FVec3 RHPosition{};
+	FRot3 RHRotation{};
+	FVec3 LHPosition{};
+	FRot3 LHRotation{};
+	EMotion Motion{ EMotion::Point };
+};
+
+// Most keypoints a spell may have - FSpellState counts them in a byte
+constexpr int32_t MaxKeyPoints{ 255 };
+
+// Spell IDs run from 0 to SpellIDCount - 1 (SpellID::None is SpellIDCount, see SpellContainer.cpp)
+// Every recognizer keeps rejection counters per ID, so the spell loaders reject IDs outside that range
+constexpr int32_t SpellIDCount{ 14 };
+
+// Engine independent FSpellData - definition data only, no per-cast state
+struct FSpellDef {
+	std::vector<FKeyPointDef> KeyPoints{};
+	FVec3 LtoRRelativeStartPos{}; // Required relative start direction from LH to RH at start of spell
+	FVec3 PositionalTolerance{}; // Set tolerance to 0 to ignore axis
+	FRot3 RotationalTolerance{}; // Set tolerance to 0 to ignore axis
+	int32_t ID{ -1 }; // Opaque to the recognizer apart from its range (see SpellIDCount) - USpellComponent stores SpellID here
+	bool isDualOnly{ true };
+};
+
+// One hand's transform in spellcasting grid space
+struct FHandPose {
+	FVec3 Position{};
+	FRot3 Rotation{};
+};
+
+enum class EHand : uint8_t {
+	Right,
+	Left
+};
+
+// Both hands sampled at the same moment, in spellcasting grid space
+struct FPoseSample {
+	FHandPose RH{};
+	FHandPose LH{};
+};
+
+// Values returned by FSpellRecognizer::GetActiveSpells() when there is not exactly one active spell
+constexpr int32_t NoSpell{ -1 };
+constexpr int32_t MultipleSpells{ -2 };
+
+} // namespace SpellRecognition
@@ -0,0 +1,81 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "RejectionCounters.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace SpellRecognition {
+
+static const char* RejectReasonNames[]{ "StartRotation", "StartPosition", "RelativeDirection", "LineWidth", "LineLength", "RotationMove" };
+static_assert(sizeof(RejectReasonNames) / sizeof(RejectReasonNames[0]) == FRejectionCounters::NumReasons, "Every ERejectReason needs a name");
+
+static const char* RejectHandNames[]{ "Right", "Left", "Both" };
+static_assert(sizeof(RejectHandNames) / sizeof(RejectHandNames[0]) == FRejectionCounters::NumHands, "Every ERejectHand needs a name");
+
+const char* GetRejectReasonName(ERejectReason Reason)
+{
+	return (Reason < ERejectReason::Num) ? RejectReasonNames[static_cast<int32_t>(Reason)] : "Unknown";
+}
+
+const char* GetRejectHandName(ERejectHand Hand)
+{
+	return (Hand < ERejectHand::Num) ? RejectHandNames[static_cast<int32_t>(Hand)] : "Unknown";
+}
+
+void FRejectionCounters::Reserve(int32_t MaxSpellID)
+{
+	if (MaxSpellID >= NumSpellIDs() && MaxSpellID < SpellIDCount) { // Out of range IDs are never counted (see Add())
+		Counts.resize(Slot(MaxSpellID + 1, ERejectHand::Right, ERejectReason::StartRotation), 0);
+	}
+}
+
+void FRejectionCounters::Reset()
+{
+	std::fill(Counts.begin(), Counts.end(), 0u);
+}
+
+uint32_t FRejectionCounters::GetTotal(int32_t SpellID) const
+{
+	uint32_t total{ 0 };
+	for (int32_t hand{ 0 }; hand < NumHands; hand++) {
+		for (int32_t reason{ 0 }; reason < NumReasons; reason++) {
+			total += Get(SpellID, static_cast<ERejectHand>(hand), static_cast<ERejectReason>(reason));
+		}
+	}
+	return total;
+}
+
+void WriteRejectionCounters(const FRejectionCounters& Counters, std::string& Out)
+{
+	Out += "SpellID,Hand";
+	for (const char* name : RejectReasonNames) {
+		Out += ',';
+		Out += name;
+	}
+	Out += '\n';
+
+	char number[16];
+	for (int32_t spellID{ 0 }; spellID < Counters.NumSpellIDs(); spellID++) {
+		for (int32_t hand{ 0 }; hand < FRejectionCounters::NumHands; hand++) {
+			std::string row{};
+			bool isRejected{ false };
+			for (int32_t reason{ 0 }; reason < FRejectionCounters::NumReasons; reason++) {
+				const uint32_t count{ Counters.Get(spellID, static_cast<ERejectHand>(hand), static_cast<ERejectReason>(reason)) };
+				std::snprintf(number, sizeof(number), ",%u", count);
+				row += number;
+				isRejected = isRejected || count > 0;
+			}
+			if (isRejected) {
+				std::snprintf(number, sizeof(number), "%d,", spellID);
+				Out += number;
+				Out += RejectHandNames[hand];
+				Out += row;
+				Out += '\n';
+			}
+		}
+	}
+}
+
+} // namespace SpellRecognition
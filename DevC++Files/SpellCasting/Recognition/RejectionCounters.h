@@ -0,0 +1,73 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Rejection counters - which check knocked which spell out, counted per SpellID and hand
+* FSpellRecognizer adds to them every time a spell's canCast goes false (always on - the reason is only worked out for the
+* spells that were rejected, never for the ones that pass), read them at runtime or dump them with WriteRejectionCounters()
+* NOTE: Counted by SpellID rather than spell order, so they carry on across SetSpells() (e.g. a spell hot reload)
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+
+#include <string>
+
+namespace SpellRecognition {
+
+enum class ERejectReason : uint8_t {
+	StartRotation, // SpellSetup() - hand rotation not in tolerance of keypoint 0 (includes spells the start pose index left out, see FStartPoseIndex::CountLeftOut())
+	StartPosition, // SpellSetup() - hand position not in tolerance of keypoint 0
+	RelativeDirection, // SpellSetup() - RH not above/in front of/next to LH as the spell requires (always counted against both hands)
+	LineWidth, // UpdateSpellStates() - hand strayed sideways off the line (or off a point keypoint or arc)
+	LineLength, // UpdateSpellStates() - hand went past either end of the line
+	RotationMove, // UpdateSpellStates() - hand rotation left the bounds of the move
+	Num
+};
+
+// EHand plus Both for the checks that need both hands
+enum class ERejectHand : uint8_t {
+	Right,
+	Left,
+	Both,
+	Num
+};
+
+inline ERejectHand ToRejectHand(EHand Hand) { return (Hand == EHand::Right) ? ERejectHand::Right : ERejectHand::Left; }
+
+const char* GetRejectReasonName(ERejectReason Reason);
+const char* GetRejectHandName(ERejectHand Hand);
+
+class FRejectionCounters {
+public:
+	static constexpr int32_t NumReasons{ static_cast<int32_t>(ERejectReason::Num) };
+	static constexpr int32_t NumHands{ static_cast<int32_t>(ERejectHand::Num) };
+
+	// Makes room for every SpellID up to MaxSpellID - existing counts are kept
+	void Reserve(int32_t MaxSpellID);
+	void Reset();
+
+	// SpellIDs that were never reserved (or are negative) are ignored
+	void Add(int32_t SpellID, ERejectHand Hand, ERejectReason Reason, uint32_t Count = 1) {
+		if (SpellID >= 0 && SpellID < NumSpellIDs()) Counts[Slot(SpellID, Hand, Reason)] += Count;
+	}
+
+	uint32_t Get(int32_t SpellID, ERejectHand Hand, ERejectReason Reason) const {
+		return (SpellID >= 0 && SpellID < NumSpellIDs()) ? Counts[Slot(SpellID, Hand, Reason)] : 0;
+	}
+	uint32_t GetTotal(int32_t SpellID) const; // Every hand and reason
+	int32_t NumSpellIDs() const { return static_cast<int32_t>(Counts.size()) / (NumHands * NumReasons); }
+
+private:
+	std::vector<uint32_t> Counts{}; // [SpellID][Hand][Reason]
+
+	static size_t Slot(int32_t SpellID, ERejectHand Hand, ERejectReason Reason) {
+		return (static_cast<size_t>(SpellID) * NumHands + static_cast<size_t>(Hand)) * NumReasons + static_cast<size_t>(Reason);
+	}
+};
+
+// Appends the counters to Out as csv - one row per SpellID and hand that has been rejected at least once:
+//	SpellID,Hand,StartRotation,StartPosition,RelativeDirection,LineWidth,LineLength,RotationMove
+void WriteRejectionCounters(const FRejectionCounters& Counters, std::string& Out);
+
+} // namespace SpellRecognition
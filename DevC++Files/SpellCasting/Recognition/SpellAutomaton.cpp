@@ -0,0 +1,68 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "SpellAutomaton.h"
+
+namespace SpellRecognition {
+
+static bool IsSameVec(const FVec3& A, const FVec3& B) {
+	return A.X == B.X && A.Y == B.Y && A.Z == B.Z;
+}
+
+static bool IsSameRot(const FRot3& A, const FRot3& B) {
+	return A.Pitch == B.Pitch && A.Yaw == B.Yaw && A.Roll == B.Roll;
+}
+
+// True if the tolerance checks could never tell keypoint kpID of the two spells apart (the keypoints before it are checked by the caller)
+static bool IsSameAutomatonKeyPoint(const FSpellDef& A, const FSpellDef& B, int kpID) {
+	const FKeyPointDef& kpA{ A.KeyPoints[kpID] };
+	const FKeyPointDef& kpB{ B.KeyPoints[kpID] };
+
+	return kpA.Motion == kpB.Motion &&
+		IsSameVec(kpA.RHPosition, kpB.RHPosition) && IsSameRot(kpA.RHRotation, kpB.RHRotation) &&
+		IsSameVec(kpA.LHPosition, kpB.LHPosition) && IsSameRot(kpA.LHRotation, kpB.LHRotation) &&
+		IsSameVec(A.PositionalTolerance, B.PositionalTolerance) && IsSameRot(A.RotationalTolerance, B.RotationalTolerance);
+}
+
+void FSpellAutomaton::Build(const std::vector<FSpellDef>& Spells)
+{
+	Nodes.clear();
+	Children.clear();
+	Roots.clear();
+	SpellNodes.clear();
+	FirstSpellNode.clear();
+
+	for (int32_t i{ 0 }; i < static_cast<int32_t>(Spells.size()); i++) {
+		FirstSpellNode.push_back(static_cast<int32_t>(SpellNodes.size()));
+
+		int32_t node{ -1 };
+		for (int kpID{ 0 }; kpID < static_cast<int>(Spells[i].KeyPoints.size()); kpID++) {
+			node = FindOrAddNode(Spells, node, i, kpID);
+			SpellNodes.push_back(node);
+		}
+	}
+
+	// Only needed to find shared nodes
+	Children.clear();
+	Roots.clear();
+}
+
+// Returns the child of Parent holding keypoint kpID of Spell, the node is added if no earlier spell has it
+int32_t FSpellAutomaton::FindOrAddNode(const std::vector<FSpellDef>& Spells, int32_t Parent, int32_t Spell, int kpID)
+{
+	std::vector<int32_t>& siblings{ (Parent < 0) ? Roots : Children[Parent] };
+	for (int32_t node : siblings) {
+		if (IsSameAutomatonKeyPoint(Spells[Nodes[node].Spell], Spells[Spell], kpID)) {
+			return node;
+		}
+	}
+
+	const int32_t newNode{ static_cast<int32_t>(Nodes.size()) };
+	Nodes.push_back(FNode{ Parent, Spell, kpID });
+	Children.emplace_back();
+	// NOTE: Children may have just been reallocated, so siblings cannot be used again
+	((Parent < 0) ? Roots : Children[Parent]).push_back(newNode);
+	return newNode;
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,49 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Spell automaton - the spell definitions merged into a prefix tree (trie) of keypoints
+* Spells that start with the same keypoints (e.g. Ball and Beam both start at a zero pose) share the same nodes,
+* so FSpellRecognizer only has to check each shared keypoint once per update, no matter how many spells are waiting on it
+*
+* A node is one keypoint of one or more spells, it is only shared if everything the tolerance checks use is the same:
+*	The keypoint and every keypoint before it (both hands and the motion type) AND the spell's positional and rotational tolerance
+* NOTE: Built once per FSpellSet (see SpellSet.h) and shared by every recognizer, nothing in here changes while casting
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+
+namespace SpellRecognition {
+
+class FSpellAutomaton {
+public:
+	// One keypoint shared by every spell whose definition passes through it
+	struct FNode {
+		int32_t Parent{ -1 }; // Node of the previous keypoint, -1 for keypoint 0
+		int32_t Spell{ -1 }; // First spell (in spell order) that passes through the node - the keypoint is read from it
+		int KeyPointID{ 0 }; // Depth of the node, i.e. which keypoint of Spell it is
+	};
+
+	// Rebuilds the automaton - must be called whenever the spell definitions change
+	void Build(const std::vector<FSpellDef>& Spells);
+
+	int32_t NumNodes() const { return static_cast<int32_t>(Nodes.size()); }
+	const FNode& GetNode(int32_t Node) const { return Nodes[Node]; }
+
+	// Returns the node Spell is at while it is working towards keypoint kpID
+	int32_t GetNodeID(int32_t Spell, int kpID) const { return SpellNodes[FirstSpellNode[Spell] + kpID]; }
+
+private:
+	std::vector<FNode> Nodes{};
+	std::vector<std::vector<int32_t>> Children{}; // Child nodes of each node, only used while building
+	std::vector<int32_t> Roots{}; // Keypoint 0 nodes, only used while building
+
+	// Path of every spell through the automaton, one node per keypoint
+	std::vector<int32_t> SpellNodes{};
+	std::vector<int32_t> FirstSpellNode{}; // Index into SpellNodes of each spell's keypoint 0
+
+	int32_t FindOrAddNode(const std::vector<FSpellDef>& Spells, int32_t Parent, int32_t Spell, int kpID);
+};
+
+} // namespace SpellRecognition
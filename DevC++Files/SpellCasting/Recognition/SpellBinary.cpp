@@ -0,0 +1,171 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "SpellBinary.h"
+#include "SpellTable.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace SpellRecognition {
+
+// The records are read in place, so their layout must never depend on the compiler
+static_assert(sizeof(FSpellBinaryHeader) == 16, "FSpellBinaryHeader must not be padded");
+static_assert(sizeof(FSpellBinaryRecord) == 52, "FSpellBinaryRecord must not be padded");
+static_assert(sizeof(FKeyPointBinaryRecord) == 52, "FKeyPointBinaryRecord must not be padded");
+static_assert(std::is_trivially_copyable<FSpellBinaryRecord>::value && std::is_trivially_copyable<FKeyPointBinaryRecord>::value, "Spell binary records must be plain data");
+
+static FVec3 BinaryToVec(const float (&Vec)[3]) {
+	return FVec3{ Vec[0], Vec[1], Vec[2] };
+}
+
+static FRot3 BinaryToRot(const float (&Rot)[3]) {
+	return FRot3{ Rot[0], Rot[1], Rot[2] };
+}
+
+static void VecToBinary(const FVec3& Vec, float (&Out)[3]) {
+	Out[0] = Vec.X;
+	Out[1] = Vec.Y;
+	Out[2] = Vec.Z;
+}
+
+static void RotToBinary(const FRot3& Rot, float (&Out)[3]) {
+	Out[0] = Rot.Pitch;
+	Out[1] = Rot.Yaw;
+	Out[2] = Rot.Roll;
+}
+
+bool FSpellBinaryView::Init(const void* Data, size_t Size)
+{
+	Spells = nullptr;
+	KeyPoints = nullptr;
+	SpellCount = 0;
+
+	if (Data == nullptr || Size < sizeof(FSpellBinaryHeader) || reinterpret_cast<uintptr_t>(Data) % alignof(FSpellBinaryHeader) != 0) {
+		return false;
+	}
+	const FSpellBinaryHeader& header{ *static_cast<const FSpellBinaryHeader*>(Data) };
+	if (header.Magic != SpellBinaryMagic || header.Version != SpellBinaryVersion) {
+		return false;
+	}
+
+	// The file must be exactly the size the header says (checked in 64 bit so huge counts cannot wrap)
+	const uint64_t expectedSize{ sizeof(FSpellBinaryHeader) +
+		uint64_t{ header.SpellCount } * sizeof(FSpellBinaryRecord) +
+		uint64_t{ header.KeyPointCount } * sizeof(FKeyPointBinaryRecord) };
+	if (expectedSize != Size) {
+		return false;
+	}
+
+	const FSpellBinaryRecord* spells{ reinterpret_cast<const FSpellBinaryRecord*>(static_cast<const uint8_t*>(Data) + sizeof(FSpellBinaryHeader)) };
+	const FKeyPointBinaryRecord* keyPoints{ reinterpret_cast<const FKeyPointBinaryRecord*>(spells + header.SpellCount) };
+
+	// Every ID in range and used once - the recognizers size their rejection counters by it
+	bool isIDUsed[SpellIDCount]{};
+	for (uint32_t i{ 0 }; i < header.SpellCount; i++) {
+		const FSpellBinaryRecord& spell{ spells[i] };
+		if (spell.FirstKeyPoint > header.KeyPointCount || spell.NumKeyPoints > header.KeyPointCount - spell.FirstKeyPoint ||
+			spell.NumKeyPoints > static_cast<uint32_t>(MaxKeyPoints) || spell.isDualOnly > 1 || !IsValidSpellID(spell.ID) || isIDUsed[spell.ID]) {
+			return false;
+		}
+		isIDUsed[spell.ID] = true;
+		for (uint32_t kpID{ 0 }; kpID < spell.NumKeyPoints; kpID++) {
+			if (keyPoints[spell.FirstKeyPoint + kpID].Motion > static_cast<uint32_t>(EMotion::Arc2)) {
+				return false;
+			}
+		}
+	}
+
+	Spells = spells;
+	KeyPoints = keyPoints;
+	SpellCount = static_cast<int32_t>(header.SpellCount);
+	return true;
+}
+
+FSpellDef FSpellBinaryView::MakeSpellDef(int32_t Index) const
+{
+	const FSpellBinaryRecord& spell{ Spells[Index] };
+
+	FSpellDef Def{};
+	Def.KeyPoints.reserve(spell.NumKeyPoints);
+	for (uint32_t kpID{ 0 }; kpID < spell.NumKeyPoints; kpID++) {
+		const FKeyPointBinaryRecord& kp{ KeyPoints[spell.FirstKeyPoint + kpID] };
+		Def.KeyPoints.push_back(FKeyPointDef{
+			BinaryToVec(kp.RHPosition),
+			BinaryToRot(kp.RHRotation),
+			BinaryToVec(kp.LHPosition),
+			BinaryToRot(kp.LHRotation),
+			static_cast<EMotion>(kp.Motion)
+		});
+	}
+	Def.LtoRRelativeStartPos = BinaryToVec(spell.LtoRRelativeStartPos);
+	Def.PositionalTolerance = BinaryToVec(spell.PositionalTolerance);
+	Def.RotationalTolerance = BinaryToRot(spell.RotationalTolerance);
+	Def.ID = spell.ID;
+	Def.isDualOnly = spell.isDualOnly != 0;
+	return Def;
+}
+
+void WriteSpellBinary(const std::vector<FSpellDef>& Spells, std::vector<uint8_t>& Out)
+{
+	FSpellBinaryHeader header{};
+	header.Magic = SpellBinaryMagic;
+	header.Version = SpellBinaryVersion;
+	header.SpellCount = static_cast<uint32_t>(Spells.size());
+	header.KeyPointCount = 0;
+
+	std::vector<FSpellBinaryRecord> spells(Spells.size());
+	std::vector<FKeyPointBinaryRecord> keyPoints{};
+	for (size_t i{ 0 }; i < Spells.size(); i++) {
+		const FSpellDef& spell{ Spells[i] };
+		FSpellBinaryRecord& record{ spells[i] };
+
+		record.FirstKeyPoint = header.KeyPointCount;
+		record.NumKeyPoints = static_cast<uint32_t>(spell.KeyPoints.size());
+		VecToBinary(spell.LtoRRelativeStartPos, record.LtoRRelativeStartPos);
+		VecToBinary(spell.PositionalTolerance, record.PositionalTolerance);
+		RotToBinary(spell.RotationalTolerance, record.RotationalTolerance);
+		record.ID = spell.ID;
+		record.isDualOnly = spell.isDualOnly ? 1 : 0;
+
+		for (const FKeyPointDef& kp : spell.KeyPoints) {
+			FKeyPointBinaryRecord kpRecord{};
+			VecToBinary(kp.RHPosition, kpRecord.RHPosition);
+			RotToBinary(kp.RHRotation, kpRecord.RHRotation);
+			VecToBinary(kp.LHPosition, kpRecord.LHPosition);
+			RotToBinary(kp.LHRotation, kpRecord.LHRotation);
+			kpRecord.Motion = static_cast<uint32_t>(kp.Motion);
+			keyPoints.push_back(kpRecord);
+		}
+		header.KeyPointCount += record.NumKeyPoints;
+	}
+
+	const size_t spellBytes{ spells.size() * sizeof(FSpellBinaryRecord) };
+	const size_t keyPointBytes{ keyPoints.size() * sizeof(FKeyPointBinaryRecord) };
+	Out.resize(sizeof(FSpellBinaryHeader) + spellBytes + keyPointBytes);
+	std::memcpy(Out.data(), &header, sizeof(FSpellBinaryHeader));
+	if (spellBytes > 0) std::memcpy(Out.data() + sizeof(FSpellBinaryHeader), spells.data(), spellBytes);
+	if (keyPointBytes > 0) std::memcpy(Out.data() + sizeof(FSpellBinaryHeader) + spellBytes, keyPoints.data(), keyPointBytes);
+}
+
+bool LoadSpellBinary(const void* Data, size_t Size, std::vector<FSpellDef>& OutSpells)
+{
+	FSpellBinaryView view{};
+	if (!view.Init(Data, Size)) {
+		return false;
+	}
+
+	std::vector<FSpellDef> spells{};
+	spells.reserve(view.NumSpells());
+	for (int32_t i{ 0 }; i < view.NumSpells(); i++) {
+		spells.push_back(view.MakeSpellDef(i));
+		if (!IsValidSpell(spells.back())) {
+			return false;
+		}
+	}
+
+	OutSpells.swap(spells);
+	return true;
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,78 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Spell binary format - flat, versioned spell definitions that are used straight from a memory mapped file (no parsing)
+* Written by Tools/SpellBinaryConverter (text -> binary), loaded by USpellContainer's hot reload
+*
+* Layout - every field is 4 bytes, little endian, no padding:
+*	FSpellBinaryHeader
+*	FSpellBinaryRecord[SpellCount]
+*	FKeyPointBinaryRecord[KeyPointCount] - the keypoints of every spell, in spell order
+* NOTE: Bump SpellBinaryVersion whenever a record changes - files of any other version are rejected
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+
+#include <cstddef>
+
+namespace SpellRecognition {
+
+constexpr uint32_t SpellBinaryMagic{ 0x424C5053 }; // "SPLB" when read as bytes
+constexpr uint32_t SpellBinaryVersion{ 1 };
+
+struct FSpellBinaryHeader {
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t SpellCount;
+	uint32_t KeyPointCount;
+};
+
+struct FSpellBinaryRecord {
+	uint32_t FirstKeyPoint; // Index of keypoint 0 in the keypoint records
+	uint32_t NumKeyPoints;
+	float LtoRRelativeStartPos[3];
+	float PositionalTolerance[3];
+	float RotationalTolerance[3]; // Pitch, Yaw, Roll
+	int32_t ID;
+	uint32_t isDualOnly; // 0 or 1
+};
+
+struct FKeyPointBinaryRecord {
+	float RHPosition[3];
+	float RHRotation[3]; // Pitch, Yaw, Roll
+	float LHPosition[3];
+	float LHRotation[3];
+	uint32_t Motion; // EMotion
+};
+
+// Read only view of a spell binary - the records are read where they are, nothing is copied
+class FSpellBinaryView {
+public:
+	// Points the view at a spell binary - returns false (and leaves the view empty) if Data is not a complete spell binary of this version,
+	// or any spell ID is out of range (see SpellIDCount) or used twice
+	// NOTE: Data must stay valid (and 4 byte aligned) for as long as the view is used
+	bool Init(const void* Data, size_t Size);
+
+	int32_t NumSpells() const { return SpellCount; }
+	const FSpellBinaryRecord& GetSpell(int32_t Index) const { return Spells[Index]; }
+	const FKeyPointBinaryRecord& GetKeyPoint(int32_t Index, int kpID) const { return KeyPoints[Spells[Index].FirstKeyPoint + kpID]; }
+
+	// Copies spell Index into a recognizer definition
+	FSpellDef MakeSpellDef(int32_t Index) const;
+
+private:
+	const FSpellBinaryRecord* Spells{ nullptr };
+	const FKeyPointBinaryRecord* KeyPoints{ nullptr };
+	int32_t SpellCount{ 0 };
+};
+
+// Replaces Out with the binary version of Spells
+void WriteSpellBinary(const std::vector<FSpellDef>& Spells, std::vector<uint8_t>& Out);
+
+// Fills OutSpells from a spell binary - returns false if the binary is invalid or any spell breaks the spellcrafting rules
+// NOTE: OutSpells is only changed if the whole binary is valid, so a bad file never replaces good spells
+bool LoadSpellBinary(const void* Data, size_t Size, std::vector<FSpellDef>& OutSpells);
+
+} // namespace SpellRecognition
@@ -0,0 +1,719 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "SpellRecognizer.h"
+#include "RecognizerMath.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace SpellRecognition {
+
+FSpellRecognizer::FSpellRecognizer(FSharedSpellSet NewSpellSet, const FRecognizerSettings& NewSettings)
+	: Settings{ NewSettings }
+{
+	SetSpells(std::move(NewSpellSet));
+}
+
+FSpellRecognizer::FSpellRecognizer(std::vector<FSpellDef> SpellDefs, const FRecognizerSettings& NewSettings)
+	: Settings{ NewSettings }
+{
+	SetSpells(std::move(SpellDefs));
+}
+
+void FSpellRecognizer::SetSpells(FSharedSpellSet NewSpellSet)
+{
+	FlushStartIndexRejections(); // The bucket keys belong to the old spells
+	SpellSet = NewSpellSet ? std::move(NewSpellSet) : GetEmptySpellSet();
+	States.assign(static_cast<size_t>(Num()), FSpellState{});
+	for (const FSpellDef& spell : SpellSet->GetSpells()) {
+		Rejections.Reserve(spell.ID);
+	}
+	StartIndexMisses.assign(static_cast<size_t>(SpellSet->GetStartIndex().NumBucketKeys()), 0);
+	ResetLanes();
+	ResetStates();
+}
+
+void FSpellRecognizer::SetSpells(std::vector<FSpellDef> SpellDefs)
+{
+	SetSpells(MakeSpellSet(std::move(SpellDefs)));
+}
+
+void FSpellRecognizer::SetSettings(const FRecognizerSettings& NewSettings)
+{
+	Settings = NewSettings;
+	ResetLanes(); // Lane tolerances depend on MaxMoveTolerance
+}
+
+// Works out everything about the pose that does not depend on the spell being checked
+FPoseSnapshot FSpellRecognizer::MakeSnapshot(const FPoseSample& Pose, bool isRHCasting, bool isLHCasting) const
+{
+	FPoseSnapshot snapshot{};
+	snapshot.Pose = Pose;
+	snapshot.RHRelativePos = Pose.RH.Position - RHStartPos;
+	snapshot.LHRelativePos = Pose.LH.Position - LHStartPos;
+	snapshot.RHPrevRelativePos = snapshot.RHRelativePos;
+	snapshot.LHPrevRelativePos = snapshot.LHRelativePos;
+	snapshot.isRHCasting = isRHCasting;
+	snapshot.isLHCasting = isLHCasting;
+	if (Settings.isQuaternionRotation) {
+		snapshot.RHOrientation = ToQuat(Pose.RH.Rotation);
+		snapshot.LHOrientation = ToQuat(Pose.LH.Rotation);
+	}
+
+	// Check if one axis' movement in relevant hands is above the current scale - used by UpdateSpellScale()
+	if (isLHCasting) {
+		snapshot.MaxMoveFromStart = snapshot.LHRelativePos.GetAbsMax();
+	}
+	if (isRHCasting) {
+		const float RHMaxMove{ snapshot.RHRelativePos.GetAbsMax() };
+		snapshot.MaxMoveFromStart = (RHMaxMove > snapshot.MaxMoveFromStart) ? RHMaxMove : snapshot.MaxMoveFromStart;
+	}
+	return snapshot;
+}
+
+// Reset all spell complete states to start settings
+void FSpellRecognizer::ResetStates()
+{
+	isCommitted = false;
+	Candidates.clear();
+	for (int32_t i{ 0 }; i < Num(); i++) {
+		ResetState(i);
+		Candidates.push_back(i);
+	}
+}
+
+void FSpellRecognizer::ResetState(int32_t Index)
+{
+	FSpellState& state{ States[Index] };
+	state.canCast = true;
+	state.isScaleSet = false;
+	state.Scale = Settings.MinMoveScale;
+	state.RHNextPointID = 0;
+	state.LHNextPointID = 0;
+	state.RHCompleteCount = 0;
+	state.LHCompleteCount = 0;
+}
+
+// Fills every automaton node lane with its keypoint, the spell lanes are filled in again as keypoints are needed
+void FSpellRecognizer::ResetLanes()
+{
+	const FSpellAutomaton& automaton{ SpellSet->GetAutomaton() };
+	const int32_t nodeCount{ automaton.NumNodes() };
+	const int32_t laneCount{ nodeCount + Num() };
+	for (FHandLanes& hand : HandLanes) {
+		hand.Lanes.isQuaternionRotation = Settings.isQuaternionRotation;
+		hand.Lanes.Resize(laneCount);
+		hand.LaneIDs.assign(static_cast<size_t>(Num()), 0);
+		hand.LiveMask.assign(ToleranceMaskWords(laneCount), 0);
+		hand.StaticMask.assign(ToleranceMaskWords(laneCount), 0);
+		hand.MoveMask.assign(ToleranceMaskWords(laneCount), 0);
+	}
+	for (int32_t node{ 0 }; node < nodeCount; node++) {
+		const FSpellAutomaton::FNode& nodeDef{ automaton.GetNode(node) };
+		GetHandLanes<EHand::Right>().Lanes.SetKeyPoint(node, SpellSet->GetSpell(nodeDef.Spell), nodeDef.KeyPointID, EHand::Right, Settings.MaxMoveTolerance);
+		GetHandLanes<EHand::Left>().Lanes.SetKeyPoint(node, SpellSet->GetSpell(nodeDef.Spell), nodeDef.KeyPointID, EHand::Left, Settings.MaxMoveTolerance);
+	}
+}
+
+void FSpellRecognizer::ClearLiveMasks()
+{
+	for (FHandLanes& hand : HandLanes) {
+		std::fill(hand.LiveMask.begin(), hand.LiveMask.end(), uint64_t{ 0 });
+	}
+}
+
+// Removes every spell that can no longer be cast from Candidates
+// NOTE: Keeps the spell order, so the first spell to complete still wins when more than one completes on the same update
+void FSpellRecognizer::UpdateCandidates()
+{
+	Candidates.erase(std::remove_if(Candidates.begin(), Candidates.end(), [this](int32_t i) { return !States[i].canCast; }), Candidates.end());
+}
+
+// If only one spell canCast returns that spell, otherwise returns MultipleSpells
+// Returns NoSpell if no spell can be cast
+int32_t FSpellRecognizer::GetActiveSpells() const
+{
+	if (Candidates.empty()) {
+		return NoSpell;
+	}
+	return (Candidates.size() > 1) ? MultipleSpells : SpellSet->GetSpell(Candidates[0]).ID;
+}
+
+// Everything that differs between the hands - picked at compile time by the per hand templates below
+template<EHand Hand>
+struct THandTraits;
+
+template<>
+struct THandTraits<EHand::Right> {
+	static constexpr ERejectHand RejectHand() { return ERejectHand::Right; }
+	static uint8_t& CompleteCount(FSpellState& State) { return State.RHCompleteCount; }
+	static uint8_t CompleteCount(const FSpellState& State) { return State.RHCompleteCount; }
+	static uint8_t NextPointID(const FSpellState& State) { return State.RHNextPointID; }
+	static const FHandPose& GetPose(const FPoseSample& Pose) { return Pose.RH; }
+	static const FVec3& GetRelativePos(const FPoseSnapshot& Snapshot) { return Snapshot.RHRelativePos; }
+	static const FVec3& GetPrevRelativePos(const FPoseSnapshot& Snapshot) { return Snapshot.RHPrevRelativePos; }
+	static const FQuat4& GetOrientation(const FPoseSnapshot& Snapshot) { return Snapshot.RHOrientation; }
+	static const FVec3& GetPosition(const FKeyPointDef& KeyPoint) { return KeyPoint.RHPosition; }
+	static const FRot3& GetRotation(const FKeyPointDef& KeyPoint) { return KeyPoint.RHRotation; }
+	static const FQuat4& GetOrientation(const FKeyPointOrientation& Orientation) { return Orientation.RHOrientation; }
+	static const FSwingTwistLimits& GetLimits(const FKeyPointOrientation& Orientation) { return Orientation.RHLimits; }
+};
+
+template<>
+struct THandTraits<EHand::Left> {
+	static constexpr ERejectHand RejectHand() { return ERejectHand::Left; }
+	static uint8_t& CompleteCount(FSpellState& State) { return State.LHCompleteCount; }
+	static uint8_t CompleteCount(const FSpellState& State) { return State.LHCompleteCount; }
+	static uint8_t NextPointID(const FSpellState& State) { return State.LHNextPointID; }
+	static const FHandPose& GetPose(const FPoseSample& Pose) { return Pose.LH; }
+	static const FVec3& GetRelativePos(const FPoseSnapshot& Snapshot) { return Snapshot.LHRelativePos; }
+	static const FVec3& GetPrevRelativePos(const FPoseSnapshot& Snapshot) { return Snapshot.LHPrevRelativePos; }
+	static const FQuat4& GetOrientation(const FPoseSnapshot& Snapshot) { return Snapshot.LHOrientation; }
+	static const FVec3& GetPosition(const FKeyPointDef& KeyPoint) { return KeyPoint.LHPosition; }
+	static const FRot3& GetRotation(const FKeyPointDef& KeyPoint) { return KeyPoint.LHRotation; }
+	static const FQuat4& GetOrientation(const FKeyPointOrientation& Orientation) { return Orientation.LHOrientation; }
+	static const FSwingTwistLimits& GetLimits(const FKeyPointOrientation& Orientation) { return Orientation.LHLimits; }
+};
+
+// Points the hand's lane for spell Index at keypoint kpID this update and marks it live
+// Spells at the same automaton node share the node's lane as long as they share a scale (they nearly always do - same keypoints, same scale updates)
+// NOTE: The spell lane only has to be refilled when its keypoint changes, most updates only touch the scale
+template<EHand Hand>
+void FSpellRecognizer::ClaimLane(int32_t Index, int kpID)
+{
+	FHandLanes& hand{ GetHandLanes<Hand>() };
+	const float scale{ States[Index].Scale };
+	const bool isScaleSet{ States[Index].isScaleSet };
+	const FSpellAutomaton& automaton{ SpellSet->GetAutomaton() };
+	int32_t lane{ automaton.GetNodeID(Index, kpID) };
+
+	if (IsLaneSet(hand.LiveMask.data(), lane)) {
+		if (hand.Lanes.HasScale(lane, scale, isScaleSet)) {
+			hand.LaneIDs[Index] = lane; // Already checked for an earlier candidate
+			return;
+		}
+		lane = automaton.NumNodes() + Index;
+		if (hand.Lanes.KeyPointID[lane] != kpID) {
+			hand.Lanes.SetKeyPoint(lane, SpellSet->GetSpell(Index), kpID, Hand, Settings.MaxMoveTolerance);
+		}
+	}
+	hand.Lanes.SetScale(lane, scale, isScaleSet);
+	SetLaneBit(hand.LiveMask.data(), lane);
+	hand.LaneIDs[Index] = lane;
+}
+
+// Checks the keypoint of every live lane at once - sets the lane's StaticMask bit if the hand is in tolerance
+// Swept from the previous sample if isSweptKeyPoints, so a keypoint the hand passed through between two samples still counts
+template<EHand Hand>
+void FSpellRecognizer::EvaluateStatic(const FPoseSnapshot& Snapshot)
+{
+	using Traits = THandTraits<Hand>;
+	FHandLanes& hand{ GetHandLanes<Hand>() };
+	if (Settings.isSweptKeyPoints) {
+		EvaluateSweptStaticTolerance(hand.Lanes, Traits::GetPrevRelativePos(Snapshot), Traits::GetRelativePos(Snapshot), Traits::GetPose(Snapshot.Pose).Rotation,
+			Traits::GetOrientation(Snapshot), hand.LiveMask.data(), hand.StaticMask.data());
+		return;
+	}
+	EvaluateStaticTolerance(hand.Lanes, Traits::GetRelativePos(Snapshot), Traits::GetPose(Snapshot.Pose).Rotation, Traits::GetOrientation(Snapshot),
+		hand.LiveMask.data(), hand.StaticMask.data());
+}
+
+// Checks the move to the keypoint of every live lane at once - sets the lane's MoveMask bit if the hand is still in tolerance
+template<EHand Hand>
+void FSpellRecognizer::EvaluateMove(const FPoseSnapshot& Snapshot)
+{
+	using Traits = THandTraits<Hand>;
+	FHandLanes& hand{ GetHandLanes<Hand>() };
+	EvaluateMoveTolerance(hand.Lanes, Traits::GetRelativePos(Snapshot), Traits::GetPose(Snapshot.Pose).Rotation, Traits::GetOrientation(Snapshot),
+		hand.LiveMask.data(), hand.MoveMask.data());
+}
+
+// Start check of one hand for spell Index (after EvaluateStatic()) - returns true if the hand is in tolerance of keypoint 0, which is then complete
+template<EHand Hand>
+bool FSpellRecognizer::CheckStart(const FPoseSnapshot& Snapshot, int32_t Index)
+{
+	using Traits = THandTraits<Hand>;
+	const FHandLanes& hand{ GetHandLanes<Hand>() };
+	const bool inTolerance{ IsLaneSet(hand.StaticMask.data(), hand.LaneIDs[Index]) };
+	Traits::CompleteCount(States[Index]) = inTolerance ? 1 : 0;
+	if (!inTolerance) {
+		CountRejection(Index, Traits::RejectHand(), ClassifyStaticRejection(hand.Lanes, hand.LaneIDs[Index], Traits::GetRelativePos(Snapshot),
+			Traits::GetPose(Snapshot.Pose).Rotation, Traits::GetOrientation(Snapshot)));
+	}
+	if (Listener) Listener->OnStartChecked(SpellSet->GetSpell(Index), Hand, inTolerance);
+	return inTolerance;
+}
+
+// Completes the keypoint the hand is working towards if it is in tolerance (after EvaluateStatic() and EvaluateMove())
+// A swept keypoint also needs the sample itself to be in tolerance of the move - a hand that went through the keypoint but overshot
+// out of the move's tolerance has left the move, it has not completed it
+// Returns true if the last keypoint was already complete
+template<EHand Hand>
+bool FSpellRecognizer::CompleteKeyPoint(int32_t Index, int keyPointCount)
+{
+	uint8_t& completeCount{ THandTraits<Hand>::CompleteCount(States[Index]) };
+	if (completeCount == keyPointCount) {
+		return true;
+	}
+	const FHandLanes& hand{ GetHandLanes<Hand>() };
+	if (IsLaneSet(hand.StaticMask.data(), hand.LaneIDs[Index]) && (!Settings.isSweptKeyPoints || IsMoveInTolerance<Hand>(Index))) {
+		completeCount++;
+	}
+	return false;
+}
+
+// Returns true if the hand is still in tolerance of the move to its next keypoint (after EvaluateMove())
+template<EHand Hand>
+bool FSpellRecognizer::IsMoveInTolerance(int32_t Index) const
+{
+	const FHandLanes& hand{ GetHandLanes<Hand>() };
+	return IsLaneSet(hand.MoveMask.data(), hand.LaneIDs[Index]);
+}
+
+// Counts why the hand left the move to its next keypoint - nothing if the keypoint is complete or the hand is still in tolerance
+template<EHand Hand>
+void FSpellRecognizer::CountMoveRejection(const FPoseSnapshot& Snapshot, int32_t Index)
+{
+	using Traits = THandTraits<Hand>;
+	const FSpellState& state{ States[Index] };
+	if (Traits::NextPointID(state) < Traits::CompleteCount(state) || IsMoveInTolerance<Hand>(Index)) {
+		return;
+	}
+	const FHandLanes& hand{ GetHandLanes<Hand>() };
+	CountRejection(Index, Traits::RejectHand(), ClassifyMoveRejection(hand.Lanes, hand.LaneIDs[Index], Traits::GetRelativePos(Snapshot),
+		Traits::GetPose(Snapshot.Pose).Rotation, Traits::GetOrientation(Snapshot)));
+}
+
+// Returns true if a spell can be cast from the start position and orientation player has chosen
+// If dual casting, it is OK to have hands complete points asynchronously, they must just stay in tolerance until casting for that hand completes
+bool FSpellRecognizer::SpellSetup(const FPoseSample& Pose, bool isRHCasting, bool isLHCasting)
+{
+	// Save start position of hands for calculations
+	RHStartPos = Pose.RH.Position;
+	LHStartPos = Pose.LH.Position;
+	StartHandSpread = (RHStartPos - LHStartPos).Size();
+	LastSnapshot = MakeSnapshot(Pose, isRHCasting, isLHCasting);
+	isCommitted = false;
+
+	// Only spells that could start from this pose are reset and checked, none of the others can be cast this time round
+	// NOTE: If only one hand is casting, the index leaves out all dual hand spells
+	// NOTE: canCast of spells left over from the last cast is cleared through the old candidate list, so nothing else is touched
+	for (int32_t i : Candidates) {
+		States[i].canCast = false;
+	}
+	if (Settings.isQuaternionRotation) {
+		SpellSet->GetStartIndex().FindAllCandidates(isRHCasting, isLHCasting, Candidates);
+	}
+	else {
+		const FStartPoseIndex& startIndex{ SpellSet->GetStartIndex() };
+		startIndex.FindCandidates(Pose.RH.Rotation, Pose.LH.Rotation, isRHCasting, isLHCasting, Candidates);
+		const int32_t bucketKey{ startIndex.FindBucketKey(Pose.RH.Rotation, Pose.LH.Rotation, isRHCasting, isLHCasting) };
+		if (bucketKey >= 0) {
+			StartIndexMisses[bucketKey]++; // The spells it left out are counted when the counters are read, never walked here
+		}
+	}
+
+	switch (GetCastMode(isRHCasting, isLHCasting)) {
+	case ECastMode::RightHand: return SetupCandidates<ECastMode::RightHand>(LastSnapshot);
+	case ECastMode::LeftHand: return SetupCandidates<ECastMode::LeftHand>(LastSnapshot);
+	case ECastMode::Dual: return SetupCandidates<ECastMode::Dual>(LastSnapshot);
+	default: return SetupCandidates<ECastMode::None>(LastSnapshot);
+	}
+}
+
+// The start checks of every candidate - Mode is known at compile time, so a hand that is not casting costs nothing
+template<ECastMode Mode>
+bool FSpellRecognizer::SetupCandidates(const FPoseSnapshot& Snapshot)
+{
+	constexpr bool isRHCasting{ IsRHCasting(Mode) };
+	constexpr bool isLHCasting{ IsLHCasting(Mode) };
+
+	ClearLiveMasks();
+	for (int32_t i : Candidates) {
+		ResetState(i);
+		if (isRHCasting) ClaimLane<EHand::Right>(i, 0);
+		if (isLHCasting) ClaimLane<EHand::Left>(i, 0);
+	}
+
+	// Check start orientation of every candidate at once
+	if (isRHCasting) EvaluateStatic<EHand::Right>(Snapshot);
+	if (isLHCasting) EvaluateStatic<EHand::Left>(Snapshot);
+
+	// Check that remaining spell start positions are in tolerance - i.e. has player started with hands in correct orientation for a spell
+	bool anySpellAvailable{ false };
+	for (int32_t i : Candidates) {
+		bool inTolerance{ true };
+		if (isRHCasting) {
+			inTolerance = CheckStart<EHand::Right>(Snapshot, i);
+		}
+		if (isLHCasting && inTolerance) { // if previous check returned true
+			inTolerance = CheckStart<EHand::Left>(Snapshot, i);
+		}
+		if (Mode == ECastMode::Dual && inTolerance) { // If dual casting and previous check returned true
+			// Check hands are correctly positioned relative to each other i.e. if RH should be above/in front of/next to LH
+			const FSpellDef& spell{ SpellSet->GetSpell(i) };
+			inTolerance = CheckRHToLHDirection(spell, spell.PositionalTolerance * Settings.MaxMoveTolerance);
+			if (!inTolerance) CountRejection(i, ERejectHand::Both, ERejectReason::RelativeDirection);
+			if (Listener) Listener->OnRelativeStartChecked(spell, inTolerance, LHStartPos, RHStartPos);
+		}
+		States[i].canCast = inTolerance;
+		anySpellAvailable = anySpellAvailable || inTolerance;
+	}
+
+	UpdateCandidates();
+
+	// Return false if all the above checks fail - i.e. no spell can be cast from start position and orientation player has chosen
+	if (!anySpellAvailable && Listener) Listener->OnNoSpellAvailable();
+	return anySpellAvailable;
+}
+
+// The overarching logic for the tolerance checker code - updates canCast to false if motion/orientation goes out of tolerance
+// NOTE: The hands are picked every call rather than once per cast - a hand may let go mid cast
+bool FSpellRecognizer::UpdateSpellStates(const FPoseSample& Pose, bool isRHCasting, bool isLHCasting)
+{
+	// The keypoint checks sweep from the last sample to this one
+	const FVec3 RHPrevRelativePos{ LastSnapshot.RHRelativePos };
+	const FVec3 LHPrevRelativePos{ LastSnapshot.LHRelativePos };
+	LastSnapshot = MakeSnapshot(Pose, isRHCasting, isLHCasting);
+	LastSnapshot.RHPrevRelativePos = RHPrevRelativePos;
+	LastSnapshot.LHPrevRelativePos = LHPrevRelativePos;
+	if (isCommitted) {
+		return true; // The spell was committed early - like a completed spell, it stays complete
+	}
+
+	bool isSpellComplete{ false };
+	switch (GetCastMode(isRHCasting, isLHCasting)) {
+	case ECastMode::RightHand: isSpellComplete = UpdateCandidateStates<ECastMode::RightHand>(LastSnapshot); break;
+	case ECastMode::LeftHand: isSpellComplete = UpdateCandidateStates<ECastMode::LeftHand>(LastSnapshot); break;
+	case ECastMode::Dual: isSpellComplete = UpdateCandidateStates<ECastMode::Dual>(LastSnapshot); break;
+	default: isSpellComplete = UpdateCandidateStates<ECastMode::None>(LastSnapshot); break;
+	}
+	if (isSpellComplete) {
+		return true;
+	}
+
+	// Early commit - the last spell standing is far enough along its path to call it
+	if (Settings.EarlyCommitScore > 0.f && Candidates.size() == 1 && GetConfidence(Candidates[0]).Score >= Settings.EarlyCommitScore) {
+		isCommitted = true;
+		return true;
+	}
+	return false;
+}
+
+// One update of every candidate - Mode is known at compile time, so the per spell loops never check which hands are casting
+// NOTE: Runs in passes so the tolerance kernels can check every candidate at once:
+//	Find the next keypoint & scale of every candidate -> keypoint complete checks -> completion -> movement checks -> canCast & scale set
+// NOTE: Only candidates (spells that canCast) are ever visited, so the cost follows the number of spells still in play
+template<ECastMode Mode>
+bool FSpellRecognizer::UpdateCandidateStates(const FPoseSnapshot& Snapshot)
+{
+	constexpr bool isRHCasting{ IsRHCasting(Mode) };
+	constexpr bool isLHCasting{ IsLHCasting(Mode) };
+
+	ClearLiveMasks();
+	for (int32_t i : Candidates) {
+		const FSpellDef& spell{ SpellSet->GetSpell(i) };
+		FSpellState& state{ States[i] };
+		const int lastPointID{ static_cast<int>(spell.KeyPoints.size()) - 1 };
+
+		// What is next point that needs to be completed for LH and RH - keypoints are completed in order, so it is the first one not complete
+		state.RHNextPointID = isRHCasting ? std::min<int>(state.RHCompleteCount, lastPointID) : 0;
+		state.LHNextPointID = isLHCasting ? std::min<int>(state.LHCompleteCount, lastPointID) : 0;
+
+		// Update scale if required
+		if (!state.isScaleSet) {
+			UpdateSpellScale(Snapshot, spell, state);
+		}
+
+		if (isRHCasting) ClaimLane<EHand::Right>(i, state.RHNextPointID);
+		if (isLHCasting) ClaimLane<EHand::Left>(i, state.LHNextPointID);
+	}
+
+	// Set Complete status true if hand in positional tolerance with the point
+	if (isRHCasting) EvaluateStatic<EHand::Right>(Snapshot);
+	if (isLHCasting) EvaluateStatic<EHand::Left>(Snapshot);
+
+	// Check hand movement is still in tolerance - before completing keypoints, swept keypoints need it (see CompleteKeyPoint())
+	if (isRHCasting) EvaluateMove<EHand::Right>(Snapshot);
+	if (isLHCasting) EvaluateMove<EHand::Left>(Snapshot);
+
+	for (int32_t i : Candidates) {
+		const FSpellDef& spell{ SpellSet->GetSpell(i) };
+		const int keyPointCount{ static_cast<int>(spell.KeyPoints.size()) };
+		const bool allRHPointsComplete{ isRHCasting && CompleteKeyPoint<EHand::Right>(i, keyPointCount) };
+		const bool allLHPointsComplete{ isLHCasting && CompleteKeyPoint<EHand::Left>(i, keyPointCount) };
+
+		// If all required keypoints have been completed, set all other spell canCast to false and return true
+		// Dual handed casting needs BOTH hands completed, one handed casting the one hand
+		if ((Mode == ECastMode::Dual) ? (allRHPointsComplete && allLHPointsComplete) : (allRHPointsComplete || allLHPointsComplete)) {
+			for (int32_t j : Candidates) {
+				if (SpellSet->GetSpell(j).ID != spell.ID) States[j].canCast = false;
+			}
+			UpdateCandidates();
+			return true;
+		}
+	}
+
+	bool isAnyDeactivated{ false };
+	for (int32_t i : Candidates) {
+		const FSpellDef& spell{ SpellSet->GetSpell(i) };
+		FSpellState& state{ States[i] };
+		const int RHNextPointID{ isRHCasting ? state.RHNextPointID : 0 };
+		const int LHNextPointID{ isLHCasting ? state.LHNextPointID : 0 };
+
+		// If keypoint not yet complete check hand movement is still in tolerance - disable canCast if the hand is out of tolerance
+		if (isRHCasting && !state.IsRHComplete(RHNextPointID)) {
+			state.canCast = IsMoveInTolerance<EHand::Right>(i);
+		}
+		if (isLHCasting && !state.IsLHComplete(LHNextPointID)) { // keypoint 0 check required due to dual hand casting
+			state.canCast = IsMoveInTolerance<EHand::Left>(i);
+		}
+
+		// Set isScaleSet true if no longer in tolerance with end point of first move (NOTE: That point would be complete at this stage)
+		if (!state.isScaleSet && state.canCast && ((RHNextPointID > LHNextPointID) ? RHNextPointID : LHNextPointID) > 0) {
+			if (RHNextPointID > LHNextPointID) {
+				if (spell.KeyPoints[RHNextPointID - 1].Motion != EMotion::Point && // If the previously completed keypoint was an end of a movement point AND
+					!CheckStaticTolerance<EHand::Right>(Snapshot, i, RHNextPointID - 1)) { // Orientation of previous keypoint no longer in tolerance
+					state.isScaleSet = true;
+				}
+			}
+			else {
+				if (spell.KeyPoints[LHNextPointID - 1].Motion != EMotion::Point && // If the previously completed keypoint was an end of a movement point AND
+					!CheckStaticTolerance<EHand::Left>(Snapshot, i, LHNextPointID - 1)) { // Orientation of previous keypoint no longer in tolerance
+					state.isScaleSet = true;
+				}
+			}
+		}
+
+		if (!state.canCast) {
+			isAnyDeactivated = true;
+			// Count every hand that left the move, not just the one that decided canCast
+			if (isRHCasting) CountMoveRejection<EHand::Right>(Snapshot, i);
+			if (isLHCasting) CountMoveRejection<EHand::Left>(Snapshot, i);
+			if (Listener) Listener->OnSpellDeactivated(spell);
+		}
+	}
+
+	if (isAnyDeactivated) {
+		UpdateCandidates();
+	}
+	return false;
+}
+
+// Progress and fit of one hand on its way from keypoint CompleteCount - 1 to CompleteCount (see FSpellConfidence)
+// The ideal path is the straight line between the two keypoints, a Point keypoint has no length so only counts once it is complete
+static void GetHandConfidence(const FPoseSnapshot& Snapshot, EHand Hand, const FSpellDef& Spell, int CompleteCount, float Scale,
+	const FVec3& MoveTolerance, float& OutProgress, float& OutFit) {
+	const int keyPointCount{ static_cast<int>(Spell.KeyPoints.size()) };
+	if (CompleteCount >= keyPointCount || keyPointCount < 2) {
+		OutProgress = 1.f;
+		OutFit = 1.f;
+		return;
+	}
+	const bool isRH{ Hand == EHand::Right };
+	const FKeyPointDef& kpPrev{ Spell.KeyPoints[std::max(CompleteCount - 1, 0)] };
+	const FKeyPointDef& kp{ Spell.KeyPoints[CompleteCount] };
+	const FVec3 start{ (isRH ? kpPrev.RHPosition : kpPrev.LHPosition) * Scale };
+	const FVec3 path{ (isRH ? kp.RHPosition : kp.LHPosition) * Scale - start };
+	const FVec3 move{ (isRH ? Snapshot.RHRelativePos : Snapshot.LHRelativePos) - start };
+
+	// How far along the line the hand is, and how far off it
+	const float lengthSq{ path.X * path.X + path.Y * path.Y + path.Z * path.Z };
+	const float along{ (lengthSq > 0.f) ? std::min(std::max((move.X * path.X + move.Y * path.Y + move.Z * path.Z) / lengthSq, 0.f), 1.f) : 0.f };
+	const FVec3 offLine{ move - path * along };
+
+	// Worst axis relative to its tolerance - ignored axes (tolerance 0) do not count
+	float worst{ 0.f };
+	worst = (MoveTolerance.X > 0.f) ? std::max(worst, std::fabs(offLine.X) / MoveTolerance.X) : worst;
+	worst = (MoveTolerance.Y > 0.f) ? std::max(worst, std::fabs(offLine.Y) / MoveTolerance.Y) : worst;
+	worst = (MoveTolerance.Z > 0.f) ? std::max(worst, std::fabs(offLine.Z) / MoveTolerance.Z) : worst;
+
+	OutProgress = (static_cast<float>(std::max(CompleteCount - 1, 0)) + along) / static_cast<float>(keyPointCount - 1);
+	OutFit = std::max(1.f - worst, 0.f);
+}
+
+FSpellConfidence FSpellRecognizer::GetConfidence(int32_t Index) const
+{
+	const FSpellDef& spell{ SpellSet->GetSpell(Index) };
+	const FSpellState& state{ States[Index] };
+	const FVec3 moveTolerance{ spell.PositionalTolerance * Settings.MaxMoveTolerance };
+
+	FSpellConfidence confidence{};
+	float progress{ 0.f };
+	float fit{ 0.f };
+	int handCount{ 0 };
+	if (LastSnapshot.isRHCasting) {
+		GetHandConfidence(LastSnapshot, EHand::Right, spell, state.RHCompleteCount, state.Scale, moveTolerance, progress, fit);
+		confidence.Progress = progress;
+		confidence.Fit = fit;
+		handCount++;
+	}
+	if (LastSnapshot.isLHCasting) {
+		GetHandConfidence(LastSnapshot, EHand::Left, spell, state.LHCompleteCount, state.Scale, moveTolerance, progress, fit);
+		confidence.Progress += progress;
+		confidence.Fit = (handCount > 0) ? std::min(confidence.Fit, fit) : fit;
+		handCount++;
+	}
+	if (handCount > 1) {
+		confidence.Progress /= static_cast<float>(handCount);
+	}
+	confidence.Score = confidence.Progress * confidence.Fit;
+	return confidence;
+}
+
+int32_t FSpellRecognizer::GetLeadingSpell(FSpellConfidence* OutConfidence) const
+{
+	int32_t leader{ -1 };
+	FSpellConfidence best{};
+	float runnerUpScore{ 0.f };
+	for (int32_t i : Candidates) {
+		const FSpellConfidence confidence{ GetConfidence(i) };
+		if (leader < 0 || confidence.Score > best.Score) {
+			runnerUpScore = (leader < 0) ? 0.f : best.Score;
+			leader = i;
+			best = confidence;
+		}
+		else {
+			runnerUpScore = std::max(runnerUpScore, confidence.Score);
+		}
+	}
+
+	// A lone candidate always leads - it is all that is left
+	if (leader < 0 || (Candidates.size() > 1 && best.Score - runnerUpScore < Settings.LeadMargin)) {
+		return NoSpell;
+	}
+	if (OutConfidence) {
+		*OutConfidence = best;
+	}
+	return SpellSet->GetSpell(leader).ID;
+}
+
+// Scale of a first movement that is an arc - how far the hands have moved along the radius the arc finishes on
+// The largest single axis movement would not do, the other axis carries on round the circle past the keypoint (it would keep growing the scale)
+// NOTE: The size of the circle is not known until the keypoint, so arc widths are not checked until the scale is set (see ClaimLane())
+static float GetArcMoveScale(const FPoseSnapshot& Snapshot, const FKeyPointDef& kpPrev, const FKeyPointDef& kp) {
+	float scale{ 0.f };
+	if (Snapshot.isRHCasting) {
+		const FVec3 endRadius{ kp.RHPosition - GetArcCentre(kpPrev.RHPosition, kp.RHPosition, kp.Motion) }; // One axis only, unit radius long
+		const FVec3 move{ Snapshot.RHRelativePos }; // The first move always sets off from the start position
+		scale = (move.X * endRadius.X + move.Y * endRadius.Y + move.Z * endRadius.Z) / (endRadius.GetAbsMax() * endRadius.GetAbsMax());
+	}
+	if (Snapshot.isLHCasting) {
+		const FVec3 endRadius{ kp.LHPosition - GetArcCentre(kpPrev.LHPosition, kp.LHPosition, kp.Motion) };
+		const FVec3 move{ Snapshot.LHRelativePos };
+		scale = std::max(scale, (move.X * endRadius.X + move.Y * endRadius.Y + move.Z * endRadius.Z) / (endRadius.GetAbsMax() * endRadius.GetAbsMax()));
+	}
+	return scale;
+}
+
+// By axis scaling is used in this project - so max movement in one axis sets the current scale
+// Until the first movement is complete, then scale is 'set' until this round of casting is complete
+void FSpellRecognizer::UpdateSpellScale(const FPoseSnapshot& Snapshot, const FSpellDef& spell, FSpellState& state)
+{
+	float NewScale{ Settings.MinMoveScale };
+
+	// The first movement - keypoints before it are Points that stay on the start position
+	size_t firstMoveID{ 1 };
+	while (firstMoveID + 1 < spell.KeyPoints.size() && spell.KeyPoints[firstMoveID].Motion == EMotion::Point) {
+		firstMoveID++;
+	}
+
+	if (spell.KeyPoints[0].Motion != EMotion::Point) { // Special case (Air) - first keypoint tells scale checker to set scale relative to starting hand positions
+		NewScale = (StartHandSpread > NewScale) ? StartHandSpread : NewScale;
+		state.isScaleSet = true;
+	}
+	else if (firstMoveID < spell.KeyPoints.size() && IsArc(spell.KeyPoints[firstMoveID].Motion)) {
+		const float arcScale{ GetArcMoveScale(Snapshot, spell.KeyPoints[firstMoveID - 1], spell.KeyPoints[firstMoveID]) };
+		NewScale = (arcScale > NewScale) ? arcScale : NewScale;
+	}
+	else {
+		NewScale = (Snapshot.MaxMoveFromStart > NewScale) ? Snapshot.MaxMoveFromStart : NewScale;
+	}
+
+	// Update Scale to maximum hand movement from start position
+	state.Scale = (state.Scale > NewScale) ? state.Scale : NewScale;
+}
+
+// Checks whether left hand start pos and right hand start pos are at the valid start position from each other
+// i.e. should RH be above/next to/in front of LH, if yes, is it
+// NOTE: Axis based calculation, will not work well for relPos FVec3{0,1,1} where there is a 1 in more than one axis
+// Will always take MaxAbs(PosTolerance) for all axes - will never ignore 0 axes
+bool FSpellRecognizer::CheckRHToLHDirection(const FSpellDef& referenceSpell, const FVec3& PosTolerance) const
+{
+	float Tolerance{ PosTolerance.GetAbsMax() };
+	FVec3 actRelativePos{ RHStartPos - LHStartPos };
+
+	if (referenceSpell.LtoRRelativeStartPos.X == 0) { // If x Axis position (in spellcasting grid) needs to be in tolerance
+		if (actRelativePos.X < -Tolerance || actRelativePos.X > Tolerance) {
+			return false;
+		}
+	}
+	if (referenceSpell.LtoRRelativeStartPos.Y == 0) { // If y Axis position (in spellcasting grid) needs to be in tolerance
+		if (actRelativePos.Y < -Tolerance || actRelativePos.Y > Tolerance) {
+			return false;
+		}
+	}
+	if (referenceSpell.LtoRRelativeStartPos.Z == 0) { // If z Axis position (in spellcasting grid) needs to be in tolerance
+		if (actRelativePos.Z < -Tolerance || actRelativePos.Z > Tolerance) {
+			return false;
+		}
+	}
+	return true;
+}
+
+const FRejectionCounters& FSpellRecognizer::GetRejectionCounters() const
+{
+	FlushStartIndexRejections();
+	return Rejections;
+}
+
+void FSpellRecognizer::ResetRejectionCounters()
+{
+	Rejections.Reset();
+	std::fill(StartIndexMisses.begin(), StartIndexMisses.end(), 0u);
+}
+
+// Counts a start rotation rejection for every spell the start pose index left out of every SpellSetup() since the last flush
+// One walk over the spells per bucket key used, however many casts used it
+void FSpellRecognizer::FlushStartIndexRejections() const
+{
+	for (int32_t key{ 0 }; key < static_cast<int32_t>(StartIndexMisses.size()); key++) {
+		if (StartIndexMisses[key] > 0) {
+			SpellSet->GetStartIndex().CountLeftOut(key, StartIndexMisses[key], SpellSet->GetSpells(), Rejections);
+			StartIndexMisses[key] = 0;
+		}
+	}
+}
+
+void FSpellRecognizer::CountRejection(int32_t Index, ERejectHand Hand, ERejectReason Reason)
+{
+	if (Reason != ERejectReason::Num) {
+		Rejections.Add(SpellSet->GetSpell(Index).ID, Hand, Reason);
+	}
+}
+
+// Conversion functions - these decide which type of tolerance check is required, then convert to the relevant units... The logic brains of the operation
+
+// Returns true if the hand is within tolerance of keypoint kpID of spell Index
+template<EHand Hand>
+bool FSpellRecognizer::CheckStaticTolerance(const FPoseSnapshot& Snapshot, int32_t Index, int kpID) const
+{
+	using Traits = THandTraits<Hand>;
+	const FSpellDef& spell{ SpellSet->GetSpell(Index) };
+	const FKeyPointDef& kp{ spell.KeyPoints[kpID] };
+	FVec3 posTolerance{ spell.PositionalTolerance * Settings.MaxMoveTolerance / 2 };
+
+	if (Settings.isQuaternionRotation) {
+		const FKeyPointOrientation& orientation{ SpellSet->GetOrientation(Index, kpID) };
+		if (!OrientationEqual(Traits::GetOrientation(Snapshot), Traits::GetOrientation(orientation), Traits::GetLimits(orientation))) {
+			return false;
+		}
+	}
+	else if (!PointEqual(Traits::GetPose(Snapshot.Pose).Rotation, Traits::GetRotation(kp), spell.RotationalTolerance)) {
+		return false;
+	}
+	return PointEqual(Traits::GetRelativePos(Snapshot), Traits::GetPosition(kp) * States[Index].Scale, posTolerance);
+}
+
+} // namespace SpellRecognition
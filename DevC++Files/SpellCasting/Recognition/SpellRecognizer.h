@@ -0,0 +1,215 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* The headless spell recognizer - all of the spell recognition logic that used to live inside USpellComponent
+* Feed it the spell definitions once, then a spellcasting grid space pose sample every update:
+*	SpellSetup() when a cast starts, UpdateSpellStates() every update after that, GetActiveSpells() whenever you like
+* NOTE: It does not know (or care) where the samples come from - a motion controller, a recording or a test
+* NOTE: Per-cast state lives in here, the definitions live in a shared FSpellSet (see SpellSet.h) - give every caster the same set
+*/
+
+#pragma once
+
+#include "RecognizerMath.h"
+#include "RecognizerTypes.h"
+#include "RejectionCounters.h"
+#include "SpellSet.h"
+#include "ToleranceKernels.h"
+
+namespace SpellRecognition {
+
+// Default setup values - see USpellComponent for what they mean in game
+struct FRecognizerSettings {
+	float MaxMoveTolerance{ 8.f }; // Constant used as the maximum movement allowed from ideal line for tolerance checks
+	float MinMoveScale{ 8.f }; // Constant used as minimum movement for spellcasting scale to be updated
+	bool isQuaternionRotation{ false }; // Check rotations as swing/twist quaternions instead of per Euler axis (see FSwingTwistLimits)
+	float LeadMargin{ 0.25f }; // How far ahead (in FSpellConfidence::Score) of every other candidate a spell must be to lead - see GetLeadingSpell()
+	float EarlyCommitScore{ 0.f }; // Complete the last candidate standing once its Score reaches this, without waiting for the last keypoint - 0 to never commit early
+	bool isSweptKeyPoints{ false }; // Check keypoints against the whole move since the last sample, not just the sample (see EvaluateSweptStaticTolerance())
+};
+
+// Which hands a cast is made with - SpellSetup() and UpdateSpellStates() run a separate loop for each, so the per spell checks never ask
+enum class ECastMode : uint8_t {
+	None,
+	RightHand,
+	LeftHand,
+	Dual
+};
+
+constexpr ECastMode GetCastMode(bool isRHCasting, bool isLHCasting) {
+	return isRHCasting ? (isLHCasting ? ECastMode::Dual : ECastMode::RightHand) : (isLHCasting ? ECastMode::LeftHand : ECastMode::None);
+}
+
+constexpr bool IsRHCasting(ECastMode Mode) { return Mode == ECastMode::RightHand || Mode == ECastMode::Dual; }
+constexpr bool IsLHCasting(ECastMode Mode) { return Mode == ECastMode::LeftHand || Mode == ECastMode::Dual; }
+
+// Per-cast state of a single spell - everything a caster keeps per spell, so it is kept small (12 bytes, five to a cache line)
+// NOTE: Keypoints are always completed in order, so a count of completed keypoints per hand is all the progress there is to keep
+// NOTE: Counts fit in a byte - spells have at most MaxKeyPoints keypoints
+struct FSpellState {
+	float Scale{ 8.f };
+	uint8_t RHCompleteCount{ 0 }; // Number of keypoints completed by the right hand
+	uint8_t LHCompleteCount{ 0 }; // Number of keypoints completed by the left hand
+	uint8_t RHNextPointID{ 0 }; // Keypoint the right hand is working towards this update
+	uint8_t LHNextPointID{ 0 }; // Keypoint the left hand is working towards this update
+	bool isScaleSet{ false };
+	bool canCast{ true };
+
+	bool IsRHComplete(int kpID) const { return kpID < RHCompleteCount; }
+	bool IsLHComplete(int kpID) const { return kpID < LHCompleteCount; }
+};
+
+// How sure the recognizer is that a candidate is the spell being cast - see GetConfidence()
+// NOTE: Arcs are measured against their chord - good enough to rank candidates, the tolerance checks still decide what can be cast
+struct FSpellConfidence {
+	float Progress{ 0.f }; // How far along the path the hands are - 0 on the start keypoint, 1 once every keypoint is complete (average of the casting hands)
+	float Fit{ 0.f }; // How close the hands are to the ideal line - 1 right on it, 0 on the edge of the move tolerance (worst of the casting hands)
+	float Score{ 0.f }; // Progress * Fit
+};
+
+// Everything derived from one pose sample that the checks need - worked out once per update, then shared by every spell
+struct FPoseSnapshot {
+	FPoseSample Pose{};
+	FVec3 RHRelativePos{}; // Hand position relative to the hand start position
+	FVec3 LHRelativePos{};
+	FVec3 RHPrevRelativePos{}; // Hand position relative to the hand start position at the previous sample - the same as above in SpellSetup()
+	FVec3 LHPrevRelativePos{};
+	float MaxMoveFromStart{ 0.f }; // Largest single axis movement of any casting hand from its start position
+	FQuat4 RHOrientation{}; // Hand rotations as quaternions - only worked out if FRecognizerSettings::isQuaternionRotation
+	FQuat4 LHOrientation{};
+	bool isRHCasting{ false };
+	bool isLHCasting{ false };
+};
+
+// Optional hooks used to find out what the recognizer decided - replaces the UE_LOG calls that used to be scattered through the checks
+// Every function has an empty default so listeners only override what they need
+class IRecognitionListener {
+public:
+	virtual ~IRecognitionListener() = default;
+
+	virtual void OnStartChecked(const FSpellDef& /*Spell*/, EHand /*Hand*/, bool /*isAccepted*/) {}
+	virtual void OnRelativeStartChecked(const FSpellDef& /*Spell*/, bool /*isAccepted*/, const FVec3& /*LHStartPos*/, const FVec3& /*RHStartPos*/) {}
+	virtual void OnNoSpellAvailable() {}
+	virtual void OnSpellDeactivated(const FSpellDef& /*Spell*/) {}
+};
+
+class FSpellRecognizer {
+public:
+	FSpellRecognizer() = default;
+	explicit FSpellRecognizer(FSharedSpellSet NewSpellSet, const FRecognizerSettings& NewSettings = FRecognizerSettings{});
+	explicit FSpellRecognizer(std::vector<FSpellDef> SpellDefs, const FRecognizerSettings& NewSettings = FRecognizerSettings{});
+
+	// Replaces all spell definitions and resets every spell state
+	// The vector version builds a set of its own - fine for one recognizer, share a set (see MakeSpellSet()) for more
+	void SetSpells(FSharedSpellSet NewSpellSet);
+	void SetSpells(std::vector<FSpellDef> SpellDefs);
+	void SetSettings(const FRecognizerSettings& NewSettings);
+	void SetListener(IRecognitionListener* NewListener) { Listener = NewListener; }
+
+	// The starting point for spell position calculations - Pose must already be relative to the new spellcasting grid
+	// Returns true if a spell can be cast from the start position and orientation player has chosen
+	bool SpellSetup(const FPoseSample& Pose, bool isRHCasting, bool isLHCasting);
+
+	// Updates canCast of every spell given the latest pose - returns true once a spell has been completed
+	bool UpdateSpellStates(const FPoseSample& Pose, bool isRHCasting, bool isLHCasting);
+
+	// Returns ID of the only spell that canCast, MultipleSpells if more than one can and NoSpell if none can
+	int32_t GetActiveSpells() const;
+	int32_t GetCandidateCount() const { return static_cast<int32_t>(Candidates.size()); }
+
+	// Confidence of spell Index (must canCast) as of the latest pose sample - worked out on request, the updates never pay for it
+	FSpellConfidence GetConfidence(int32_t Index) const;
+
+	// Returns ID of the candidate whose Score is LeadMargin ahead of every other candidate, long before GetActiveSpells() narrows down to it
+	// NoSpell if no candidate leads - OutConfidence (optional) is the leader's confidence
+	// Cheap enough for once per tick, e.g. to pre-warm the likely spell's effects
+	int32_t GetLeadingSpell(FSpellConfidence* OutConfidence = nullptr) const;
+
+	// Accessors
+	int32_t Num() const { return SpellSet->Num(); }
+	const FSpellDef& GetSpell(int32_t Index) const { return SpellSet->GetSpell(Index); }
+	const FSharedSpellSet& GetSpellSet() const { return SpellSet; }
+	const FSpellState& GetSpellState(int32_t Index) const { return States[Index]; }
+	const FVec3& GetRHStartPos() const { return RHStartPos; }
+	const FVec3& GetLHStartPos() const { return LHStartPos; }
+	const FRecognizerSettings& GetSettings() const { return Settings; }
+
+	// Which check rejected which spell since the recognizer was made (or last reset) - see RejectionCounters.h
+	// NOTE: Spells the start pose index left out are only added here, in bulk, when the counters are read
+	const FRejectionCounters& GetRejectionCounters() const;
+	void ResetRejectionCounters();
+
+private:
+	FSharedSpellSet SpellSet{ GetEmptySpellSet() }; // Never null
+	std::vector<FSpellState> States{}; // Same order as the spells
+	FRecognizerSettings Settings{};
+	IRecognitionListener* Listener{ nullptr };
+
+	// Start position of both hands for this cast period in terms of spellcasting grid
+	// NOTE: All positional tolerance calculations must be passed values relative to the start position
+	FVec3 RHStartPos{};
+	FVec3 LHStartPos{};
+	float StartHandSpread{ 0.f }; // Distance between the hand start positions
+
+	FPoseSnapshot LastSnapshot{}; // Latest pose sample - used by GetConfidence()
+	bool isCommitted{ false }; // Set once EarlyCommitScore is reached, until the next SpellSetup()
+
+	// Index of every spell that canCast, in spell order - the only spells UpdateSpellStates() looks at
+	std::vector<int32_t> Candidates{};
+
+	// Keypoints one hand is working towards - checked for every candidate at once by the tolerance kernels
+	// One lane per automaton node, followed by one lane per spell (used when a spell's scale no longer matches the others at its node)
+	struct FHandLanes {
+		FToleranceLanes Lanes{};
+		std::vector<int32_t> LaneIDs{}; // Lane each spell is checked in this update, same order as the spells
+		std::vector<uint64_t> LiveMask{}; // One bit per lane, set if a candidate is checked in it this update
+		std::vector<uint64_t> StaticMask{}; // One bit per lane, set if the hand is in tolerance
+		std::vector<uint64_t> MoveMask{};
+	};
+	FHandLanes HandLanes[2]{}; // Indexed by EHand
+
+	// Mutable so GetRejectionCounters() can add the start pose index rejections still waiting in StartIndexMisses
+	mutable FRejectionCounters Rejections{};
+	mutable std::vector<uint32_t> StartIndexMisses{}; // SpellSetup()s per start pose index bucket key (see FStartPoseIndex::FindBucketKey())
+
+	FPoseSnapshot MakeSnapshot(const FPoseSample& Pose, bool isRHCasting, bool isLHCasting) const;
+	void ResetStates();
+	void ResetState(int32_t Index);
+	void ResetLanes();
+	void ClearLiveMasks();
+	void UpdateCandidates();
+	void UpdateSpellScale(const FPoseSnapshot& Snapshot, const FSpellDef& spell, FSpellState& state);
+	bool CheckRHToLHDirection(const FSpellDef& referenceSpell, const FVec3& PosTolerance) const;
+	void FlushStartIndexRejections() const;
+	void CountRejection(int32_t Index, ERejectHand Hand, ERejectReason Reason);
+
+	// The checks themselves - one instance per cast mode, picked once per call (see SpellRecognizer.cpp)
+	template<ECastMode Mode>
+	bool SetupCandidates(const FPoseSnapshot& Snapshot);
+	template<ECastMode Mode>
+	bool UpdateCandidateStates(const FPoseSnapshot& Snapshot);
+
+	// Per hand parts of the checks - one instance per hand, so the right and left hand code can not drift apart
+	template<EHand Hand>
+	FHandLanes& GetHandLanes() { return HandLanes[static_cast<int>(Hand)]; }
+	template<EHand Hand>
+	const FHandLanes& GetHandLanes() const { return HandLanes[static_cast<int>(Hand)]; }
+	template<EHand Hand>
+	void ClaimLane(int32_t Index, int kpID);
+	template<EHand Hand>
+	void EvaluateStatic(const FPoseSnapshot& Snapshot);
+	template<EHand Hand>
+	void EvaluateMove(const FPoseSnapshot& Snapshot);
+	template<EHand Hand>
+	bool CheckStart(const FPoseSnapshot& Snapshot, int32_t Index);
+	template<EHand Hand>
+	bool CompleteKeyPoint(int32_t Index, int keyPointCount);
+	template<EHand Hand>
+	bool IsMoveInTolerance(int32_t Index) const;
+	template<EHand Hand>
+	void CountMoveRejection(const FPoseSnapshot& Snapshot, int32_t Index);
+	template<EHand Hand>
+	bool CheckStaticTolerance(const FPoseSnapshot& Snapshot, int32_t Index, int kpID) const;
+};
+
+} // namespace SpellRecognition
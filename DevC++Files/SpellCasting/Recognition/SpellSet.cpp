@@ -0,0 +1,52 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "SpellSet.h"
+
+#include <utility>
+
+namespace SpellRecognition {
+
+FSpellSet::FSpellSet(std::vector<FSpellDef> SpellDefs)
+	: Spells{ std::move(SpellDefs) }
+{
+	StartIndex.Build(Spells);
+	Automaton.Build(Spells);
+	BuildOrientations();
+}
+
+// Works out the quaternion rotation checks of every keypoint - used by FSpellRecognizer's static checks (the kernels keep their own in the lanes)
+void FSpellSet::BuildOrientations()
+{
+	size_t keyPointCount{ 0 };
+	for (const FSpellDef& spell : Spells) {
+		keyPointCount += spell.KeyPoints.size();
+	}
+	KeyPointOrientations.reserve(keyPointCount);
+	FirstOrientation.reserve(Spells.size());
+
+	for (const FSpellDef& spell : Spells) {
+		FirstOrientation.push_back(static_cast<int32_t>(KeyPointOrientations.size()));
+		for (const FKeyPointDef& kp : spell.KeyPoints) {
+			FKeyPointOrientation orientation{};
+			orientation.RHOrientation = ToQuat(kp.RHRotation);
+			orientation.LHOrientation = ToQuat(kp.LHRotation);
+			orientation.RHLimits = MakeStaticLimits(kp.RHRotation, spell.RotationalTolerance);
+			orientation.LHLimits = MakeStaticLimits(kp.LHRotation, spell.RotationalTolerance);
+			KeyPointOrientations.push_back(orientation);
+		}
+	}
+}
+
+FSharedSpellSet MakeSpellSet(std::vector<FSpellDef> SpellDefs)
+{
+	return std::make_shared<const FSpellSet>(std::move(SpellDefs));
+}
+
+const FSharedSpellSet& GetEmptySpellSet()
+{
+	static const FSharedSpellSet EmptySet{ MakeSpellSet(std::vector<FSpellDef>{}) };
+	return EmptySet;
+}
+
+} // namespace SpellRecognition
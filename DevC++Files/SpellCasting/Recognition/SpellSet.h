@@ -0,0 +1,70 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Spell set - the spell definitions plus everything worked out from them alone, built once and shared by every caster
+* FSpellRecognizer and FDtwMatcher only point at a set - all they keep of their own is per-cast state (FSpellState, candidates, tolerance lanes)
+* A set never changes once MakeSpellSet() has built it:
+*	Any number of recognizers, on any number of threads, read the same copy
+*	A hot reload builds a new set - recognizers still on the old one keep it alive until they are given the new one (between casts)
+* NOTE: Anything that depends on FRecognizerSettings (e.g. the tolerance lanes) is per recognizer, not in here
+*/
+
+#pragma once
+
+#include "RecognizerMath.h"
+#include "RecognizerTypes.h"
+#include "SpellAutomaton.h"
+#include "StartPoseIndex.h"
+
+#include <memory>
+
+namespace SpellRecognition {
+
+// Quaternion rotation checks of one keypoint - worked out once per set, so the checks outside the kernels need no trig either
+struct FKeyPointOrientation {
+	FQuat4 RHOrientation{};
+	FQuat4 LHOrientation{};
+	FSwingTwistLimits RHLimits{};
+	FSwingTwistLimits LHLimits{};
+};
+
+class FSpellSet {
+public:
+	// Use MakeSpellSet() - sets are only ever shared
+	explicit FSpellSet(std::vector<FSpellDef> SpellDefs);
+
+	FSpellSet(const FSpellSet&) = delete;
+	FSpellSet& operator=(const FSpellSet&) = delete;
+
+	int32_t Num() const { return static_cast<int32_t>(Spells.size()); }
+	const std::vector<FSpellDef>& GetSpells() const { return Spells; }
+	const FSpellDef& GetSpell(int32_t Index) const { return Spells[Index]; }
+	const FStartPoseIndex& GetStartIndex() const { return StartIndex; }
+	const FSpellAutomaton& GetAutomaton() const { return Automaton; }
+	const FKeyPointOrientation& GetOrientation(int32_t Index, int kpID) const { return KeyPointOrientations[FirstOrientation[Index] + kpID]; }
+
+private:
+	std::vector<FSpellDef> Spells{};
+
+	// Finds the spells worth checking in FSpellRecognizer::SpellSetup()
+	FStartPoseIndex StartIndex{};
+
+	// Shared keypoints of all spells - candidates waiting on the same node are checked once
+	FSpellAutomaton Automaton{};
+
+	// Quaternion version of every keypoint's rotation - spell Index's keypoints start at KeyPointOrientations[FirstOrientation[Index]]
+	std::vector<FKeyPointOrientation> KeyPointOrientations{};
+	std::vector<int32_t> FirstOrientation{};
+
+	void BuildOrientations();
+};
+
+using FSharedSpellSet = std::shared_ptr<const FSpellSet>;
+
+// Builds a set - safe to call from any thread, e.g. while loading a spell binary in the background
+FSharedSpellSet MakeSpellSet(std::vector<FSpellDef> SpellDefs);
+
+// A set with no spells - what a recognizer starts with, so it never has to check for a missing set
+const FSharedSpellSet& GetEmptySpellSet();
+
+} // namespace SpellRecognition
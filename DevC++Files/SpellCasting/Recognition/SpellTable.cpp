@@ -0,0 +1,49 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "SpellTable.h"
+
+#include <utility>
+
+namespace SpellRecognition {
+
+bool IsValidSpell(const FSpellDef& Spell)
+{
+	const FSpellTableEntry entry{ Spell.KeyPoints.data(), static_cast<int32_t>(Spell.KeyPoints.size()), Spell.LtoRRelativeStartPos,
+		Spell.PositionalTolerance, Spell.RotationalTolerance, Spell.ID, Spell.isDualOnly };
+	return IsValidSpell(entry);
+}
+
+bool HasUniqueSpellIDs(const std::vector<FSpellDef>& Spells)
+{
+	bool isUsed[SpellIDCount]{};
+	for (const FSpellDef& spell : Spells) {
+		if (isUsed[spell.ID]) {
+			return false;
+		}
+		isUsed[spell.ID] = true;
+	}
+	return true;
+}
+
+std::vector<FSpellDef> MakeSpellDefs(const FSpellTableEntry* Table, int32_t NumSpells)
+{
+	std::vector<FSpellDef> SpellDefs{};
+	SpellDefs.reserve(NumSpells);
+
+	for (int32_t i{ 0 }; i < NumSpells; i++) {
+		const FSpellTableEntry& entry{ Table[i] };
+
+		FSpellDef Def{};
+		Def.KeyPoints.assign(entry.KeyPoints, entry.KeyPoints + entry.NumKeyPoints);
+		Def.LtoRRelativeStartPos = entry.LtoRRelativeStartPos;
+		Def.PositionalTolerance = entry.PositionalTolerance;
+		Def.RotationalTolerance = entry.RotationalTolerance;
+		Def.ID = entry.ID;
+		Def.isDualOnly = entry.isDualOnly;
+		SpellDefs.push_back(std::move(Def));
+	}
+	return SpellDefs;
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,127 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Compile time spell table - spells written as constexpr data (read-only memory, nothing built at startup)
+* The spellcrafting rules (see USpellContainer) are checked with static_assert, so a broken spell fails the build:
+*	static_assert(IsValidSpell(SpellTable, SpellID::Ball), "Ball breaks the spellcrafting rules");
+*
+* Rules checked:
+*	The spell must be in the table (exactly once), with an ID in [0, SpellIDCount)
+*	There must always be at least two keypoints
+*	First position vectors are always 0,0,0 for both hands
+*	A Line moves MAX TWO AXES per hand - axes ignored by the positional tolerance do not count (e.g. Atune)
+*	An Arc is a quarter circle - EXACTLY TWO AXES per hand move the same distance (every axis counts, it is the shape of the circle)
+*	Both hands must have the same movement type - a Line or Arc moves both hands, a Point moves neither
+* NOTE: The first keypoint is not a movement, so its Motion is not checked (Air uses it to set the scale - see UpdateSpellScale())
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+
+namespace SpellRecognition {
+
+// One spell of a constexpr spell table - same as FSpellDef, but points at its keypoints instead of owning them
+struct FSpellTableEntry {
+	const FKeyPointDef* KeyPoints{ nullptr };
+	int32_t NumKeyPoints{ 0 };
+	FVec3 LtoRRelativeStartPos{};
+	FVec3 PositionalTolerance{};
+	FRot3 RotationalTolerance{};
+	int32_t ID{ -1 };
+	bool isDualOnly{ true };
+};
+
+template <int32_t N>
+constexpr FSpellTableEntry MakeSpellTableEntry(const FKeyPointDef (&KeyPoints)[N], const FVec3& LtoRRelativeStartPos,
+	const FVec3& PositionalTolerance, const FRot3& RotationalTolerance, int32_t ID, bool isDualOnly)
+{
+	return FSpellTableEntry{ KeyPoints, N, LtoRRelativeStartPos, PositionalTolerance, RotationalTolerance, ID, isDualOnly };
+}
+
+// Spellcrafting rule checks - all constexpr so they can be used in static_assert
+constexpr bool IsZeroPosition(const FVec3& Pos) {
+	return Pos.X == 0 && Pos.Y == 0 && Pos.Z == 0;
+}
+
+// Returns the number of axes moved between two positions, only counting the axes in PosTolerance that are not ignored
+constexpr int CountMovedAxes(const FVec3& From, const FVec3& To, const FVec3& PosTolerance) {
+	return (From.X != To.X && PosTolerance.X != 0 ? 1 : 0) +
+		(From.Y != To.Y && PosTolerance.Y != 0 ? 1 : 0) +
+		(From.Z != To.Z && PosTolerance.Z != 0 ? 1 : 0);
+}
+
+constexpr float AbsDistance(float From, float To) {
+	return (To > From) ? To - From : From - To;
+}
+
+// Largest difference allowed between the two axes of an arc (unit space) - we only work in circles here
+constexpr float ArcRoundness{ 1.0e-3f };
+
+constexpr bool IsQuarterCircle(const FVec3& From, const FVec3& To) {
+	const float deltas[3]{ AbsDistance(From.X, To.X), AbsDistance(From.Y, To.Y), AbsDistance(From.Z, To.Z) };
+	int movedAxes{ 0 };
+	float radius{ 0.f };
+	bool isRound{ true };
+	for (int axis{ 0 }; axis < 3; axis++) {
+		if (deltas[axis] != 0) {
+			isRound = isRound && (movedAxes == 0 || AbsDistance(radius, deltas[axis]) <= ArcRoundness);
+			radius = deltas[axis];
+			movedAxes++;
+		}
+	}
+	return movedAxes == 2 && isRound;
+}
+
+constexpr bool IsValidMove(const FKeyPointDef& Prev, const FKeyPointDef& KeyPoint, const FVec3& PosTolerance) {
+	const int RHAxes{ CountMovedAxes(Prev.RHPosition, KeyPoint.RHPosition, PosTolerance) };
+	const int LHAxes{ CountMovedAxes(Prev.LHPosition, KeyPoint.LHPosition, PosTolerance) };
+
+	if (KeyPoint.Motion == EMotion::Point) {
+		return RHAxes == 0 && LHAxes == 0;
+	}
+	if (IsArc(KeyPoint.Motion)) {
+		return IsQuarterCircle(Prev.RHPosition, KeyPoint.RHPosition) && IsQuarterCircle(Prev.LHPosition, KeyPoint.LHPosition);
+	}
+	return RHAxes <= 2 && LHAxes <= 2 && (RHAxes == 0) == (LHAxes == 0);
+}
+
+constexpr bool IsValidSpellID(int32_t ID) {
+	return ID >= 0 && ID < SpellIDCount;
+}
+
+constexpr bool IsValidSpell(const FSpellTableEntry& Spell) {
+	if (!IsValidSpellID(Spell.ID) || Spell.NumKeyPoints < 2 || Spell.NumKeyPoints > MaxKeyPoints || !IsZeroPosition(Spell.KeyPoints[0].RHPosition) || !IsZeroPosition(Spell.KeyPoints[0].LHPosition)) {
+		return false;
+	}
+	for (int32_t i{ 1 }; i < Spell.NumKeyPoints; i++) {
+		if (!IsValidMove(Spell.KeyPoints[i - 1], Spell.KeyPoints[i], Spell.PositionalTolerance)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// True if the spell with the given ID is in Table exactly once and follows the spellcrafting rules
+template <int32_t N>
+constexpr bool IsValidSpell(const FSpellTableEntry (&Table)[N], int32_t ID) {
+	int32_t found{ -1 };
+	for (int32_t i{ 0 }; i < N; i++) {
+		if (Table[i].ID == ID) {
+			if (found >= 0) return false;
+			found = i;
+		}
+	}
+	return found >= 0 && IsValidSpell(Table[found]);
+}
+
+// Same rules for definitions built at runtime (e.g. loaded from a spell binary)
+bool IsValidSpell(const FSpellDef& Spell);
+
+// True if no two spells share an ID - the runtime version of the "exactly once" rule (IDs must already be valid)
+bool HasUniqueSpellIDs(const std::vector<FSpellDef>& Spells);
+
+// Copies a spell table into recognizer definitions (see MakeSpellSet())
+std::vector<FSpellDef> MakeSpellDefs(const FSpellTableEntry* Table, int32_t NumSpells);
+
+} // namespace SpellRecognition
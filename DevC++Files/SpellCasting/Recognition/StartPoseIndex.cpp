@@ -0,0 +1,187 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "StartPoseIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace SpellRecognition {
+
+// Bucket layout - grid space rotations stay within +/-260 deg (see USpellComponent::ToSpellcastingGrid()), anything outside goes in the end buckets
+constexpr float StartBucketMin{ -270.f };
+constexpr float StartBucketWidth{ 15.f };
+constexpr int StartBucketCount{ 36 };
+
+static float GetRotationAxis(const FRot3& Rotation, int Axis) {
+	return (Axis == 0) ? Rotation.Pitch : ((Axis == 1) ? Rotation.Yaw : Rotation.Roll);
+}
+
+static int GetStartBucket(float Angle) {
+	if (!(Angle >= StartBucketMin)) return 0; // Also catches NaN
+	const int bucket{ static_cast<int>(std::floor((Angle - StartBucketMin) / StartBucketWidth)) };
+	return (bucket < StartBucketCount) ? bucket : StartBucketCount - 1;
+}
+
+// Returns the first and last bucket a spell's start rotation tolerance overlaps on the given axis (all buckets if the axis is ignored)
+static void GetStartBucketRange(const FSpellDef& Spell, EHand Hand, int Axis, int& OutFirst, int& OutLast) {
+	const FRot3& startRotation{ (Hand == EHand::Right) ? Spell.KeyPoints[0].RHRotation : Spell.KeyPoints[0].LHRotation };
+	const float tolerance{ GetRotationAxis(Spell.RotationalTolerance, Axis) };
+
+	if (tolerance == 0) {
+		OutFirst = 0;
+		OutLast = StartBucketCount - 1;
+		return;
+	}
+	OutFirst = GetStartBucket(GetRotationAxis(startRotation, Axis) - tolerance);
+	OutLast = GetStartBucket(GetRotationAxis(startRotation, Axis) + tolerance);
+}
+
+void FStartPoseIndex::FRotationBuckets::Build(const std::vector<FSpellDef>& Spells, const std::vector<int32_t>& SpellIndices, EHand Hand)
+{
+	// Pick the axis that lists spells the fewest times in total
+	int bestEntryCount{ 0 };
+	for (int axis{ 0 }; axis < 3; axis++) {
+		int entryCount{ 0 };
+		for (int32_t i : SpellIndices) {
+			int first, last;
+			GetStartBucketRange(Spells[i], Hand, axis, first, last);
+			entryCount += last - first + 1;
+		}
+		if (axis == 0 || entryCount < bestEntryCount) {
+			Axis = axis;
+			bestEntryCount = entryCount;
+		}
+	}
+
+	Buckets.assign(StartBucketCount, std::vector<int32_t>{});
+	for (int32_t i : SpellIndices) {
+		int first, last;
+		GetStartBucketRange(Spells[i], Hand, Axis, first, last);
+		for (int bucket{ first }; bucket <= last; bucket++) {
+			Buckets[bucket].push_back(i); // SpellIndices are ascending, so every bucket is too
+		}
+	}
+}
+
+int FStartPoseIndex::FRotationBuckets::FindBucket(const FRot3& Rotation) const
+{
+	return GetStartBucket(GetRotationAxis(Rotation, Axis));
+}
+
+bool FStartPoseIndex::FRotationBuckets::Contains(int Bucket, int32_t SpellIndex) const
+{
+	return std::binary_search(Buckets[Bucket].begin(), Buckets[Bucket].end(), SpellIndex);
+}
+
+void FStartPoseIndex::Build(const std::vector<FSpellDef>& Spells)
+{
+	SpellCount = static_cast<int32_t>(Spells.size());
+
+	SingleHandSpells.clear();
+	AllSpells.clear();
+	for (int32_t i{ 0 }; i < SpellCount; i++) {
+		if (Spells[i].KeyPoints.empty()) continue; // Can never be cast
+		if (!Spells[i].isDualOnly) SingleHandSpells.push_back(i);
+		AllSpells.push_back(i);
+	}
+
+	SingleRH.Build(Spells, SingleHandSpells, EHand::Right);
+	SingleLH.Build(Spells, SingleHandSpells, EHand::Left);
+	DualRH.Build(Spells, AllSpells, EHand::Right);
+	DualLH.Build(Spells, AllSpells, EHand::Left);
+}
+
+void FStartPoseIndex::FindCandidates(const FRot3& RHRotation, const FRot3& LHRotation, bool isRHCasting, bool isLHCasting, std::vector<int32_t>& OutCandidates) const
+{
+	OutCandidates.clear();
+	if (SpellCount == 0) return;
+
+	if (isRHCasting && isLHCasting) { // Must be in both hands' buckets
+		const std::vector<int32_t>& RHBucket{ DualRH.Find(RHRotation) };
+		const std::vector<int32_t>& LHBucket{ DualLH.Find(LHRotation) };
+		std::set_intersection(RHBucket.begin(), RHBucket.end(), LHBucket.begin(), LHBucket.end(), std::back_inserter(OutCandidates));
+	}
+	else if (isRHCasting) {
+		const std::vector<int32_t>& RHBucket{ SingleRH.Find(RHRotation) };
+		OutCandidates.assign(RHBucket.begin(), RHBucket.end());
+	}
+	else if (isLHCasting) {
+		const std::vector<int32_t>& LHBucket{ SingleLH.Find(LHRotation) };
+		OutCandidates.assign(LHBucket.begin(), LHBucket.end());
+	}
+	else { // Nothing to check against - every spell is a candidate
+		for (int32_t i{ 0 }; i < SpellCount; i++) {
+			OutCandidates.push_back(i);
+		}
+	}
+}
+
+void FStartPoseIndex::FindAllCandidates(bool isRHCasting, bool isLHCasting, std::vector<int32_t>& OutCandidates) const
+{
+	OutCandidates.clear();
+	if (isRHCasting && isLHCasting) {
+		OutCandidates.assign(AllSpells.begin(), AllSpells.end());
+	}
+	else if (isRHCasting || isLHCasting) {
+		OutCandidates.assign(SingleHandSpells.begin(), SingleHandSpells.end());
+	}
+	else { // Nothing to check against - every spell is a candidate
+		for (int32_t i{ 0 }; i < SpellCount; i++) {
+			OutCandidates.push_back(i);
+		}
+	}
+}
+
+// Keys - single RH buckets, then single LH buckets, then every pair of dual RH and LH buckets
+int32_t FStartPoseIndex::FindBucketKey(const FRot3& RHRotation, const FRot3& LHRotation, bool isRHCasting, bool isLHCasting) const
+{
+	if (SpellCount == 0) return -1;
+
+	if (isRHCasting && isLHCasting) {
+		return 2 * StartBucketCount + DualRH.FindBucket(RHRotation) * StartBucketCount + DualLH.FindBucket(LHRotation);
+	}
+	if (isRHCasting) {
+		return SingleRH.FindBucket(RHRotation);
+	}
+	if (isLHCasting) {
+		return StartBucketCount + SingleLH.FindBucket(LHRotation);
+	}
+	return -1;
+}
+
+int32_t FStartPoseIndex::NumBucketKeys() const
+{
+	return 2 * StartBucketCount + StartBucketCount * StartBucketCount;
+}
+
+void FStartPoseIndex::CountLeftOut(int32_t Key, uint32_t Times, const std::vector<FSpellDef>& Spells, FRejectionCounters& OutCounters) const
+{
+	if (Key < 0 || Key >= NumBucketKeys() || Times == 0) return;
+
+	if (Key >= 2 * StartBucketCount) {
+		const int RHBucket{ (Key - 2 * StartBucketCount) / StartBucketCount };
+		const int LHBucket{ (Key - 2 * StartBucketCount) % StartBucketCount };
+		for (int32_t i : AllSpells) {
+			if (!DualRH.Contains(RHBucket, i)) {
+				OutCounters.Add(Spells[i].ID, ERejectHand::Right, ERejectReason::StartRotation, Times);
+			}
+			else if (!DualLH.Contains(LHBucket, i)) {
+				OutCounters.Add(Spells[i].ID, ERejectHand::Left, ERejectReason::StartRotation, Times);
+			}
+		}
+		return;
+	}
+
+	const bool isRH{ Key < StartBucketCount };
+	const FRotationBuckets& buckets{ isRH ? SingleRH : SingleLH };
+	const int bucket{ isRH ? Key : Key - StartBucketCount };
+	for (int32_t i : SingleHandSpells) {
+		if (!buckets.Contains(bucket, i)) {
+			OutCounters.Add(Spells[i].ID, isRH ? ERejectHand::Right : ERejectHand::Left, ERejectReason::StartRotation, Times);
+		}
+	}
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,61 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Start pose index - finds the spells that could possibly start from a pose, without checking every spell
+* Used by FSpellRecognizer::SpellSetup() so only those spells are reset and given the full start checks
+*
+* Spells are split into single hand (not isDualOnly) and dual hand tables, then bucketed on one rotation axis of keypoint 0
+* The axis is picked per table and hand when the index is built (whichever one splits the spells best - usually Roll)
+* NOTE: The index is conservative - spells it returns may still fail the start checks, spells it leaves out could never pass them
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+#include "RejectionCounters.h"
+
+namespace SpellRecognition {
+
+class FStartPoseIndex {
+public:
+	// Rebuilds the index - must be called whenever the spell definitions change
+	void Build(const std::vector<FSpellDef>& Spells);
+
+	// Fills OutCandidates with the index (ascending) of every spell that could start from the given hand rotations
+	void FindCandidates(const FRot3& RHRotation, const FRot3& LHRotation, bool isRHCasting, bool isLHCasting, std::vector<int32_t>& OutCandidates) const;
+
+	// Fills OutCandidates with every spell that can be cast with the casting hands, whatever their rotation
+	// The buckets are Euler angles, so this is what the quaternion rotation checks use (they accept rotations the buckets would leave out)
+	void FindAllCandidates(bool isRHCasting, bool isLHCasting, std::vector<int32_t>& OutCandidates) const;
+
+	// Which buckets FindCandidates() takes the candidates from, in [0, NumBucketKeys()) - -1 if it leaves nothing out (no spells, no hand casting)
+	// The key alone says which spells were left out, so they can be counted later (see CountLeftOut()) instead of walked on every cast
+	int32_t FindBucketKey(const FRot3& RHRotation, const FRot3& LHRotation, bool isRHCasting, bool isLHCasting) const;
+	int32_t NumBucketKeys() const;
+
+	// Adds Times start rotation rejections for every spell the buckets of Key leave out
+	// Blamed on the first hand (RH first, the same order SpellSetup() checks them in) whose bucket the spell is not in
+	void CountLeftOut(int32_t Key, uint32_t Times, const std::vector<FSpellDef>& Spells, FRejectionCounters& OutCounters) const;
+
+private:
+	// Keypoint 0 rotation buckets for one hand - each spell is listed in every bucket its start rotation tolerance overlaps
+	struct FRotationBuckets {
+		int Axis{ 0 }; // 0 = Pitch, 1 = Yaw, 2 = Roll
+		std::vector<std::vector<int32_t>> Buckets{};
+
+		void Build(const std::vector<FSpellDef>& Spells, const std::vector<int32_t>& SpellIndices, EHand Hand);
+		int FindBucket(const FRot3& Rotation) const;
+		const std::vector<int32_t>& Find(const FRot3& Rotation) const { return Buckets[FindBucket(Rotation)]; }
+		bool Contains(int Bucket, int32_t SpellIndex) const;
+	};
+
+	FRotationBuckets SingleRH{}; // Spells that can be cast with one hand
+	FRotationBuckets SingleLH{};
+	FRotationBuckets DualRH{}; // Every spell - dual casting can cast anything
+	FRotationBuckets DualLH{};
+	std::vector<int32_t> SingleHandSpells{}; // Ascending
+	std::vector<int32_t> AllSpells{}; // Ascending, every spell with keypoints
+	int32_t SpellCount{ 0 };
+};
+
+} // namespace SpellRecognition
@@ -0,0 +1,586 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "ToleranceKernels.h"
+#include "KernelOps.h"
+#include "RecognizerMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SpellRecognition {
+
+void FToleranceLanes::Resize(int32_t NewLaneCount)
+{
+	LaneCount = NewLaneCount;
+	const size_t paddedCount{ static_cast<size_t>((NewLaneCount + ToleranceLaneWidth - 1) / ToleranceLaneWidth * ToleranceLaneWidth) };
+
+	for (std::vector<float>* field : {
+		&PrevX, &PrevY, &PrevZ, &EndX, &EndY, &EndZ, &Scale,
+		&StaticTolX, &StaticTolY, &StaticTolZ, &MoveTolX, &MoveTolY, &MoveTolZ,
+		&Pitch, &Yaw, &Roll, &StaticTolPitch, &StaticTolYaw, &StaticTolRoll,
+		&MoveMinPitch, &MoveMinYaw, &MoveMinRoll, &MoveMaxPitch, &MoveMaxYaw, &MoveMaxRoll,
+		&OrientX, &OrientY, &OrientZ, &OrientW, &StaticSwingYY, &StaticSwingYZ, &StaticSwingZZ, &StaticTwist,
+		&PathStartX, &PathStartY, &PathStartZ, &PathStartW, &PathX, &PathY, &PathZ, &PathW,
+		&PathEndX, &PathEndY, &PathEndZ, &PathEndW, &PathEndCos, &PathEndSin, &MoveSwing, &MoveTwist,
+		&DirXYx, &DirXYy, &LengthXY, &WidthXY, &DirXZx, &DirXZz, &LengthXZ, &WidthXZ, &DirYZy, &DirYZz, &LengthYZ, &WidthYZ,
+		&ArcCentreX, &ArcCentreY, &ArcCentreZ, &ArcX, &ArcY, &ArcZ, &ArcRadius, &ArcTolerance, &ArcWidth }) {
+		field->assign(paddedCount, 0.f);
+	}
+	KeyPointID.assign(paddedCount, -1);
+}
+
+// Returns IgnoredTolerance in place of 0 tolerances so the kernels don't need to check for them
+static float ToLaneTolerance(float Tolerance) {
+	return (Tolerance == 0) ? IgnoredTolerance : Tolerance;
+}
+
+// Stores the geometry of the I/J part of a line in a lane - only if both axes move and need checking (see LineMoveInTolerance())
+static void SetLaneDiagonal(float DeltaI, float DeltaJ, float TolI, float TolJ, float& DirI, float& DirJ, float& Length, float& Width) {
+	if (TolI != 0 && DeltaI != 0 && TolJ != 0 && DeltaJ != 0) {
+		const FLineSegment segment{ MakeLineSegment(DeltaI, DeltaJ) };
+		DirI = segment.DirI;
+		DirJ = segment.DirJ;
+		Length = segment.Length;
+		Width = TolI;
+	}
+	else {
+		DirI = 0.f;
+		DirJ = 0.f;
+		Length = 0.f;
+		Width = IgnoredTolerance;
+	}
+}
+
+// Stores the circle of an arc move in a lane - anything else gets an arc that always passes
+static void SetLaneArc(FToleranceLanes& Lanes, int32_t Lane, const FVec3& StartPos, const FVec3& EndPos, EMotion Motion, const FVec3& MoveTolerance) {
+	const FVec3 centre{ IsArc(Motion) ? GetArcCentre(StartPos, EndPos, Motion) : FVec3{} };
+	Lanes.ArcCentreX[Lane] = centre.X;
+	Lanes.ArcCentreY[Lane] = centre.Y;
+	Lanes.ArcCentreZ[Lane] = centre.Z;
+	Lanes.ArcX[Lane] = (IsArc(Motion) && StartPos.X != EndPos.X) ? 1.f : 0.f;
+	Lanes.ArcY[Lane] = (IsArc(Motion) && StartPos.Y != EndPos.Y) ? 1.f : 0.f;
+	Lanes.ArcZ[Lane] = (IsArc(Motion) && StartPos.Z != EndPos.Z) ? 1.f : 0.f;
+	Lanes.ArcRadius[Lane] = IsArc(Motion) ? (StartPos - centre).GetAbsMax() : 0.f;
+
+	// Same width as ArcMoveInTolerance() - the tighter of the two moving axes
+	float width{ IgnoredTolerance };
+	width = (Lanes.ArcX[Lane] != 0) ? std::min(width, ToLaneTolerance(MoveTolerance.X)) : width;
+	width = (Lanes.ArcY[Lane] != 0) ? std::min(width, ToLaneTolerance(MoveTolerance.Y)) : width;
+	width = (Lanes.ArcZ[Lane] != 0) ? std::min(width, ToLaneTolerance(MoveTolerance.Z)) : width;
+	Lanes.ArcTolerance[Lane] = width;
+	Lanes.ArcWidth[Lane] = width;
+}
+
+// Stores the quaternion version of the keypoint's rotation checks in a lane (see OrientationEqual() & OrientationMoveInTolerance())
+static void SetLaneOrientation(FToleranceLanes& Lanes, int32_t Lane, const FRot3& StartRot, const FRot3& EndRot, const FRot3& RotTolerance) {
+	const FQuat4 orientation{ ToQuat(EndRot) };
+	const FSwingTwistLimits staticLimits{ MakeStaticLimits(EndRot, RotTolerance) };
+	Lanes.OrientX[Lane] = orientation.X;
+	Lanes.OrientY[Lane] = orientation.Y;
+	Lanes.OrientZ[Lane] = orientation.Z;
+	Lanes.OrientW[Lane] = orientation.W;
+	Lanes.StaticSwingYY[Lane] = staticLimits.SwingYY;
+	Lanes.StaticSwingYZ[Lane] = staticLimits.SwingYZ;
+	Lanes.StaticSwingZZ[Lane] = staticLimits.SwingZZ;
+	Lanes.StaticTwist[Lane] = staticLimits.Twist;
+
+	const FOrientationPath path{ MakeOrientationPath(ToQuat(StartRot), orientation) };
+	const FSwingTwistLimits moveLimits{ MakeMoveLimits(RotTolerance) };
+	Lanes.PathStartX[Lane] = path.Start.X;
+	Lanes.PathStartY[Lane] = path.Start.Y;
+	Lanes.PathStartZ[Lane] = path.Start.Z;
+	Lanes.PathStartW[Lane] = path.Start.W;
+	Lanes.PathX[Lane] = path.Path.X;
+	Lanes.PathY[Lane] = path.Path.Y;
+	Lanes.PathZ[Lane] = path.Path.Z;
+	Lanes.PathW[Lane] = path.Path.W;
+	Lanes.PathEndX[Lane] = path.End.X;
+	Lanes.PathEndY[Lane] = path.End.Y;
+	Lanes.PathEndZ[Lane] = path.End.Z;
+	Lanes.PathEndW[Lane] = path.End.W;
+	Lanes.PathEndCos[Lane] = path.EndCos;
+	Lanes.PathEndSin[Lane] = path.EndSin;
+	Lanes.MoveSwing[Lane] = moveLimits.SwingYY;
+	Lanes.MoveTwist[Lane] = moveLimits.Twist;
+}
+
+void FToleranceLanes::SetKeyPoint(int32_t Lane, const FSpellDef& Spell, int kpID, EHand Hand, float MaxMoveTolerance)
+{
+	const FKeyPointDef& kp{ Spell.KeyPoints[kpID] };
+	const FKeyPointDef& kpPrev{ (kpID == 0) ? Spell.KeyPoints[0] : Spell.KeyPoints[kpID - 1] };
+	const bool isRH{ Hand == EHand::Right };
+
+	const FVec3& endPos{ isRH ? kp.RHPosition : kp.LHPosition };
+	const FRot3& endRot{ isRH ? kp.RHRotation : kp.LHRotation };
+	const FRot3& startRot{ isRH ? kpPrev.RHRotation : kpPrev.LHRotation };
+	// Point movements must stay on the keypoint, so they start where they end
+	const FVec3& startPos{ (kp.Motion == EMotion::Point) ? endPos : (isRH ? kpPrev.RHPosition : kpPrev.LHPosition) };
+
+	KeyPointID[Lane] = kpID;
+
+	PrevX[Lane] = startPos.X;
+	PrevY[Lane] = startPos.Y;
+	PrevZ[Lane] = startPos.Z;
+	EndX[Lane] = endPos.X;
+	EndY[Lane] = endPos.Y;
+	EndZ[Lane] = endPos.Z;
+
+	const FVec3 moveTolerance{ Spell.PositionalTolerance * MaxMoveTolerance };
+	const FVec3 staticTolerance{ moveTolerance / 2 };
+	MoveTolX[Lane] = ToLaneTolerance(moveTolerance.X);
+	MoveTolY[Lane] = ToLaneTolerance(moveTolerance.Y);
+	MoveTolZ[Lane] = ToLaneTolerance(moveTolerance.Z);
+	StaticTolX[Lane] = ToLaneTolerance(staticTolerance.X);
+	StaticTolY[Lane] = ToLaneTolerance(staticTolerance.Y);
+	StaticTolZ[Lane] = ToLaneTolerance(staticTolerance.Z);
+
+	const FRot3& rotTolerance{ Spell.RotationalTolerance };
+	Pitch[Lane] = endRot.Pitch;
+	Yaw[Lane] = endRot.Yaw;
+	Roll[Lane] = endRot.Roll;
+	StaticTolPitch[Lane] = ToLaneTolerance(rotTolerance.Pitch);
+	StaticTolYaw[Lane] = ToLaneTolerance(rotTolerance.Yaw);
+	StaticTolRoll[Lane] = ToLaneTolerance(rotTolerance.Roll);
+
+	// Same bounds as RotationMoveInTolerance()
+	MoveMinPitch[Lane] = (rotTolerance.Pitch == 0) ? -IgnoredTolerance : std::min(startRot.Pitch, endRot.Pitch) - rotTolerance.Pitch;
+	MoveMaxPitch[Lane] = (rotTolerance.Pitch == 0) ? IgnoredTolerance : std::max(startRot.Pitch, endRot.Pitch) + rotTolerance.Pitch;
+	MoveMinYaw[Lane] = (rotTolerance.Yaw == 0) ? -IgnoredTolerance : std::min(startRot.Yaw, endRot.Yaw) - rotTolerance.Yaw;
+	MoveMaxYaw[Lane] = (rotTolerance.Yaw == 0) ? IgnoredTolerance : std::max(startRot.Yaw, endRot.Yaw) + rotTolerance.Yaw;
+	MoveMinRoll[Lane] = (rotTolerance.Roll == 0) ? -IgnoredTolerance : std::min(startRot.Roll, endRot.Roll) - rotTolerance.Roll;
+	MoveMaxRoll[Lane] = (rotTolerance.Roll == 0) ? IgnoredTolerance : std::max(startRot.Roll, endRot.Roll) + rotTolerance.Roll;
+
+	if (isQuaternionRotation) {
+		SetLaneOrientation(*this, Lane, startRot, endRot, rotTolerance);
+	}
+
+	// Same axis pairs as LineMoveInTolerance() - a YZ check only happens if X is not paired with Y already
+	// Arcs move diagonally from keypoint to keypoint too, but they are checked against their circle instead
+	const FVec3 delta{ IsArc(kp.Motion) ? FVec3{} : endPos - startPos };
+	SetLaneDiagonal(delta.X, delta.Y, moveTolerance.X, moveTolerance.Y, DirXYx[Lane], DirXYy[Lane], LengthXY[Lane], WidthXY[Lane]);
+	if (WidthXY[Lane] == IgnoredTolerance) {
+		SetLaneDiagonal(delta.X, delta.Z, moveTolerance.X, moveTolerance.Z, DirXZx[Lane], DirXZz[Lane], LengthXZ[Lane], WidthXZ[Lane]);
+	}
+	else {
+		SetLaneDiagonal(0.f, 0.f, 0.f, 0.f, DirXZx[Lane], DirXZz[Lane], LengthXZ[Lane], WidthXZ[Lane]);
+	}
+	SetLaneDiagonal(delta.Y, delta.Z, moveTolerance.Y, moveTolerance.Z, DirYZy[Lane], DirYZz[Lane], LengthYZ[Lane], WidthYZ[Lane]);
+
+	SetLaneArc(*this, Lane, startPos, endPos, kp.Motion, moveTolerance);
+}
+
+static_assert(ToleranceLaneWidth % FKernelOps::Width == 0, "Lane storage must be padded to a multiple of the kernel width");
+
+// True where -Tolerance <= Value <= Tolerance (same as PointEqual())
+static MaskN WithinTolerance(VecN Value, VecN Tolerance) {
+	return FKernelOps::LessEqual(FKernelOps::Abs(Value), Tolerance);
+}
+
+// True where Min <= Value <= Max
+static MaskN WithinBounds(VecN Value, VecN Min, VecN Max) {
+	return FKernelOps::And(FKernelOps::LessEqual(Min, Value), FKernelOps::LessEqual(Value, Max));
+}
+
+// True where the I/J position is within Width of the line and no more than Width past either end (same as DiagonalMoveInTolerance())
+// Length is the grid space length of the line - unused lanes have a direction and length of 0, so they always pass
+static MaskN WithinDiagonal(VecN RelI, VecN RelJ, VecN DirI, VecN DirJ, VecN Length, VecN Width) {
+	const VecN along{ FKernelOps::Add(FKernelOps::Mul(RelI, DirI), FKernelOps::Mul(RelJ, DirJ)) }; // Projection onto the line
+	const VecN across{ FKernelOps::Sub(FKernelOps::Mul(RelI, DirJ), FKernelOps::Mul(RelJ, DirI)) }; // Perpendicular distance (signed)
+	return FKernelOps::And(
+		WithinTolerance(across, Width),
+		WithinBounds(along, FKernelOps::Sub(FKernelOps::Set(0.f), Width), FKernelOps::Add(Length, Width)));
+}
+
+// True where the position is within Width of the arc's circle (same as CurveMoveInTolerance())
+// Rel is the position relative to the centre, already multiplied by the lane's ArcX/Y/Z so the third axis drops out
+static MaskN WithinCurve(VecN RelX, VecN RelY, VecN RelZ, VecN Radius, VecN Width) {
+	const VecN actRadius{ FKernelOps::Sqrt(FKernelOps::Add(FKernelOps::Add(FKernelOps::Mul(RelX, RelX), FKernelOps::Mul(RelY, RelY)), FKernelOps::Mul(RelZ, RelZ))) };
+	return WithinTolerance(FKernelOps::Sub(actRadius, Radius), Width);
+}
+
+// Quaternion in one register per component - one orientation per lane
+struct FQuatN {
+	VecN X, Y, Z, W;
+};
+
+static FQuatN SetQuat(const FQuat4& Quat) {
+	return FQuatN{ FKernelOps::Set(Quat.X), FKernelOps::Set(Quat.Y), FKernelOps::Set(Quat.Z), FKernelOps::Set(Quat.W) };
+}
+
+static FQuatN LoadQuat(const std::vector<float>& X, const std::vector<float>& Y, const std::vector<float>& Z, const std::vector<float>& W, int32_t i) {
+	return FQuatN{ FKernelOps::Load(&X[i]), FKernelOps::Load(&Y[i]), FKernelOps::Load(&Z[i]), FKernelOps::Load(&W[i]) };
+}
+
+static VecN DotQuat(const FQuatN& A, const FQuatN& B) {
+	return FKernelOps::Add(FKernelOps::Add(FKernelOps::Mul(A.X, B.X), FKernelOps::Mul(A.Y, B.Y)), FKernelOps::Add(FKernelOps::Mul(A.Z, B.Z), FKernelOps::Mul(A.W, B.W)));
+}
+
+// A.Inverse() * B (same as FQuat4) - A does not need to be normalised, the swing/twist checks do not care
+static FQuatN InverseTimes(const FQuatN& A, const FQuatN& B) {
+	return FQuatN{
+		FKernelOps::Sub(FKernelOps::Add(FKernelOps::Mul(A.W, B.X), FKernelOps::Mul(A.Z, B.Y)), FKernelOps::Add(FKernelOps::Mul(A.X, B.W), FKernelOps::Mul(A.Y, B.Z))),
+		FKernelOps::Sub(FKernelOps::Add(FKernelOps::Mul(A.W, B.Y), FKernelOps::Mul(A.X, B.Z)), FKernelOps::Add(FKernelOps::Mul(A.Y, B.W), FKernelOps::Mul(A.Z, B.X))),
+		FKernelOps::Sub(FKernelOps::Add(FKernelOps::Mul(A.W, B.Z), FKernelOps::Mul(A.Y, B.X)), FKernelOps::Add(FKernelOps::Mul(A.X, B.Y), FKernelOps::Mul(A.Z, B.W))),
+		DotQuat(A, B) };
+}
+
+// True where Relative is within the swing/twist limits (same as InSwingTwistLimits())
+static MaskN WithinSwingTwist(const FQuatN& Relative, VecN SwingYY, VecN SwingYZ, VecN SwingZZ, VecN Twist) {
+	const VecN twistWSq{ FKernelOps::Mul(Relative.W, Relative.W) };
+	const VecN twistXSq{ FKernelOps::Mul(Relative.X, Relative.X) };
+	const VecN twistSq{ FKernelOps::Add(twistWSq, twistXSq) };
+	const VecN swingY{ FKernelOps::Sub(FKernelOps::Mul(Relative.Y, Relative.W), FKernelOps::Mul(Relative.Z, Relative.X)) };
+	const VecN swingZ{ FKernelOps::Add(FKernelOps::Mul(Relative.Z, Relative.W), FKernelOps::Mul(Relative.Y, Relative.X)) };
+	const VecN swing{ FKernelOps::Add(FKernelOps::Add(
+		FKernelOps::Mul(SwingYY, FKernelOps::Mul(swingY, swingY)),
+		FKernelOps::Mul(SwingYZ, FKernelOps::Mul(swingY, swingZ))),
+		FKernelOps::Mul(SwingZZ, FKernelOps::Mul(swingZ, swingZ))) };
+	return FKernelOps::And(
+		FKernelOps::LessEqual(swing, FKernelOps::Mul(twistSq, twistSq)),
+		FKernelOps::LessEqual(FKernelOps::Mul(Twist, twistXSq), twistWSq));
+}
+
+// Returns the index of the lowest set bit - Bits must not be 0
+static int32_t LowestSetBit(uint64_t Bits) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, Bits);
+	return static_cast<int32_t>(index);
+#else
+	return __builtin_ctzll(Bits);
+#endif
+}
+
+// Calls Kernel(Lane, LiveBits) for every group of Width lanes that has at least one live lane
+// Dead groups are skipped without being loaded, so the cost follows the number of live spells rather than the total
+template<typename KernelType>
+static void ForEachLiveGroup(const FToleranceLanes& Lanes, const uint64_t* LiveMask, uint64_t* OutMask, KernelType Kernel) {
+	const uint64_t groupBits{ (uint64_t{ 1 } << FKernelOps::Width) - 1 };
+	const int32_t wordCount{ ToleranceMaskWords(Lanes.Num()) };
+
+	for (int32_t word{ 0 }; word < wordCount; word++) {
+		OutMask[word] = 0;
+		uint64_t remaining{ LiveMask[word] };
+		while (remaining != 0) {
+			const int32_t groupStart{ LowestSetBit(remaining) / FKernelOps::Width * FKernelOps::Width };
+			const uint64_t live{ (remaining >> groupStart) & groupBits };
+			remaining &= ~(groupBits << groupStart);
+
+			// Padding and dead lanes are evaluated along with the rest, so only live bits are kept
+			OutMask[word] |= (static_cast<uint64_t>(FKernelOps::Bits(Kernel(word * 64 + groupStart))) & live) << groupStart;
+		}
+	}
+}
+
+// Rotation in tolerance of keypoint - per Euler axis
+static MaskN StaticRotationInTolerance(const FToleranceLanes& Lanes, int32_t i, VecN Pitch, VecN Yaw, VecN Roll) {
+	MaskN pass{ WithinTolerance(FKernelOps::Sub(Pitch, FKernelOps::Load(&Lanes.Pitch[i])), FKernelOps::Load(&Lanes.StaticTolPitch[i])) };
+	pass = FKernelOps::And(pass, WithinTolerance(FKernelOps::Sub(Yaw, FKernelOps::Load(&Lanes.Yaw[i])), FKernelOps::Load(&Lanes.StaticTolYaw[i])));
+	return FKernelOps::And(pass, WithinTolerance(FKernelOps::Sub(Roll, FKernelOps::Load(&Lanes.Roll[i])), FKernelOps::Load(&Lanes.StaticTolRoll[i])));
+}
+
+// Rotation in tolerance of keypoint - quaternion (same as OrientationEqual())
+static MaskN StaticOrientationInTolerance(const FToleranceLanes& Lanes, int32_t i, const FQuatN& Orientation) {
+	const FQuatN relative{ InverseTimes(LoadQuat(Lanes.OrientX, Lanes.OrientY, Lanes.OrientZ, Lanes.OrientW, i), Orientation) };
+	return WithinSwingTwist(relative, FKernelOps::Load(&Lanes.StaticSwingYY[i]), FKernelOps::Load(&Lanes.StaticSwingYZ[i]),
+		FKernelOps::Load(&Lanes.StaticSwingZZ[i]), FKernelOps::Load(&Lanes.StaticTwist[i]));
+}
+
+// Position in tolerance of keypoint
+static MaskN StaticPositionInTolerance(const FToleranceLanes& Lanes, int32_t i, VecN PosX, VecN PosY, VecN PosZ) {
+	const VecN scale{ FKernelOps::Load(&Lanes.Scale[i]) };
+	MaskN pass{ WithinTolerance(FKernelOps::Sub(PosX, FKernelOps::Mul(FKernelOps::Load(&Lanes.EndX[i]), scale)), FKernelOps::Load(&Lanes.StaticTolX[i])) };
+	pass = FKernelOps::And(pass, WithinTolerance(FKernelOps::Sub(PosY, FKernelOps::Mul(FKernelOps::Load(&Lanes.EndY[i]), scale)), FKernelOps::Load(&Lanes.StaticTolY[i])));
+	return FKernelOps::And(pass, WithinTolerance(FKernelOps::Sub(PosZ, FKernelOps::Mul(FKernelOps::Load(&Lanes.EndZ[i]), scale)), FKernelOps::Load(&Lanes.StaticTolZ[i])));
+}
+
+// Ignored axes are clamped to this in the swept check - IgnoredTolerance times a movement would overflow
+constexpr float SweptToleranceLimit{ 1.0e6f };
+
+// Position swept from the previous sample to this one touches the tolerance box of keypoint - a separating axis test, so no division
+// Mid is the middle of the swept segment relative to the hand start position, Half half of the segment and AbsHalf its absolute value
+// NOTE: Same as StaticPositionInTolerance() if the hand has not moved (Half is 0)
+static MaskN StaticSweepInTolerance(const FToleranceLanes& Lanes, int32_t i, VecN MidX, VecN MidY, VecN MidZ,
+	VecN HalfX, VecN HalfY, VecN HalfZ, VecN AbsHalfX, VecN AbsHalfY, VecN AbsHalfZ) {
+	const VecN scale{ FKernelOps::Load(&Lanes.Scale[i]) };
+	const VecN limit{ FKernelOps::Set(SweptToleranceLimit) };
+	const VecN tolX{ FKernelOps::Min(FKernelOps::Load(&Lanes.StaticTolX[i]), limit) };
+	const VecN tolY{ FKernelOps::Min(FKernelOps::Load(&Lanes.StaticTolY[i]), limit) };
+	const VecN tolZ{ FKernelOps::Min(FKernelOps::Load(&Lanes.StaticTolZ[i]), limit) };
+	const VecN relX{ FKernelOps::Sub(MidX, FKernelOps::Mul(FKernelOps::Load(&Lanes.EndX[i]), scale)) };
+	const VecN relY{ FKernelOps::Sub(MidY, FKernelOps::Mul(FKernelOps::Load(&Lanes.EndY[i]), scale)) };
+	const VecN relZ{ FKernelOps::Sub(MidZ, FKernelOps::Mul(FKernelOps::Load(&Lanes.EndZ[i]), scale)) };
+
+	// Box axes - the segment's bounds overlap the box
+	MaskN pass{ WithinTolerance(relX, FKernelOps::Add(tolX, AbsHalfX)) };
+	pass = FKernelOps::And(pass, WithinTolerance(relY, FKernelOps::Add(tolY, AbsHalfY)));
+	pass = FKernelOps::And(pass, WithinTolerance(relZ, FKernelOps::Add(tolZ, AbsHalfZ)));
+
+	// Segment direction crossed with each box axis - the segment does not pass by a corner of the box
+	pass = FKernelOps::And(pass, WithinTolerance(FKernelOps::Sub(FKernelOps::Mul(relY, HalfZ), FKernelOps::Mul(relZ, HalfY)),
+		FKernelOps::Add(FKernelOps::Mul(tolY, AbsHalfZ), FKernelOps::Mul(tolZ, AbsHalfY))));
+	pass = FKernelOps::And(pass, WithinTolerance(FKernelOps::Sub(FKernelOps::Mul(relZ, HalfX), FKernelOps::Mul(relX, HalfZ)),
+		FKernelOps::Add(FKernelOps::Mul(tolX, AbsHalfZ), FKernelOps::Mul(tolZ, AbsHalfX))));
+	return FKernelOps::And(pass, WithinTolerance(FKernelOps::Sub(FKernelOps::Mul(relX, HalfY), FKernelOps::Mul(relY, HalfX)),
+		FKernelOps::Add(FKernelOps::Mul(tolX, AbsHalfY), FKernelOps::Mul(tolY, AbsHalfX))));
+}
+
+// Rotation within the bounds of the move - per Euler axis
+static MaskN MoveRotationInTolerance(const FToleranceLanes& Lanes, int32_t i, VecN Pitch, VecN Yaw, VecN Roll) {
+	MaskN pass{ WithinBounds(Pitch, FKernelOps::Load(&Lanes.MoveMinPitch[i]), FKernelOps::Load(&Lanes.MoveMaxPitch[i])) };
+	pass = FKernelOps::And(pass, WithinBounds(Yaw, FKernelOps::Load(&Lanes.MoveMinYaw[i]), FKernelOps::Load(&Lanes.MoveMaxYaw[i])));
+	return FKernelOps::And(pass, WithinBounds(Roll, FKernelOps::Load(&Lanes.MoveMinRoll[i]), FKernelOps::Load(&Lanes.MoveMaxRoll[i])));
+}
+
+// Rotation within tolerance of the move's path - quaternion (same as OrientationMoveInTolerance())
+static MaskN MoveOrientationInTolerance(const FToleranceLanes& Lanes, int32_t i, const FQuatN& Orientation) {
+	const FQuatN start{ LoadQuat(Lanes.PathStartX, Lanes.PathStartY, Lanes.PathStartZ, Lanes.PathStartW, i) };
+	const FQuatN path{ LoadQuat(Lanes.PathX, Lanes.PathY, Lanes.PathZ, Lanes.PathW, i) };
+	const FQuatN end{ LoadQuat(Lanes.PathEndX, Lanes.PathEndY, Lanes.PathEndZ, Lanes.PathEndW, i) };
+	const VecN alongStart{ DotQuat(Orientation, start) };
+	const VecN alongPath{ DotQuat(Orientation, path) };
+
+	// Closest orientation on the path - the projection if it is between the ends, otherwise the closer end
+	const VecN pastEnd{ FKernelOps::Sub(FKernelOps::Mul(alongStart, FKernelOps::Load(&Lanes.PathEndSin[i])), FKernelOps::Mul(alongPath, FKernelOps::Load(&Lanes.PathEndCos[i]))) };
+	const MaskN isOffPath{ FKernelOps::LessEqual(FKernelOps::Mul(alongPath, pastEnd), FKernelOps::Set(0.f)) };
+	const MaskN isStartCloser{ FKernelOps::LessEqual(FKernelOps::Abs(DotQuat(Orientation, end)), FKernelOps::Abs(alongStart)) };
+	const FQuatN closest{
+		FKernelOps::Select(isOffPath, FKernelOps::Select(isStartCloser, start.X, end.X), FKernelOps::Add(FKernelOps::Mul(start.X, alongStart), FKernelOps::Mul(path.X, alongPath))),
+		FKernelOps::Select(isOffPath, FKernelOps::Select(isStartCloser, start.Y, end.Y), FKernelOps::Add(FKernelOps::Mul(start.Y, alongStart), FKernelOps::Mul(path.Y, alongPath))),
+		FKernelOps::Select(isOffPath, FKernelOps::Select(isStartCloser, start.Z, end.Z), FKernelOps::Add(FKernelOps::Mul(start.Z, alongStart), FKernelOps::Mul(path.Z, alongPath))),
+		FKernelOps::Select(isOffPath, FKernelOps::Select(isStartCloser, start.W, end.W), FKernelOps::Add(FKernelOps::Mul(start.W, alongStart), FKernelOps::Mul(path.W, alongPath))) };
+
+	const VecN swing{ FKernelOps::Load(&Lanes.MoveSwing[i]) };
+	return WithinSwingTwist(InverseTimes(closest, Orientation), swing, FKernelOps::Set(0.f), swing, FKernelOps::Load(&Lanes.MoveTwist[i]));
+}
+
+// Position within the box around the move (length check) and the width of diagonal & arc moves
+static MaskN MovePositionInTolerance(const FToleranceLanes& Lanes, int32_t i, VecN PosX, VecN PosY, VecN PosZ) {
+	const VecN scale{ FKernelOps::Load(&Lanes.Scale[i]) };
+
+	// Position within the box around the move (length check)
+	const VecN startX{ FKernelOps::Mul(FKernelOps::Load(&Lanes.PrevX[i]), scale) };
+	const VecN startY{ FKernelOps::Mul(FKernelOps::Load(&Lanes.PrevY[i]), scale) };
+	const VecN startZ{ FKernelOps::Mul(FKernelOps::Load(&Lanes.PrevZ[i]), scale) };
+	const VecN endX{ FKernelOps::Mul(FKernelOps::Load(&Lanes.EndX[i]), scale) };
+	const VecN endY{ FKernelOps::Mul(FKernelOps::Load(&Lanes.EndY[i]), scale) };
+	const VecN endZ{ FKernelOps::Mul(FKernelOps::Load(&Lanes.EndZ[i]), scale) };
+	const VecN tolX{ FKernelOps::Load(&Lanes.MoveTolX[i]) };
+	const VecN tolY{ FKernelOps::Load(&Lanes.MoveTolY[i]) };
+	const VecN tolZ{ FKernelOps::Load(&Lanes.MoveTolZ[i]) };
+	MaskN pass{ WithinBounds(PosX, FKernelOps::Sub(FKernelOps::Min(startX, endX), tolX), FKernelOps::Add(FKernelOps::Max(startX, endX), tolX)) };
+	pass = FKernelOps::And(pass, WithinBounds(PosY, FKernelOps::Sub(FKernelOps::Min(startY, endY), tolY), FKernelOps::Add(FKernelOps::Max(startY, endY), tolY)));
+	pass = FKernelOps::And(pass, WithinBounds(PosZ, FKernelOps::Sub(FKernelOps::Min(startZ, endZ), tolZ), FKernelOps::Add(FKernelOps::Max(startZ, endZ), tolZ)));
+
+	// Position within the width of diagonal moves
+	const VecN relX{ FKernelOps::Sub(PosX, startX) };
+	const VecN relY{ FKernelOps::Sub(PosY, startY) };
+	const VecN relZ{ FKernelOps::Sub(PosZ, startZ) };
+	pass = FKernelOps::And(pass, WithinDiagonal(relX, relY, FKernelOps::Load(&Lanes.DirXYx[i]), FKernelOps::Load(&Lanes.DirXYy[i]),
+		FKernelOps::Mul(FKernelOps::Load(&Lanes.LengthXY[i]), scale), FKernelOps::Load(&Lanes.WidthXY[i])));
+	pass = FKernelOps::And(pass, WithinDiagonal(relX, relZ, FKernelOps::Load(&Lanes.DirXZx[i]), FKernelOps::Load(&Lanes.DirXZz[i]),
+		FKernelOps::Mul(FKernelOps::Load(&Lanes.LengthXZ[i]), scale), FKernelOps::Load(&Lanes.WidthXZ[i])));
+	pass = FKernelOps::And(pass, WithinDiagonal(relY, relZ, FKernelOps::Load(&Lanes.DirYZy[i]), FKernelOps::Load(&Lanes.DirYZz[i]),
+		FKernelOps::Mul(FKernelOps::Load(&Lanes.LengthYZ[i]), scale), FKernelOps::Load(&Lanes.WidthYZ[i])));
+
+	// Position within the width of arc moves
+	const VecN arcX{ FKernelOps::Mul(FKernelOps::Sub(PosX, FKernelOps::Mul(FKernelOps::Load(&Lanes.ArcCentreX[i]), scale)), FKernelOps::Load(&Lanes.ArcX[i])) };
+	const VecN arcY{ FKernelOps::Mul(FKernelOps::Sub(PosY, FKernelOps::Mul(FKernelOps::Load(&Lanes.ArcCentreY[i]), scale)), FKernelOps::Load(&Lanes.ArcY[i])) };
+	const VecN arcZ{ FKernelOps::Mul(FKernelOps::Sub(PosZ, FKernelOps::Mul(FKernelOps::Load(&Lanes.ArcCentreZ[i]), scale)), FKernelOps::Load(&Lanes.ArcZ[i])) };
+	return FKernelOps::And(pass, WithinCurve(arcX, arcY, arcZ, FKernelOps::Mul(FKernelOps::Load(&Lanes.ArcRadius[i]), scale), FKernelOps::Load(&Lanes.ArcWidth[i])));
+}
+
+// Runs the keypoint rotation check together with PositionCheck(i) for every live lane group
+// NOTE: The rotation check is picked once per call rather than per lane group, so the loops themselves never branch on it
+template<typename PositionCheckType>
+static void EvaluateStaticLanes(const FToleranceLanes& Lanes, const FRot3& Rotation, const FQuat4& Orientation, const uint64_t* LiveMask, uint64_t* OutMask,
+	PositionCheckType PositionCheck) {
+	if (Lanes.isQuaternionRotation) {
+		const FQuatN orientation{ SetQuat(Orientation) };
+		ForEachLiveGroup(Lanes, LiveMask, OutMask, [&](int32_t i) {
+			return FKernelOps::And(StaticOrientationInTolerance(Lanes, i, orientation), PositionCheck(i));
+		});
+	}
+	else {
+		const VecN pitch{ FKernelOps::Set(Rotation.Pitch) };
+		const VecN yaw{ FKernelOps::Set(Rotation.Yaw) };
+		const VecN roll{ FKernelOps::Set(Rotation.Roll) };
+		ForEachLiveGroup(Lanes, LiveMask, OutMask, [&](int32_t i) {
+			return FKernelOps::And(StaticRotationInTolerance(Lanes, i, pitch, yaw, roll), PositionCheck(i));
+		});
+	}
+}
+
+void EvaluateStaticTolerance(const FToleranceLanes& Lanes, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation, const uint64_t* LiveMask, uint64_t* OutMask)
+{
+	const VecN posX{ FKernelOps::Set(RelativePos.X) };
+	const VecN posY{ FKernelOps::Set(RelativePos.Y) };
+	const VecN posZ{ FKernelOps::Set(RelativePos.Z) };
+	EvaluateStaticLanes(Lanes, Rotation, Orientation, LiveMask, OutMask, [&](int32_t i) {
+		return StaticPositionInTolerance(Lanes, i, posX, posY, posZ);
+	});
+}
+
+void EvaluateSweptStaticTolerance(const FToleranceLanes& Lanes, const FVec3& PrevRelativePos, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation,
+	const uint64_t* LiveMask, uint64_t* OutMask)
+{
+	const FVec3 half{ (RelativePos - PrevRelativePos) * 0.5f };
+	const FVec3 mid{ PrevRelativePos + half };
+	const VecN midX{ FKernelOps::Set(mid.X) };
+	const VecN midY{ FKernelOps::Set(mid.Y) };
+	const VecN midZ{ FKernelOps::Set(mid.Z) };
+	const VecN halfX{ FKernelOps::Set(half.X) };
+	const VecN halfY{ FKernelOps::Set(half.Y) };
+	const VecN halfZ{ FKernelOps::Set(half.Z) };
+	const VecN absHalfX{ FKernelOps::Set(std::fabs(half.X)) };
+	const VecN absHalfY{ FKernelOps::Set(std::fabs(half.Y)) };
+	const VecN absHalfZ{ FKernelOps::Set(std::fabs(half.Z)) };
+	EvaluateStaticLanes(Lanes, Rotation, Orientation, LiveMask, OutMask, [&](int32_t i) {
+		return StaticSweepInTolerance(Lanes, i, midX, midY, midZ, halfX, halfY, halfZ, absHalfX, absHalfY, absHalfZ);
+	});
+}
+
+void EvaluateMoveTolerance(const FToleranceLanes& Lanes, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation, const uint64_t* LiveMask, uint64_t* OutMask)
+{
+	const VecN posX{ FKernelOps::Set(RelativePos.X) };
+	const VecN posY{ FKernelOps::Set(RelativePos.Y) };
+	const VecN posZ{ FKernelOps::Set(RelativePos.Z) };
+
+	if (Lanes.isQuaternionRotation) {
+		const FQuatN orientation{ SetQuat(Orientation) };
+		ForEachLiveGroup(Lanes, LiveMask, OutMask, [&](int32_t i) {
+			return FKernelOps::And(MoveOrientationInTolerance(Lanes, i, orientation), MovePositionInTolerance(Lanes, i, posX, posY, posZ));
+		});
+	}
+	else {
+		const VecN pitch{ FKernelOps::Set(Rotation.Pitch) };
+		const VecN yaw{ FKernelOps::Set(Rotation.Yaw) };
+		const VecN roll{ FKernelOps::Set(Rotation.Roll) };
+		ForEachLiveGroup(Lanes, LiveMask, OutMask, [&](int32_t i) {
+			return FKernelOps::And(MoveRotationInTolerance(Lanes, i, pitch, yaw, roll), MovePositionInTolerance(Lanes, i, posX, posY, posZ));
+		});
+	}
+}
+
+// Scalar rejection reasons - same checks as the kernels, one lane at a time
+
+static bool InLaneTolerance(float Value, float Tolerance) {
+	return std::fabs(Value) <= Tolerance;
+}
+
+static bool InLaneBounds(float Value, float Min, float Max) {
+	return Min <= Value && Value <= Max;
+}
+
+static bool InLaneDiagonalWidth(float RelI, float RelJ, float DirI, float DirJ, float Width) {
+	return InLaneTolerance(RelI * DirJ - RelJ * DirI, Width);
+}
+
+static bool InLaneDiagonalLength(float RelI, float RelJ, float DirI, float DirJ, float Length, float Width) {
+	return InLaneBounds(RelI * DirI + RelJ * DirJ, -Width, Length + Width);
+}
+
+// Same as the kernels' quaternion checks, one lane at a time
+static bool InLaneOrientation(const FToleranceLanes& Lanes, int32_t i, const FQuat4& Orientation) {
+	const FQuat4 keyPoint{ Lanes.OrientX[i], Lanes.OrientY[i], Lanes.OrientZ[i], Lanes.OrientW[i] };
+	const FSwingTwistLimits limits{ Lanes.StaticSwingYY[i], Lanes.StaticSwingYZ[i], Lanes.StaticSwingZZ[i], Lanes.StaticTwist[i] };
+	return OrientationEqual(Orientation, keyPoint, limits);
+}
+
+static bool InLaneOrientationMove(const FToleranceLanes& Lanes, int32_t i, const FQuat4& Orientation) {
+	FOrientationPath path{};
+	path.Start = FQuat4{ Lanes.PathStartX[i], Lanes.PathStartY[i], Lanes.PathStartZ[i], Lanes.PathStartW[i] };
+	path.Path = FQuat4{ Lanes.PathX[i], Lanes.PathY[i], Lanes.PathZ[i], Lanes.PathW[i] };
+	path.End = FQuat4{ Lanes.PathEndX[i], Lanes.PathEndY[i], Lanes.PathEndZ[i], Lanes.PathEndW[i] };
+	path.EndCos = Lanes.PathEndCos[i];
+	path.EndSin = Lanes.PathEndSin[i];
+	const FSwingTwistLimits limits{ Lanes.MoveSwing[i], 0.f, Lanes.MoveSwing[i], Lanes.MoveTwist[i] };
+	return OrientationMoveInTolerance(Orientation, path, limits);
+}
+
+ERejectReason ClassifyStaticRejection(const FToleranceLanes& Lanes, int32_t Lane, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation)
+{
+	const int32_t i{ Lane };
+	if (Lanes.isQuaternionRotation) {
+		if (!InLaneOrientation(Lanes, i, Orientation)) {
+			return ERejectReason::StartRotation;
+		}
+	}
+	else if (!InLaneTolerance(Rotation.Pitch - Lanes.Pitch[i], Lanes.StaticTolPitch[i]) ||
+		!InLaneTolerance(Rotation.Yaw - Lanes.Yaw[i], Lanes.StaticTolYaw[i]) ||
+		!InLaneTolerance(Rotation.Roll - Lanes.Roll[i], Lanes.StaticTolRoll[i])) {
+		return ERejectReason::StartRotation;
+	}
+	if (!InLaneTolerance(RelativePos.X - Lanes.EndX[i] * Lanes.Scale[i], Lanes.StaticTolX[i]) ||
+		!InLaneTolerance(RelativePos.Y - Lanes.EndY[i] * Lanes.Scale[i], Lanes.StaticTolY[i]) ||
+		!InLaneTolerance(RelativePos.Z - Lanes.EndZ[i] * Lanes.Scale[i], Lanes.StaticTolZ[i])) {
+		return ERejectReason::StartPosition;
+	}
+	return ERejectReason::Num;
+}
+
+ERejectReason ClassifyMoveRejection(const FToleranceLanes& Lanes, int32_t Lane, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation)
+{
+	const int32_t i{ Lane };
+	if (Lanes.isQuaternionRotation) {
+		if (!InLaneOrientationMove(Lanes, i, Orientation)) {
+			return ERejectReason::RotationMove;
+		}
+	}
+	else if (!InLaneBounds(Rotation.Pitch, Lanes.MoveMinPitch[i], Lanes.MoveMaxPitch[i]) ||
+		!InLaneBounds(Rotation.Yaw, Lanes.MoveMinYaw[i], Lanes.MoveMaxYaw[i]) ||
+		!InLaneBounds(Rotation.Roll, Lanes.MoveMinRoll[i], Lanes.MoveMaxRoll[i])) {
+		return ERejectReason::RotationMove;
+	}
+
+	// Box around the move - past the end of an axis that moves is the length, off an axis that does not is the width
+	const float scale{ Lanes.Scale[i] };
+	const float start[3]{ Lanes.PrevX[i] * scale, Lanes.PrevY[i] * scale, Lanes.PrevZ[i] * scale };
+	const float end[3]{ Lanes.EndX[i] * scale, Lanes.EndY[i] * scale, Lanes.EndZ[i] * scale };
+	const float tolerance[3]{ Lanes.MoveTolX[i], Lanes.MoveTolY[i], Lanes.MoveTolZ[i] };
+	const float pos[3]{ RelativePos.X, RelativePos.Y, RelativePos.Z };
+	bool isOffLine{ false };
+	bool isPastEnd{ false };
+	for (int axis{ 0 }; axis < 3; axis++) {
+		if (!InLaneBounds(pos[axis], std::min(start[axis], end[axis]) - tolerance[axis], std::max(start[axis], end[axis]) + tolerance[axis])) {
+			isPastEnd = isPastEnd || start[axis] != end[axis];
+			isOffLine = isOffLine || start[axis] == end[axis];
+		}
+	}
+	if (isOffLine) {
+		return ERejectReason::LineWidth; // Width first - a hand off the line has usually overshot too
+	}
+	if (isPastEnd) {
+		return ERejectReason::LineLength;
+	}
+
+	const float relX{ pos[0] - start[0] };
+	const float relY{ pos[1] - start[1] };
+	const float relZ{ pos[2] - start[2] };
+	if (!InLaneDiagonalWidth(relX, relY, Lanes.DirXYx[i], Lanes.DirXYy[i], Lanes.WidthXY[i]) ||
+		!InLaneDiagonalWidth(relX, relZ, Lanes.DirXZx[i], Lanes.DirXZz[i], Lanes.WidthXZ[i]) ||
+		!InLaneDiagonalWidth(relY, relZ, Lanes.DirYZy[i], Lanes.DirYZz[i], Lanes.WidthYZ[i])) {
+		return ERejectReason::LineWidth;
+	}
+	if (!InLaneDiagonalLength(relX, relY, Lanes.DirXYx[i], Lanes.DirXYy[i], Lanes.LengthXY[i] * scale, Lanes.WidthXY[i]) ||
+		!InLaneDiagonalLength(relX, relZ, Lanes.DirXZx[i], Lanes.DirXZz[i], Lanes.LengthXZ[i] * scale, Lanes.WidthXZ[i]) ||
+		!InLaneDiagonalLength(relY, relZ, Lanes.DirYZy[i], Lanes.DirYZz[i], Lanes.LengthYZ[i] * scale, Lanes.WidthYZ[i])) {
+		return ERejectReason::LineLength;
+	}
+
+	const float arcX{ (pos[0] - Lanes.ArcCentreX[i] * scale) * Lanes.ArcX[i] };
+	const float arcY{ (pos[1] - Lanes.ArcCentreY[i] * scale) * Lanes.ArcY[i] };
+	const float arcZ{ (pos[2] - Lanes.ArcCentreZ[i] * scale) * Lanes.ArcZ[i] };
+	if (!InLaneTolerance(std::sqrt((arcX * arcX) + (arcY * arcY) + (arcZ * arcZ)) - Lanes.ArcRadius[i] * scale, Lanes.ArcWidth[i])) {
+		return ERejectReason::LineWidth; // Off the curve
+	}
+	return ERejectReason::Num;
+}
+
+const char* GetToleranceKernelName()
+{
+	return FKernelOps::Name;
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,132 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Batch tolerance checks - test one hand against the active keypoint of every candidate spell in one pass
+* Keypoints are stored as a structure of arrays (one lane per spell) so the checks can run 4 (SSE/NEON) or 8 (AVX) spells at a time
+* The result of every check is a bit mask, bit N set == lane N is in tolerance
+* Only lanes set in the LiveMask passed in are checked (spells that can no longer be cast are skipped a whole vector at a time)
+*
+* NOTE: Every lane is precomputed so the kernels never branch:
+*	Ignored axes (tolerance 0) get a tolerance so large that the check always passes
+*	RotationMoveInTolerance() bounds only depend on the keypoints, so they are stored ready made
+*	DiagonalMoveInTolerance() only depends on the direction and length of the line, which are stored per axis pair (normalised
+*	direction, unit space length) - the width is a perpendicular distance and the length a projection, no sqrt or trig per frame
+*	ArcMoveInTolerance() only depends on the centre and radius of the circle, so there is no trig per frame - the box check
+*	already keeps the hand in the quadrant the arc sweeps through, so the kernel just checks the distance from the centre
+* NOTE: Lane positions are in unit space, the spell scale is applied inside the kernels
+* NOTE: Rotations are checked per Euler axis, or as quaternions if isQuaternionRotation is set (see FSwingTwistLimits in RecognizerMath.h)
+*	The keypoint orientations, swing/twist limits and move paths are stored ready made, so the quaternion checks are multiply-adds too
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+#include "RejectionCounters.h"
+
+namespace SpellRecognition {
+
+// Used in place of a tolerance of 0 (ignore axis) - large but finite so it survives fast-math builds
+constexpr float IgnoredTolerance{ 3.0e38f };
+
+// Number of lanes evaluated together by the widest kernel - lane storage is always padded to a multiple of this
+constexpr int32_t ToleranceLaneWidth{ 8 };
+
+// Returns the number of 64 bit words required to hold a mask of LaneCount bits
+inline int32_t ToleranceMaskWords(int32_t LaneCount) { return (LaneCount + 63) / 64; }
+
+inline bool IsLaneSet(const uint64_t* Mask, int32_t Lane) { return (Mask[Lane / 64] >> (Lane % 64)) & 1; }
+inline void SetLaneBit(uint64_t* Mask, int32_t Lane) { Mask[Lane / 64] |= uint64_t{ 1 } << (Lane % 64); }
+
+// One hand's keypoint requirements for a set of spells, one lane per spell
+struct FToleranceLanes {
+	// Keypoint positions in unit space (multiplied by Scale in the kernels)
+	std::vector<float> PrevX{}, PrevY{}, PrevZ{}; // Previous keypoint - start of the movement
+	std::vector<float> EndX{}, EndY{}, EndZ{}; // The keypoint being checked
+	std::vector<float> Scale{};
+
+	// Positional tolerances in grid space
+	std::vector<float> StaticTolX{}, StaticTolY{}, StaticTolZ{}; // Used when checking if the keypoint is complete
+	std::vector<float> MoveTolX{}, MoveTolY{}, MoveTolZ{}; // Used when checking the movement towards the keypoint
+
+	// Rotations - Deg
+	std::vector<float> Pitch{}, Yaw{}, Roll{};
+	std::vector<float> StaticTolPitch{}, StaticTolYaw{}, StaticTolRoll{};
+	std::vector<float> MoveMinPitch{}, MoveMinYaw{}, MoveMinRoll{};
+	std::vector<float> MoveMaxPitch{}, MoveMaxYaw{}, MoveMaxRoll{};
+
+	// Rotations - quaternions, only filled in if isQuaternionRotation is set
+	std::vector<float> OrientX{}, OrientY{}, OrientZ{}, OrientW{}; // The keypoint
+	std::vector<float> StaticSwingYY{}, StaticSwingYZ{}, StaticSwingZZ{}, StaticTwist{};
+	std::vector<float> PathStartX{}, PathStartY{}, PathStartZ{}, PathStartW{}; // FOrientationPath of the move
+	std::vector<float> PathX{}, PathY{}, PathZ{}, PathW{};
+	std::vector<float> PathEndX{}, PathEndY{}, PathEndZ{}, PathEndW{};
+	std::vector<float> PathEndCos{}, PathEndSin{};
+	std::vector<float> MoveSwing{}, MoveTwist{}; // Move limits are a circle (see MakeMoveLimits()), so one swing value is enough
+
+	// Diagonal line movements - normalised line direction, length in unit space and width tolerance per axis pair
+	// (width is IgnoredTolerance and the rest 0 if unused)
+	std::vector<float> DirXYx{}, DirXYy{}, LengthXY{}, WidthXY{};
+	std::vector<float> DirXZx{}, DirXZz{}, LengthXZ{}, WidthXZ{};
+	std::vector<float> DirYZy{}, DirYZz{}, LengthYZ{}, WidthYZ{};
+
+	// Arc movements - circle centre and radius in unit space, width tolerance (IgnoredTolerance if the keypoint is not an arc)
+	// ArcX/Y/Z are 1 for the two axes the arc moves in and 0 for the other, so one kernel covers every plane
+	// ArcWidth is what the kernels check - it is only ArcTolerance once the scale is set (the size of the circle is not known before then)
+	std::vector<float> ArcCentreX{}, ArcCentreY{}, ArcCentreZ{};
+	std::vector<float> ArcX{}, ArcY{}, ArcZ{};
+	std::vector<float> ArcRadius{}, ArcTolerance{}, ArcWidth{};
+
+	// Keypoint currently stored in each lane, -1 if the lane has not been set yet
+	std::vector<int32_t> KeyPointID{};
+
+	// Which rotation lanes SetKeyPoint() fills in and the kernels check - set it before filling the lanes
+	bool isQuaternionRotation{ false };
+
+	int32_t Num() const { return LaneCount; }
+
+	// Sets the number of lanes, every lane is cleared
+	void Resize(int32_t NewLaneCount);
+
+	// Stores keypoint kpID of Spell for the given hand in Lane
+	void SetKeyPoint(int32_t Lane, const FSpellDef& Spell, int kpID, EHand Hand, float MaxMoveTolerance);
+
+	// isScaleSet is the spell's FSpellState::isScaleSet - arc widths are only checked once it is true
+	void SetScale(int32_t Lane, float NewScale, bool isScaleSet) {
+		Scale[Lane] = NewScale;
+		ArcWidth[Lane] = isScaleSet ? ArcTolerance[Lane] : IgnoredTolerance;
+	}
+	// True if SetScale() with the same values would not change the lane
+	bool HasScale(int32_t Lane, float OtherScale, bool isScaleSet) const {
+		return Scale[Lane] == OtherScale && ArcWidth[Lane] == (isScaleSet ? ArcTolerance[Lane] : IgnoredTolerance);
+	}
+
+private:
+	int32_t LaneCount{ 0 };
+};
+
+// Keypoint complete check for every lane - same as USpellComponent's old CheckRH/LHStaticTolerance()
+// RelativePos is the hand position relative to the hand start position, masks must hold ToleranceMaskWords(Lanes.Num()) words
+// Orientation is ToQuat(Rotation) - only used if Lanes.isQuaternionRotation, Rotation is only used if it is not
+void EvaluateStaticTolerance(const FToleranceLanes& Lanes, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation, const uint64_t* LiveMask, uint64_t* OutMask);
+
+// Keypoint complete check for every lane, swept from PrevRelativePos to RelativePos - passes if the hand went through the tolerance box
+// anywhere in between, so a fast hand can not jump over a keypoint between two samples (like continuous collision detection)
+// Rotation is only checked at RelativePos - hands sweep through positions much faster than they turn
+// NOTE: Same as EvaluateStaticTolerance() if the hand has not moved
+void EvaluateSweptStaticTolerance(const FToleranceLanes& Lanes, const FVec3& PrevRelativePos, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation,
+	const uint64_t* LiveMask, uint64_t* OutMask);
+
+// Movement check for every lane - same as USpellComponent's old CheckRH/LHMoveTolerance()
+// RelativePos is the hand position relative to the hand start position, masks must hold ToleranceMaskWords(Lanes.Num()) words
+void EvaluateMoveTolerance(const FToleranceLanes& Lanes, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation, const uint64_t* LiveMask, uint64_t* OutMask);
+
+// Which check failed for one lane - plain scalar versions of the kernels above, only used on spells that have been rejected
+// ClassifyStaticRejection() returns StartRotation/StartPosition (it is only a rejection in SpellSetup()), ClassifyMoveRejection() returns RotationMove/LineWidth/LineLength
+// Both return ERejectReason::Num if the lane passes (only possible right on the edge of a tolerance, the kernels round differently)
+ERejectReason ClassifyStaticRejection(const FToleranceLanes& Lanes, int32_t Lane, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation);
+ERejectReason ClassifyMoveRejection(const FToleranceLanes& Lanes, int32_t Lane, const FVec3& RelativePos, const FRot3& Rotation, const FQuat4& Orientation);
+
+// Returns the name of the instruction set the kernels were compiled for (AVX, SSE2, NEON or Scalar)
+const char* GetToleranceKernelName();
+
+} // namespace SpellRecognition
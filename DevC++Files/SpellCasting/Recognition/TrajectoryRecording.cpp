@@ -0,0 +1,145 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "TrajectoryRecording.h"
+#include "SpellRecognizer.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace SpellRecognition {
+
+// Records are read in place, so their layout must never depend on the compiler
+static_assert(sizeof(FTrajectoryHeader) == 16, "FTrajectoryHeader must not be padded");
+static_assert(sizeof(FTrajectoryRecord) == 60, "FTrajectoryRecord must not be padded");
+static_assert(std::is_trivially_copyable<FTrajectoryRecord>::value, "FTrajectoryRecord must be plain data");
+
+static void TrajectoryVecToArray(const FVec3& Vec, float (&Out)[3]) {
+	Out[0] = Vec.X;
+	Out[1] = Vec.Y;
+	Out[2] = Vec.Z;
+}
+
+static void TrajectoryRotToArray(const FRot3& Rot, float (&Out)[3]) {
+	Out[0] = Rot.Pitch;
+	Out[1] = Rot.Yaw;
+	Out[2] = Rot.Roll;
+}
+
+FTrajectoryRecord MakeTrajectoryRecord(uint32_t Frame, float Time, uint16_t Buttons, ETrajectoryEvent Event, const FPoseSample& Pose)
+{
+	FTrajectoryRecord Record{};
+	Record.Frame = Frame;
+	Record.Time = Time;
+	Record.Buttons = Buttons;
+	Record.Event = static_cast<uint16_t>(Event);
+	TrajectoryVecToArray(Pose.RH.Position, Record.RHPosition);
+	TrajectoryRotToArray(Pose.RH.Rotation, Record.RHRotation);
+	TrajectoryVecToArray(Pose.LH.Position, Record.LHPosition);
+	TrajectoryRotToArray(Pose.LH.Rotation, Record.LHRotation);
+	return Record;
+}
+
+FPoseSample GetTrajectoryPose(const FTrajectoryRecord& Record)
+{
+	FPoseSample Pose{};
+	Pose.RH.Position = FVec3{ Record.RHPosition[0], Record.RHPosition[1], Record.RHPosition[2] };
+	Pose.RH.Rotation = FRot3{ Record.RHRotation[0], Record.RHRotation[1], Record.RHRotation[2] };
+	Pose.LH.Position = FVec3{ Record.LHPosition[0], Record.LHPosition[1], Record.LHPosition[2] };
+	Pose.LH.Rotation = FRot3{ Record.LHRotation[0], Record.LHRotation[1], Record.LHRotation[2] };
+	return Pose;
+}
+
+void FTrajectoryRecorder::Write(std::vector<uint8_t>& Out) const
+{
+	FTrajectoryHeader header{};
+	header.Magic = TrajectoryMagic;
+	header.Version = TrajectoryVersion;
+	header.RecordCount = static_cast<uint32_t>(Records.size());
+	header.RecordSize = sizeof(FTrajectoryRecord);
+
+	const size_t recordBytes{ Records.size() * sizeof(FTrajectoryRecord) };
+	Out.resize(sizeof(FTrajectoryHeader) + recordBytes);
+	std::memcpy(Out.data(), &header, sizeof(FTrajectoryHeader));
+	if (recordBytes > 0) std::memcpy(Out.data() + sizeof(FTrajectoryHeader), Records.data(), recordBytes);
+}
+
+bool LoadTrajectoryRecording(const void* Data, size_t Size, std::vector<FTrajectoryRecord>& OutRecords)
+{
+	if (Data == nullptr || Size < sizeof(FTrajectoryHeader)) {
+		return false;
+	}
+	FTrajectoryHeader header{};
+	std::memcpy(&header, Data, sizeof(FTrajectoryHeader));
+	if (header.Magic != TrajectoryMagic || header.Version != TrajectoryVersion || header.RecordSize != sizeof(FTrajectoryRecord)) {
+		return false;
+	}
+	if (sizeof(FTrajectoryHeader) + uint64_t{ header.RecordCount } * sizeof(FTrajectoryRecord) != Size) {
+		return false;
+	}
+
+	std::vector<FTrajectoryRecord> records(header.RecordCount);
+	if (header.RecordCount > 0) std::memcpy(records.data(), static_cast<const uint8_t*>(Data) + sizeof(FTrajectoryHeader), Size - sizeof(FTrajectoryHeader));
+	for (const FTrajectoryRecord& record : records) {
+		if (record.Event > static_cast<uint16_t>(ETrajectoryEvent::SpellUpdate)) {
+			return false;
+		}
+	}
+
+	OutRecords.swap(records);
+	return true;
+}
+
+int32_t ReplayTrajectory(FSpellRecognizer& Recognizer, const FTrajectoryRecord* Records, size_t NumRecords, std::vector<FReplayCast>& OutCasts)
+{
+	OutCasts.clear();
+	int32_t numSamples{ 0 };
+
+	for (size_t i{ 0 }; i < NumRecords; i++) {
+		const FTrajectoryRecord& record{ Records[i] };
+		const ETrajectoryEvent event{ static_cast<ETrajectoryEvent>(record.Event) };
+		if (event == ETrajectoryEvent::Frame && !OutCasts.empty() && !OutCasts.back().isComplete && (record.Buttons & (TrajectoryRHCast | TrajectoryLHCast)) != 0) {
+			// End of a tick mid cast - USpellComponent asks for the leading spell once per tick
+			FReplayCast& cast{ OutCasts.back() };
+			const int32_t leader{ Recognizer.GetLeadingSpell() };
+			if (leader != cast.LeadSpellID) {
+				cast.LeadSpellID = leader;
+				cast.LeadTime = record.Time;
+			}
+		}
+		if (event == ETrajectoryEvent::Frame || (event == ETrajectoryEvent::SpellUpdate && OutCasts.empty())) {
+			continue; // Nothing fed to the recognizer (an update before any setup means the recording started mid cast)
+		}
+
+		const bool isRHCasting{ (record.Buttons & TrajectoryRHCast) != 0 };
+		const bool isLHCasting{ (record.Buttons & TrajectoryLHCast) != 0 };
+		const FPoseSample pose{ GetTrajectoryPose(record) };
+		numSamples++;
+
+		if (event == ETrajectoryEvent::SpellSetup) {
+			OutCasts.emplace_back();
+			FReplayCast& cast{ OutCasts.back() };
+			cast.StartFrame = record.Frame;
+			cast.StartTime = record.Time;
+			cast.NumSamples = 1;
+			Recognizer.SpellSetup(pose, isRHCasting, isLHCasting);
+			cast.SpellID = Recognizer.GetActiveSpells();
+		}
+		else {
+			FReplayCast& cast{ OutCasts.back() };
+			cast.NumSamples++;
+			const bool isSpellComplete{ Recognizer.UpdateSpellStates(pose, isRHCasting, isLHCasting) };
+			if (!cast.isComplete) {
+				cast.SpellID = Recognizer.GetActiveSpells();
+				if (isSpellComplete) {
+					cast.isComplete = true;
+					cast.CompleteFrame = record.Frame;
+					cast.CompleteTime = record.Time;
+				}
+			}
+		}
+	}
+	return numSamples;
+}
+
+} // namespace SpellRecognition
@@ -0,0 +1,95 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Trajectory recordings - every pose the recognizer was fed (and one per tick) with the button states and a timestamp
+* Recorded by USpellComponent (isRecordingTrajectories), replayed by Tools/TrajectoryReplay to reproduce a player's cast
+* or benchmark the recognizer far faster than realtime
+*
+* Layout - little endian, no padding, read in place like the spell binary (see SpellBinary.h):
+*	FTrajectoryHeader
+*	FTrajectoryRecord[RecordCount] - in the order they happened
+* NOTE: Bump TrajectoryVersion whenever the record changes - files of any other version are rejected
+*/
+
+#pragma once
+
+#include "RecognizerTypes.h"
+
+#include <cstddef>
+
+namespace SpellRecognition {
+
+class FSpellRecognizer;
+
+constexpr uint32_t TrajectoryMagic{ 0x544C5053 }; // "SPLT" when read as bytes
+constexpr uint32_t TrajectoryVersion{ 1 };
+
+// What a record was used for
+enum class ETrajectoryEvent : uint16_t {
+	Frame, // End of a tick - not fed to the recognizer, keeps the trajectory complete between casts
+	SpellSetup, // Fed to FSpellRecognizer::SpellSetup()
+	SpellUpdate // Fed to FSpellRecognizer::UpdateSpellStates()
+};
+
+// Button bits of FTrajectoryRecord::Buttons
+constexpr uint16_t TrajectoryRHCast{ 1 << 0 };
+constexpr uint16_t TrajectoryLHCast{ 1 << 1 };
+constexpr uint16_t TrajectoryRHLaunch{ 1 << 2 };
+constexpr uint16_t TrajectoryLHLaunch{ 1 << 3 };
+
+struct FTrajectoryHeader {
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t RecordCount;
+	uint32_t RecordSize; // sizeof(FTrajectoryRecord) - a cheap check that the file was written by the same layout
+};
+
+struct FTrajectoryRecord {
+	uint32_t Frame; // Tick the record belongs to
+	float Time; // Seconds since the recording started
+	uint16_t Buttons;
+	uint16_t Event; // ETrajectoryEvent
+	float RHPosition[3]; // Spellcasting grid space
+	float RHRotation[3]; // Pitch, Yaw, Roll
+	float LHPosition[3];
+	float LHRotation[3];
+};
+
+FTrajectoryRecord MakeTrajectoryRecord(uint32_t Frame, float Time, uint16_t Buttons, ETrajectoryEvent Event, const FPoseSample& Pose);
+FPoseSample GetTrajectoryPose(const FTrajectoryRecord& Record);
+
+// Collects records while playing, then writes them out in one go
+class FTrajectoryRecorder {
+public:
+	void Add(const FTrajectoryRecord& Record) { Records.push_back(Record); }
+	void Reset() { Records.clear(); }
+	int32_t Num() const { return static_cast<int32_t>(Records.size()); }
+
+	// Replaces Out with the recording file
+	void Write(std::vector<uint8_t>& Out) const;
+
+private:
+	std::vector<FTrajectoryRecord> Records{};
+};
+
+// Fills OutRecords from a recording file - returns false (and leaves OutRecords alone) if Data is not a recording of this version
+bool LoadTrajectoryRecording(const void* Data, size_t Size, std::vector<FTrajectoryRecord>& OutRecords);
+
+// What the recognizer made of one cast (a SpellSetup record and every SpellUpdate after it) in a replay
+struct FReplayCast {
+	uint32_t StartFrame{ 0 };
+	float StartTime{ 0.f };
+	int32_t SpellID{ NoSpell }; // GetActiveSpells() once the spell completed, or when the cast ended if it never did
+	bool isComplete{ false };
+	uint32_t CompleteFrame{ 0 }; // Frame of the sample that completed the spell
+	float CompleteTime{ 0.f };
+	int32_t NumSamples{ 0 }; // Samples fed to the recognizer for this cast
+	int32_t LeadSpellID{ NoSpell }; // GetLeadingSpell() at the end of the last tick before the spell completed (or the cast ended)
+	float LeadTime{ 0.f }; // When LeadSpellID took the lead - how much sooner the spell could have been pre-warmed
+};
+
+// Feeds every SpellSetup/SpellUpdate record through Recognizer exactly as USpellComponent did - returns the number of samples fed
+// NOTE: Recognizer must already have its spells and settings
+int32_t ReplayTrajectory(FSpellRecognizer& Recognizer, const FTrajectoryRecord* Records, size_t NumRecords, std::vector<FReplayCast>& OutCasts);
+
+} // namespace SpellRecognition
@@ -2,6 +2,8 @@
 
 
 #include "Spell.h"
+#include "CastLatencyTracer.h"
+#include "TimerManager.h"
 
 // Sets default values
 ASpell::ASpell()
@@ -33,6 +35,8 @@ void ASpell::SpellSetup(SpellID Element, SpellID Modifier, FVector InitialTarget
 
 	// Update mesh materials if required
 	SetMeshMaterial(GetMaterial());
+
+	FCastLatencyTracer::Get().Mark(ECastLatencyChain::Launch, ECastTracePoint::SpellSetup);
 }
 
 // Called when the game starts or when spawned
@@ -40,19 +44,16 @@ void ASpell::BeginPlay()
 {
 	Super::BeginPlay();
 	
+	FCastLatencyTracer::Get().Mark(ECastLatencyChain::Launch, ECastTracePoint::SpawnActor); // BeginPlay runs inside SpawnActor
 }
 
-// Called every frame
-void ASpell::Tick(float DeltaTime)
+// Launch animation done - the duration only counts down from here
+// A timer rather than a countdown in Tick(), so spells with nothing left to animate can stop ticking (see TickSleep.h)
+void ASpell::CompleteLaunch()
 {
-	Super::Tick(DeltaTime);
-	if (!(DefaultDuration >= 9999.f) && isLaunchComplete){ // Only count down once launch is complete
-		if (DefaultDuration > 0) {
-			DefaultDuration -= DeltaTime;
-		}
-		else {
-			EndSpell();
-		}
+	isLaunchComplete = true;
+	if (!(DefaultDuration >= 9999.f)) {
+		GetWorld()->GetTimerManager().SetTimer(DurationTimer, this, &ASpell::EndSpell, FMath::Max(DefaultDuration, KINDA_SMALL_NUMBER), false);
 	}
 }
 
@@ -23,9 +23,6 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	virtual void SetMeshMaterial(UMaterialInterface* NewMaterial);
 
 	// Public functions
@@ -74,6 +71,7 @@ protected:
 	FVector MoveDirection{};
 
 	bool isLaunchComplete{ false };
+	FTimerHandle DurationTimer; // Ends the spell DefaultDuration after the launch completes
 
 	// Spell specific Functions
 	virtual void UpdateCollision(); // Only when launch animation is complete
@@ -81,6 +79,7 @@ protected:
 	virtual void EndSpell();
 
 	// Generic spell functions
+	void CompleteLaunch();
 	float GetDistanceFactor(FVector StartPos, FVector EndPos, FVector CurrentPos);
 	float GetDistanceFactor(FVector StartPos, FVector CurrentPos, float Range);
 
@@ -0,0 +1,78 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "SpellAllocationCheck.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/UnrealMemory.h"
+#include "Recognition/AllocationCounter.h"
+
+#if SPELLCASTING_ALLOCATION_CHECK
+
+// Forwards everything to the allocator it wraps - counting every call that may allocate
+// NOTE: FMalloc is itself allocated with the system allocator (FUseSystemMallocForNew), never through GMalloc
+class FCountingMalloc final : public FMalloc {
+public:
+	explicit FCountingMalloc(FMalloc* NewInner) : Inner{ NewInner } {}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override {
+		SpellRecognition::CountAllocation();
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override {
+		SpellRecognition::CountAllocation();
+		return Inner->TryMalloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override {
+		if (Count > 0) { // Realloc to nothing is a free
+			SpellRecognition::CountAllocation();
+		}
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override {
+		if (Count > 0) {
+			SpellRecognition::CountAllocation();
+		}
+		return Inner->TryRealloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { Inner->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+private:
+	FMalloc* Inner{ nullptr };
+};
+
+// Runs while the statics are set up, before main() - no other thread exists yet to allocate through the old GMalloc mid swap
+static FMalloc* InstallCountingMalloc() {
+	FMemory::Free(FMemory::Malloc(1)); // GMalloc is only created on the first allocation
+	GMalloc = new FCountingMalloc{ GMalloc };
+	return GMalloc;
+}
+
+static FMalloc* const CountingMalloc{ InstallCountingMalloc() };
+
+bool IsAllocationCounterInstalled() {
+	return CountingMalloc != nullptr;
+}
+
+#else
+
+bool IsAllocationCounterInstalled() {
+	return false;
+}
+
+#endif
@@ -0,0 +1,22 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Allocation check - counts the heap allocations the engine makes, so USpellComponent::isAllocationCheckEnabled can check a cast allocates nothing
+* A counting allocator is put in front of GMalloc while the C++ statics are set up - it forwards everything to the real one,
+* calling SpellRecognition::CountAllocation() (see Recognition/AllocationCounter.h) for every Malloc/Realloc on the way
+* Compiled in unless SPELLCASTING_ALLOCATION_CHECK is 0 - by default it is only on in monolithic non-shipping builds (a Development game build)
+* NOTE: Statics are only set up before main() - before any other thread can allocate - in a monolithic build, the module DLLs of an
+*	editor build are loaded once the engine is running, far too late to swap GMalloc safely
+* NOTE: Installed for the whole run, like the engine's own malloc proxies - anything installed later (leak detection, the malloc profiler) wraps it
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#ifndef SPELLCASTING_ALLOCATION_CHECK
+#define SPELLCASTING_ALLOCATION_CHECK (!UE_BUILD_SHIPPING && IS_MONOLITHIC)
+#endif
+
+// False if allocations can not be counted in this build
+bool IsAllocationCounterInstalled();
@@ -0,0 +1,159 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SpellAllocationCheck.h"
+#include "SpellContainer.h"
+#include "Recognition/AllocationCounter.h"
+#include "Recognition/DtwMatcher.h"
+#include "Recognition/RecognitionBatch.h"
+#include "Recognition/RecognizerMath.h"
+#include "Recognition/SpellRecognizer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Cast allocation test - scripted casts of every spell, ticked the way USpellComponent ticks them, must make no heap allocations once warmed up
+* The same check as USpellComponent::isAllocationCheckEnabled, without a map, a headset or a player
+* Run it in a Development game build (the counting allocator is only installed in monolithic builds, see SpellAllocationCheck.h):
+*	<Game> -ExecCmds="Automation RunTests BattlemageAtlantis.SpellCasting.CastAllocations;Quit" -unattended -nullrhi
+* Anywhere else it only warns that nothing was counted
+*/
+
+constexpr float ScriptedCastScale{ 20.f };
+constexpr int32 ScriptedSamplesPerMove{ 8 };
+constexpr int32 ScriptedSamplesPerTick{ 2 }; // A 90Hz sampler and a 45Hz tick
+constexpr double ScriptedSampleTime{ 1.0 / 90.0 };
+
+struct FScriptedCast {
+	std::vector<SpellRecognition::FPoseSample> Samples{};
+	bool isRHCasting{ false };
+	bool isLHCasting{ false };
+};
+
+// Both hands Fraction of the way from keypoint From to keypoint To - no noise, the test is about allocations not tolerances
+static SpellRecognition::FPoseSample MakeScriptedSample(const SpellRecognition::FSpellDef& Spell, const SpellRecognition::FKeyPointDef& From,
+	const SpellRecognition::FKeyPointDef& To, float Fraction)
+{
+	using namespace SpellRecognition;
+	const FVec3 LHStart{ 10.f, -5.f, 3.f };
+	const FVec3 RHStart{ LHStart + Spell.LtoRRelativeStartPos * 20.f };
+	const auto PathPosition = [&To, Fraction](const FVec3& FromPos, const FVec3& ToPos) {
+		return IsArc(To.Motion) ? GetArcPosition(FromPos, ToPos, To.Motion, Fraction) : FromPos + (ToPos - FromPos) * Fraction;
+	};
+	const auto PathRotation = [Fraction](const FRot3& FromRot, const FRot3& ToRot) {
+		return FRot3{ FromRot.Pitch + (ToRot.Pitch - FromRot.Pitch) * Fraction, FromRot.Yaw + (ToRot.Yaw - FromRot.Yaw) * Fraction, FromRot.Roll + (ToRot.Roll - FromRot.Roll) * Fraction };
+	};
+
+	FPoseSample Sample{};
+	Sample.RH.Position = RHStart + PathPosition(From.RHPosition, To.RHPosition) * ScriptedCastScale;
+	Sample.LH.Position = LHStart + PathPosition(From.LHPosition, To.LHPosition) * ScriptedCastScale;
+	Sample.RH.Rotation = PathRotation(From.RHRotation, To.RHRotation);
+	Sample.LH.Rotation = PathRotation(From.LHRotation, To.LHRotation);
+	return Sample;
+}
+
+// The start pose, ScriptedSamplesPerMove samples along every move, then a few holding the last keypoint
+static FScriptedCast MakeScriptedCast(const SpellRecognition::FSpellDef& Spell, bool isRHCasting, bool isLHCasting)
+{
+	FScriptedCast Cast{};
+	Cast.isRHCasting = isRHCasting;
+	Cast.isLHCasting = isLHCasting;
+	Cast.Samples.push_back(MakeScriptedSample(Spell, Spell.KeyPoints[0], Spell.KeyPoints[0], 0.f));
+	for (size_t kp{ 1 }; kp < Spell.KeyPoints.size(); kp++) {
+		for (int32 i{ 1 }; i <= ScriptedSamplesPerMove; i++) {
+			Cast.Samples.push_back(MakeScriptedSample(Spell, Spell.KeyPoints[kp - 1], Spell.KeyPoints[kp], static_cast<float>(i) / ScriptedSamplesPerMove));
+		}
+	}
+	for (int32 i{ 0 }; i < 4; i++) {
+		Cast.Samples.push_back(MakeScriptedSample(Spell, Spell.KeyPoints.back(), Spell.KeyPoints.back(), 1.f));
+	}
+	return Cast;
+}
+
+// One cast, the recognition work of USpellComponent's ticks without a manager and with DTW matching on (SpellSetup(), UpdateSpellStates(),
+// UpdateLikelySpell(), MatchCast())
+// Returns true if the keypoint checks completed a spell
+static bool RunScriptedCast(const FScriptedCast& Cast, SpellRecognition::FSpellRecognizer& Recognizer, SpellRecognition::FDtwMatcher& DtwMatcher,
+	SpellRecognition::FRecognitionBatch& Batch)
+{
+	DtwMatcher.BeginCast(Cast.Samples[0], Cast.isRHCasting, Cast.isLHCasting);
+	if (!Recognizer.SpellSetup(Cast.Samples[0], Cast.isRHCasting, Cast.isLHCasting)) {
+		return false;
+	}
+
+	bool isComplete{ false };
+	for (size_t Next{ 1 }; Next < Cast.Samples.size() && !isComplete; Next += ScriptedSamplesPerTick) {
+		Batch.Reset();
+		SpellRecognition::FCasterUpdate& Update{ Batch.Add(Recognizer, Cast.isRHCasting, Cast.isLHCasting) };
+		for (size_t i{ Next }; i < Next + ScriptedSamplesPerTick && i < Cast.Samples.size(); i++) {
+			Update.Samples.push_back(SpellRecognition::FTimedPoseSample{ i * ScriptedSampleTime, Cast.Samples[i] });
+		}
+		Batch.Evaluate();
+
+		const SpellRecognition::FCasterUpdate& Result{ Batch.Get(0) };
+		for (const SpellRecognition::FTimedPoseSample& Sample : Result.Samples) {
+			DtwMatcher.AddSample(Sample.Pose);
+		}
+		isComplete = Result.isSpellComplete;
+
+		SpellRecognition::FSpellConfidence Confidence{};
+		Recognizer.GetLeadingSpell(&Confidence);
+	}
+
+	SpellRecognition::FDtwMatch Match{};
+	DtwMatcher.Match(Match);
+	return isComplete;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpellCastAllocationTest, "BattlemageAtlantis.SpellCasting.CastAllocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FSpellCastAllocationTest::RunTest(const FString& Parameters)
+{
+	if (!IsAllocationCounterInstalled()) {
+		AddWarning(TEXT("Allocations can only be counted in a monolithic non-shipping build (e.g. a Development game build) - nothing was checked"));
+		return true;
+	}
+
+	// Every hand combination every spell allows - made before anything is counted
+	const SpellRecognition::FSharedSpellSet& SpellSet{ USpellContainer::GetSharedSpellSet() };
+	std::vector<FScriptedCast> Casts{};
+	for (const SpellRecognition::FSpellDef& Spell : SpellSet->GetSpells()) {
+		Casts.push_back(MakeScriptedCast(Spell, true, Spell.isDualOnly));
+		if (!Spell.isDualOnly) {
+			Casts.push_back(MakeScriptedCast(Spell, false, true));
+			Casts.push_back(MakeScriptedCast(Spell, true, true));
+		}
+	}
+
+	SpellRecognition::FSpellRecognizer Recognizer{ SpellSet };
+	SpellRecognition::FDtwMatcher DtwMatcher{ SpellSet };
+	SpellRecognition::FRecognitionBatch Batch{};
+
+	// The first pass grows every buffer to size - the same as the first cast in game (see USpellComponent::isAllocationCheckArmed)
+	int32 NumWarmUpComplete{ 0 };
+	for (const FScriptedCast& Cast : Casts) {
+		NumWarmUpComplete += RunScriptedCast(Cast, Recognizer, DtwMatcher, Batch) ? 1 : 0;
+	}
+
+	uint64 Allocations{ 0 };
+	int32 NumComplete{ 0 };
+	{
+		SpellRecognition::FAllocationScope AllocationScope{ Allocations };
+		for (const FScriptedCast& Cast : Casts) {
+			NumComplete += RunScriptedCast(Cast, Recognizer, DtwMatcher, Batch) ? 1 : 0;
+		}
+	}
+
+	TestTrue(TEXT("The scripted casts complete spells"), NumComplete > 0);
+	TestEqual(TEXT("Spells completed by the counted pass and the warm up"), NumComplete, NumWarmUpComplete);
+	if (Allocations != 0) {
+		AddError(FString::Printf(TEXT("%d scripted casts made %llu heap allocations - casting should make none once warmed up"),
+			static_cast<int32>(Casts.size()), Allocations));
+	}
+	return !HasAnyErrors();
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
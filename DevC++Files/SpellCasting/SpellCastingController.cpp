@@ -2,18 +2,20 @@
 
 
 #include "SpellCastingController.h"
+#include "CastLatencyTracer.h"
+#include "SpellCastingLog.h"
 #include "MotionControllerComponent.h"
 #include "Spell_Wall.h"
 #include "Spell_Ball.h"
 #include "Spell_Beam.h"
 #include "Camera/CameraComponent.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
 // Sets default values for this component's properties
 USpellCastingController::USpellCastingController()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	// Nothing to do every frame - elements and modifiers are zeroed when the spells change (see ClearSecondarySpellsIfIdle())
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
 // Called when the game starts
@@ -25,23 +27,10 @@ void USpellCastingController::BeginPlay()
 	
 }
 
-// Called every frame
-void USpellCastingController::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
-{
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	// ...
-
-	// Zero all elements if no spell is set
-	if (ActiveRHSpell == SpellID::None && ActiveLHSpell == SpellID::None) {
-		ActiveElement = SpellID::None;
-		ActiveModifier = SpellID::None;
-	}
-}
-
 void USpellCastingController::ApplyRHSpell(SpellID spell)
 {
-	UE_LOG(LogTemp, Warning, TEXT("Applying RH Spell: %s"), *UEnum::GetValueAsString(spell));
+	TRACE_CPUPROFILER_EVENT_SCOPE(USpellCastingController::ApplyRHSpell);
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Applying RH Spell: %s"), GetSpellName(spell));
 	switch (spell) {
 	case SpellID::Wall:
 		if (ActiveRHSpell != SpellID::Wall) { // If wall is not the current spell
@@ -52,7 +41,7 @@ void USpellCastingController::ApplyRHSpell(SpellID spell)
 			// Add correct wall actor to RH (includes element and modifier)
 
 			ActiveRHSpell = SpellID::Wall;
-			UE_LOG(LogTemp, Warning, TEXT("\nWall Spell Applied in SCController\n "));
+			UE_LOG(LogSpellCasting, Verbose, TEXT("Wall Spell Applied in SCController"));
 		}
 		break;
 	case SpellID::Ball:
@@ -89,14 +78,15 @@ void USpellCastingController::ApplyRHSpell(SpellID spell)
 		}
 		break;
 	default:
-		UE_LOG(LogTemp, Error, TEXT("\nIncorrect SpellID for ApplyRHSpell(): %s\n "), *UEnum::GetValueAsString(spell));
+		UE_LOG(LogSpellCasting, Error, TEXT("\nIncorrect SpellID for ApplyRHSpell(): %s\n "), GetSpellName(spell));
 		break;
 	}
 }
 
 void USpellCastingController::ApplyLHSpell(SpellID spell)
 {
-	UE_LOG(LogTemp, Warning, TEXT("Applying LH Spell: %s"), *UEnum::GetValueAsString(spell));
+	TRACE_CPUPROFILER_EVENT_SCOPE(USpellCastingController::ApplyLHSpell);
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Applying LH Spell: %s"), GetSpellName(spell));
 	switch (spell) {
 	case SpellID::Wall:
 		if (ActiveLHSpell != SpellID::Wall) { // If wall is not the current spell
@@ -143,14 +133,15 @@ void USpellCastingController::ApplyLHSpell(SpellID spell)
 		}
 		break;
 	default:
-		UE_LOG(LogTemp, Error, TEXT("\nIncorrect SpellID for ApplyLHSpell(): %S\n "), *UEnum::GetValueAsString(spell));
+		UE_LOG(LogSpellCasting, Error, TEXT("\nIncorrect SpellID for ApplyLHSpell(): %s\n "), GetSpellName(spell));
 		break;
 	}
 }
 
 void USpellCastingController::ApplyDualHSpell(SpellID spell)
 {
-	UE_LOG(LogTemp, Warning, TEXT("Applying DualH Spell: %s"), *UEnum::GetValueAsString(spell));
+	TRACE_CPUPROFILER_EVENT_SCOPE(USpellCastingController::ApplyDualHSpell);
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Applying DualH Spell: %s"), GetSpellName(spell));
 	switch (spell) {
 	case SpellID::Wall: // || SpellID::Ball || SpellID::Beam || SpellID::Atune: this does not work?// If any of the base spells
 		ApplyRHSpell(spell);
@@ -279,14 +270,17 @@ void USpellCastingController::ApplyDualHSpell(SpellID spell)
 		}
 		break;
 	default:
-		UE_LOG(LogTemp, Error, TEXT("That DualH spell can not be applied... %s"), *UEnum::GetValueAsString(spell));
+		UE_LOG(LogSpellCasting, Error, TEXT("That DualH spell can not be applied... %s"), GetSpellName(spell));
 		break;
 	}
+	ClearSecondarySpellsIfIdle();
 }
 
 void USpellCastingController::LaunchRHSpell()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Launching RH Spell: %s"), *UEnum::GetValueAsString(ActiveRHSpell));
+	TRACE_CPUPROFILER_EVENT_SCOPE(USpellCastingController::LaunchRHSpell);
+	FCastLatencyTracer::Get().Mark(ECastLatencyChain::Launch, ECastTracePoint::LaunchSpell);
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Launching RH Spell: %s"), GetSpellName(ActiveRHSpell));
 
 	if (ActiveRHSpell != SpellID::None) { // i.e. there is a spell in RH
 		// Commence RHSpell launch
@@ -425,7 +419,9 @@ void USpellCastingController::LaunchRHSpell()
 
 void USpellCastingController::LaunchLHSpell()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Launching LH Spell: %s"), *UEnum::GetValueAsString(ActiveRHSpell));
+	TRACE_CPUPROFILER_EVENT_SCOPE(USpellCastingController::LaunchLHSpell);
+	FCastLatencyTracer::Get().Mark(ECastLatencyChain::Launch, ECastTracePoint::LaunchSpell);
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Launching LH Spell: %s"), GetSpellName(ActiveLHSpell));
 
 	if (ActiveLHSpell != SpellID::None) { // i.e. there is a spell in LH
 		// Commence LHSpell launch
@@ -563,13 +559,15 @@ void USpellCastingController::LaunchLHSpell()
 
 void USpellCastingController::LaunchDualHSpell()
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(USpellCastingController::LaunchDualHSpell);
+	FCastLatencyTracer::Get().Mark(ECastLatencyChain::Launch, ECastTracePoint::LaunchSpell);
 	if (ActiveRHSpell != ActiveLHSpell) { // If dual casting was called, but each hand contains a different spell, launch each hand separately
 		LaunchRHSpell();
 		LaunchLHSpell();
 	}
 	else { // Otherwise launch as a dual hand spell
 
-		UE_LOG(LogTemp, Warning, TEXT("Launching DualH Spell: %s"), *UEnum::GetValueAsString(ActiveRHSpell));
+		UE_LOG(LogSpellCasting, Verbose, TEXT("Launching DualH Spell: %s"), GetSpellName(ActiveRHSpell));
 		
 		if (ActiveLHSpell != SpellID::None) { // i.e. there is a spell in LH (RH==LH)
 		// Commence Dual Hand Spell launch
@@ -748,6 +746,15 @@ void USpellCastingController::ResetSecondarySpells()
 	}
 }
 
+// Zero all elements if no spell is set - an element or modifier only sticks to a spell in hand
+void USpellCastingController::ClearSecondarySpellsIfIdle()
+{
+	if (ActiveRHSpell == SpellID::None && ActiveLHSpell == SpellID::None) {
+		ActiveElement = SpellID::None;
+		ActiveModifier = SpellID::None;
+	}
+}
+
 void USpellCastingController::ConnectMotionControllers(UMotionControllerComponent* LeftController, UMotionControllerComponent* RightController, UCameraComponent* HMD)
 {
 	LHand = LeftController;
@@ -27,9 +27,6 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-
 	// The ApplySpell Functions: - These apply the relevant materials and spawn the relevant pre-launch actors
 	void ApplyRHSpell(SpellID spell);
 	void ApplyLHSpell(SpellID spell);
@@ -39,6 +36,9 @@ public:
 	void LaunchRHSpell();
 	void LaunchLHSpell();
 	void LaunchDualHSpell();
+
+	SpellID GetRHSpell() const { return ActiveRHSpell; }
+	SpellID GetLHSpell() const { return ActiveLHSpell; }
 	
 private:
 	// Variables
@@ -56,6 +56,7 @@ private:
 	// Above is the foundation, anything beyond this point is purely infrastructure and implementation used by the above functions...
 
 	void ResetSecondarySpells();
+	void ClearSecondarySpellsIfIdle();
 private:
 
 	class UCameraComponent* hmdCamera{};
@@ -0,0 +1,41 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Spellcasting log - the log category for everything logged while casting, and the helpers that keep those logs from allocating
+* Per cast and per spell messages are Verbose:
+*	Filtered out before their arguments are even evaluated - "log LogSpellCasting Verbose" in the console turns them on
+*	Compiled out completely in test and shipping builds (see SPELLCASTING_LOG_COMPILE_VERBOSITY)
+* Anything logged from the casting hot path uses:
+*	GetSpellName() for spell names - UEnum::GetValueAsString() builds an FString every call
+*	%.1f per component for vectors - FVector::ToString() builds an FString every call
+* NOTE: An enabled message still goes to the output devices, which may allocate - check allocations with Verbose off (see USpellComponent::isAllocationCheckEnabled)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpellContainer.h"
+
+#ifndef SPELLCASTING_LOG_COMPILE_VERBOSITY
+#if UE_BUILD_SHIPPING || UE_BUILD_TEST
+#define SPELLCASTING_LOG_COMPILE_VERBOSITY Log
+#else
+#define SPELLCASTING_LOG_COMPILE_VERBOSITY All
+#endif
+#endif
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSpellCasting, Log, SPELLCASTING_LOG_COMPILE_VERBOSITY);
+
+// Same names as UEnum::GetValueAsString(), without building a string
+inline const TCHAR* GetSpellName(SpellID Spell) {
+	static constexpr const TCHAR* SpellNames[]{
+		TEXT("Ball"), TEXT("Wall"), TEXT("Beam"), TEXT("Atune"),
+		TEXT("Air"), TEXT("Water"), TEXT("Earth"), TEXT("Fire"),
+		TEXT("IncDur"), TEXT("DecDur"), TEXT("IncPwr"), TEXT("DecPwr"), TEXT("Explode"), TEXT("Magnet"),
+		TEXT("None"), TEXT("Multiple")
+	};
+	static_assert(UE_ARRAY_COUNT(SpellNames) == SpellID::Multiple + 1, "A SpellID is missing its name");
+
+	const int32 Index{ static_cast<int32>(Spell) };
+	return (Index >= 0 && Index < static_cast<int32>(UE_ARRAY_COUNT(SpellNames))) ? SpellNames[Index] : TEXT("Unknown");
+}
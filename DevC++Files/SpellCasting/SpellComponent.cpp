@@ -2,11 +2,38 @@
 
 
 #include "SpellComponent.h"
+#include "CastLatencyTracer.h"
 #include "MotionControllerComponent.h"
+#include "IMotionController.h"
+#include "Features/IModularFeatures.h"
+#include "GameFramework/WorldSettings.h"
 #include "Camera/CameraComponent.h"
 #include "CastingNode.h"
 #include "SpellCastingController.h"
+#include "TimerManager.h"
+#include "TickSleep.h"
+#include "SpellAllocationCheck.h"
+#include "SpellCastingLog.h"
+#include "Recognition/AllocationCounter.h"
 
+DEFINE_LOG_CATEGORY(LogSpellCasting);
+
+// Conversions between Unreal types and the engine independent recognizer types
+static SpellRecognition::FVec3 ToRecognizerVec(const FVector& Vec) {
+	return SpellRecognition::FVec3{ Vec.X, Vec.Y, Vec.Z };
+}
+
+static SpellRecognition::FRot3 ToRecognizerRot(const FRotator& Rot) {
+	return SpellRecognition::FRot3{ Rot.Pitch, Rot.Yaw, Rot.Roll };
+}
+
+static FVector FromRecognizerVec(const SpellRecognition::FVec3& Vec) {
+	return FVector{ Vec.X, Vec.Y, Vec.Z };
+}
+
+static FRotator FromRecognizerRot(const SpellRecognition::FRot3& Rot) {
+	return FRotator{ Rot.Pitch, Rot.Yaw, Rot.Roll };
+}
 
 // Sets default values for this component's properties
 USpellComponent::USpellComponent()
@@ -17,9 +44,6 @@ USpellComponent::USpellComponent()
 
 	SpellContainer = CreateDefaultSubobject<USpellContainer>(TEXT("SpellContainer"));
 
-	// Setup Spells
-	AllSpells = SpellContainer->AllSpells;
-
 	// ******* Dev section *******
 	//SpellNodeList()
 
@@ -35,6 +59,43 @@ void USpellComponent::BeginPlay()
 	Super::BeginPlay();
 
 	// ...
+	UpdateGridTransform();
+
+	// Setup Spells - straight from the constexpr spell table, so nothing is built for the CDO
+	// Every player shares the one set of definitions, only the per-cast state is their own
+	Recognizer.SetSettings(SpellRecognition::FRecognizerSettings{ MAX_MOVE_TOLERANCE, MIN_MOVE_SCALE, isQuaternionRotationEnabled, LeadMargin, EarlyCommitScore, isSweptKeyPointsEnabled });
+	SpellRecognition::FDtwSettings DtwSettings{};
+	DtwSettings.MaxCost = DtwMaxCost;
+	DtwSettings.MinMoveScale = MIN_MOVE_SCALE;
+	DtwMatcher.SetSettings(DtwSettings);
+	DtwMatcher.SetSpells(USpellContainer::GetSharedSpellSet());
+	Recognizer.SetSpells(USpellContainer::GetSharedSpellSet());
+	Recognizer.SetListener(&RecognitionLogger);
+	ResetCastingNodes();
+
+	if (isAllocationCheckEnabled && !IsAllocationCounterInstalled()) {
+		UE_LOG(LogSpellCasting, Warning, TEXT("Allocations can only be counted in a monolithic non-shipping build (e.g. a Development game build) - the allocation check is off"));
+		isAllocationCheckEnabled = false;
+	}
+
+	// Start sampling the hands faster than we tick
+	if (isPoseSamplingEnabled && RHand && LHand && PoseSource.Init(RHand, LHand, GetWorld()->GetWorldSettings()->WorldToMeters)) {
+		PoseSampler.Start(&PoseSource, PoseSampleRate);
+	}
+	if (!PoseSampler.IsRunning()) {
+		UE_LOG(LogTemp, Warning, TEXT("Pose sampling thread not running - spells are checked once per tick"));
+	}
+
+	TrajectoryStartTime = SpellRecognition::FPoseSampler::Now();
+
+	// Hand the spell checks over to the manager - they are done after this component ticks, along with every other caster's
+	if (isBatchRecognitionEnabled) {
+		RecognitionManager = GetWorld()->GetSubsystem<USpellRecognitionManager>();
+		if (RecognitionManager) {
+			RecognitionManager->AddCaster(this, this, PrimaryComponentTick);
+		}
+	}
+
 	if (SpellControllerBlueprint) {
 		SpellCastingController = NewObject<USpellCastingController>(this, SpellControllerBlueprint);
 	}
@@ -50,52 +111,79 @@ void USpellComponent::BeginPlay()
 	}
 }
 
+void USpellComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (RecognitionManager) {
+		RecognitionManager->RemoveCaster(this, this, PrimaryComponentTick);
+		RecognitionManager = nullptr;
+	}
+	PoseSampler.Stop();
+	SaveTrajectories();
+	SaveRejectionCounters();
+	FCastLatencyTracer::Get().SaveHistograms(FPaths::ProjectSavedDir() / TEXT("Profiling") / TEXT("CastLatency.csv"));
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void USpellComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// Update dual hand delay as required
-	if (isRHCasting != isLHCasting) { // If one hand is casting
-		if (CurrentDualHandDelay <= MAX_DUAL_HAND_DELAY) {
-			CurrentDualHandDelay += DeltaTime;
+	{
+		SpellRecognition::FAllocationScope AllocationScope{ TickAllocations };
+		if (isRHCasting || isLHCasting || isRecordingTrajectories) {
+			UpdateHandPoses();
 		}
-	}
-	if (isLaunching) {
-		if (!(isRHLaunching && isLHLaunching) && CurrentDualLaunchDelay <= MAX_DUAL_HAND_DELAY) {
-			CurrentDualLaunchDelay += DeltaTime;
+		if (!isRHCasting && !isLHCasting) { // Spells can only change between casts
+			ApplyReloadedSpells();
+			PoseSampler.Clear(); // Nothing to check the samples against
 		}
-		else {
-			if (isRHLaunching && isLHLaunching) {
-				SpellCastingController->LaunchDualHSpell();
-				isLaunching = false;
-			}
-			else if (isRHLaunching && !isLHLaunching) {
-				SpellCastingController->LaunchRHSpell();
-				isLaunching = false;
-			}
-			else if (!isRHLaunching && isLHLaunching) {
-				SpellCastingController->LaunchLHSpell();
-				isLaunching = false;
-			}
+
+		// The cast window closes on its own time stamp, however long this frame was
+		CastInput.Update(SpellRecognition::FPoseSampler::Now());
+
+		if (RecognitionManager == nullptr && IsSpellUpdateDue()) {
+			CurrentSpell = UpdateSpellList();
 		}
 	}
 
-	if ((isRHCasting && isLHCasting) || // If both hands are casting OR
-		((isRHCasting != isLHCasting) && (CurrentDualHandDelay > MAX_DUAL_HAND_DELAY))) { // If one hand is casting and dual hand delay has been passed
-		CurrentSpell = UpdateSpellList();
+	// With a manager the spells are checked once every caster has ticked - see GatherRecognitionUpdate()
+	if (RecognitionManager == nullptr) {
+		EndSpellUpdate();
 	}
 
-	UpdateCastingNodes();
-
 	//UE_LOG(LogTemp, Warning, TEXT("Current Spellgrid Rotation: %s!!!"), *GetComponentRotation().ToString());
-
-	// *** DEV Section *** //
-	RunDevTests();
 	//UE_LOG(LogTemp, Warning, TEXT("Current Rotation: LH: %s; RH: %s"), *ToSpellcastingGrid(LHand->GetComponentRotation()).ToString(), *ToSpellcastingGrid(RHand->GetComponentRotation()).ToString());
 	//UE_LOG(LogTemp, Warning, TEXT("Current Location: LH: %s; RH: %s"), *ToSpellcastingGrid(LHand->GetComponentLocation()).ToString(), *ToSpellcastingGrid(RHand->GetComponentLocation()).ToString());
 }
 
+// Queues this tick's samples in the manager's batch - SpellSetup() moves the spellcasting grid, so starting a cast is never batched
+void USpellComponent::GatherRecognitionUpdate(SpellRecognition::FRecognitionBatch& Batch) {
+	if (!IsComponentTickEnabled() || !IsSpellUpdateDue()) {
+		return;
+	}
+	SpellRecognition::FAllocationScope AllocationScope{ TickAllocations };
+	if (isCasting) {
+		QueueSpellStates(Batch.Add(Recognizer, isRHCasting, isLHCasting));
+	}
+	else {
+		CurrentSpell = UpdateSpellList();
+	}
+}
+
+// The rest of the tick, now the batch has been checked - Update is nullptr if nothing was queued in GatherRecognitionUpdate()
+void USpellComponent::ApplyRecognitionUpdate(const SpellRecognition::FCasterUpdate* Update) {
+	if (!IsComponentTickEnabled()) { // Asleep - the manager still goes over every caster
+		return;
+	}
+	if (Update != nullptr) {
+		SpellRecognition::FAllocationScope AllocationScope{ TickAllocations };
+		isComplete = ApplySpellStates(*Update);
+		CurrentSpell = GetActiveSpells();
+	}
+	EndSpellUpdate();
+}
+
 bool USpellComponent::SetupHands(UMotionControllerComponent* LeftHand, UMotionControllerComponent* RightHand, UCameraComponent* hmdCam) {
 	if (LeftHand && RightHand && hmdCam) {
 		LHand = LeftHand;
@@ -109,99 +197,146 @@ bool USpellComponent::SetupHands(UMotionControllerComponent* LeftHand, UMotionCo
 
 // These four functions activate and de-activate the LH/RH casting variables
 void USpellComponent::RightHandCast() { 
-	if (isLHCasting) { // If LH is already casting, check dual hand delay
-		if (CurrentDualHandDelay <= MAX_DUAL_HAND_DELAY) {
-			isRHCasting = true;
-			UE_LOG(LogTemp, Warning, TEXT("Dual Casting Started..."));
-		}
-	}
-	else { // Otherwise
-		isRHCasting = true;
-		UE_LOG(LogTemp, Warning, TEXT("Right Hand Casting Started..."));
+	WakeForCast();
+	CastInput.Press(SpellRecognition::EHand::Right, SpellRecognition::FPoseSampler::Now());
+	SyncCastingHands();
+	if (isRHCasting) {
+		UE_LOG(LogSpellCasting, Verbose, TEXT("%s"), isLHCasting ? TEXT("Dual Casting Started...") : TEXT("Right Hand Casting Started..."));
 	}
-
-	CurrentDualHandDelay = 0;
 }
 
 void USpellComponent::LeftHandCast() {
-	if (isRHCasting) { // If RH is already casting, check dual hand delay
-		if (CurrentDualHandDelay <= MAX_DUAL_HAND_DELAY) {
-			isLHCasting = true;
-			UE_LOG(LogTemp, Warning, TEXT("Dual Casting Started..."));
-		}
-	}
-	else { // Otherwise
-		isLHCasting = true;
-		UE_LOG(LogTemp, Warning, TEXT("Left Hand Casting Started..."));
+	WakeForCast();
+	CastInput.Press(SpellRecognition::EHand::Left, SpellRecognition::FPoseSampler::Now());
+	SyncCastingHands();
+	if (isLHCasting) {
+		UE_LOG(LogSpellCasting, Verbose, TEXT("%s"), isRHCasting ? TEXT("Dual Casting Started...") : TEXT("Left Hand Casting Started..."));
 	}
-
-	CurrentDualHandDelay = 0;
 }
 
 void USpellComponent::RightHandStopCast() {
+	MatchCast();
 	if (isComplete){
+		FCastLatencyTracer::Get().Begin(ECastLatencyChain::Apply, ECastTracePoint::CastReleased);
 		EndCast();
 	}
 
-	isRHCasting = false;
+	CastInput.Release(SpellRecognition::EHand::Right, SpellRecognition::FPoseSampler::Now());
+	SyncCastingHands();
 	isCasting = false; // Reset so that spellchecker/setup functions can update which spell to cast
 
-	UE_LOG(LogTemp, Warning, TEXT("Right Hand Casting Stopped...\n "));
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Right Hand Casting Stopped..."));
 }
 
 void USpellComponent::LeftHandStopCast() {
+	MatchCast();
 	if (isComplete) {
+		FCastLatencyTracer::Get().Begin(ECastLatencyChain::Apply, ECastTracePoint::CastReleased);
 		EndCast();
 	}
 
-	isLHCasting = false;
+	CastInput.Release(SpellRecognition::EHand::Left, SpellRecognition::FPoseSampler::Now());
+	SyncCastingHands();
 	isCasting = false; // Reset so that spellchecker/setup functions can update which spell to cast
 
-	UE_LOG(LogTemp, Warning, TEXT("Left Hand Casting Stopped...\n "));
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Left Hand Casting Stopped..."));
 }
 
-void USpellComponent::RightHandLaunch()
-{
-	if (!isLaunching) {
-		CurrentDualLaunchDelay = 0;
+// Wakes the tick up for a cast - does what the tick would have done between casts while it was asleep
+void USpellComponent::WakeForCast() {
+	PoseSampler.Resume();
+	if (!isRHCasting && !isLHCasting) {
+		ApplyReloadedSpells();
+		PoseSampler.Clear();
 	}
+	WakeTick(this);
+}
+
+// The casting hands are whichever hands CastInput took - a second hand pressed too late is left out
+void USpellComponent::SyncCastingHands() {
+	isRHCasting = CastInput.IsActive(SpellRecognition::EHand::Right);
+	isLHCasting = CastInput.IsActive(SpellRecognition::EHand::Left);
+}
 
+void USpellComponent::RightHandLaunch()
+{
 	isRHLaunching = true;
-	isLaunching = true;
+	HandleLaunchInput(LaunchInput.Press(SpellRecognition::EHand::Right, SpellRecognition::FPoseSampler::Now()));
 }
 
 void USpellComponent::LeftHandLaunch()
 {
-	if (!isLaunching) {
-		CurrentDualLaunchDelay = 0;
-	}
-
 	isLHLaunching = true;
-	isLaunching = true;
+	HandleLaunchInput(LaunchInput.Press(SpellRecognition::EHand::Left, SpellRecognition::FPoseSampler::Now()));
 }
 
 void USpellComponent::RightHandStopLaunch()
 {
 	isRHLaunching = false;
-	isLaunching = false;
+	HandleLaunchInput(LaunchInput.Release(SpellRecognition::EHand::Right, SpellRecognition::FPoseSampler::Now()));
 }
 
 void USpellComponent::LeftHandStopLaunch()
 {
 	isLHLaunching = false;
-	isLaunching = false;
+	HandleLaunchInput(LaunchInput.Release(SpellRecognition::EHand::Left, SpellRecognition::FPoseSampler::Now()));
+}
+
+// Launches the moment LaunchInput decides - right away when the second trigger comes in time, from the timer when the window closes
+void USpellComponent::HandleLaunchInput(SpellRecognition::EHandIntent Decided)
+{
+	FTimerManager& TimerManager{ GetWorld()->GetTimerManager() };
+	if (Decided != SpellRecognition::EHandIntent::None) {
+		TimerManager.ClearTimer(LaunchWindowTimer);
+		LaunchSpell(Decided);
+		LaunchInput.Reset(); // Triggers still held do not launch again, the next launch needs a new press
+	}
+	else if (LaunchInput.IsWaiting() && !TimerManager.IsTimerActive(LaunchWindowTimer)) { // First trigger - the window just opened
+		FCastLatencyTracer::Get().Begin(ECastLatencyChain::Launch, ECastTracePoint::LaunchPressed);
+		TimerManager.SetTimer(LaunchWindowTimer, this, &USpellComponent::OnLaunchWindowClosed, MAX_DUAL_HAND_DELAY, false);
+	}
+	else if (!LaunchInput.IsWaiting()) { // Released before the window closed - nothing launches
+		TimerManager.ClearTimer(LaunchWindowTimer);
+	}
+}
+
+// NOTE: The timer runs on world time, LaunchInput on FPoseSampler::Now() - closing it at its own window end keeps the two from disagreeing
+void USpellComponent::OnLaunchWindowClosed()
+{
+	HandleLaunchInput(LaunchInput.Update(LaunchInput.GetWindowEnd()));
+}
+
+void USpellComponent::LaunchSpell(SpellRecognition::EHandIntent Intent)
+{
+	FCastLatencyTracer::Get().Mark(ECastLatencyChain::Launch, ECastTracePoint::LaunchTick);
+	const SpellID LaunchedSpell{ Intent == SpellRecognition::EHandIntent::Left ? SpellCastingController->GetLHSpell() : SpellCastingController->GetRHSpell() };
+
+	if (Intent == SpellRecognition::EHandIntent::Dual) {
+		SpellCastingController->LaunchDualHSpell();
+	}
+	else if (Intent == SpellRecognition::EHandIntent::Right) {
+		SpellCastingController->LaunchRHSpell();
+	}
+	else if (Intent == SpellRecognition::EHandIntent::Left) {
+		SpellCastingController->LaunchLHSpell();
+	}
+	FCastLatencyTracer::Get().End(ECastLatencyChain::Launch, ECastTracePoint::LaunchDone, LaunchedSpell, ECastTracePoint::SpellSetup);
 }
 
 // Projects vector onto spellcasting grid coordinate system
 FVector USpellComponent::ToSpellcastingGrid(FVector Pos) {
 	//UE_LOG(LogTemp, Warning, TEXT("SpellComponent Location: %s; Comparing Location: %s"), *GetComponentLocation().ToString(), *Pos.ToString());
-	return (Pos - GetComponentLocation()).RotateAngleAxis(-GetComponentRotation().Yaw, GetUpVector()); // Works because spellcasting grid (i.e. SpellComponent) only rotates in Yaw
+	CheckGridTransform();
+	const FVector relativePos{ Pos - GetComponentLocation() };
+	// Rotate by -Yaw around the up axis - works because spellcasting grid (i.e. SpellComponent) only rotates in Yaw
+	return FVector{ (relativePos.X * GridYawCos) + (relativePos.Y * GridYawSin), (relativePos.Y * GridYawCos) - (relativePos.X * GridYawSin), relativePos.Z };
 	// This is the fifth attempt, learning on the job i guess - but I feel like I'm starting to understand - everything works backwards i.e. the cake is a lie.
 }
 
 // Converts rotation relative to spellcasting grid coordinate system
 FRotator USpellComponent::ToSpellcastingGrid(FRotator Rot) {
-	FRotator convertedRot{ Rot - GetComponentRotation() };
+	CheckGridTransform();
+	FRotator convertedRot{ Rot - GridRotation };
 
 	// Something Unreal.... Not entirely sure, but it's required
 	if (convertedRot.Pitch < -260) convertedRot.Pitch += 360;
@@ -216,7 +351,9 @@ FRotator USpellComponent::ToSpellcastingGrid(FRotator Rot) {
 
 // Converts from spellcasting grid to world coordinates
 FVector USpellComponent::SpellcastingGridToWorld(FVector gridPosition) {
-	return gridPosition.RotateAngleAxis(GetComponentRotation().Yaw, GetUpVector()) + GetComponentLocation(); // Works because spellcasting grid (i.e. SpellComponent) only rotates in Yaw
+	CheckGridTransform();
+	// Rotate by Yaw around the up axis - works because spellcasting grid (i.e. SpellComponent) only rotates in Yaw
+	return FVector{ (gridPosition.X * GridYawCos) - (gridPosition.Y * GridYawSin), (gridPosition.X * GridYawSin) + (gridPosition.Y * GridYawCos), gridPosition.Z } + GetComponentLocation();
 }
 
 // Sets the reference location for all spellcasting - without this, no tolerances will be right
@@ -226,19 +363,40 @@ void USpellComponent::SetFrameStartPosAndRot() {
 	if (isLHCasting && !isRHCasting) {
 		SetWorldLocation(LHand->GetComponentLocation());
 		SetWorldRotation(FRotator{ 0,LHand->GetComponentRotation().Yaw,0 });
-		return;
 	}
 	else if (!isLHCasting && isRHCasting) {
 		SetWorldLocation(RHand->GetComponentLocation());
 		SetWorldRotation(FRotator{ 0,RHand->GetComponentRotation().Yaw,0 });
-		return;
 	}
 	else {
-		FVector MaxPos{ RHand->GetComponentLocation().ComponentMax(LHand->GetComponentLocation()) };
-		FVector MinPos{ RHand->GetComponentLocation().ComponentMin(LHand->GetComponentLocation()) };
+		const FVector RHLocation{ RHand->GetComponentLocation() };
+		const FVector LHLocation{ LHand->GetComponentLocation() };
+		FVector MaxPos{ RHLocation.ComponentMax(LHLocation) };
+		FVector MinPos{ RHLocation.ComponentMin(LHLocation) };
 		SetWorldLocation(MinPos + ((MaxPos - MinPos) / 2));
 		SetWorldRotation(FRotator{ 0,hmdCamera->GetComponentRotation().Yaw, 0 });
 	}
+
+	UpdateGridTransform();
+}
+
+// Caches the spellcasting grid rotation used by the grid conversions
+void USpellComponent::UpdateGridTransform() {
+	GridQuat = GetComponentQuat();
+	GridRotation = GetComponentRotation();
+	FMath::SinCos(&GridYawSin, &GridYawCos, FMath::DegreesToRadians(GridRotation.Yaw));
+}
+
+// The grid can still turn with the player between casts, so a (cheap) quat compare makes sure the cached rotation is never stale
+void USpellComponent::CheckGridTransform() {
+	if (!GetComponentQuat().Equals(GridQuat, 0.f)) {
+		UpdateGridTransform();
+	}
+}
+
+// True once CastInput has decided between one hand and both
+bool USpellComponent::IsSpellUpdateDue() const {
+	return (isRHCasting || isLHCasting) && CastInput.GetIntent() != SpellRecognition::EHandIntent::None;
 }
 
 SpellID USpellComponent::UpdateSpellList()
@@ -263,302 +421,281 @@ SpellID USpellComponent::UpdateSpellList()
 // If only one spell canCast returns that spell, otherwise returns Multiple
 // Returns None if no spell can be cast
 SpellID USpellComponent::GetActiveSpells() {
-	SpellID id{ SpellID::None };
-	int activeSpellCount{ 0 };
-
-	for (const auto& spell : AllSpells) {
-		if (spell.canCast) { 
-			activeSpellCount++;
-			id = spell.ID;
-			//UE_LOG(LogTemp, Warning, TEXT("%s spell is active..."), *UEnum::GetValueAsString(id));
-		}
+	const int32 id{ Recognizer.GetActiveSpells() };
+
+	if (id == SpellRecognition::NoSpell) {
+		return SpellID::None;
+	}
+	if (id == SpellRecognition::MultipleSpells) {
+		return SpellID::Multiple;
 	}
-	return (activeSpellCount > 1) ? SpellID::Multiple : id;
+	return static_cast<SpellID>(id);
 }
 
 // The starting point for spell position calculations - if this doesn't run, nothing that follows will run correctly
 // Returns true if a spell can be cast from the start position and orientation player has chosen
-// If dual casting, it is OK to have hands complete points asynchronously, they must just stay in tolerance until casting for that hand completes
 bool USpellComponent::SpellSetup()
 {
-	UE_LOG(LogTemp, Warning, TEXT("Running SpellSetup()"));
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Running SpellSetup()"));
 
 	// Setup up the reference point for all spell casting calculations
-	SetFrameStartPosAndRot();
-
-	// Save start position and orientation of hands for calculations
-	RHStartPos = ToSpellcastingGrid(RHand->GetComponentLocation());
-	LHStartPos = ToSpellcastingGrid(LHand->GetComponentLocation());
-
-	// Reset all spell complete states to start settings
-	for (auto& spell : AllSpells) {
-		spell.canCast = true;
-		spell.isScaleSet = false;
-		spell.Scale = MIN_MOVE_SCALE;
-		for (auto& kp : spell.KeyPoints) {
-			kp.LHComplete = false;
-			kp.RHComplete = false;
-		}
-	}
-
-	// If only one hand is casting disable all dual hand spells
-	if (isLHCasting != isRHCasting)
 	{
-		for (auto& spell : AllSpells) {
-			if (spell.isDualOnly) {
-				spell.canCast = false;
-				//UE_LOG(LogTemp, Warning, TEXT("%s spell deactivated -> isDualCasting"), *UEnum::GetValueAsString(spell.ID));
-			}
-		}
+		SpellRecognition::FUncountedScope UncountedScope{}; // Moving the grid is engine work (the component and anything attached to it)
+		SetFrameStartPosAndRot();
 	}
-	
-	// Check that remaining spell start positions are in tolerance - i.e. has player started with hands in correct orientation for a spell
-	for (auto& spell : AllSpells) {
-		if (spell.canCast) {
-			bool inTolerance{ true };
-			if (isRHCasting) {
-				// Check RH in tolerance
-				inTolerance = CheckRHStaticTolerance(spell, spell.KeyPoints[0]);
-				if (inTolerance) {
-					spell.KeyPoints[0].RHComplete = true;
-					UE_LOG(LogTemp, Warning, TEXT("Starting pos/rot ACCEPTED for spell: %s"), *UEnum::GetValueAsString(spell.ID));
-				}
-				else {
-					UE_LOG(LogTemp, Warning, TEXT("Starting pos/rot REJECTED for spell: %s"), *UEnum::GetValueAsString(spell.ID));
-				}
-			}
-			if (isLHCasting && inTolerance) { // if previous check returned true
-				// Check LH in tolerance
-				inTolerance = CheckLHStaticTolerance(spell, spell.KeyPoints[0]);
-				if (inTolerance) {
-					spell.KeyPoints[0].LHComplete = true;
-					UE_LOG(LogTemp, Warning, TEXT("Starting LH pos/rot ACCEPTED for spell: %s"), *UEnum::GetValueAsString(spell.ID));
-				}
-				else {
-					UE_LOG(LogTemp, Warning, TEXT("Starting LH pos/rot REJECTED for spell: %s"), *UEnum::GetValueAsString(spell.ID));
-				}
-			}
-			if (isLHCasting && isRHCasting && inTolerance) { // If dual casting and previous check returned true
-				// Check hands are correctly positioned relative to each other i.e. if RH should be above/in front of/next to LH
-				inTolerance = CheckRHToLHDirection(spell, spell.PositionalTolerance * MAX_MOVE_TOLERANCE);
-				if (inTolerance) {
-					UE_LOG(LogTemp, Warning, TEXT("Starting relative H position ACCEPTED for spell: %s"), *UEnum::GetValueAsString(spell.ID));
-				}
-				else {
-					UE_LOG(LogTemp, Warning, TEXT("Starting relative H position REJECTED for spell: %s"), *UEnum::GetValueAsString(spell.ID));
-				}
-				UE_LOG(LogTemp, Warning, TEXT("LH Start Pos: %s; RH Start Pos: %s; Reltaive Pos: %s"), *LHStartPos.ToString(), *RHStartPos.ToString(), *(RHStartPos - LHStartPos).ToString())
-			}
-			spell.canCast = inTolerance;
-		}
+
+	// NOTE: Hands must be sampled again after the spellcasting grid has moved
+	UpdateHandPoses();
+
+	// Samples taken before this point belong to the last cast (or none at all)
+	PoseSampler.Clear();
+	CastStartTime = SpellRecognition::FPoseSampler::Now();
+	RecordTrajectory(SpellRecognition::ETrajectoryEvent::SpellSetup, HandPoses, CastStartTime);
+	if (isDtwMatchingEnabled) {
+		DtwMatcher.BeginCast(HandPoses, isRHCasting, isLHCasting);
 	}
+	const bool isSpellAvailable{ Recognizer.SpellSetup(HandPoses, isRHCasting, isLHCasting) };
+	return isSpellAvailable || isDtwMatchingEnabled; // DTW matching does not need the start checks, any cast is recorded
+}
+
+// Updates canCast to false for every spell whose motion/orientation goes out of tolerance - returns true once a spell is complete
+// Checks every pose sampled since the last tick in order, so a fast move can not skip past a keypoint between ticks
+// Only used without a USpellRecognitionManager - a batch of one, checked right here
+bool USpellComponent::UpdateSpellStates() {
+	LocalBatch.Reset();
+	QueueSpellStates(LocalBatch.Add(Recognizer, isRHCasting, isLHCasting));
+	LocalBatch.Evaluate();
+	return ApplySpellStates(LocalBatch.Get(0));
+}
 
-	// Return true if at least one spell can be cast
-	for (const auto& spell : AllSpells) {
-		if (spell.canCast) return true;
+// Fills Update with every pose sampled since the last tick (just HandPoses if the sampling thread is not running), in spellcasting grid space
+void USpellComponent::QueueSpellStates(SpellRecognition::FCasterUpdate& Update) {
+	if (!PoseSampler.IsRunning()) {
+		Update.Samples.push_back(SpellRecognition::FTimedPoseSample{ SpellRecognition::FPoseSampler::Now(), HandPoses });
+		return;
 	}
 
-	UE_LOG(LogTemp, Warning, TEXT("No spells can be cast from that starting configuration!\n "));
+	PoseSampler.Drain([this, &Update](const SpellRecognition::FTimedPoseSample& Sample) {
+		if (Sample.Time >= CastStartTime) {
+			Update.Samples.push_back(SpellRecognition::FTimedPoseSample{ Sample.Time, TrackingToSpellcastingGrid(Sample.Pose) });
+		}
+	});
+}
 
-	// If all the above checks fail return false - i.e. no spell can be cast from start position and orientation player has chosen
-	return false;
+// Records the samples the recognizer checked and hands every sample to DTW matching (if enabled) - returns true once a spell is complete
+bool USpellComponent::ApplySpellStates(const SpellRecognition::FCasterUpdate& Update) {
+	for (int32 i{ 0 }; i < static_cast<int32>(Update.Samples.size()); i++) {
+		const SpellRecognition::FTimedPoseSample& Sample{ Update.Samples[i] };
+		if (isDtwMatchingEnabled) {
+			DtwMatcher.AddSample(Sample.Pose);
+		}
+		if (i < Update.NumChecked) { // Everything after a complete spell is thrown away
+			RecordTrajectory(SpellRecognition::ETrajectoryEvent::SpellUpdate, Sample.Pose, Sample.Time);
+		}
+	}
+	return Update.isSpellComplete && !isDtwMatchingEnabled; // DTW matching only decides once the cast is released
 }
 
-// The overarching logic for the tolerance checker code - updates canCast to false if motion/orientation goes out of tolerance
-bool USpellComponent::UpdateSpellStates() {
-	for (auto& spell : AllSpells) {
-		if (spell.canCast) {
-
-			// What is next point that needs to be completed for LH and RH
-			int RHNextPointID{ 0 };
-			int LHNextPointID{ 0 };
-			bool allRHPointsComplete{ false };
-			bool allLHPointsComplete{ false };
-
-			if (isRHCasting) {
-				for (auto& kp : spell.KeyPoints) {
-					RHNextPointID += 1;
-					if (!kp.RHComplete) {
-						//UE_LOG(LogTemp, Warning, TEXT("RHKP loop stopped at point: %d for spell %s"), RHNextPointID, *UEnum::GetValueAsString(spell.ID));
-						break;// Stop counting if keypoint is not complete
-					}
-				}
-			}
+// End of the tick - after the spells have been checked, so everything in here sees this frame's results
+// With a manager that is in the manager's tick (see ApplyRecognitionUpdate()), after every caster has ticked
+void USpellComponent::EndSpellUpdate() {
+	float LikelySpellScore{ 0.f };
+	bool isLikelySpellChanged{ false };
+	{
+		SpellRecognition::FAllocationScope AllocationScope{ TickAllocations };
+		isLikelySpellChanged = UpdateLikelySpell(LikelySpellScore);
 
-			if (isLHCasting) {
-				for (auto& kp : spell.KeyPoints) {
-					LHNextPointID += 1;
-					if (!kp.LHComplete) {
-						//UE_LOG(LogTemp, Warning, TEXT("LHKP loop stopped at point: %d for spell %s"), RHNextPointID, *UEnum::GetValueAsString(spell.ID));
-						break;// Stop counting if keypoint is not complete
-					}
-				}
-			}
+		RecordTrajectory(SpellRecognition::ETrajectoryEvent::Frame, HandPoses, SpellRecognition::FPoseSampler::Now());
+		TrajectoryFrame++;
+	}
+	CheckTickAllocations();
 
-			// Fix the logic for computers
-			RHNextPointID -= 1;
-			LHNextPointID -= 1;
+	// The game side of the tick is not counted - the delegate's listeners and the casting node actors (spawned the first time a spell shows them)
+	// allocate as they like
+	if (isLikelySpellChanged) {
+		OnLikelySpellChanged.Broadcast(LikelySpell, LikelySpellScore);
+	}
+	UpdateCastingNodes();
 
-			// Update scale if required
-			if (!spell.isScaleSet) {
-				UpdateSpellScale(spell, (RHNextPointID > LHNextPointID) ? RHNextPointID : LHNextPointID);
-			}
+	// *** DEV Section *** //
+	RunDevTests();
 
-			if (isRHCasting) {
-				// If this is the last point and it is already completed
-				if (RHNextPointID == spell.KeyPoints.Num() - 1 && spell.KeyPoints[RHNextPointID].RHComplete) {
-					allRHPointsComplete = true;
-				}
-				else {
-					// Set RHComplete status true if hand in positional tolerance with the point
-					spell.KeyPoints[RHNextPointID].RHComplete = CheckRHStaticTolerance(spell, spell.KeyPoints[RHNextPointID]);
-				}
-			}
+	// Nothing to do until the next cast - this tick has already hidden the casting nodes and logged the last cast
+	if (!isRHCasting && !isLHCasting && !isRecordingTrajectories) {
+		PoseSampler.Pause(); // Nothing drains the samples while asleep
+		SleepTick(this);
+	}
+}
 
-			if (isLHCasting) {
-				// If this is the last point and it is already completed
-				if (LHNextPointID == spell.KeyPoints.Num() - 1 && spell.KeyPoints[LHNextPointID].LHComplete) {
-					allLHPointsComplete = true;
-				}
-				else {
-					// Set LHComplete status if hand in positional tolerance with the point
-					spell.KeyPoints[LHNextPointID].LHComplete = CheckLHStaticTolerance(spell, spell.KeyPoints[LHNextPointID]);
-				}
-			}
+// DTW matching - picks the spell from everything recorded since SpellSetup() when the cast button is released
+void USpellComponent::MatchCast() {
+	if (!isDtwMatchingEnabled || !isCasting) {
+		return;
+	}
+	SpellRecognition::FDtwMatch Match{};
+	isComplete = DtwMatcher.Match(Match);
+	CurrentSpell = isComplete ? static_cast<SpellID>(Match.SpellID) : SpellID::None;
+	UE_LOG(LogSpellCasting, Verbose, TEXT("DTW match: %s (cost %.3f, %d samples, %d spells compared)"),
+		GetSpellName(CurrentSpell), Match.Cost, DtwMatcher.NumSamples(), Match.NumCompared);
+}
 
-			// If all required keypoints have been completed, set all other spell canCast to false and return true
-			if ((allRHPointsComplete && isRHCasting && allLHPointsComplete && isLHCasting) || // If dual handed casting AND BOTH hands completed OR
-			   (((allRHPointsComplete && isRHCasting) || (allLHPointsComplete && isLHCasting)) && isRHCasting != isLHCasting)) { // One handed casting AND one hand completed
-				for (auto& spl : AllSpells) {
-					if (spl.ID != spell.ID) spl.canCast = false;
-				}
-				return true;
-			}
+// Swaps in any spells hot reloaded by the SpellContainer - only called between casts
+void USpellComponent::ApplyReloadedSpells() {
+	SpellRecognition::FSharedSpellSet ReloadedSpellSet{};
+	if (SpellContainer == nullptr || !SpellContainer->TakeReloadedSpells(ReloadedSpellSet)) {
+		return;
+	}
+	DtwMatcher.SetSpells(ReloadedSpellSet);
+	Recognizer.SetSpells(std::move(ReloadedSpellSet));
+	ResetCastingNodes();
+	isAllocationCheckArmed = false; // The buffers grow to fit the new spells on the next cast
+}
 
-			// If keypoint not yet complete check hand movement is still in tolerance
-			if (isRHCasting && !spell.KeyPoints[RHNextPointID].RHComplete) {
-				spell.canCast = CheckRHMoveTolerance(spell, RHNextPointID); // Disable can cast if right hand out of tolerance
-			}
+// Works out which spell is most likely being cast - once per tick, after the spells have been checked
+// Returns true if LikelySpell changed (OutScore is its confidence) - EndSpellUpdate() broadcasts it outside the allocation check
+bool USpellComponent::UpdateLikelySpell(float& OutScore) {
+	SpellID NewLikelySpell{ SpellID::None };
+	SpellRecognition::FSpellConfidence Confidence{};
+	if (isComplete) {
+		NewLikelySpell = CurrentSpell;
+		Confidence.Score = 1.f;
+	}
+	else if (isCasting) {
+		const int32 id{ Recognizer.GetLeadingSpell(&Confidence) };
+		NewLikelySpell = (id == SpellRecognition::NoSpell) ? SpellID::None : static_cast<SpellID>(id);
+	}
 
-			// If keypoint not yet complete check hand movement is still in tolerance
-			if (isLHCasting && !spell.KeyPoints[LHNextPointID].LHComplete) { // keypoint 0 check required due to dual hand casting
-				spell.canCast = CheckLHMoveTolerance(spell, LHNextPointID); // Disable canCast if left hand out of tolerance
-			}
+	OutScore = Confidence.Score;
+	if (NewLikelySpell == LikelySpell) {
+		return false;
+	}
+	LikelySpell = NewLikelySpell;
+	return true;
+}
 
-			// Set isScaleSet true if no longer in tolerance with end point of first move (NOTE: That point would be complete at this stage)
-			if (!spell.isScaleSet && spell.canCast && ((RHNextPointID > LHNextPointID) ? RHNextPointID : LHNextPointID) > 0) {
-				if (RHNextPointID > LHNextPointID) {
-					if (spell.KeyPoints[RHNextPointID - 1].Motion != MoveType::Point && // If the previously completed keypoint was an end of a movement point AND
-						!CheckRHStaticTolerance(spell, spell.KeyPoints[RHNextPointID - 1])) { // Orientation of previous keypoint no longer in tolerance
-						spell.isScaleSet = true;
-					}
-				}
-				else {
-					if (spell.KeyPoints[LHNextPointID - 1].Motion != MoveType::Point && // If the previously completed keypoint was an end of a movement point AND
-						!CheckLHStaticTolerance(spell, spell.KeyPoints[LHNextPointID - 1])) { // Orientation of previous keypoint no longer in tolerance
-						spell.isScaleSet = true;
-					}
-				}
+// Makes an empty set of casting nodes for every keypoint of every spell
+// Old casting node actors are destroyed, their spells/keypoints may be gone after a hot reload
+void USpellComponent::ResetCastingNodes() {
+	for (auto& spellNodes : CastingNodes) {
+		for (auto& nodes : spellNodes) {
+			if (nodes.LH != nullptr) {
+				nodes.LH->Destroy();
 			}
-
-			if (!spell.canCast) {
-				UE_LOG(LogTemp, Warning, TEXT("Spell Deactivated: %s!!"), *UEnum::GetValueAsString(spell.ID));
+			if (nodes.RH != nullptr) {
+				nodes.RH->Destroy();
 			}
 		}
 	}
-	return false;
+
+	CastingNodes.Reset();
+	CastingNodes.SetNum(Recognizer.Num());
+	for (int32 SpellIndex{ 0 }; SpellIndex < Recognizer.Num(); SpellIndex++) {
+		CastingNodes[SpellIndex].SetNum(static_cast<int32>(Recognizer.GetSpell(SpellIndex).KeyPoints.size()));
+	}
 }
 
 // Displays/'hides' the spellcasting nodes depending on what is going on
 // *** Currently Extremely inefficient, upgrade to much better code at somepoint ***
 void USpellComponent::UpdateCastingNodes() {
 	if ((isRHCasting || isLHCasting)) { // If any hand is casting
+		CheckGridTransform();
+		const FVector RHStartPos{ FromRecognizerVec(Recognizer.GetRHStartPos()) };
+		const FVector LHStartPos{ FromRecognizerVec(Recognizer.GetLHStartPos()) };
+
 		// Update the visible casting node actors
-		for (auto& spell : AllSpells) {
+		for (int32 SpellIndex{ 0 }; SpellIndex < Recognizer.Num(); SpellIndex++) {
+			const SpellRecognition::FSpellDef& spell{ Recognizer.GetSpell(SpellIndex) };
+			const SpellID ID{ static_cast<SpellID>(spell.ID) };
+			const SpellRecognition::FSpellState& state{ Recognizer.GetSpellState(SpellIndex) };
 			int CurrentKP{ 0 };
-			for (auto& kp : spell.KeyPoints) {
-				if (spell.canCast) { // Show nodes
+			for (FKeyPointCastingNodes& nodes : CastingNodes[SpellIndex]) {
+				const SpellRecognition::FKeyPointDef& kp{ spell.KeyPoints[CurrentKP] };
+				const FVector RHPosition{ FromRecognizerVec(kp.RHPosition) };
+				const FRotator RHRotation{ FromRecognizerRot(kp.RHRotation) };
+				const FVector LHPosition{ FromRecognizerVec(kp.LHPosition) };
+				const FRotator LHRotation{ FromRecognizerRot(kp.LHRotation) };
+				if (state.canCast) { // Show nodes
 					if (isRHCasting) {
-						if (kp.CastingNodeRH == nullptr) { // If casting node doesn't exist yet
-							kp.CastingNodeRH = GetWorld()->SpawnActor<ACastingNode>(CastingNodeBlueprint, SpellcastingGridToWorld((kp.RHPosition * spell.Scale) + RHStartPos), kp.RHRotation + GetComponentRotation());
-							if (spell.ID == SpellID::Wall || spell.ID == SpellID::Atune || spell.ID == SpellID::Beam) {
-								kp.CastingNodeRH->StaticMesh->SetMaterial(0, kp.CastingNodeRH->OrangeMaterial);
+						if (nodes.RH == nullptr) { // If casting node doesn't exist yet
+							nodes.RH = GetWorld()->SpawnActor<ACastingNode>(CastingNodeBlueprint, SpellcastingGridToWorld((RHPosition * state.Scale) + RHStartPos), RHRotation + GridRotation);
+							if (ID == SpellID::Wall || ID == SpellID::Atune || ID == SpellID::Beam) {
+								nodes.RH->StaticMesh->SetMaterial(0, nodes.RH->OrangeMaterial);
 							}
-							else if (spell.ID == SpellID::Fire || spell.ID == SpellID::IncPwr || spell.ID == SpellID::IncDur || spell.ID == SpellID::Explode) {
-								kp.CastingNodeRH->StaticMesh->SetMaterial(0, kp.CastingNodeRH->RedMaterial);
+							else if (ID == SpellID::Fire || ID == SpellID::IncPwr || ID == SpellID::IncDur || ID == SpellID::Explode) {
+								nodes.RH->StaticMesh->SetMaterial(0, nodes.RH->RedMaterial);
 							}
-							else if (spell.ID == SpellID::Water || spell.ID == SpellID::DecDur || spell.ID == SpellID::Air || spell.ID == SpellID::Magnet) {
-								kp.CastingNodeRH->StaticMesh->SetMaterial(0, kp.CastingNodeRH->BlueMaterial);
+							else if (ID == SpellID::Water || ID == SpellID::DecDur || ID == SpellID::Air || ID == SpellID::Magnet) {
+								nodes.RH->StaticMesh->SetMaterial(0, nodes.RH->BlueMaterial);
 							}
-							else if (spell.ID == SpellID::Ball || spell.ID == SpellID::Earth) {
-								kp.CastingNodeRH->StaticMesh->SetMaterial(0, kp.CastingNodeRH->GreenMaterial);
+							else if (ID == SpellID::Ball || ID == SpellID::Earth) {
+								nodes.RH->StaticMesh->SetMaterial(0, nodes.RH->GreenMaterial);
 							}
-							else if (spell.ID == SpellID::DecPwr) {
-								kp.CastingNodeRH->StaticMesh->SetMaterial(0, kp.CastingNodeRH->PurpleMaterial);
+							else if (ID == SpellID::DecPwr) {
+								nodes.RH->StaticMesh->SetMaterial(0, nodes.RH->PurpleMaterial);
 							}
 						}
 						else { // Update position of casting nodes that are already in place
-							kp.CastingNodeRH->SetActorLocation(SpellcastingGridToWorld((kp.RHPosition * spell.Scale) + RHStartPos));
-							kp.CastingNodeRH->SetActorRotation(kp.RHRotation + GetComponentRotation());
+							nodes.RH->SetActorLocation(SpellcastingGridToWorld((RHPosition * state.Scale) + RHStartPos));
+							nodes.RH->SetActorRotation(RHRotation + GridRotation);
 
 							// Increase size of next keypoint in list
-							if (CurrentKP > 0 && spell.KeyPoints[CurrentKP - 1].RHComplete && !kp.RHComplete) {
-								kp.CastingNodeRH->StaticMesh->SetWorldScale3D(FVector{ 2, 2, 2 });
+							if (CurrentKP > 0 && state.IsRHComplete(CurrentKP - 1) && !state.IsRHComplete(CurrentKP)) {
+								nodes.RH->StaticMesh->SetWorldScale3D(FVector{ 2, 2, 2 });
 							}
 							else {
-								kp.CastingNodeRH->StaticMesh->SetWorldScale3D(FVector{ 1, 1, 1 });
+								nodes.RH->StaticMesh->SetWorldScale3D(FVector{ 1, 1, 1 });
 							}
 						}
 					}
 					else {
-						if (kp.CastingNodeLH != nullptr) {
-							kp.CastingNodeLH->SetActorLocation(FVector{ 0,0,-100 });
+						if (nodes.LH != nullptr) {
+							nodes.LH->SetActorLocation(FVector{ 0,0,-100 });
 						}
 					}
 					if (isLHCasting) {
-						if (kp.CastingNodeLH == nullptr) { // If casting node doesn't exist yet
-							kp.CastingNodeLH = GetWorld()->SpawnActor<ACastingNode>(CastingNodeBlueprint, SpellcastingGridToWorld((kp.LHPosition * spell.Scale) + LHStartPos), kp.LHRotation + GetComponentRotation());
-							if (spell.ID == SpellID::Wall || spell.ID == SpellID::Atune || spell.ID == SpellID::Beam) {
-								kp.CastingNodeLH->StaticMesh->SetMaterial(0, kp.CastingNodeRH->OrangeMaterial);
+						if (nodes.LH == nullptr) { // If casting node doesn't exist yet
+							nodes.LH = GetWorld()->SpawnActor<ACastingNode>(CastingNodeBlueprint, SpellcastingGridToWorld((LHPosition * state.Scale) + LHStartPos), LHRotation + GridRotation);
+							if (ID == SpellID::Wall || ID == SpellID::Atune || ID == SpellID::Beam) {
+								nodes.LH->StaticMesh->SetMaterial(0, nodes.RH->OrangeMaterial);
 							}
-							else if (spell.ID == SpellID::Fire || spell.ID == SpellID::IncPwr || spell.ID == SpellID::IncDur || spell.ID == SpellID::Explode) {
-								kp.CastingNodeLH->StaticMesh->SetMaterial(0, kp.CastingNodeLH->RedMaterial);
+							else if (ID == SpellID::Fire || ID == SpellID::IncPwr || ID == SpellID::IncDur || ID == SpellID::Explode) {
+								nodes.LH->StaticMesh->SetMaterial(0, nodes.LH->RedMaterial);
 							}
-							else if (spell.ID == SpellID::Water || spell.ID == SpellID::DecDur || spell.ID == SpellID::Air || spell.ID == SpellID::Magnet) {
-								kp.CastingNodeLH->StaticMesh->SetMaterial(0, kp.CastingNodeLH->BlueMaterial);
+							else if (ID == SpellID::Water || ID == SpellID::DecDur || ID == SpellID::Air || ID == SpellID::Magnet) {
+								nodes.LH->StaticMesh->SetMaterial(0, nodes.LH->BlueMaterial);
 							}
-							else if (spell.ID == SpellID::Ball || spell.ID == SpellID::Earth) {
-								kp.CastingNodeLH->StaticMesh->SetMaterial(0, kp.CastingNodeLH->GreenMaterial);
+							else if (ID == SpellID::Ball || ID == SpellID::Earth) {
+								nodes.LH->StaticMesh->SetMaterial(0, nodes.LH->GreenMaterial);
 							}
-							else if (spell.ID == SpellID::DecPwr) {
-								kp.CastingNodeLH->StaticMesh->SetMaterial(0, kp.CastingNodeLH->PurpleMaterial);
+							else if (ID == SpellID::DecPwr) {
+								nodes.LH->StaticMesh->SetMaterial(0, nodes.LH->PurpleMaterial);
 							}
 						}
 						else { // Update position of casting nodes that are already in place
-							kp.CastingNodeLH->SetActorLocation(SpellcastingGridToWorld((kp.LHPosition * spell.Scale) + LHStartPos));
-							kp.CastingNodeLH->SetActorRotation(kp.LHRotation + GetComponentRotation());
+							nodes.LH->SetActorLocation(SpellcastingGridToWorld((LHPosition * state.Scale) + LHStartPos));
+							nodes.LH->SetActorRotation(LHRotation + GridRotation);
 
 							// Increase size of next keypoint in list
-							if (CurrentKP > 0 && spell.KeyPoints[CurrentKP - 1].LHComplete && !kp.LHComplete) {
-								kp.CastingNodeLH->StaticMesh->SetWorldScale3D(FVector{ 2, 2, 2 });
+							if (CurrentKP > 0 && state.IsLHComplete(CurrentKP - 1) && !state.IsLHComplete(CurrentKP)) {
+								nodes.LH->StaticMesh->SetWorldScale3D(FVector{ 2, 2, 2 });
 							}
 							else {
-								kp.CastingNodeLH->StaticMesh->SetWorldScale3D(FVector{ 1, 1, 1 });
+								nodes.LH->StaticMesh->SetWorldScale3D(FVector{ 1, 1, 1 });
 							}
 						}
 					}
 					else {
-						if (kp.CastingNodeLH != nullptr) {
-							kp.CastingNodeLH->SetActorLocation(FVector{ 0,0,-100 });
+						if (nodes.LH != nullptr) {
+							nodes.LH->SetActorLocation(FVector{ 0,0,-100 });
 						}
 					}
 				}
 				else { // Hide nodes
-					if (kp.CastingNodeLH != nullptr) {
-						kp.CastingNodeLH->SetActorLocation(FVector{ 0,0,-100 });
+					if (nodes.LH != nullptr) {
+						nodes.LH->SetActorLocation(FVector{ 0,0,-100 });
 					}
-					if (kp.CastingNodeRH != nullptr) {
-						kp.CastingNodeRH->SetActorLocation(FVector{ 0,0,-100 });
+					if (nodes.RH != nullptr) {
+						nodes.RH->SetActorLocation(FVector{ 0,0,-100 });
 					}
 				}
 				CurrentKP++;
@@ -566,13 +703,13 @@ void USpellComponent::UpdateCastingNodes() {
 		}
 	}
 	else { // If player is not casting, hide all nodes
-		for (auto& spell : AllSpells) {
-			for (auto& kp : spell.KeyPoints) {
-				if (kp.CastingNodeLH != nullptr) {
-					kp.CastingNodeLH->SetActorLocation(FVector{ 0,0,-100 });
+		for (auto& spellNodes : CastingNodes) {
+			for (auto& nodes : spellNodes) {
+				if (nodes.LH != nullptr) {
+					nodes.LH->SetActorLocation(FVector{ 0,0,-100 });
 				}
-				if (kp.CastingNodeRH != nullptr) {
-					kp.CastingNodeRH->SetActorLocation(FVector{ 0,0,-100 });
+				if (nodes.RH != nullptr) {
+					nodes.RH->SetActorLocation(FVector{ 0,0,-100 });
 				}
 			}
 		}
@@ -580,550 +717,192 @@ void USpellComponent::UpdateCastingNodes() {
 }
 
 void USpellComponent::EndCast() {
+	FCastLatencyTracer::Get().Mark(ECastLatencyChain::Apply, ECastTracePoint::EndCast);
 	if (isRHCasting && isLHCasting) { // If ended dualcasting
 		SpellCastingController->ApplyDualHSpell(CurrentSpell);
 		isLHCasting = false;
 		isRHCasting = false;
-		UE_LOG(LogTemp, Warning, TEXT("Dual Handed Spell Complete: %s"), *UEnum::GetValueAsString(CurrentSpell));
+		UE_LOG(LogSpellCasting, Verbose, TEXT("Dual Handed Spell Complete: %s"), GetSpellName(CurrentSpell));
 	}
 	else if (isRHCasting && !isLHCasting) { // If ended RH casting
 		SpellCastingController->ApplyRHSpell(CurrentSpell);
 		isRHCasting = false;
-		UE_LOG(LogTemp, Warning, TEXT("Right Handed Spell Complete: %s"), *UEnum::GetValueAsString(CurrentSpell));
+		UE_LOG(LogSpellCasting, Verbose, TEXT("Right Handed Spell Complete: %s"), GetSpellName(CurrentSpell));
 	}
 	else if (!isRHCasting && isLHCasting) { // If ended LH casting
 		SpellCastingController->ApplyLHSpell(CurrentSpell);
 		isLHCasting = false;
-		UE_LOG(LogTemp, Warning, TEXT("Left Handed Spell Complete: %s"), *UEnum::GetValueAsString(CurrentSpell));
+		UE_LOG(LogSpellCasting, Verbose, TEXT("Left Handed Spell Complete: %s"), GetSpellName(CurrentSpell));
 	}
+	FCastLatencyTracer::Get().End(ECastLatencyChain::Apply, ECastTracePoint::SpellApplied, CurrentSpell, ECastTracePoint::EndCast);
+	CastInput.Reset(); // A hand still held after the spell is applied does not start a new cast
 	isComplete = false;
+	isAllocationCheckArmed = true; // Every buffer has been through a whole cast
 }
 
-// By axis scaling is used in this project - so max movement in one axis sets the current scale
-// Until the first movement is complete, then scale is 'set' until this round of casting is complete
-void USpellComponent::UpdateSpellScale(FSpellData& spell, int kpID) {
-	float NewScale{ MIN_MOVE_SCALE };
-	float MaxMoveFromStart{ 0.f };
+// Reads both motion controllers and converts them to the recognizer's spellcasting grid space pose
+void USpellComponent::UpdateHandPoses() {
+	HandPoses.RH = SpellRecognition::FHandPose{ ToRecognizerVec(ToSpellcastingGrid(RHand->GetComponentLocation())), ToRecognizerRot(ToSpellcastingGrid(RHand->GetComponentRotation())) };
+	HandPoses.LH = SpellRecognition::FHandPose{ ToRecognizerVec(ToSpellcastingGrid(LHand->GetComponentLocation())), ToRecognizerRot(ToSpellcastingGrid(LHand->GetComponentRotation())) };
+}
 
-	if (spell.ID == SpellID::Air) { // Special case
-		MaxMoveFromStart = (RHStartPos - LHStartPos).Size();
-		NewScale = (MaxMoveFromStart > NewScale) ? MaxMoveFromStart : NewScale;
-		spell.isScaleSet = true;
-	}
-	else {
-		// Check if one axis' movement in relevant hands is above MIN_MOVE_SCALE
-		if (isLHCasting) { // Check if movement from start in left hand is greater than current scale
-			MaxMoveFromStart = (ToSpellcastingGrid(LHand->GetComponentLocation()) - LHStartPos).GetAbsMax();
-			NewScale = (MaxMoveFromStart > NewScale) ? MaxMoveFromStart : NewScale;
-		}
-		if (isRHCasting) { // Check if movement from start in right hand is greater than current scale
-			MaxMoveFromStart = (ToSpellcastingGrid(RHand->GetComponentLocation()) - RHStartPos).GetAbsMax();
-			NewScale = (MaxMoveFromStart > NewScale) ? MaxMoveFromStart : NewScale;
-		}
-	}
+// Converts a tracking space pose from the pose sampler to spellcasting grid space
+// NOTE: Uses where the motion controllers' parent is this tick for every sample - it barely moves within one tick
+SpellRecognition::FPoseSample USpellComponent::TrackingToSpellcastingGrid(const SpellRecognition::FPoseSample& TrackingPose) {
+	const FTransform RHTrackingToWorld{ RHand->GetAttachParent() ? RHand->GetAttachParent()->GetComponentTransform() : FTransform::Identity };
+	const FTransform LHTrackingToWorld{ LHand->GetAttachParent() ? LHand->GetAttachParent()->GetComponentTransform() : FTransform::Identity };
 
-	// Update Scale to maximum hand movement from start position
-	spell.Scale = (spell.Scale > NewScale) ? spell.Scale : NewScale;
+	SpellRecognition::FPoseSample GridPose{};
+	GridPose.RH = SpellRecognition::FHandPose{
+		ToRecognizerVec(ToSpellcastingGrid(RHTrackingToWorld.TransformPosition(FromRecognizerVec(TrackingPose.RH.Position)))),
+		ToRecognizerRot(ToSpellcastingGrid(RHTrackingToWorld.TransformRotation(FromRecognizerRot(TrackingPose.RH.Rotation).Quaternion()).Rotator()))
+	};
+	GridPose.LH = SpellRecognition::FHandPose{
+		ToRecognizerVec(ToSpellcastingGrid(LHTrackingToWorld.TransformPosition(FromRecognizerVec(TrackingPose.LH.Position)))),
+		ToRecognizerRot(ToSpellcastingGrid(LHTrackingToWorld.TransformRotation(FromRecognizerRot(TrackingPose.LH.Rotation).Quaternion()).Rotator()))
+	};
+	return GridPose;
 }
 
-// Checks whether left hand start pos and right hand start pos are at the valid start position from each other
-// i.e. should RH be above/next to/in front of LH, if yes, is it
-// NOTE: Axis based calculation, will not work well for relPos FVec{0,1,1} where there is a 1 in more than one axis
-// LHStartPos and RHStartPos must be set before this function is called
-// Will always take MaxAbs(PosTolerance) for all axes - will never ignore 0 axes
-bool USpellComponent::CheckRHToLHDirection(FSpellData& referenceSpell, FVector PosTolerance) {
-	float Tolerance{ PosTolerance.GetAbsMax() };
-	FVector actRelativePos{ RHStartPos - LHStartPos };
-
-	if (referenceSpell.LtoRRelativeStartPos.X == 0) { // If x Axis position (in spellcasting grid) needs to be in tolerance
-		if (actRelativePos.X < -Tolerance || actRelativePos.X > Tolerance) {
-			return false;
-		}
-	}
-	if (referenceSpell.LtoRRelativeStartPos.Y == 0) { // If y Axis position (in spellcasting grid) needs to be in tolerance
-		if (actRelativePos.Y < -Tolerance || actRelativePos.Y > Tolerance) {
-			return false;
-		}
-	}
-	if (referenceSpell.LtoRRelativeStartPos.Z == 0) { // If z Axis position (in spellcasting grid) needs to be in tolerance
-		if (actRelativePos.Z < -Tolerance || actRelativePos.Z > Tolerance) {
-			return false;
-		}
-	}
-	return true;
+// Motion controller sampling - IMotionController is what UMotionControllerComponent reads every tick
+// NOTE: Stock XR plugins hand back the pose cached (or predicted) for the current frame, so polling faster than the headset's frame rate
+// mostly reads the same pose again - FPoseSampler drops the repeats, the samples that are left are at most one per tracking update
+// NOTE: Those plugins read their cached poses without a lock - a sample can mix two frames, which is no worse than a tick that lands mid-update
+bool FMotionControllerPoseSource::Init(const UMotionControllerComponent* RightHand, const UMotionControllerComponent* LeftHand, float NewWorldToMeters) {
+	MotionControllers = IModularFeatures::Get().GetModularFeatureImplementations<IMotionController>(IMotionController::GetModularFeatureName());
+	RHSource = RightHand->MotionSource;
+	LHSource = LeftHand->MotionSource;
+	PlayerIndex = RightHand->PlayerIndex;
+	WorldToMeters = NewWorldToMeters;
+	return MotionControllers.Num() > 0;
 }
 
-// Conversion functions - these decide which type of tolerance check is required, then convert to the relevant units... The logic brains of the operation
-
-// Returns true if RH is within tolerance of relevant keypoint
-bool USpellComponent::CheckRHStaticTolerance(FSpellData& spell, FKeyPoint& kp) {
-	bool rotationPassed{};
-	bool positionPassed{};
-
-	FRotator handRotation{ ToSpellcastingGrid(RHand->GetComponentRotation()) };
-	FVector handLocation{ ToSpellcastingGrid(RHand->GetComponentLocation()) };
-	FVector requiredLocation{ (kp.RHPosition * spell.Scale) + RHStartPos };
-	FVector posTolerance{ spell.PositionalTolerance * MAX_MOVE_TOLERANCE / 2};
-	
-	rotationPassed = PointEqual(handRotation, kp.RHRotation, spell.RotationalTolerance);
-	positionPassed = PointEqual(handLocation, requiredLocation, posTolerance);
-
-	/*if (!rotationPassed) {
-		UE_LOG(LogTemp, Warning, TEXT("RH static point rotation failed\n     RH Rot: %s\n     KP Rot: %s\n     Rot Tolerance: %s"),
-			*handRotation.ToString(), *kp.RHRotation.ToString(), *spell.RotationalTolerance.ToString());
-	}
-	if (!positionPassed) {
-		UE_LOG(LogTemp, Warning, TEXT("RH static point position failed\n     RH Pos: %s\n     KP Pos: %s\n     Pos Tolerance: %s"),
-			*handLocation.ToString(), *requiredLocation.ToString(), *posTolerance.ToString());
-	}*/
+bool FMotionControllerPoseSource::SamplePose(SpellRecognition::FPoseSample& OutPose) {
+	return SampleHand(RHSource, OutPose.RH) && SampleHand(LHSource, OutPose.LH);
+}
 
-	if (rotationPassed && positionPassed) {
-		return true;
-	}
-	else {
-		return false;
+bool FMotionControllerPoseSource::SampleHand(FName Source, SpellRecognition::FHandPose& OutPose) const {
+	for (const IMotionController* MotionController : MotionControllers) {
+		FRotator Rotation{};
+		FVector Position{};
+		if (MotionController && MotionController->GetControllerOrientationAndPosition(PlayerIndex, Source, Rotation, Position, WorldToMeters)) {
+			OutPose = SpellRecognition::FHandPose{ ToRecognizerVec(Position), ToRecognizerRot(Rotation) };
+			return true;
+		}
 	}
+	return false;
 }
 
-// Returns true if LH is within tolerance of relevant keypoint
-bool USpellComponent::CheckLHStaticTolerance(FSpellData& spell, FKeyPoint& kp) {
-	bool rotationPassed{};
-	bool positionPassed{};
-
-	FRotator handRotation{ ToSpellcastingGrid(LHand->GetComponentRotation()) };
-	FVector handLocation{ ToSpellcastingGrid(LHand->GetComponentLocation()) };
-	FVector requiredLocation{ (kp.LHPosition * spell.Scale) + LHStartPos };
-	FVector posTolerance{ spell.PositionalTolerance * MAX_MOVE_TOLERANCE / 2 };
-
-	rotationPassed = PointEqual(handRotation, kp.LHRotation, spell.RotationalTolerance);
-	positionPassed = PointEqual(handLocation, requiredLocation, posTolerance);
-
-	if (rotationPassed && positionPassed) {
-		return true;
+// Recognizer logging - same output as when these checks lived in this component, as Verbose LogSpellCasting (see SpellCastingLog.h)
+void FSpellRecognitionLogger::OnStartChecked(const SpellRecognition::FSpellDef& Spell, SpellRecognition::EHand Hand, bool isAccepted) {
+	if (Hand == SpellRecognition::EHand::Right) {
+		UE_LOG(LogSpellCasting, Verbose, TEXT("Starting pos/rot %s for spell: %s"), isAccepted ? TEXT("ACCEPTED") : TEXT("REJECTED"), GetSpellName(static_cast<SpellID>(Spell.ID)));
 	}
 	else {
-		return false;
+		UE_LOG(LogSpellCasting, Verbose, TEXT("Starting LH pos/rot %s for spell: %s"), isAccepted ? TEXT("ACCEPTED") : TEXT("REJECTED"), GetSpellName(static_cast<SpellID>(Spell.ID)));
 	}
 }
 
-// Returns true if RH is within tolerance of current keypoint movement
-// NOTE: Movement checks are done in unit space -> everything in spellgrid space must be converted
-bool USpellComponent::CheckRHMoveTolerance(FSpellData& spell, int& kpID) {
-	FKeyPoint& kp{ spell.KeyPoints[kpID] };
-	FKeyPoint& kpPrev{ (kpID == 0) ? spell.KeyPoints[0] : spell.KeyPoints[kpID - 1] };
-
-	// First check that hand rotation is in tolerance
-	if (!RotationMoveInTolerance(
-		ToSpellcastingGrid(RHand->GetComponentRotation()),
-		kpPrev.RHRotation,
-		kp.RHRotation,
-		spell.RotationalTolerance)
-		) {
-		return false;
-	}
-
-	// Then check if any other movements are out
-	switch (kp.Motion) {
-	case MoveType::Point: // Position from this point to last point does not change
-		if (!PointEqual( // Check if the hand has moved too far from the required position
-			ToSpellcastingGrid(RHand->GetComponentLocation()),
-			(kp.RHPosition * spell.Scale) + RHStartPos,
-			spell.PositionalTolerance * MAX_MOVE_TOLERANCE
-		)) {
-			return false;
-		}
-		break;
-	case MoveType::Line: // Position from this point to the last point does change (MAX TWO AXES!)
-		if (!LineMoveInTolerance( // Check if the movement went out of bounds
-			(ToSpellcastingGrid(RHand->GetComponentLocation()) - RHStartPos),
-			kpPrev.RHPosition * spell.Scale,
-			kp.RHPosition * spell.Scale,
-			spell.PositionalTolerance * MAX_MOVE_TOLERANCE // The reason we use MAX_MOVE_TOLERANCE here, is to keep some kind of order to the world - this may need increasing, we shall see
-		)) {
-			//UE_LOG(LogTemp, Error, TEXT("\nRH move tolerance failed!\n     RHPos %s\n     StartPos: %s; EndPos %s\n     Tolerance: %s"),
-			//	*(ToSpellcastingGrid(RHand->GetComponentLocation()) - RHStartPos).ToString(), *(kpPrev.RHPosition * spell.Scale).ToString(), *(kp.RHPosition * spell.Scale).ToString(), *(spell.PositionalTolerance * MAX_MOVE_TOLERANCE).ToString());
-			return false;
-		}
-		break;
-	}
-
-	return true;
+void FSpellRecognitionLogger::OnRelativeStartChecked(const SpellRecognition::FSpellDef& Spell, bool isAccepted, const SpellRecognition::FVec3& LHStartPos, const SpellRecognition::FVec3& RHStartPos) {
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Starting relative H position %s for spell: %s"), isAccepted ? TEXT("ACCEPTED") : TEXT("REJECTED"), GetSpellName(static_cast<SpellID>(Spell.ID)));
+	UE_LOG(LogSpellCasting, Verbose, TEXT("LH Start Pos: X=%.1f Y=%.1f Z=%.1f; RH Start Pos: X=%.1f Y=%.1f Z=%.1f; Relative Pos: X=%.1f Y=%.1f Z=%.1f"),
+		LHStartPos.X, LHStartPos.Y, LHStartPos.Z, RHStartPos.X, RHStartPos.Y, RHStartPos.Z,
+		RHStartPos.X - LHStartPos.X, RHStartPos.Y - LHStartPos.Y, RHStartPos.Z - LHStartPos.Z);
 }
 
-// Returns true if LH is within tolerance of current keypoint movement
-// NOTE: Movement checks are done in unit space -> everything in spellgrid space must be converted
-bool USpellComponent::CheckLHMoveTolerance(FSpellData& spell, int& kpID) {
-	FKeyPoint& kp{ spell.KeyPoints[kpID] };
-	FKeyPoint& kpPrev{ (kpID == 0) ? spell.KeyPoints[0] : spell.KeyPoints[kpID - 1] };
-
-	// First check that hand rotation is in tolerance
-	if (!RotationMoveInTolerance(
-		ToSpellcastingGrid(LHand->GetComponentRotation()),
-		kpPrev.LHRotation,
-		kp.LHRotation,
-		spell.RotationalTolerance)
-		) {
-		return false;
-	}
-
-	// Then check if any other movements are out
-	switch (kp.Motion) {
-	case MoveType::Point: // Position from this point to last point does not change
-		if (!PointEqual( // Check if the hand has moved too far from the required position
-			ToSpellcastingGrid(LHand->GetComponentLocation()),
-			(kp.LHPosition * spell.Scale) + LHStartPos,
-			spell.PositionalTolerance * MAX_MOVE_TOLERANCE
-		)) {
-			return false;
-		}
-		break;
-	case MoveType::Line: // Position from this point to the last point does change (MAX TWO AXES!)
-		if (!LineMoveInTolerance( // Check if the movement went out of bounds
-			(ToSpellcastingGrid(LHand->GetComponentLocation()) - LHStartPos),
-			kpPrev.LHPosition * spell.Scale,
-			kp.LHPosition * spell.Scale,
-			spell.PositionalTolerance * MAX_MOVE_TOLERANCE // The reason we use MAX_MOVE_TOLERANCE here, is to keep some kind of order to the world - this may need increasing, we shall see
-		)) {
-			//UE_LOG(LogTemp, Error, TEXT("\nLH move tolerance failed!\n     LHPos %s\n     StartPos: %s; EndPos %s\n     Tolerance: %s"),
-			//	*(ToSpellcastingGrid(LHand->GetComponentLocation()) - LHStartPos).ToString(), *(kpPrev.LHPosition * spell.Scale).ToString(), *(kp.LHPosition * spell.Scale).ToString(), *(spell.PositionalTolerance * MAX_MOVE_TOLERANCE).ToString());
-			return false;
-		}
-		break;
-	}
-
-	return true;
+void FSpellRecognitionLogger::OnNoSpellAvailable() {
+	UE_LOG(LogSpellCasting, Verbose, TEXT("No spells can be cast from that starting configuration!"));
 }
 
-// Calculcation functions... The maths brains of the operation
-
-// Checks if a position is within tolerance +/- of another position
-// Ignores axes where tolerance.axis == 0
-bool USpellComponent::PointEqual(FVector posToCheck, FVector refPos, FVector posTolerance) {
-	FVector RelativePos{ posToCheck - refPos };
-
-	if (posTolerance.X != 0) {
-		if (RelativePos.X > posTolerance.X || RelativePos.X < -posTolerance.X) { // If relative X position is too far away
-			return false;
-		}
-	}
-	if (posTolerance.Y != 0) {
-		if (RelativePos.Y > posTolerance.Y || RelativePos.Y < -posTolerance.Y) { // If relative Y position is too far away
-			return false;
-		}
-	}
-	if (posTolerance.Z != 0) {
-		if (RelativePos.Z > posTolerance.Z || RelativePos.Z < -posTolerance.Z) { // If relative Z position is too far away
-			return false;
-		}
-	}
-
-	return true;
+void FSpellRecognitionLogger::OnSpellDeactivated(const SpellRecognition::FSpellDef& Spell) {
+	UE_LOG(LogSpellCasting, Verbose, TEXT("Spell Deactivated: %s!!"), GetSpellName(static_cast<SpellID>(Spell.ID)));
 }
 
-// Checks if a rotation is within tolerance +/- of another rotation
-// Ignores axes where tolerance.axis == 0
-bool USpellComponent::PointEqual(FRotator rotToCheck, FRotator refRot, FRotator rotTolerance) {
-	
-	FRotator RelativeRot{ rotToCheck - refRot };
-
-	// The actual check
-	if (rotTolerance.Pitch != 0) {
-		if (RelativeRot.Pitch > rotTolerance.Pitch || RelativeRot.Pitch < -rotTolerance.Pitch) { // If relative Pitch position is too far away
-			//UE_LOG(LogTemp, Error, TEXT("\nPoint pitch tolerance failed!\n     Pitch to check: %f\n     Ref Pitch: %f\n     Tolerance: %f"), rotToCheck.Pitch, refRot.Pitch, rotTolerance.Pitch)
-			return false;
-		}
-	}
-	if (rotTolerance.Yaw != 0) {
-		if (RelativeRot.Yaw > rotTolerance.Yaw || RelativeRot.Yaw < -rotTolerance.Yaw) { // If relative Yaw position is too far away
-			//UE_LOG(LogTemp, Error, TEXT("\nPoint yaw tolerance failed!\n     yaw to check: %f\n     Ref yaw: %f\n     Tolerance: %f"), rotToCheck.Yaw, refRot.Yaw, rotTolerance.Yaw)
-			return false;
-		}
-	}
-	if (rotTolerance.Roll != 0) {
-		if (RelativeRot.Roll > rotTolerance.Roll || RelativeRot.Roll < -rotTolerance.Roll) { // If relative Roll position is too far away
-			//UE_LOG(LogTemp, Error, TEXT("\nPoint Roll tolerance failed!\n     Roll to check: %f\n     Ref Roll: %f\n     Tolerance: %f"), rotToCheck.Roll, refRot.Roll, rotTolerance.Roll)
-			return false;
-		}
+// *** DEV SECTION *** //
+void USpellComponent::RecordTrajectory(SpellRecognition::ETrajectoryEvent Event, const SpellRecognition::FPoseSample& Pose, double Time) {
+	if (!isRecordingTrajectories) {
+		return;
 	}
-
-	return true;
+	const uint16 Buttons{ static_cast<uint16>(
+		(isRHCasting ? SpellRecognition::TrajectoryRHCast : 0) |
+		(isLHCasting ? SpellRecognition::TrajectoryLHCast : 0) |
+		(isRHLaunching ? SpellRecognition::TrajectoryRHLaunch : 0) |
+		(isLHLaunching ? SpellRecognition::TrajectoryLHLaunch : 0)) };
+	TrajectoryRecorder.Add(SpellRecognition::MakeTrajectoryRecord(TrajectoryFrame, static_cast<float>(Time - TrajectoryStartTime), Buttons, Event, Pose));
 }
 
-// Checks if two floats are within tolerance of each other
-bool USpellComponent::PointEqual(float PointToCheck, float refPoint, float PointTolerance) {
-	if (PointToCheck > refPoint + PointTolerance ||
-		PointToCheck < refPoint - PointTolerance) {
-		return false;
+// Ensures this tick's casting reused the storage of the ticks before it - everything counted in TickAllocations since the last check
+// NOTE: ensureMsgf() only fires once per run - look for the allocation with a memory trace (-trace=memory) or a breakpoint in FCountingMalloc
+void USpellComponent::CheckTickAllocations() {
+	if (isAllocationCheckEnabled && isAllocationCheckArmed && !isRecordingTrajectories) {
+		ensureMsgf(TickAllocations == 0, TEXT("USpellComponent made %llu heap allocations this tick - casting should make none once warmed up"), TickAllocations);
 	}
-	return true;
+	TickAllocations = 0;
 }
 
-// Checks if RotToCheck is within the bounds created by StartRot and EndRot and tolerance
-bool USpellComponent::RotationMoveInTolerance(FRotator RotToCheck, FRotator StartRot, FRotator EndRot, FRotator RotTolerance) {
-	// Pivot Check (twist your wrist)
-	FRotator MinRot{};
-	FRotator MaxRot{};
-	FRotator PointRelativeRot{ EndRot - StartRot };
-
-	// Check tolerance for each axis
-	if (RotTolerance.Pitch != 0) { // If pitch axis needs checking
-		if (PointRelativeRot.Pitch == 0) { // If there is no movement from A->B in pitch axis
-			MinRot.Pitch = StartRot.Pitch - RotTolerance.Pitch;
-			MaxRot.Pitch = StartRot.Pitch + RotTolerance.Pitch;
-		}
-		else { // If there is movement from point a -> point b in pitch axis
-			if (PointRelativeRot.Pitch < 0) {
-				MinRot.Pitch = EndRot.Pitch - RotTolerance.Pitch;
-				MaxRot.Pitch = StartRot.Pitch + RotTolerance.Pitch;
-			}
-			else { // PointRelativeRot.Pitch > 0
-				MinRot.Pitch = StartRot.Pitch - RotTolerance.Pitch;
-				MaxRot.Pitch = EndRot.Pitch + RotTolerance.Pitch;
-			}
-		}
-		// Return false if out of bounds
-		if (RotToCheck.Pitch < MinRot.Pitch || RotToCheck.Pitch > MaxRot.Pitch) {
-			//UE_LOG(LogTemp, Error, TEXT("Pitch motion rot (%f) out of bounds\n     Min allowed: %f\n     Max allowed: %f"), RotToCheck.Pitch, MinRot.Pitch, MaxRot.Pitch);
-			return false;
-		}
+// Writes everything recorded this play to Saved/Trajectories/<date and time>.spelltraj
+void USpellComponent::SaveTrajectories() {
+	if (TrajectoryRecorder.Num() == 0) {
+		return;
 	}
+	std::vector<uint8_t> Recording{};
+	TrajectoryRecorder.Write(Recording);
+	TrajectoryRecorder.Reset();
 
-	if (RotTolerance.Yaw != 0) { // If yaw axis needs checking
-		if (PointRelativeRot.Yaw == 0) { // If there is no movement from A->B in yaw axis
-			MinRot.Yaw = StartRot.Yaw - RotTolerance.Yaw;
-			MaxRot.Yaw = StartRot.Yaw + RotTolerance.Yaw;
-		}
-		else { // If there is movement from point a -> point b in yaw axis
-			if (PointRelativeRot.Yaw < 0) {
-				MinRot.Yaw = EndRot.Yaw - RotTolerance.Yaw;
-				MaxRot.Yaw = StartRot.Yaw + RotTolerance.Yaw;
-			}
-			else { // PointRelativeRot.Yaw > 0
-				MinRot.Yaw = StartRot.Yaw - RotTolerance.Yaw;
-				MaxRot.Yaw = EndRot.Yaw + RotTolerance.Yaw;
-			}
-		}
-		// Return false if out of bounds
-		if (RotToCheck.Yaw < MinRot.Yaw || RotToCheck.Yaw > MaxRot.Yaw) {
-			//UE_LOG(LogTemp, Error, TEXT("Yaw motion rot (%f) out of bounds\n     Min allowed: %f\n     Max allowed: %f"), RotToCheck.Yaw, MinRot.Yaw, MaxRot.Yaw);
-			return false;
-		}
+	TArray<uint8> FileData{};
+	FileData.Append(Recording.data(), static_cast<int32>(Recording.size()));
+	const FString FilePath{ FPaths::ProjectSavedDir() / TEXT("Trajectories") / (FDateTime::Now().ToString() + TEXT(".spelltraj")) };
+	if (FFileHelper::SaveArrayToFile(FileData, *FilePath)) {
+		UE_LOG(LogTemp, Warning, TEXT("Trajectory recording saved to %s"), *FilePath);
 	}
-
-	if (RotTolerance.Roll != 0) { // If Roll axis needs checking
-		if (PointRelativeRot.Roll == 0) { // If there is no movement from A->B in Roll axis
-			MinRot.Roll = StartRot.Roll - RotTolerance.Roll;
-			MaxRot.Roll = StartRot.Roll + RotTolerance.Roll;
-		}
-		else { // If there is movement from point a -> point b in Roll axis
-			if (PointRelativeRot.Roll < 0) {
-				MinRot.Roll = EndRot.Roll - RotTolerance.Roll;
-				MaxRot.Roll = StartRot.Roll + RotTolerance.Roll;
-			}
-			else { // PointRelativeRot.Roll > 0
-				MinRot.Roll = StartRot.Roll - RotTolerance.Roll;
-				MaxRot.Roll = EndRot.Roll + RotTolerance.Roll;
-			}
-		}
-
-		// Return false if out of bounds
-		if (RotToCheck.Roll < MinRot.Roll || RotToCheck.Roll > MaxRot.Roll) {
-			//UE_LOG(LogTemp, Error, TEXT("Roll motion rot (%f) out of bounds\n     Min allowed: %f\n     Max allowed: %f"), RotToCheck.Roll, MinRot.Roll, MaxRot.Roll);
-			return false;
-		}
+	else {
+		UE_LOG(LogTemp, Error, TEXT("Failed to save trajectory recording to %s"), *FilePath);
 	}
-
-	return true; // passed all rotational movement checks
 }
 
-// Checks if a position is within the bounds created by start pos, end pos and tolerance
-// All passed in values must be in unit co-ordinates (ie (worldsize/scale))
-bool USpellComponent::LineMoveInTolerance(FVector PosToCheck, FVector StartPos, FVector EndPos, FVector PosTolerance) {
-	/* This function performs the following logic:
-	* For every axis where tolerance != 0:
-	*	Where it is the only axis that changes from a->b check it is in tolerance
-	*	If it moves along with one other axis check that the relative movement of both of these is in tolerance (i.e. DeltaX = 3, DeltaY = 5)
-	*/
-
-	FVector DeltaPos{ EndPos - StartPos }; // The required motion in unit space from startpos
-	FVector RelativePos{ PosToCheck - StartPos }; // Relative position in grid space from strartpos
-	
-	FVector MinPos{ ((StartPos.X < EndPos.X) ? StartPos.X : EndPos.X) - PosTolerance.X,
-					((StartPos.Y < EndPos.Y) ? StartPos.Y : EndPos.Y) - PosTolerance.Y,
-					((StartPos.Z < EndPos.Z) ? StartPos.Z : EndPos.Z) - PosTolerance.Z };
-	FVector MaxPos{ ((StartPos.X > EndPos.X) ? StartPos.X : EndPos.X) + PosTolerance.X,
-					((StartPos.Y > EndPos.Y) ? StartPos.Y : EndPos.Y) + PosTolerance.Y,
-					((StartPos.Z > EndPos.Z) ? StartPos.Z : EndPos.Z) + PosTolerance.Z };
-
-	if (PosTolerance.X != 0) { // If x axis needs checking
-		if (DeltaPos.X == 0) { // If x value does not change during movement
-			if (!PointEqual(PosToCheck.X, StartPos.X, PosTolerance.X)) { // If the tolerance check failes
-				//UE_LOG(LogTemp, Error, TEXT("X Move Point Fail"));
-				return false;
-			}
-		}
-		else { // if X does change, check if any other axis is moving - NOTE: Spell setup states that a maximum of two axes will be moving - therefore no further checks are needed for all three
-			if (PosTolerance.Y != 0 && DeltaPos.Y != 0) { // if the other moving axis is Y axis
-				// If width out of tolerance
-				if (!DiagonalMoveInTolerance(RelativePos.X, RelativePos.Y, DeltaPos.X, DeltaPos.Y, (PosTolerance.X == 0) ? PosTolerance.Y : PosTolerance.X)) {
-					//UE_LOG(LogTemp, Error, TEXT("XY Move Diag Fail\n     RelativePos: %s\n     Delta Pos: %s"), *RelativePos.ToString(), *DeltaPos.ToString());
-					return false;
-				}
-				// If length out of tolerance
-				if (PosToCheck.Y > MaxPos.Y || PosToCheck.Y < MinPos.Y || PosToCheck.X > MaxPos.X || PosToCheck.X < MinPos.X) {
-					//UE_LOG(LogTemp, Error, TEXT("XY Move Diag Length Fail"));
-					return false;
-				}
-			}
-			else if (PosTolerance.Z != 0 && DeltaPos.Z != 0) { // if the other moving axis is Z axis
-				// If width out of tolerance
-				if (!DiagonalMoveInTolerance(RelativePos.X, RelativePos.Z, DeltaPos.X, DeltaPos.Z, (PosTolerance.X == 0) ? PosTolerance.Z : PosTolerance.X)) {
-					//UE_LOG(LogTemp, Error, TEXT("XZ Move Diag Fail"));
-					return false;
-				}
-				// If length out of tolerance
-				if (PosToCheck.Z > MaxPos.Z || PosToCheck.Z < MinPos.Z || PosToCheck.X > MaxPos.X || PosToCheck.X < MinPos.X) {
-					//UE_LOG(LogTemp, Error, TEXT("XZ Move Diag Length Fail\n     RelativePos: %s\n     Delta Pos: %s"), *RelativePos.ToString(), *DeltaPos.ToString());
-					return false;
-				}
-			}
-			else { // if X is the only moving axis - check that movement is not outside max/min
-				if (PosToCheck.X < MinPos.X || PosToCheck.X > MaxPos.X) {
-					//UE_LOG(LogTemp, Error, TEXT("X Move Straight Length Fail"));
-					return false;
-				}
-			}
-		}
+// Writes the rejection counters to Saved/Profiling/SpellRejections.csv - one row per spell and hand that was rejected, with the spell's name
+// Columns are the same as SpellRecognition::WriteRejectionCounters()
+void USpellComponent::SaveRejectionCounters() const {
+	const SpellRecognition::FRejectionCounters& Counters{ Recognizer.GetRejectionCounters() };
+	FString Output{ TEXT("Spell,Hand") };
+	for (int32 Reason{ 0 }; Reason < SpellRecognition::FRejectionCounters::NumReasons; Reason++) {
+		Output += FString::Printf(TEXT(",%s"), ANSI_TO_TCHAR(SpellRecognition::GetRejectReasonName(static_cast<SpellRecognition::ERejectReason>(Reason))));
 	}
+	Output += TEXT("\n");
 
-	if (PosTolerance.Y != 0) { // If Y axis needs checking - NOTE: X axis has been checked...
-		if (DeltaPos.Y == 0) { // If Y value does not change during movement
-			if (!PointEqual(PosToCheck.Y, StartPos.Y, PosTolerance.Y)) { // If the tolerance check failes
-				//UE_LOG(LogTemp, Error, TEXT("Y Move Point Fail"));
-				return false;
-			}
-		}
-		else { // Y does change
-			if (PosTolerance.Z != 0 && DeltaPos.Z != 0) { // if the other moving axis is Z (NOTE: X->Y has already been verified)
-				if (!DiagonalMoveInTolerance(RelativePos.Y, RelativePos.Z, DeltaPos.Y, DeltaPos.Z, (PosTolerance.Y == 0) ? PosTolerance.Z : PosTolerance.Y)) {
-					//UE_LOG(LogTemp, Error, TEXT("YZ Move Diag Fail\n     RelativePos: %s\n     Delta Pos: %s"), *RelativePos.ToString(), *DeltaPos.ToString());
-					return false;
-				}
-				// If length out of tolerance
-				if (PosToCheck.Y > MaxPos.Y || PosToCheck.Y < MinPos.Y || PosToCheck.Z > MaxPos.Z || PosToCheck.Z < MinPos.Z) {
-					//UE_LOG(LogTemp, Error, TEXT("YZ Move Diag Length Fail"));
-					return false;
-				}
-			}
-			else if ((PosTolerance.X != 0 && DeltaPos.X == 0) || PosTolerance.X == 0) { // If Y is the only moving axis
-				if (PosToCheck.Y < MinPos.Y || PosToCheck.Y > MaxPos.Y) {
-					//UE_LOG(LogTemp, Error, TEXT("Y Move Straight Length Fail"));
-					return false;
-				}
-			}
+	bool hasData{ false };
+	for (int32 Spell{ 0 }; Spell < Counters.NumSpellIDs(); Spell++) {
+		if (Counters.GetTotal(Spell) == 0) {
+			continue;
 		}
-	}
+		hasData = true;
+		const FString SpellName{ UEnum::GetValueAsString(static_cast<SpellID>(Spell)) };
+		UE_LOG(LogTemp, Warning, TEXT("Spell %s rejected %u times"), *SpellName, Counters.GetTotal(Spell));
 
-	if (PosTolerance.Z != 0) { // If Z axis needs checking - NOTE: X && Y have both been checked
-		if (DeltaPos.Z == 0) { // If Z value does not change during movement
-			if (!PointEqual(PosToCheck.Z, StartPos.Z, PosTolerance.Z)) { // If the tolerance check failes
-				//UE_LOG(LogTemp, Error, TEXT("Z Move Point Fail"));
-				return false;
+		for (int32 Hand{ 0 }; Hand < SpellRecognition::FRejectionCounters::NumHands; Hand++) {
+			FString Row{};
+			uint32 HandTotal{ 0 };
+			for (int32 Reason{ 0 }; Reason < SpellRecognition::FRejectionCounters::NumReasons; Reason++) {
+				const uint32 Count{ Counters.Get(Spell, static_cast<SpellRecognition::ERejectHand>(Hand), static_cast<SpellRecognition::ERejectReason>(Reason)) };
+				Row += FString::Printf(TEXT(",%u"), Count);
+				HandTotal += Count;
 			}
-		}
-		else { // Z does change
-			// NOTE: X->Z && Y->Z have already been checked
-			if (((PosTolerance.X != 0 && DeltaPos.X == 0) || PosTolerance.X == 0) && 
-				((PosTolerance.Y != 0 && DeltaPos.Y == 0) || PosTolerance.Y == 0)) { // If Z is the only moving axis
-				if (PosToCheck.Z < MinPos.Z || PosToCheck.Z > MaxPos.Z) {
-					//UE_LOG(LogTemp, Error, TEXT("Z Move Straight Length Fail"));
-					return false;
-				}
+			if (HandTotal > 0) {
+				Output += FString::Printf(TEXT("%s,%s%s\n"), *SpellName, ANSI_TO_TCHAR(SpellRecognition::GetRejectHandName(static_cast<SpellRecognition::ERejectHand>(Hand))), *Row);
 			}
 		}
 	}
-
-	return true;
-}
-
-// Part of LineMoveInTolerance()
-bool USpellComponent::DiagonalMoveInTolerance(float iPos, float jPos, float DeltaI, float DeltaJ, float WidthTolerance) {
-	
-	float actMovLen{ FMath::Sqrt(FMath::Square(iPos) + FMath::Square(jPos)) }; // Length of hand movement from startPos
-	float theta{ FMath::Atan(DeltaJ / DeltaI) }; // Angle from axis I of required movement
-	float idealI{ actMovLen * FMath::Cos(theta) }; // Where i would be on ideal line
-	float idealJ{ actMovLen * FMath::Sin(theta) }; // Where j would be on ideal line
-
-	// Fix lack of negativity
-	if (DeltaI < 0) {
-		idealI = (idealI < 0) ? idealI : - idealI;
-	}
-	else {
-		idealI = (idealI > 0) ? idealI : -idealI;
-	}
-	if (DeltaJ < 0) {
-		idealJ = (idealJ < 0) ? idealJ : -idealJ;
-	}
-	else {
-		idealJ = (idealJ > 0) ? idealJ : -idealJ;
-	}
-
-	// Perform tolerance check (basically a positional check at this point)
-	if (!PointEqual(iPos, idealI, WidthTolerance) ||
-		!PointEqual(jPos, idealJ, WidthTolerance)) {
-		return false;
+	if (hasData) {
+		FFileHelper::SaveStringToFile(Output, *(FPaths::ProjectSavedDir() / TEXT("Profiling") / TEXT("SpellRejections.csv")));
 	}
-
-	return true;
 }
 
-/*
-// Checks if an arc motion is in tolerance
-// NOTE: All values must be passed in unit scale
-bool USpellComponent::ArcMoveInTolerance(FVector PosToCheck, FVector StartPos, FVector EndPos, FVector PosTolerance, MoveType Quadrant) {	
-	FVector RefRelativePos{ EndPos - StartPos }; // As it is an arc movement, there will always be only one axis == 0 here (we are not going 3D with the movements - just the tolerances)
-	FVector ChkRelativePos{ PosToCheck - StartPos };
-	int QuadMod{ 0 };
-	// There are three variations -> either DeltaX = 0, DeltaY = 0 or Delta Z = 0
-	// For each variation there are four quadrants in a circle, we need to figure out which quadrant we are in (which 90Deg)	
-	// Then we can calculate based on that quadrant's arc type
-	
-	switch (Quadrant) {
-	case MoveType::Arc1:
-		QuadMod = 0;
-		break;
-	case MoveType::Arc2:
-		QuadMod = 1;
-		break;
-	case MoveType::Arc3:
-		QuadMod = 2;
-		break;
-	case MoveType::Arc4:
-		QuadMod = 3;
-	}
-
-
-	if (RefRelativePos.X == 0) { // Variation 1: Movement is in YZ plane (RL/UD) - Z = sin(Y * 90) - Quadrant in terms of sine Y
-		
-	}
-	else if (RefRelativePos.Y == 0) { // Variation 2: Movement is in XZ plane (FB/UD) - Z = sin(X * 90) - quadrant in terms of sine X
-
-	}
-	else { // Variation 3: Movement is in XY plane (FB/RL) - X = sin(Y * 90)- currently no spells use this variation
-
-	}
-
-	return true;
-}
-*/
-
-// *** DEV SECTION *** //
 void USpellComponent::RunDevTests() {
 	if (!isLoggingLHData) {
 		if (isLHCasting) { // If LH casting started
 			// Setup LH Logging variables
-			FVector curPos{ ToSpellcastingGrid(LHand->GetComponentLocation()) };
-			FRotator curRot{ ToSpellcastingGrid(LHand->GetComponentRotation()) };
+			FVector curPos{ FromRecognizerVec(HandPoses.LH.Position) };
+			FRotator curRot{ FromRecognizerRot(HandPoses.LH.Rotation) };
 
 			MinLHPos = FVector{ curPos };
 			MaxLHPos = FVector{ curPos };
@@ -1142,8 +921,8 @@ void USpellComponent::RunDevTests() {
 	if (!isLoggingRHData) {
 		if (isRHCasting) { // If RH casting started
 			// Setup RH Logging variables
-			FVector curPos{ ToSpellcastingGrid(RHand->GetComponentLocation()) };
-			FRotator curRot{ ToSpellcastingGrid(RHand->GetComponentRotation()) };
+			FVector curPos{ FromRecognizerVec(HandPoses.RH.Position) };
+			FRotator curRot{ FromRecognizerRot(HandPoses.RH.Rotation) };
 
 			MinRHPos = FVector{ curPos };
 			MaxRHPos = FVector{ curPos };
@@ -1168,8 +947,8 @@ void USpellComponent::RunDevTests() {
 // Updates maximum motion details for casting log output
 void USpellComponent::UpdateMoveDetails() {
 	if (isLHCasting) {
-		FVector handPos{ ToSpellcastingGrid(LHand->GetComponentLocation()) };
-		FRotator handRot{ ToSpellcastingGrid(LHand->GetComponentRotation()) };
+		FVector handPos{ FromRecognizerVec(HandPoses.LH.Position) };
+		FRotator handRot{ FromRecognizerRot(HandPoses.LH.Rotation) };
 
 		MinLHPos.X = (MinLHPos.X < handPos.X) ? MinLHPos.X : handPos.X;
 		MaxLHPos.X = (MaxLHPos.X > handPos.X) ? MaxLHPos.X : handPos.X;
@@ -1186,8 +965,8 @@ void USpellComponent::UpdateMoveDetails() {
 		MaxLHRot.Roll = (MaxLHRot.Roll > handRot.Roll) ? MaxLHRot.Roll : handRot.Roll;
 	}
 	if (isRHCasting) {
-		FVector handPos{ ToSpellcastingGrid(RHand->GetComponentLocation()) };
-		FRotator handRot{ ToSpellcastingGrid(RHand->GetComponentRotation()) };
+		FVector handPos{ FromRecognizerVec(HandPoses.RH.Position) };
+		FRotator handRot{ FromRecognizerRot(HandPoses.RH.Rotation) };
 
 		MinRHPos.X = (MinRHPos.X < handPos.X) ? MinRHPos.X : handPos.X;
 		MaxRHPos.X = (MaxRHPos.X > handPos.X) ? MaxRHPos.X : handPos.X;
@@ -14,11 +14,54 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "SpellCastingController.h"
+#include "SpellRecognitionManager.h"
+#include "Recognition/DtwMatcher.h"
+#include "Recognition/DualHandInput.h"
+#include "Recognition/PoseSampler.h"
+#include "Recognition/SpellRecognizer.h"
+#include "Recognition/TrajectoryRecording.h"
 #include "SpellComponent.generated.h"
 
+// Logs the decisions made by the spell recognizer - see Recognition/SpellRecognizer.h
+class FSpellRecognitionLogger : public SpellRecognition::IRecognitionListener {
+public:
+	virtual void OnStartChecked(const SpellRecognition::FSpellDef& Spell, SpellRecognition::EHand Hand, bool isAccepted) override;
+	virtual void OnRelativeStartChecked(const SpellRecognition::FSpellDef& Spell, bool isAccepted, const SpellRecognition::FVec3& LHStartPos, const SpellRecognition::FVec3& RHStartPos) override;
+	virtual void OnNoSpellAvailable() override;
+	virtual void OnSpellDeactivated(const SpellRecognition::FSpellDef& Spell) override;
+};
+
+// Reads both motion controllers straight from the XR tracking system, so it can be polled by the pose sampling thread
+// NOTE: Only as fresh as the tracking system's own poses - with stock XR plugins that is once a frame (see FMotionControllerPoseSource::Init())
+// NOTE: Poses are in tracking space (relative to the motion controllers' parent) - see USpellComponent::TrackingToSpellcastingGrid()
+class FMotionControllerPoseSource : public SpellRecognition::IPoseSource {
+public:
+	// Game thread - returns false if there is no tracking system to sample
+	bool Init(const class UMotionControllerComponent* RightHand, const class UMotionControllerComponent* LeftHand, float NewWorldToMeters);
+	virtual bool SamplePose(SpellRecognition::FPoseSample& OutPose) override;
+
+private:
+	TArray<class IMotionController*> MotionControllers{};
+	FName RHSource{};
+	FName LHSource{};
+	int32 PlayerIndex{ 0 };
+	float WorldToMeters{ 100.f };
+
+	bool SampleHand(FName Source, SpellRecognition::FHandPose& OutPose) const;
+};
+
+// The spell most likely being cast changed - None once nothing leads. Confidence is the spell's FSpellConfidence::Score (1 once complete)
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnLikelySpellChanged, SpellID /*Spell*/, float /*Confidence*/);
+
+// The casting node actors shown for one keypoint - see USpellComponent::UpdateCastingNodes()
+struct FKeyPointCastingNodes {
+	class ACastingNode* RH{ nullptr };
+	class ACastingNode* LH{ nullptr };
+};
+
 
 UCLASS( Blueprintable )
-class BATTLEMAGEATLANTIS01_API USpellComponent : public USceneComponent
+class BATTLEMAGEATLANTIS01_API USpellComponent : public USceneComponent, public ISpellRecognitionCaster
 {
 	GENERATED_BODY()
 
@@ -29,16 +72,31 @@ public:
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
-	// Called every frame
+	// Called every frame while a hand is casting (or trajectories are being recorded) - asleep otherwise, see TickSleep.h
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	// Which check rejected which spell this play, by SpellID and hand - saved to Saved/Profiling/SpellRejections.csv when play ends
+	const SpellRecognition::FRejectionCounters& GetRejectionCounters() const { return Recognizer.GetRejectionCounters(); }
+
+	// Batch recognition - called by the USpellRecognitionManager after this component has ticked (see isBatchRecognitionEnabled)
+	virtual void GatherRecognitionUpdate(SpellRecognition::FRecognitionBatch& Batch) override;
+	virtual void ApplyRecognitionUpdate(const SpellRecognition::FCasterUpdate* Update) override;
+
+	// Fired mid cast as soon as one spell leads the others (see FSpellRecognizer::GetLeadingSpell()), long before the last keypoint
+	// Use it to pre-warm the likely spell's effects, so they are ready the moment the cast completes
+	FOnLikelySpellChanged OnLikelySpellChanged{};
+
 private: // List of spells and spell components
 
-	// Array holding the spell data of all the game's spells - basically the memory bank
-	// Yes it's hard coded. No I'm not currently planning on changing that.
-	TArray<FSpellData> AllSpells{};
+	// The engine independent brains of the operation - spells are set up from the spell table (see USpellContainer) in BeginPlay()
+	SpellRecognition::FSpellRecognizer Recognizer{};
+
+	// Casting nodes of every spell keypoint - same spell order as the Recognizer
+	TArray<TArray<FKeyPointCastingNodes>> CastingNodes{};
+	FSpellRecognitionLogger RecognitionLogger{};
 
 	UPROPERTY(VisibleAnywhere, category = "Setup")
 	USpellContainer* SpellContainer;
@@ -80,6 +138,55 @@ private: // Operating Variables
 	class UMotionControllerComponent* LHand;
 	class UCameraComponent* hmdCamera;
 
+	// Spellcasting grid rotation - the grid only rotates in Yaw, so the sin/cos are worked out in SetFrameStartPosAndRot() instead of every conversion
+	// NOTE: Also redone if the grid turns with its parent mid cast, see CheckGridTransform()
+	FQuat GridQuat{ FQuat::Identity };
+	FRotator GridRotation{};
+	float GridYawSin{ 0.f };
+	float GridYawCos{ 1.f };
+
+	// Both hands in spellcasting grid space for this tick - read from the motion controllers once, then shared by everything that needs them
+	SpellRecognition::FPoseSample HandPoses{};
+
+	// High rate pose sampling - every sample taken since the last tick is checked, not just the one above (see Recognition/PoseSampler.h)
+	// Falls back to one sample per tick if disabled or there is no tracking system
+	UPROPERTY(EditAnywhere, category = "Pose Sampling")
+	bool isPoseSamplingEnabled{ true };
+	UPROPERTY(EditAnywhere, category = "Pose Sampling", meta = (ClampMin = "1.0"))
+	float PoseSampleRate{ 500.f }; // Polls per second - only new poses are kept, so this caps the samples checked. Can be lowered a good deal if isSweptKeyPointsEnabled
+	FMotionControllerPoseSource PoseSource{};
+	SpellRecognition::FPoseSampler PoseSampler{};
+	double CastStartTime{ 0.0 }; // When SpellSetup() ran, on the FPoseSampler::Now() clock - older samples are ignored
+
+	// DTW matching - the spell is picked from the whole cast when the cast button is released, instead of when the last keypoint is reached
+	// More forgiving of casts that are sloppy but follow the right path (see Recognition/DtwMatcher.h), the keypoint checks still drive the casting nodes
+	UPROPERTY(EditAnywhere, category = "Recognition")
+	bool isDtwMatchingEnabled{ false };
+	UPROPERTY(EditAnywhere, category = "Recognition", meta = (ClampMin = "0.0"))
+	float DtwMaxCost{ 1.f }; // Highest average cost per point that is still a match - 1 is roughly every checked axis on its tolerance
+	SpellRecognition::FDtwMatcher DtwMatcher{};
+	// Check the spells of every caster in the world together, spread over the worker threads (see SpellRecognitionManager.h)
+	// Otherwise the spells are checked in this component's tick
+	// NOTE: When enabled the results (CurrentSpell, the casting nodes, OnLikelySpellChanged) are only ready once the manager has ticked,
+	// later in the same frame - ticks that read them and do not run after the manager (e.g. in TG_PrePhysics) see last frame's
+	UPROPERTY(EditAnywhere, category = "Recognition")
+	bool isBatchRecognitionEnabled{ true };
+	USpellRecognitionManager* RecognitionManager{ nullptr }; // Set if this component is in the batch
+	SpellRecognition::FRecognitionBatch LocalBatch{}; // Used to check the samples in the tick when there is no manager
+	// Leading spell & early commit - see FRecognizerSettings
+	UPROPERTY(EditAnywhere, category = "Recognition", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float LeadMargin{ 0.25f }; // How far ahead of every other spell the likely spell has to be before OnLikelySpellChanged fires
+	UPROPERTY(EditAnywhere, category = "Recognition", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float EarlyCommitScore{ 0.f }; // Complete the last spell standing once it is this sure, without waiting for its last keypoint - 0 to disable
+	SpellID LikelySpell{ SpellID::None };
+	// Check rotations as quaternions (swing/twist limits) instead of per Euler axis - no wraparound at +-180 or gimbal lock
+	UPROPERTY(EditAnywhere, category = "Recognition")
+	bool isQuaternionRotationEnabled{ false };
+	// Check keypoints against the whole move since the last sample, not just the sample - a hand that passes through a keypoint between samples still completes it
+	// Keeps recognition accurate at lower PoseSampleRate or over dropped frames, the sample must still be in tolerance of the move
+	UPROPERTY(EditAnywhere, category = "Recognition")
+	bool isSweptKeyPointsEnabled{ false };
+
 	/*UPROPERTY(EditDefaultsOnly)
 	class USpellCastingController* SpellcastingController;*/
 
@@ -87,28 +194,24 @@ private: // Operating Variables
 	const float MAX_MOVE_TOLERANCE = 8.f; // Constant used as the maximum movement allowed from ideal line for tolerance checks
 	const float MIN_MOVE_SCALE = 8.f; // Constant used as minimum movement for spellcasting scale to be updated
 	const float MAX_DUAL_HAND_DELAY = 0.2f; // Time in seconds to wait for second hand to decide whether to cancel dual-casting
-	float CurrentDualHandDelay{ 0 }; // Time in seconds since first hand started casting
 
 	// Connected to user inputs A/X (oculus touch)
 	bool isRHCasting{ false };
 	bool isLHCasting{ false };
 	// NOTE: Dual handed casting happens whenever both of these are set to true in short succession
-	// Right/LeftHandCast functions do not allow both to be true if MAX_DUAL_HAND delay has been reached
+	// CastInput decides from the press times - the second hand is ignored once MAX_DUAL_HAND_DELAY has passed
+	// Letting go of one hand of a dual cast waits MAX_DUAL_HAND_DELAY for it to come back before the other hand casts on its own
+	SpellRecognition::FDualHandInput CastInput{ MAX_DUAL_HAND_DELAY };
 
-	bool isLaunching{false};
 	bool isRHLaunching{ false };
 	bool isLHLaunching{ false };
-	float CurrentDualLaunchDelay{ 0.f };
+	SpellRecognition::FDualHandInput LaunchInput{ MAX_DUAL_HAND_DELAY };
+	FTimerHandle LaunchWindowTimer; // Fires when LaunchInput's window closes with one hand
 
 	// Spellcasting state boolean values
 	bool isCasting{ false };
 	bool isComplete{ false };
 
-	// Start position and orientation of both hands for this cast period in terms of spellcasting grid
-	FVector RHStartPos{};
-	FVector LHStartPos{};
-	// NOTE: All positional tolerance calculations must be passed values relative to the start position
-
 	// Enum containing ID of currently active spell
 	// Set to Multiple if more than one spell could be cast given the players current movement
 	// Set to None if no spell can be cast right now
@@ -117,39 +220,36 @@ private: // Operating Variables
 private: // Operating Functions, where the main logic goes
 
 	void SetFrameStartPosAndRot();
+	void ApplyReloadedSpells();
+	void ResetCastingNodes();
+	void UpdateGridTransform();
+	void CheckGridTransform();
 
 	// Returns spellID of current spell being cast.
 	SpellID UpdateSpellList(); // Will return None if no spells can be cast and Multiple if the spell which player is casting can not yet be decided
 	SpellID GetActiveSpells();
 
+	bool IsSpellUpdateDue() const;
 	bool SpellSetup();
 	bool UpdateSpellStates();
+	void QueueSpellStates(SpellRecognition::FCasterUpdate& Update);
+	bool ApplySpellStates(const SpellRecognition::FCasterUpdate& Update);
+	void EndSpellUpdate();
+	bool UpdateLikelySpell(float& OutScore);
+	void MatchCast();
 	void UpdateCastingNodes();
 	void EndCast();
+	void SyncCastingHands();
+	void WakeForCast();
+	void HandleLaunchInput(SpellRecognition::EHandIntent Decided);
+	void OnLaunchWindowClosed();
+	void LaunchSpell(SpellRecognition::EHandIntent Intent);
 
-	void UpdateSpellScale(FSpellData& spell, int kpID);
 	FVector SpellcastingGridToWorld(FVector gridPosition);
-	bool CheckRHToLHDirection(FSpellData& referenceSpell, FVector PosTolerance);
-
-private: // Calculations, where we get the maths done
-
-	bool CheckRHStaticTolerance(FSpellData& spell, FKeyPoint& kp);
-	bool CheckLHStaticTolerance(FSpellData& spell, FKeyPoint& kp);
-	bool CheckRHMoveTolerance(FSpellData& spell, int& kpID);
-	bool CheckLHMoveTolerance(FSpellData& spell, int& kpID);
 
-	// Functions dealing with single points
-	bool PointEqual(FVector posToCheck, FVector refPos, FVector posTolerance);
-	bool PointEqual(FRotator rotToCheck, FRotator refRot, FRotator rotTolerance);
-	bool PointEqual(float PointToCheck, float refPoint, float PointTolerance);
-
-	// Functions dealing with a movement from point A->B
-	
-	bool RotationMoveInTolerance(FRotator RotToCheck, FRotator StartRot, FRotator EndRot, FRotator RotTolerance); // NOTE: All units are Deg, there is no rotational scaling required
-	bool LineMoveInTolerance(FVector PosToCheck, FVector StartPos, FVector EndPos, FVector PosTolerance); // NOTE: All values must be converted to the unit grid type (cannot be world size co-ordinates)
-	bool DiagonalMoveInTolerance(float iPos, float jPos, float DeltaI, float DeltaJ, float WidthTolerance); // Part of LineMoveInTolerance()
-	//bool ArcMoveInTolerance(FVector PosToCheck, FVector StartPos, FVector EndPos, FVector PosTolerance, MoveType Quadrant); // NOTE: All values must be converted to the unit grid type (cannot be worldsize coordinates)
-	//bool CurveMoveInTolerance(int quadrant, float aCheckPos, float bCheckPos, float tolerance) // Part of ArcMoveInTolerance()
+	// Reads both motion controllers into HandPoses - once per tick, and again whenever the spellcasting grid moves
+	void UpdateHandPoses();
+	SpellRecognition::FPoseSample TrackingToSpellcastingGrid(const SpellRecognition::FPoseSample& TrackingPose);
 
 private: // *** Test Section ***//
 	// THIS IS WHERE ANY TEST CODE CAN BE FOUND //
@@ -173,6 +273,28 @@ private: // *** Test Section ***//
 	bool isLoggingRHData{ false };
 	int castNo{ 0 };
 
+	// Trajectory recording - every pose the recognizer is fed (and one per tick) is saved to Saved/Trajectories when play ends
+	// Replay them with Tools/TrajectoryReplay to reproduce a cast or benchmark the recognizer
+	UPROPERTY(EditAnywhere, category = "Dev")
+	bool isRecordingTrajectories{ false };
+	SpellRecognition::FTrajectoryRecorder TrajectoryRecorder{};
+	uint32 TrajectoryFrame{ 0 };
+	double TrajectoryStartTime{ 0.0 }; // On the FPoseSampler::Now() clock
+
+	void RecordTrajectory(SpellRecognition::ETrajectoryEvent Event, const SpellRecognition::FPoseSample& Pose, double Time);
+	void SaveTrajectories();
+	void SaveRejectionCounters() const;
+
+	// Allocation check - ensures a tick makes no heap allocations once the first cast has grown every buffer to size (see SpellAllocationCheck.h)
+	// Meant for a test map - not checked while recording trajectories (the recording grows as it goes) and only quiet with LogSpellCasting Verbose off
+	// The same check without a map runs as the BattlemageAtlantis.SpellCasting.CastAllocations automation test (see SpellAllocationTest.cpp)
+	UPROPERTY(EditAnywhere, category = "Dev")
+	bool isAllocationCheckEnabled{ false };
+	bool isAllocationCheckArmed{ false }; // Set once a cast completes, cleared when the spells are swapped
+	uint64 TickAllocations{ 0 }; // Made by this component on the game thread this tick - the batch workers are checked by Tools/TrajectoryReplay
+
+	void CheckTickAllocations();
+
 	void RunDevTests();
 	void UpdateMoveDetails();
 	void SendMoveDetailsToLog(FVector MinPos, FVector MaxPos, FRotator MinRot, FRotator MaxRot, bool isRH);
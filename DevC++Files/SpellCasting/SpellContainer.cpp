@@ -4,6 +4,31 @@
 #include "SpellContainer.h"
 #include "CastingDemo.h"
 #include "EngineUtils.h"
+#include "TimerManager.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+#include "Recognition/SpellBinary.h"
+
+// Memory maps a spell binary and copies it into recognizer definitions - safe to call from any thread
+static bool LoadSpellBinaryFile(const FString& Path, std::vector<SpellRecognition::FSpellDef>& OutSpells) {
+	TUniquePtr<IMappedFileHandle> MappedFile{ FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path) };
+	if (!MappedFile) {
+		return false;
+	}
+	TUniquePtr<IMappedFileRegion> MappedRegion{ MappedFile->MapRegion() }; // NOTE: Must be released before MappedFile - it is, it was declared after
+	return MappedRegion && SpellRecognition::LoadSpellBinary(MappedRegion->GetMappedPtr(), static_cast<size_t>(MappedRegion->GetMappedSize()), OutSpells);
+}
+
+// The last spell binary loaded by any container - the others take the same set instead of loading their own copy (game thread only)
+struct FLoadedSpellBinary {
+	FString Path{};
+	FDateTime TimeStamp{ FDateTime::MinValue() };
+	SpellRecognition::FSharedSpellSet SpellSet{};
+};
+static FLoadedSpellBinary LastLoadedSpellBinary{};
 
 // Sets default values for this component's properties
 USpellContainer::USpellContainer()
@@ -13,7 +38,6 @@ USpellContainer::USpellContainer()
 	PrimaryComponentTick.bCanEverTick = false;
 
 	// ...
-	AllSpells = initSpellData();
 }
 
 
@@ -24,507 +48,582 @@ void USpellContainer::BeginPlay()
 
 	// ...
 	for (TActorIterator<ACastingDemo> DemoActor(GetWorld()); DemoActor; ++DemoActor) {
-		for (auto& spell : AllSpells) {
-			if (DemoActor->SpellToDisplay == spell.ID) {
-				DemoActor->initDemo(spell);
+		for (int32 i{ 0 }; i < GetSpellTableSize(); i++) {
+			if (DemoActor->SpellToDisplay.GetValue() == GetSpellTable()[i].ID) {
+				DemoActor->initDemo(MakeSpellData(GetSpellTable()[i]));
 			}
 		}
 	}
-}
-
-
-// Spell Initialisation Functions
-// The following intitialiser functions represent the vertex transformations for each spell's casting shape
-TArray<FKeyPoint> USpellContainer::initBall() // it's a ball, one round circle
-{
-	/* Spellcrafting instructions/Rules:
-	* There must always be at least two points
-	* There must be one keypoint only every 90Deg or 1/4 turn around a curved movement (no in-betweens, no gaps) - We only work in circles here, no fancy ovals etc...
-	* Though feel free to add that functionality if you like
-	* Every first straight line can not be followed by an identical straight line (there must be a significant difference in hand rotation or line direction)
-	* The movements can be anything in any order, however, scale is only confirmed after the first positional change is completed
-	* Except - the left hand must have the same movement type (i.e. if RH moves in straight line, so does left, or stationary or curved)
-	* All positional vectors are multiplied by the scale.
-	* First position vectors are always 0,0,0 (Distance from starting hand position MUST be 0 in starting position)
-	* I mean, you can try to be clever if you like, but good luck...
-	* Remember Unreal Engine Grid works backwards to normal mathematics - because they like to keep mathematicians away
-	* X represents forward/backward. Y Represents left/right. Z is familiar... up/down
-	*/
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 },
-			// Default move type is Point - and there is no point... in changing something that does not need checking
-		},
-
-		FKeyPoint{
-			FVector { 0,0.5,-1 },
-			FRotator { 0,0,0 },
-			FVector { 0,-0.5,-1 },
-			FRotator { 0,0,0 },
-			MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,-0.5,-1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,0.5,-1 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{ // Return to origin
-				FVector{ 0,0,0 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,0,0 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		}
-	};
-}
-
-TArray<FKeyPoint> USpellContainer::initWall() // It's a wall... one straight line
-{
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,-90 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,90 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,1,0 },
-				FRotator{ 0,0,-90 },
-				FVector{ 0,-1,0 },
-				FRotator{ 0,0,90 },
-				MoveType::Line
-		}
-	};
-}
-
-TArray<FKeyPoint> USpellContainer::initBeam() // Like punching, only more magical
-{
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 }
-		},
-
-			// It was a tough decision whether to ensure the rotation is uniform along the length of the line or not
-			// I went for, "I can't be bothered to implement that many checks."
-			FKeyPoint{
-				FVector{ 1,0,0 },
-				FRotator{ 0,0,-90 },
-				FVector{ 1,0,0 },
-				FRotator{ 0,0,90 },
-				MoveType::Line // I know, it's still called a straight line, even if you twist your wrist while forming it
-		}
-	};
-}
 
-TArray<FKeyPoint> USpellContainer::initAtune() // I am one with the energies
-{
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,90 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,-90 }
-		},
-
-			FKeyPoint{
-				FVector{ -1,-1,0.75 },
-				FRotator{ 60,-90,0 },
-				FVector{ -1,0.95,0.75 },
-				FRotator{ 60,90,0 },
-				MoveType::Line // how can an arc be 90Deg but arm angle only 60Deg I hear you ask... Try twisting your wrist and drawing a curved line
-		}
-	};
+	if (isHotReloadEnabled) {
+		GetWorld()->GetTimerManager().SetTimer(HotReloadTimer, this, &USpellContainer::CheckSpellBinary, HotReloadInterval, true, 0.f);
+	}
 }
 
-TArray<FKeyPoint> USpellContainer::initAir() // Tumble dryer - maths this if you can
+// Starts loading the spell binary in the background if it has changed since it was last loaded
+// NOTE: Only the time stamp is read on the game thread - mapping, checking and copying the spells happens on the thread pool
+void USpellContainer::CheckSpellBinary()
 {
-	// Special case spell - only do something like this if you know what's going on
-
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,-90,-90 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,90,90 },
-			MoveType::Line // THIS TELLS SCALE CHECKER TO SET SCALE RELATIVE TO STARTING HAND POSITIONS instead of waiting for first movement!
-			// All other spells first keypoint default to MoveType::Point)
-		},
-
-			FKeyPoint{
-				FVector{ -0.5,0,-0.5 },
-				FRotator{ 0,-90,-90 },
-				FVector{ 0.5,0,0.5 },
-				FRotator{ 0,90,90 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ -1,0,0 },
-				FRotator{ 0,-90,-90 },
-				FVector{ 1,0,0 },
-				FRotator{ 0,90,90 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ -0.5,0,0.5 },
-				FRotator{ 0,-90,-90 },
-				FVector{ 0.5,0,-0.5 },
-				FRotator{ 0,90,90 },
-				MoveType::Line
-		},
-
-			FKeyPoint{ // Return to origin
-				FVector{ 0,0,0 },
-				FRotator{ 0,-90,-90 },
-				FVector{ 0,0,0 },
-				FRotator{ 0,90,90 },
-				MoveType::Line
-		}
-	};
-}
+	if (isReloadingSpells) {
+		return;
+	}
 
-TArray<FKeyPoint> USpellContainer::initWater()
-{
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,1,-1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,-1,-1 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,1,0 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,-1,0 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,2,-1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,-2,-1 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		}
-	};
-}
+	const FString Path{ FPaths::ProjectContentDir() / SpellBinaryFile };
+	const FDateTime TimeStamp{ IFileManager::Get().GetTimeStamp(*Path) };
+	if (TimeStamp == FDateTime::MinValue() || TimeStamp == SpellBinaryTimeStamp) { // No file or nothing new
+		return;
+	}
+	SpellBinaryTimeStamp = TimeStamp;
 
-TArray<FKeyPoint> USpellContainer::initEarth()
-{
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,-90 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,90 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,0,1 },
-				FRotator{ 0,0,-90 },
-				FVector{ 0,0,1 },
-				FRotator{ 0,0,90 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,0,1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,0,1 },
-				FRotator{ 0,0,0 },
-				MoveType::Point
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,1,1 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		}
-	};
+	// Another player's container has already loaded this one
+	if (LastLoadedSpellBinary.SpellSet && LastLoadedSpellBinary.TimeStamp == TimeStamp && LastLoadedSpellBinary.Path == Path) {
+		ReloadedSpellSet = LastLoadedSpellBinary.SpellSet;
+		return;
+	}
+	isReloadingSpells = true;
+
+	TWeakObjectPtr<USpellContainer> WeakThis{ this };
+	Async(EAsyncExecution::ThreadPool, [WeakThis, Path, TimeStamp]() {
+		std::vector<SpellRecognition::FSpellDef> Spells{};
+		const bool isLoaded{ LoadSpellBinaryFile(Path, Spells) };
+		SpellRecognition::FSharedSpellSet SpellSet{ isLoaded ? SpellRecognition::MakeSpellSet(std::move(Spells)) : nullptr };
+
+		// Hand the spells back to the game thread, they are swapped in by TakeReloadedSpells()
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Path, TimeStamp, SpellSet{ std::move(SpellSet) }]() mutable {
+			USpellContainer* Container{ WeakThis.Get() };
+			if (!Container) {
+				return;
+			}
+			Container->isReloadingSpells = false;
+			if (SpellSet) {
+				LastLoadedSpellBinary = FLoadedSpellBinary{ Path, TimeStamp, SpellSet };
+				Container->ReloadedSpellSet = std::move(SpellSet);
+				UE_LOG(LogTemp, Warning, TEXT("Spells reloaded from %s"), *Path);
+			}
+			else {
+				UE_LOG(LogTemp, Error, TEXT("Failed to reload spells - %s is not a valid spell binary (version %d)"), *Path, SpellRecognition::SpellBinaryVersion);
+			}
+		});
+	});
 }
 
-TArray<FKeyPoint> USpellContainer::initFire()
+bool USpellContainer::TakeReloadedSpells(SpellRecognition::FSharedSpellSet& OutSpellSet)
 {
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,0 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,1,1 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,-0.5,1.5 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,0.5,1.5 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,2 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,1,2 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		}
-	};
+	if (!ReloadedSpellSet) {
+		return false;
+	}
+	OutSpellSet = std::move(ReloadedSpellSet);
+	ReloadedSpellSet = nullptr;
+	return true;
 }
 
-TArray<FKeyPoint> USpellContainer::initIncDur()
-{
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,90 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,-90 } // Start palms up
-		},
-
-			FKeyPoint{
-				FVector{ 0,1,1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,-1,1 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,2,0 },
-				FRotator{ 0,0,-90 },
-				FVector{ 0,-2,0 },
-				FRotator{ 0,0,90 }, // End palms down
-				MoveType::Line
-		}
-	};
-}
 
-TArray<FKeyPoint> USpellContainer::initDecDur()
-{
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,-90 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,90 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,1 },
-				FRotator{ 0,0,0 },
-				FVector{ 0,1,1 },
-				FRotator{ 0,0,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,0 },
-				FRotator{ 0,0,90 },
-				FVector{ 0,1,0 },
-				FRotator{ 0,0,-90 },
-				MoveType::Line
-		}
-	};
-}
+namespace SpellRecognition {
+
+// Spell Keypoint Tables
+// The following tables represent the vertex transformations for each spell's casting shape
+// NOTE: They are constexpr - no spell data is built (or copied) at startup, and the rules below are checked when compiling (see the static_asserts)
+/* Spellcrafting instructions/Rules:
+* There must always be at least two points
+* There must be one keypoint only every 90Deg or 1/4 turn around a curved movement (no in-betweens, no gaps) - We only work in circles here, no fancy ovals etc...
+* Though feel free to add that functionality if you like
+* Curved movements use EMotion::Arc1/Arc2 - pick the one that sets off in the direction the hand leaves the previous keypoint (see RecognizerTypes.h)
+* Every first straight line can not be followed by an identical straight line (there must be a significant difference in hand rotation or line direction)
+* The movements can be anything in any order, however, scale is only confirmed after the first positional change is completed
+* Except - the left hand must have the same movement type (i.e. if RH moves in straight line, so does left, or stationary or curved)
+* All positional vectors are multiplied by the scale.
+* First position vectors are always 0,0,0 (Distance from starting hand position MUST be 0 in starting position)
+* I mean, you can try to be clever if you like, but good luck...
+* Remember Unreal Engine Grid works backwards to normal mathematics - because they like to keep mathematicians away
+* X represents forward/backward. Y Represents left/right. Z is familiar... up/down
+*/
+constexpr FKeyPointDef BallKeyPoints[]{ // it's a ball, one round circle
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 },
+		// Default move type is Point - and there is no point... in changing something that does not need checking
+	},
+
+	FKeyPointDef{ // Hands part sideways and curve down...
+		FVec3 { 0,1,-1 },
+		FRot3 { 0,0,0 },
+		FVec3 { 0,-1,-1 },
+		FRot3 { 0,0,0 },
+		EMotion::Arc1
+	},
+
+		FKeyPointDef{ // ...meet at the bottom...
+			FVec3{ 0,0,-2 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,0,-2 },
+			FRot3{ 0,0,0 },
+			EMotion::Arc2
+	},
+
+		FKeyPointDef{ // ...cross over and curve back up...
+			FVec3{ 0,-1,-1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,1,-1 },
+			FRot3{ 0,0,0 },
+			EMotion::Arc1
+	},
+
+		FKeyPointDef{ // ...and return to origin
+			FVec3{ 0,0,0 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,0,0 },
+			FRot3{ 0,0,0 },
+			EMotion::Arc2
+	}
+};
+
+constexpr FKeyPointDef WallKeyPoints[]{ // It's a wall... one straight line
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,-90 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,90 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,1,0 },
+			FRot3{ 0,0,-90 },
+			FVec3{ 0,-1,0 },
+			FRot3{ 0,0,90 },
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef BeamKeyPoints[]{ // Like punching, only more magical
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 }
+	},
+
+		// It was a tough decision whether to ensure the rotation is uniform along the length of the line or not
+		// I went for, "I can't be bothered to implement that many checks."
+		FKeyPointDef{
+			FVec3{ 1,0,0 },
+			FRot3{ 0,0,-90 },
+			FVec3{ 1,0,0 },
+			FRot3{ 0,0,90 },
+			EMotion::Line // I know, it's still called a straight line, even if you twist your wrist while forming it
+	}
+};
+
+constexpr FKeyPointDef AtuneKeyPoints[]{ // I am one with the energies
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,90 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,-90 }
+	},
+
+		FKeyPointDef{
+			FVec3{ -1,-1,0.75 },
+			FRot3{ 60,-90,0 },
+			FVec3{ -1,0.95,0.75 },
+			FRot3{ 60,90,0 },
+			EMotion::Line // how can an arc be 90Deg but arm angle only 60Deg I hear you ask... Try twisting your wrist and drawing a curved line
+	}
+};
+
+constexpr FKeyPointDef AirKeyPoints[]{ // Tumble dryer - maths this if you can
+// Special case spell - only do something like this if you know what's going on
+
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,-90,-90 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,90,90 },
+		EMotion::Line // THIS TELLS SCALE CHECKER TO SET SCALE RELATIVE TO STARTING HAND POSITIONS instead of waiting for first movement!
+		// All other spells first keypoint default to EMotion::Point)
+	},
+
+		FKeyPointDef{
+			FVec3{ -0.5,0,-0.5 },
+			FRot3{ 0,-90,-90 },
+			FVec3{ 0.5,0,0.5 },
+			FRot3{ 0,90,90 },
+			EMotion::Arc2 // Both hands go round their own circle - RH's centre is at -0.5,0,0, LH's at 0.5,0,0
+	},
+
+		FKeyPointDef{
+			FVec3{ -1,0,0 },
+			FRot3{ 0,-90,-90 },
+			FVec3{ 1,0,0 },
+			FRot3{ 0,90,90 },
+			EMotion::Arc1
+	},
+
+		FKeyPointDef{
+			FVec3{ -0.5,0,0.5 },
+			FRot3{ 0,-90,-90 },
+			FVec3{ 0.5,0,-0.5 },
+			FRot3{ 0,90,90 },
+			EMotion::Arc2
+	},
+
+		FKeyPointDef{ // Return to origin
+			FVec3{ 0,0,0 },
+			FRot3{ 0,-90,-90 },
+			FVec3{ 0,0,0 },
+			FRot3{ 0,90,90 },
+			EMotion::Arc1
+	}
+};
+
+constexpr FKeyPointDef WaterKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,1,-1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,-1,-1 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,1,0 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,-1,0 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,2,-1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,-2,-1 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef EarthKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,-90 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,90 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,0,1 },
+			FRot3{ 0,0,-90 },
+			FVec3{ 0,0,1 },
+			FRot3{ 0,0,90 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,0,1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,0,1 },
+			FRot3{ 0,0,0 },
+			EMotion::Point
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,1,1 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef FireKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,0 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,1,1 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-0.5,1.5 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,0.5,1.5 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,2 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,1,2 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef IncDurKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,90 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,-90 } // Start palms up
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,1,1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,-1,1 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,2,0 },
+			FRot3{ 0,0,-90 },
+			FVec3{ 0,-2,0 },
+			FRot3{ 0,0,90 }, // End palms down
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef DecDurKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,-90 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,90 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,1 },
+			FRot3{ 0,0,0 },
+			FVec3{ 0,1,1 },
+			FRot3{ 0,0,0 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,0 },
+			FRot3{ 0,0,90 },
+			FVec3{ 0,1,0 },
+			FRot3{ 0,0,-90 },
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef IncPwrKeyPoints[]{ // Not quite Gangnam Style
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,-135 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,135 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,1 },
+			FRot3{ 0,0,-135 },
+			FVec3{ 0,1,1 },
+			FRot3{ 0,0,135 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,1 },
+			FRot3{ 0,0,-45 },
+			FVec3{ 0,1,1 },
+			FRot3{ 0,0,45 },
+			EMotion::Point
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,0,2 },
+			FRot3{ 0,0,-45 },
+			FVec3{ 0,0,2 },
+			FRot3{ 0,0,45 },
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef DecPwrKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,-135 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,0,135 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,1,-1 },
+			FRot3{ 0,0,-135 },
+			FVec3{ 0,-1,-1 },
+			FRot3{ 0,0,135 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,1,-1 },
+			FRot3{ 0,0,-45 },
+			FVec3{ 0,-1,-1 },
+			FRot3{ 0,0,45 },
+			EMotion::Point
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,0,-2 },
+			FRot3{ 0,0,-45 },
+			FVec3{ 0,0,-2 },
+			FRot3{ 0,0,45 },
+			EMotion::Line
+	}
+};
+
+constexpr FKeyPointDef ExplosiveKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,-90,-90 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,90,0 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,0 },
+			FRot3{ 0,-90,-90 },
+			FVec3{ 0,1,0 },
+			FRot3{ 0,90,0 },
+			EMotion::Line
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,-1,0 },
+			FRot3{ 0,-90,0 },
+			FVec3{ 0,1,0 },
+			FRot3{ 0,90,90 },
+			EMotion::Point
+	}
+};
+
+constexpr FKeyPointDef MagneticKeyPoints[]{
+	FKeyPointDef{
+		FVec3{ 0,0,0 },
+		FRot3{ 0,-90,0 },
+		FVec3{ 0,0,0 },
+		FRot3{ 0,90,90 }
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,0,0 },
+			FRot3{ 0,-90,-90 },
+			FVec3{ 0,0,0 },
+			FRot3{ 0,90,0 },
+			EMotion::Point
+	},
+
+		FKeyPointDef{
+			FVec3{ 0,1,0 },
+			FRot3{ 0,-90,-90 },
+			FVec3{ 0,-1,0 },
+			FRot3{ 0,90,0 },
+			EMotion::Line
+	}
+};
 
-TArray<FKeyPoint> USpellContainer::initIncPwr() // Not quite Gangnam Style
+// This is where tolerances are set up for the various spell casts
+// And Where the full spell list is defined
+// If you wish to ignore any tolerance simply set to 0
+// Eg. If it doesn't matter how much Yaw there is, set Yaw to 0
+// Note all tolerances are +&- i.e. a value of 15Deg results in a total tolerance of 30Deg
+constexpr FSpellTableEntry SpellTable[]{
+	//		    KPArray, RelStartPosLH->RH, Tolerance%ofScale, RotToleranceDeg, SpellID,	isDualOnly
+	MakeSpellTableEntry(BallKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,45,30}, SpellID::Ball, false),   // Can be cast one handed
+	MakeSpellTableEntry(WallKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{45,0,30}, SpellID::Wall, false),   // Can be cast one handed
+	MakeSpellTableEntry(BeamKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{45,0,30}, SpellID::Beam, false),   // Can be cast one handed
+	MakeSpellTableEntry(AtuneKeyPoints, FVec3{0,1,0}, FVec3{0,1,1}, FRot3{45,45,45}, SpellID::Atune, false), // Can be cast one handed
+
+	MakeSpellTableEntry(AirKeyPoints, FVec3{1,0,0}, FVec3{1,1,1}, FRot3{0,45,45}, SpellID::Air, true),
+	MakeSpellTableEntry(WaterKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,0,45}, SpellID::Water, true),
+	MakeSpellTableEntry(EarthKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,30,30}, SpellID::Earth, true),
+	MakeSpellTableEntry(FireKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{45,0,30}, SpellID::Fire, true),
+
+	MakeSpellTableEntry(IncDurKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,0,30}, SpellID::IncDur, true),
+	MakeSpellTableEntry(DecDurKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,0,30}, SpellID::DecDur, true),
+	MakeSpellTableEntry(IncPwrKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,0,40}, SpellID::IncPwr, true),
+	MakeSpellTableEntry(DecPwrKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,0,40}, SpellID::DecPwr, true),
+	MakeSpellTableEntry(ExplosiveKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,40,30}, SpellID::Explode, true),
+	MakeSpellTableEntry(MagneticKeyPoints, FVec3{0,1,0}, FVec3{1,1,1}, FRot3{0,40,30}, SpellID::Magnet, true),
+};
+
+// Spellcrafting rules - a spell that breaks them will not compile
+static_assert(IsValidSpell(SpellTable, SpellID::Ball), "Ball breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Wall), "Wall breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Beam), "Beam breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Atune), "Atune breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Air), "Air breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Water), "Water breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Earth), "Earth breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Fire), "Fire breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::IncDur), "IncDur breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::DecDur), "DecDur breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::IncPwr), "IncPwr breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::DecPwr), "DecPwr breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Explode), "Explode breaks the spellcrafting rules");
+static_assert(IsValidSpell(SpellTable, SpellID::Magnet), "Magnet breaks the spellcrafting rules");
+
+static_assert(SpellIDCount == SpellID::None, "SpellIDCount must be the number of real SpellIDs");
+
+static_assert(static_cast<int>(EMotion::Line) == MoveType::Line && static_cast<int>(EMotion::Arc1) == MoveType::Arc1 &&
+	static_cast<int>(EMotion::Arc2) == MoveType::Arc2, "EMotion must mirror MoveType");
+
+} // namespace SpellRecognition
+
+const SpellRecognition::FSpellTableEntry* USpellContainer::GetSpellTable()
 {
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,-135 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,135 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,1 },
-				FRotator{ 0,0,-135 },
-				FVector{ 0,1,1 },
-				FRotator{ 0,0,135 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,1 },
-				FRotator{ 0,0,-45 },
-				FVector{ 0,1,1 },
-				FRotator{ 0,0,45 },
-				MoveType::Point
-		},
-
-			FKeyPoint{
-				FVector{ 0,0,2 },
-				FRotator{ 0,0,-45 },
-				FVector{ 0,0,2 },
-				FRotator{ 0,0,45 },
-				MoveType::Line
-		}
-	};
+	return SpellRecognition::SpellTable;
 }
 
-TArray<FKeyPoint> USpellContainer::initDecPwr()
+int32 USpellContainer::GetSpellTableSize()
 {
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,-135 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,0,135 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,1,-1 },
-				FRotator{ 0,0,-135 },
-				FVector{ 0,-1,-1 },
-				FRotator{ 0,0,135 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,1,-1 },
-				FRotator{ 0,0,-45 },
-				FVector{ 0,-1,-1 },
-				FRotator{ 0,0,45 },
-				MoveType::Point
-		},
-
-			FKeyPoint{
-				FVector{ 0,0,-2 },
-				FRotator{ 0,0,-45 },
-				FVector{ 0,0,-2 },
-				FRotator{ 0,0,45 },
-				MoveType::Line
-		}
-	};
+	return static_cast<int32>(sizeof(SpellRecognition::SpellTable) / sizeof(SpellRecognition::SpellTable[0]));
 }
 
-TArray<FKeyPoint> USpellContainer::initExplosive()
+const SpellRecognition::FSharedSpellSet& USpellContainer::GetSharedSpellSet()
 {
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,-90,-90 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,90,0 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,0 },
-				FRotator{ 0,-90,-90 },
-				FVector{ 0,1,0 },
-				FRotator{ 0,90,0 },
-				MoveType::Line
-		},
-
-			FKeyPoint{
-				FVector{ 0,-1,0 },
-				FRotator{ 0,-90,0 },
-				FVector{ 0,1,0 },
-				FRotator{ 0,90,90 },
-				MoveType::Point
-		}
-	};
+	static const SpellRecognition::FSharedSpellSet SpellSet{ SpellRecognition::MakeSpellSet(SpellRecognition::MakeSpellDefs(GetSpellTable(), GetSpellTableSize())) };
+	return SpellSet;
 }
 
-TArray<FKeyPoint> USpellContainer::initMagnetic()
+// Builds the editable (Unreal type) version of a spell - only used by the casting demos
+FSpellData USpellContainer::MakeSpellData(const SpellRecognition::FSpellTableEntry& Entry)
 {
-	// Spell Keypoint configuration
-	return TArray<FKeyPoint>{
-		FKeyPoint{
-			FVector{ 0,0,0 },
-			FRotator{ 0,-90,0 },
-			FVector{ 0,0,0 },
-			FRotator{ 0,90,90 }
-		},
-
-			FKeyPoint{
-				FVector{ 0,0,0 },
-				FRotator{ 0,-90,-90 },
-				FVector{ 0,0,0 },
-				FRotator{ 0,90,0 },
-				MoveType::Point
-		},
-
-			FKeyPoint{
-				FVector{ 0,1,0 },
-				FRotator{ 0,-90,-90 },
-				FVector{ 0,-1,0 },
-				FRotator{ 0,90,0 },
-				MoveType::Line
-		}
-	};
+	FSpellData Spell{};
+	for (int32 i{ 0 }; i < Entry.NumKeyPoints; i++) {
+		const SpellRecognition::FKeyPointDef& kp{ Entry.KeyPoints[i] };
+		FKeyPoint KeyPoint{};
+		KeyPoint.RHPosition = FVector{ kp.RHPosition.X, kp.RHPosition.Y, kp.RHPosition.Z };
+		KeyPoint.RHRotation = FRotator{ kp.RHRotation.Pitch, kp.RHRotation.Yaw, kp.RHRotation.Roll };
+		KeyPoint.LHPosition = FVector{ kp.LHPosition.X, kp.LHPosition.Y, kp.LHPosition.Z };
+		KeyPoint.LHRotation = FRotator{ kp.LHRotation.Pitch, kp.LHRotation.Yaw, kp.LHRotation.Roll };
+		KeyPoint.Motion = static_cast<MoveType>(kp.Motion); // EMotion mirrors MoveType
+		Spell.KeyPoints.Add(KeyPoint);
+	}
+	Spell.LtoRRelativeStartPos = FVector{ Entry.LtoRRelativeStartPos.X, Entry.LtoRRelativeStartPos.Y, Entry.LtoRRelativeStartPos.Z };
+	Spell.PositionalTolerance = FVector{ Entry.PositionalTolerance.X, Entry.PositionalTolerance.Y, Entry.PositionalTolerance.Z };
+	Spell.RotationalTolerance = FRotator{ Entry.RotationalTolerance.Pitch, Entry.RotationalTolerance.Yaw, Entry.RotationalTolerance.Roll };
+	Spell.ID = static_cast<SpellID>(Entry.ID);
+	Spell.isDualOnly = Entry.isDualOnly;
+	return Spell;
 }
-
-// This is where tolerances are set up for the various spell casts
-// And Where the full spell list is defined
-TArray<FSpellData> USpellContainer::initSpellData()
-{
-	// If you wish to ignore any tolerance simply set to 0
-	// Eg. If it doesn't matter how much Yaw there is, set Yaw to 0
-	// Note all tolerances are +&- i.e. a value of 15Deg results in a total tolerance of 30Deg
-	return TArray<FSpellData>{
-		//		    KPArray, RelStartPosLH->RH, Tolerance%ofScale, RotToleranceDeg, SpellID,	isDualOnly
-		FSpellData{ initBall(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,45,30}, SpellID::Ball, false },   // Can be cast one handed
-			FSpellData{ initWall(), FVector{0,1,0}, FVector{1,1,1}, FRotator{45,0,30}, SpellID::Wall, false },   // Can be cast one handed
-			FSpellData{ initBeam(), FVector{0,1,0}, FVector{1,1,1}, FRotator{45,0,30}, SpellID::Beam, false },   // Can be cast one handed
-			FSpellData{ initAtune(), FVector{0,1,0}, FVector{0,1,1}, FRotator{45,45,45}, SpellID::Atune, false }, // Can be cast one handed
-
-			FSpellData{ initAir(), FVector{1,0,0}, FVector{1,1,1}, FRotator{0,45,45}, SpellID::Air, true },
-			FSpellData{ initWater(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,0,45}, SpellID::Water, true },
-			FSpellData{ initEarth(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,30,30}, SpellID::Earth, true },
-			FSpellData{ initFire(), FVector{0,1,0}, FVector{1,1,1}, FRotator{45,0,30}, SpellID::Fire, true },
-
-			FSpellData{ initIncDur(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,0,30}, SpellID::IncDur, true },
-			FSpellData{ initDecDur(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,0,30}, SpellID::DecDur, true },
-			FSpellData{ initIncPwr(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,0,40}, SpellID::IncPwr, true },
-			FSpellData{ initDecPwr(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,0,40}, SpellID::DecPwr, true },
-			FSpellData{ initExplosive(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,40,30}, SpellID::Explode, true },
-			FSpellData{ initMagnetic(), FVector{0,1,0}, FVector{1,1,1}, FRotator{0,40,30}, SpellID::Magnet, true },
-	};
-}
\ No newline at end of file
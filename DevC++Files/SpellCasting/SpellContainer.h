@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Recognition/SpellSet.h"
+#include "Recognition/SpellTable.h"
 #include "SpellContainer.generated.h"
 
 /*
@@ -22,13 +24,14 @@ UENUM()
 enum MoveType {
 	Point, // There is no movement between this keypoint and the previous (Also used for the first keypoint in any spell)
 	Line, // Used when the movement from the previous keypoint is a straight line
-	//Arc1, Arc2, Arc3, Arc4 // Used when the movement from the previous keypoint is a curved line ** currently not implemented
-		// for YZ plane Z = sin(Y * 90); For XZ plane Z = sin(X * 90); For XY plane Y = sin(X * 90)!
-		// Arc type represents which quadrant the start of the motion is based on
+	Arc1, Arc2 // Used when the movement from the previous keypoint is a quarter circle (see EMotion in Recognition/RecognizerTypes.h)
+		// The two moving axes go in X, Y, Z order - Arc1 sets off along the first and curves onto the second, Arc2 the other way round
+		// e.g. for the YZ plane Arc1 starts sideways and ends up/down
 };
 
 // Structure used to store the evaluation points of all spells
 // Structure Contents: RHPosition, RHRotation, LHPosition, LHRotation
+// NOTE: Definition data only - progress lives in the recognizer's FSpellState, casting nodes in USpellComponent::CastingNodes
 USTRUCT()
 struct FKeyPoint {
 	GENERATED_BODY()
@@ -39,12 +42,6 @@ struct FKeyPoint {
 	FVector LHPosition;
 	FRotator LHRotation;
 	MoveType Motion{ MoveType::Point };
-	bool RHComplete{ false };
-	bool LHComplete{ false };
-
-	// The graphical content presented to the user - see CastingNode.h/.cpp for more details
-	class ACastingNode* CastingNodeRH{ nullptr };
-	class ACastingNode* CastingNodeLH{ nullptr };
 };
 
 // Structure Contents: Key Spellcasting Points, Positional Tolerance, Rotational Tolerance
@@ -58,9 +55,6 @@ struct FSpellData {
 	FRotator RotationalTolerance; // NOTE: Set tolerance to 0 to ignore axis
 	SpellID ID; // See SpellCastingController.h
 	bool isDualOnly{ true };
-	float Scale{ 5.f }; // Default to the same as MIN_MOVE_SCALE
-	bool isScaleSet{ false };
-	bool canCast{ true };
 };
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
@@ -78,32 +72,40 @@ protected:
 
 public:	
 
-	// Array holding the spell data of all the game's spells - basically the memory bank
+	// The spell table holding the spell data of all the game's spells - basically the memory bank
 	// Yes it's hard coded. No I'm not currently planning on changing that.
-	TArray<FSpellData> AllSpells{};
+	// NOTE: constexpr data (see SpellContainer.cpp) - it lives in read-only memory and is never copied
+	static const SpellRecognition::FSpellTableEntry* GetSpellTable();
+	static int32 GetSpellTableSize();
+
+	// The spell table as recognizer definitions - built the first time it is asked for, then shared by every caster in the process
+	static const SpellRecognition::FSharedSpellSet& GetSharedSpellSet();
+
+	// Builds the Unreal type version of a spell
+	static FSpellData MakeSpellData(const SpellRecognition::FSpellTableEntry& Entry);
+
+	// Hot reload - hands over the spells last loaded from SpellBinaryFile, returns false if nothing new has been loaded
+	// NOTE: Only call between casts - the spell definitions must never change mid cast
+	// NOTE: Every container that finds the same spell binary gets the same set - it is only loaded once per process
+	bool TakeReloadedSpells(SpellRecognition::FSharedSpellSet& OutSpellSet);
 
 	/*// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 */
-private: // List of spells and spell components
-
-	// The Initialisation functions
-	TArray<FKeyPoint> initBall();
-	TArray<FKeyPoint> initWall();
-	TArray<FKeyPoint> initBeam();
-	TArray<FKeyPoint> initAtune();
-
-	TArray<FKeyPoint> initAir();
-	TArray<FKeyPoint> initWater();
-	TArray<FKeyPoint> initEarth();
-	TArray<FKeyPoint> initFire();
-
-	TArray<FKeyPoint> initIncDur();
-	TArray<FKeyPoint> initDecDur();
-	TArray<FKeyPoint> initIncPwr();
-	TArray<FKeyPoint> initDecPwr();
-	TArray<FKeyPoint> initExplosive();
-	TArray<FKeyPoint> initMagnetic();
-
-	TArray<FSpellData> initSpellData();
+private: // Spell hot reload
+
+	// Spell binary to hot reload, relative to the project Content folder - see Tools/SpellBinaryConverter
+	UPROPERTY(EditAnywhere, category = "Hot Reload")
+	FString SpellBinaryFile{ TEXT("Spells/Spells.spellbin") };
+	UPROPERTY(EditAnywhere, category = "Hot Reload")
+	bool isHotReloadEnabled{ true };
+	UPROPERTY(EditAnywhere, category = "Hot Reload")
+	float HotReloadInterval{ 1.f }; // Time in seconds between checks for a changed spell binary
+
+	FTimerHandle HotReloadTimer;
+	FDateTime SpellBinaryTimeStamp{ FDateTime::MinValue() }; // Time stamp of the last spell binary loaded
+	bool isReloadingSpells{ false }; // True while a spell binary is being loaded in the background
+	SpellRecognition::FSharedSpellSet ReloadedSpellSet{}; // Set until taken by TakeReloadedSpells()
+
+	void CheckSpellBinary();
 };
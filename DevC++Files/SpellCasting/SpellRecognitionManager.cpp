@@ -0,0 +1,69 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+
+#include "SpellRecognitionManager.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+
+void FSpellRecognitionTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Manager) {
+		Manager->UpdateCasters();
+	}
+}
+
+FString FSpellRecognitionTickFunction::DiagnosticMessage()
+{
+	return TEXT("USpellRecognitionManager::UpdateCasters");
+}
+
+void USpellRecognitionManager::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered()) {
+		TickFunction.UnRegisterTickFunction();
+	}
+	Casters.Reset();
+	Super::Deinitialize();
+}
+
+void USpellRecognitionManager::AddCaster(ISpellRecognitionCaster* Caster, UObject* TickOwner, FTickFunction& CasterTick)
+{
+	if (!TickFunction.IsTickFunctionRegistered()) {
+		TickFunction.bCanEverTick = true;
+		TickFunction.bStartWithTickEnabled = true;
+		TickFunction.TickGroup = TG_PrePhysics; // Same group as the casters - the prerequisites put it after them
+		TickFunction.Manager = this;
+		TickFunction.RegisterTickFunction(GetWorld()->PersistentLevel);
+	}
+	Casters.AddUnique(Caster);
+	TickFunction.AddPrerequisite(TickOwner, CasterTick);
+}
+
+void USpellRecognitionManager::RemoveCaster(ISpellRecognitionCaster* Caster, UObject* TickOwner, FTickFunction& CasterTick)
+{
+	Casters.Remove(Caster);
+	TickFunction.RemovePrerequisite(TickOwner, CasterTick);
+}
+
+void USpellRecognitionManager::UpdateCasters()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(USpellRecognitionManager::UpdateCasters);
+
+	Batch.Reset();
+	BatchIndices.SetNum(Casters.Num(), false);
+	for (int32 i{ 0 }; i < Casters.Num(); i++) {
+		const int32 batchSize{ Batch.Num() };
+		Casters[i]->GatherRecognitionUpdate(Batch);
+		BatchIndices[i] = (Batch.Num() > batchSize) ? batchSize : INDEX_NONE;
+	}
+
+	// The casters share nothing, so each one is a task of its own - not worth waking the workers for a lone player
+	Batch.Evaluate([](int32 Num, TFunctionRef<void(int32)> Body) {
+		ParallelFor(Num, Body, Num < 2);
+	});
+
+	for (int32 i{ 0 }; i < Casters.Num(); i++) {
+		Casters[i]->ApplyRecognitionUpdate(BatchIndices[i] != INDEX_NONE ? &Batch.Get(BatchIndices[i]) : nullptr);
+	}
+}
@@ -0,0 +1,70 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Batch spell recognition for every caster in the world (players, AI mages, spectator replays) - see Recognition/RecognitionBatch.h
+* Casters register with AddCaster() and stop running their recognizer in their own tick, then once all of them have ticked the manager:
+*	Gathers every caster's samples into one FRecognitionBatch - game thread
+*	Checks every caster with ParallelFor - worker threads
+*	Hands every caster its results back - game thread, before any spell is applied (EndCast() only runs on input, which is before the next tick)
+* NOTE: Every registered caster's tick is a prerequisite of the manager tick, so the manager always runs after them in the same frame
+* NOTE: Casters finish their tick in ApplyRecognitionUpdate() (casting nodes, dev logging, ...) - anything that ticks between a caster
+*	and the manager still sees the caster's results from last frame
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Recognition/RecognitionBatch.h"
+#include "SpellRecognitionManager.generated.h"
+
+// Anything that casts spells through an FSpellRecognizer - USpellComponent, or a bot caster feeding it scripted/replayed poses
+class ISpellRecognitionCaster {
+public:
+	virtual ~ISpellRecognitionCaster() = default;
+
+	// Game thread - Add() this caster to the batch with the samples to check this frame, or leave it out if there is nothing to check
+	virtual void GatherRecognitionUpdate(SpellRecognition::FRecognitionBatch& Batch) = 0;
+
+	// Game thread - Update is this caster's results, nullptr if it left itself out of the batch this frame
+	virtual void ApplyRecognitionUpdate(const SpellRecognition::FCasterUpdate* Update) = 0;
+};
+
+USTRUCT()
+struct FSpellRecognitionTickFunction : public FTickFunction {
+	GENERATED_BODY()
+
+	class USpellRecognitionManager* Manager{ nullptr };
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSpellRecognitionTickFunction> : public TStructOpsTypeTraitsBase2<FSpellRecognitionTickFunction> {
+	enum { WithCopy = false };
+};
+
+UCLASS()
+class BATTLEMAGEATLANTIS01_API USpellRecognitionManager : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Game thread - TickOwner/CasterTick is the tick the caster does the rest of its work in, the manager ticks after it
+	void AddCaster(ISpellRecognitionCaster* Caster, UObject* TickOwner, FTickFunction& CasterTick);
+	void RemoveCaster(ISpellRecognitionCaster* Caster, UObject* TickOwner, FTickFunction& CasterTick);
+	int32 NumCasters() const { return Casters.Num(); }
+
+	// Gather, check in parallel, apply - called by the manager's tick function
+	void UpdateCasters();
+
+private:
+	FSpellRecognitionTickFunction TickFunction{};
+	TArray<ISpellRecognitionCaster*> Casters{};
+	TArray<int32> BatchIndices{}; // Batch index of every caster this frame, INDEX_NONE if it left itself out
+	SpellRecognition::FRecognitionBatch Batch{};
+};
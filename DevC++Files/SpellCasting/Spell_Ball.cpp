@@ -102,7 +102,7 @@ void ASpell_Ball::UpdateLaunch() {
 				SpellMesh->SetHiddenInGame(false);
 				AnimationMesh2->SetHiddenInGame(true);
 				AnimationMesh3->SetHiddenInGame(true);
-				isLaunchComplete = true;
+				CompleteLaunch();
 			}
 		}
 	}
@@ -7,6 +7,7 @@
 #include "Camera/CameraComponent.h"
 #include "Components/SplineComponent.h"
 #include "EnergyBeam.h"
+#include "TickSleep.h"
 
 ASpell_Beam::ASpell_Beam()
 {
@@ -33,6 +34,9 @@ void ASpell_Beam::Tick(float DeltaTime)
 			NextSpike++;
 			SpikeTimer = 0;
 		}
+		if (NextSpike >= SpikePlateCount) {
+			SleepTick(this); // Every plate is out - the duration timer ends the spell
+		}
 	}
 	else {
 		UpdatePosition(); // Of actor
@@ -80,7 +84,7 @@ void ASpell_Beam::ConnectMotionControllers(UMotionControllerComponent* LeftHand,
 		//SpellMesh->SetRelativeScale3D(FVector{ SpellRange / EnergyBeamLength,1,1 }); //
 	}
 
-	isLaunchComplete = true;
+	CompleteLaunch();
 }
 
 void ASpell_Beam::UpdateCollision()
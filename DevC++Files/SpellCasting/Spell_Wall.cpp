@@ -2,6 +2,7 @@
 
 
 #include "Spell_Wall.h"
+#include "TickSleep.h"
 
 ASpell_Wall::ASpell_Wall()
 {
@@ -40,12 +41,10 @@ void ASpell_Wall::Tick(float DeltaTime)
 	if (!isLaunchComplete) {
 		UpdatePosition();
 	}
-	else {
-		UpdateCollision();
-	}
 }
 
 // Updates what happens upon collision of the static mesh (provided launch animation is complete)
+// *** TBI - to be bound to the meshes' overlap events, the wall stops ticking once it is up
 void ASpell_Wall::UpdateCollision()
 {
 	// Get all 'colliding' objects
@@ -99,7 +98,8 @@ void ASpell_Wall::UpdatePosition()
 		UE_LOG(LogTemp, Warning, TEXT("Garbage passed into Spell_Wall.UpdatePosition().AnimCompleteFactor"));
 	}
 	if (AnimCompleteFactor >= 1) {
-		isLaunchComplete = true; // Stop updating launch animation (in this case, stop moving the wall around)
+		CompleteLaunch(); // Stop updating launch animation (in this case, stop moving the wall around)
+		SleepTick(this); // Nothing moves from here on - collisions are to come in as overlap events, the duration is a timer
 
 		// Set current position/rotation to correct end position (minor detail, but in the name of perfection)
 		SetActorLocation(TargetPosition);
@@ -34,7 +34,7 @@ protected:
 	virtual void BeginPlay() override;
 
 public:
-	// Called every frame
+	// Called every frame until the wall is in place
 	virtual void Tick(float DeltaTime) override;
 
 private:
@@ -0,0 +1,42 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Tick sleep/wake - the spellcasting actors and components only tick while they have work to do
+* Every one of them follows the same pattern:
+*	Constructor: bCanEverTick = true, plus bStartWithTickEnabled = false if nothing happens until some event (e.g. ACastingDemo::initDemo())
+*	The event that starts the work (a button, a setup call): WakeTick(this)
+*	The tick that finds nothing left to do: SleepTick(this)
+* A disabled tick function is taken out of the tick task manager's lists, so a sleeping actor costs nothing per frame - however full the arena
+* NOTE: Game thread only - both do nothing if the tick is already in that state, so they are fine to call on every event/tick
+* NOTE: Timers and overlap events still fire while asleep - use them for anything that happens later (e.g. ASpell's duration)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Components/ActorComponent.h"
+
+inline void WakeTick(AActor* Actor) {
+	if (!Actor->IsActorTickEnabled()) {
+		Actor->SetActorTickEnabled(true);
+	}
+}
+
+inline void SleepTick(AActor* Actor) {
+	if (Actor->IsActorTickEnabled()) {
+		Actor->SetActorTickEnabled(false);
+	}
+}
+
+inline void WakeTick(UActorComponent* Component) {
+	if (!Component->IsComponentTickEnabled()) {
+		Component->SetComponentTickEnabled(true);
+	}
+}
+
+inline void SleepTick(UActorComponent* Component) {
+	if (Component->IsComponentTickEnabled()) {
+		Component->SetComponentTickEnabled(false);
+	}
+}
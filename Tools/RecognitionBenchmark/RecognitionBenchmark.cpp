@@ -0,0 +1,234 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Recognition benchmark - many casters replaying a recording at once, checked in parallel batches the way USpellRecognitionManager does in game
+* Every caster has its own FSpellRecognizer (all sharing one FSpellSet, like the players in game) and replays the same recording (see Tools/TrajectoryReplay) from a different starting point, so they are never in step
+* Each frame: SpellSetup() for the casters starting a cast on the calling thread, then FRecognitionBatch::Evaluate() over a pool of worker threads
+* Prints the time per frame and the speed up over one thread for 1, 2, 4... threads, and checks every thread count recognised exactly the same spells
+*
+* Usage: RecognitionBenchmark <Recording.spelltraj> <Spells.spellbin> [Casters] [Frames] [MaxThreads]
+*	Casters defaults to 64, Frames to 2000, MaxThreads to std::thread::hardware_concurrency()
+*
+* Build (plain C++14, no engine required):
+*	g++ -std=c++14 -O2 -pthread -I../../DevC++Files/SpellCasting/Recognition RecognitionBenchmark.cpp ../../DevC++Files/SpellCasting/Recognition/[A-Z]*.cpp -o RecognitionBenchmark
+* NOTE: Expect close to linear scaling up to the number of physical cores - the casters only share read-only spell data, the only shared write is the
+*	counter the workers take casters from. Threads past the number of cores only add overhead
+*/
+
+#include "RecognitionBatch.h"
+#include "SpellBinary.h"
+#include "SpellRecognizer.h"
+#include "TrajectoryRecording.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <utility>
+
+using namespace SpellRecognition;
+
+static bool ReadFile(const char* Path, std::vector<uint8_t>& Out) {
+	std::ifstream file{ Path, std::ios::binary };
+	if (!file) {
+		return false;
+	}
+	Out.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+	return true;
+}
+
+// Stand in for ParallelFor - WorkerCount - 1 threads spinning on a generation counter, the calling thread is the last worker
+// Spinning keeps the wake up cost out of the numbers, the task graph in game has its own
+class FWorkerPool {
+public:
+	explicit FWorkerPool(int32_t WorkerCount) {
+		for (int32_t i{ 1 }; i < WorkerCount; i++) {
+			Threads.emplace_back([this]() { Work(); });
+		}
+	}
+	~FWorkerPool() {
+		isStopping.store(true, std::memory_order_release);
+		for (std::thread& thread : Threads) {
+			thread.join();
+		}
+	}
+
+	void ParallelFor(int32_t NewNum, const std::function<void(int32_t)>& NewBody) {
+		Body = &NewBody;
+		Num = NewNum;
+		NextIndex.store(0, std::memory_order_relaxed);
+		NumBusy.store(static_cast<int32_t>(Threads.size()), std::memory_order_relaxed);
+		Generation.fetch_add(1, std::memory_order_release);
+		RunTasks();
+		while (NumBusy.load(std::memory_order_acquire) > 0) {
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	std::vector<std::thread> Threads{};
+	std::atomic<uint32_t> Generation{ 0 };
+	std::atomic<int32_t> NextIndex{ 0 };
+	std::atomic<int32_t> NumBusy{ 0 };
+	std::atomic<bool> isStopping{ false };
+	const std::function<void(int32_t)>* Body{ nullptr };
+	int32_t Num{ 0 };
+
+	void Work() {
+		uint32_t seen{ 0 };
+		while (true) {
+			uint32_t generation{ Generation.load(std::memory_order_acquire) };
+			while (generation == seen) {
+				if (isStopping.load(std::memory_order_acquire)) {
+					return;
+				}
+				std::this_thread::yield();
+				generation = Generation.load(std::memory_order_acquire);
+			}
+			seen = generation;
+			RunTasks();
+			NumBusy.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void RunTasks() {
+		for (int32_t index{ NextIndex.fetch_add(1, std::memory_order_relaxed) }; index < Num; index = NextIndex.fetch_add(1, std::memory_order_relaxed)) {
+			(*Body)(index);
+		}
+	}
+};
+
+// One simulated caster - loops over the recording forever
+struct FBenchCaster {
+	std::unique_ptr<FSpellRecognizer> Recognizer{}; // On its own allocation like a USpellComponent's - side by side they would share cache lines
+	size_t NextRecord{ 0 };
+	bool isCasting{ false }; // False until the first SpellSetup - updates before it belong to a cast the replay never saw start
+};
+
+// Feeds one frame of Caster's recording - SpellSetup() right here (never batched, same as in game), updates are queued in Batch
+// A frame ends at the next recorded frame, or at a SpellSetup that comes after updates (so the batch never reorders a cast)
+static void GatherFrame(FBenchCaster& Caster, const std::vector<FTrajectoryRecord>& Records, FRecognitionBatch& Batch) {
+	const uint32_t frame{ Records[Caster.NextRecord].Frame };
+	FCasterUpdate* update{ nullptr };
+	for (size_t i{ 0 }; i < Records.size(); i++) { // A recording of a single frame is one frame every time round
+		const FTrajectoryRecord& record{ Records[Caster.NextRecord] };
+		if (record.Frame != frame) {
+			return;
+		}
+		const ETrajectoryEvent event{ static_cast<ETrajectoryEvent>(record.Event) };
+		const bool isRHCasting{ (record.Buttons & TrajectoryRHCast) != 0 };
+		const bool isLHCasting{ (record.Buttons & TrajectoryLHCast) != 0 };
+		if (event == ETrajectoryEvent::SpellSetup) {
+			if (update != nullptr) {
+				return;
+			}
+			Caster.Recognizer->SpellSetup(GetTrajectoryPose(record), isRHCasting, isLHCasting);
+			Caster.isCasting = true;
+		}
+		else if (event == ETrajectoryEvent::SpellUpdate && Caster.isCasting) {
+			if (update == nullptr) {
+				update = &Batch.Add(*Caster.Recognizer, isRHCasting, isLHCasting);
+			}
+			update->Samples.push_back(FTimedPoseSample{ record.Time, GetTrajectoryPose(record) });
+		}
+		Caster.NextRecord = (Caster.NextRecord + 1) % Records.size();
+	}
+}
+
+struct FBenchResult {
+	double Seconds{ 0.0 };
+	int64_t NumSamples{ 0 };
+	int64_t NumComplete{ 0 };
+	uint64_t Fingerprint{ 1469598103934665603ull }; // FNV-1a of every caster's results, in batch order
+};
+
+static FBenchResult RunBenchmark(const FSharedSpellSet& SpellSet, const std::vector<FTrajectoryRecord>& Records, int32_t NumCasters, int32_t NumFrames, int32_t NumThreads) {
+	// Fresh casters every run, so every thread count replays exactly the same thing
+	std::vector<FBenchCaster> casters(NumCasters);
+	for (int32_t i{ 0 }; i < NumCasters; i++) {
+		casters[i].Recognizer.reset(new FSpellRecognizer{ SpellSet, FRecognizerSettings{} });
+		casters[i].NextRecord = Records.size() * i / NumCasters;
+	}
+
+	FWorkerPool pool{ NumThreads };
+	FRecognitionBatch batch{};
+	FBenchResult result{};
+	const auto start{ std::chrono::steady_clock::now() };
+	for (int32_t frame{ 0 }; frame < NumFrames; frame++) {
+		batch.Reset();
+		for (FBenchCaster& caster : casters) {
+			GatherFrame(caster, Records, batch);
+		}
+
+		batch.Evaluate([&pool](int32_t Num, const std::function<void(int32_t)>& Body) { pool.ParallelFor(Num, Body); });
+
+		for (int32_t i{ 0 }; i < batch.Num(); i++) {
+			const FCasterUpdate& update{ batch.Get(i) };
+			result.NumSamples += update.NumChecked;
+			result.NumComplete += update.isSpellComplete ? 1 : 0;
+			const uint64_t values[]{ static_cast<uint64_t>(update.NumChecked), static_cast<uint64_t>(update.ActiveSpell), update.isSpellComplete ? 1ull : 0ull };
+			for (uint64_t value : values) {
+				result.Fingerprint = (result.Fingerprint ^ value) * 1099511628211ull;
+			}
+		}
+	}
+	result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3 || argc > 6) {
+		std::fprintf(stderr, "Usage: RecognitionBenchmark <Recording.spelltraj> <Spells.spellbin> [Casters] [Frames] [MaxThreads]\n");
+		return 1;
+	}
+	const int32_t numCasters{ argc > 3 ? std::atoi(argv[3]) : 64 };
+	const int32_t numFrames{ argc > 4 ? std::atoi(argv[4]) : 2000 };
+	const int32_t maxThreads{ argc > 5 ? std::atoi(argv[5]) : static_cast<int32_t>(std::thread::hardware_concurrency()) };
+	if (numCasters <= 0 || numFrames <= 0) {
+		std::fprintf(stderr, "Casters and Frames must be more than 0\n");
+		return 1;
+	}
+
+	std::vector<uint8_t> fileData{};
+	std::vector<FTrajectoryRecord> records{};
+	if (!ReadFile(argv[1], fileData) || !LoadTrajectoryRecording(fileData.data(), fileData.size(), records) || records.empty()) {
+		std::fprintf(stderr, "%s is not a trajectory recording (version %u) or is empty\n", argv[1], TrajectoryVersion);
+		return 1;
+	}
+	std::vector<FSpellDef> spells{};
+	if (!ReadFile(argv[2], fileData) || !LoadSpellBinary(fileData.data(), fileData.size(), spells)) {
+		std::fprintf(stderr, "%s is not a valid spell binary (version %u)\n", argv[2], SpellBinaryVersion);
+		return 1;
+	}
+	const FSharedSpellSet spellSet{ MakeSpellSet(std::move(spells)) };
+
+	std::vector<int32_t> threadCounts{};
+	for (int32_t threads{ 1 }; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads > 1 ? maxThreads : 1);
+
+	std::printf("%d casters, %d frames, %s kernels, %u hardware threads\n", numCasters, numFrames, GetToleranceKernelName(), std::thread::hardware_concurrency());
+	FBenchResult baseline{};
+	bool isConsistent{ true };
+	for (int32_t threads : threadCounts) {
+		const FBenchResult result{ RunBenchmark(spellSet, records, numCasters, numFrames, threads) };
+		if (threads == threadCounts.front()) {
+			baseline = result;
+		}
+		const bool isSame{ result.Fingerprint == baseline.Fingerprint && result.NumSamples == baseline.NumSamples };
+		isConsistent = isConsistent && isSame;
+
+		const double speedUp{ result.Seconds > 0.0 ? baseline.Seconds / result.Seconds : 0.0 };
+		std::printf("%3d threads: %8.1f us/frame %6.1f ns/sample  x%.2f (%.0f%% per thread)  %lld samples %lld complete %016llx%s\n",
+			threads, result.Seconds * 1.0e6 / numFrames, result.NumSamples > 0 ? result.Seconds * 1.0e9 / result.NumSamples : 0.0,
+			speedUp, speedUp * 100.0 / threads, static_cast<long long>(result.NumSamples), static_cast<long long>(result.NumComplete),
+			static_cast<unsigned long long>(result.Fingerprint), isSame ? "" : "  MISMATCH");
+	}
+	return isConsistent ? 0 : 1;
+}
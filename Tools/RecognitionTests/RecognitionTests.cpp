@@ -0,0 +1,688 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Recognition tests - plain C++ checks of the engine independent recognizer, no engine or test framework required
+* Covers the parts that are easy to get subtly wrong and hard to spot in game:
+*	Tolerance kernels against the scalar checks they replace (ClassifyStaticRejection/ClassifyMoveRejection and RecognizerMath)
+*	LineMoveInTolerance() and ArcMoveInTolerance() right on and just past their edges, and with ignored axes
+*	GetArcCentre() for Arc1 and Arc2 in every plane
+*	The swept keypoint check (EvaluateSweptStaticTolerance()), including ignored axes, and how the recognizer uses it
+*	FDualHandInput state transitions
+*	Start rotation rejections of the spells the start pose index leaves out, counted in bulk when the counters are read
+*	FDtwMatcher keeps a long cast within DtwMaxSamples and still matches it
+*	Spell binaries with an out of range or duplicate spell ID are rejected
+*	FAllocationScope and FUncountedScope nesting (allocations are counted by hand, nothing hooks the allocator here)
+*
+* Usage: RecognitionTests
+*	Prints every failed check and a summary, returns non-zero if anything failed
+*	Build it once as it is and once with -DSPELLRECOGNITION_SCALAR_KERNELS, both must pass - the SIMD and scalar kernels
+*	are checked against the same scalar code, so passing both means they agree with each other too (Tools/CMakeLists.txt does this)
+*
+* Build (plain C++14, no engine required):
+*	g++ -std=c++14 -O2 -I../../DevC++Files/SpellCasting/Recognition RecognitionTests.cpp ../../DevC++Files/SpellCasting/Recognition/[A-Z]*.cpp -o RecognitionTests
+*/
+
+#include "AllocationCounter.h"
+#include "DtwMatcher.h"
+#include "DualHandInput.h"
+#include "RecognizerMath.h"
+#include "SpellBinary.h"
+#include "SpellRecognizer.h"
+#include "SpellTable.h"
+#include "ToleranceKernels.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace SpellRecognition;
+
+static int NumChecks{ 0 };
+static int NumFailed{ 0 };
+
+static bool Check(bool isPassed, const char* Condition, int Line) {
+	NumChecks++;
+	if (!isPassed) {
+		NumFailed++;
+		std::printf("FAILED line %d: %s\n", Line, Condition);
+	}
+	return isPassed;
+}
+
+#define CHECK(Condition) Check((Condition), #Condition, __LINE__)
+
+// Fixed seed LCG - the same poses every run, so a failure can be reproduced
+static uint32_t RandomState{ 2021 };
+
+static float MakeRandom(float Min, float Max) {
+	RandomState = RandomState * 1664525u + 1013904223u;
+	return Min + (RandomState >> 8) / static_cast<float>(1 << 24) * (Max - Min);
+}
+
+static FKeyPointDef MakeKeyPoint(const FVec3& Position, EMotion Motion, const FRot3& Rotation = FRot3{}) {
+	FKeyPointDef kp{};
+	kp.RHPosition = Position;
+	kp.RHRotation = Rotation;
+	kp.LHPosition = FVec3{ Position.X, -Position.Y, Position.Z }; // Mirrored, like most two handed spells
+	kp.LHRotation = FRot3{ Rotation.Pitch, -Rotation.Yaw, -Rotation.Roll };
+	kp.Motion = Motion;
+	return kp;
+}
+
+// One of every kind of move - straight, diagonal in every plane, arcs both ways round, points and rotations
+static FSpellDef MakeTestSpell(const FVec3& PositionalTolerance, const FRot3& RotationalTolerance) {
+	FSpellDef spell{};
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 0.f, 0.f, 0.f }, EMotion::Point));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 0.f, 1.f, 0.f }, EMotion::Line, FRot3{ 0.f, 45.f, 0.f }));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 1.f, 3.f, 0.f }, EMotion::Line, FRot3{ 30.f, 45.f, 0.f }));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 1.f, 4.f, -1.f }, EMotion::Arc1, FRot3{ 30.f, 45.f, 90.f }));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 3.f, 4.f, 1.f }, EMotion::Arc2));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 3.f, 4.f, 1.f }, EMotion::Point, FRot3{ -20.f, 0.f, 0.f }));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 3.f, 2.f, 3.f }, EMotion::Line));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 2.f, 2.f, 2.f }, EMotion::Arc1));
+	spell.PositionalTolerance = PositionalTolerance;
+	spell.RotationalTolerance = RotationalTolerance;
+	spell.isDualOnly = false;
+	return spell;
+}
+
+static FVec3 GetHandPosition(const FKeyPointDef& kp, EHand Hand) { return (Hand == EHand::Right) ? kp.RHPosition : kp.LHPosition; }
+static FRot3 GetHandRotation(const FKeyPointDef& kp, EHand Hand) { return (Hand == EHand::Right) ? kp.RHRotation : kp.LHRotation; }
+
+// Same checks as the kernels, made of the scalar RecognizerMath functions USpellComponent used to call one spell at a time
+static bool ReferenceStatic(const FSpellDef& Spell, int kpID, EHand Hand, float Scale, float MaxMoveTolerance, const FVec3& RelativePos, const FRot3& Rotation) {
+	const FKeyPointDef& kp{ Spell.KeyPoints[kpID] };
+	return PointEqual(RelativePos / Scale, GetHandPosition(kp, Hand), Spell.PositionalTolerance * MaxMoveTolerance / 2 / Scale) &&
+		PointEqual(Rotation, GetHandRotation(kp, Hand), Spell.RotationalTolerance);
+}
+
+static bool ReferenceMove(const FSpellDef& Spell, int kpID, EHand Hand, float Scale, float MaxMoveTolerance, const FVec3& RelativePos, const FRot3& Rotation) {
+	const FKeyPointDef& kp{ Spell.KeyPoints[kpID] };
+	const FKeyPointDef& kpPrev{ Spell.KeyPoints[(kpID == 0) ? 0 : kpID - 1] };
+	const FVec3 endPos{ GetHandPosition(kp, Hand) };
+	const FVec3 startPos{ (kp.Motion == EMotion::Point) ? endPos : GetHandPosition(kpPrev, Hand) };
+	const FVec3 tolerance{ Spell.PositionalTolerance * MaxMoveTolerance / Scale };
+	const bool isPositionInTolerance{ IsArc(kp.Motion) ?
+		ArcMoveInTolerance(RelativePos / Scale, startPos, endPos, tolerance, kp.Motion) :
+		LineMoveInTolerance(RelativePos / Scale, startPos, endPos, tolerance) };
+	return isPositionInTolerance && RotationMoveInTolerance(Rotation, GetHandRotation(kpPrev, Hand), GetHandRotation(kp, Hand), Spell.RotationalTolerance);
+}
+
+// A pose somewhere around the move to keypoint kpID - mostly near the path, often just outside the tolerances
+static void MakeRandomPose(const FSpellDef& Spell, int kpID, EHand Hand, float Scale, float MaxMoveTolerance, FVec3& OutRelativePos, FRot3& OutRotation) {
+	const FKeyPointDef& kp{ Spell.KeyPoints[kpID] };
+	const FKeyPointDef& kpPrev{ Spell.KeyPoints[(kpID == 0) ? 0 : kpID - 1] };
+	const float fraction{ MakeRandom(-0.2f, 1.2f) };
+	const FVec3 start{ GetHandPosition(kpPrev, Hand) };
+	const FVec3 end{ GetHandPosition(kp, Hand) };
+	const FVec3 path{ IsArc(kp.Motion) ? GetArcPosition(start, end, kp.Motion, fraction) : start + (end - start) * fraction };
+	const float noise{ MaxMoveTolerance * 1.5f };
+	OutRelativePos = path * Scale + FVec3{ MakeRandom(-noise, noise), MakeRandom(-noise, noise), MakeRandom(-noise, noise) };
+
+	const FRot3 startRot{ GetHandRotation(kpPrev, Hand) };
+	const FRot3 endRot{ GetHandRotation(kp, Hand) };
+	OutRotation = FRot3{ startRot.Pitch + (endRot.Pitch - startRot.Pitch) * fraction + MakeRandom(-40.f, 40.f),
+		startRot.Yaw + (endRot.Yaw - startRot.Yaw) * fraction + MakeRandom(-40.f, 40.f),
+		startRot.Roll + (endRot.Roll - startRot.Roll) * fraction + MakeRandom(-40.f, 40.f) };
+}
+
+// Every kernel against the scalar checks - one lane per keypoint, hand and scale of every test spell
+static void TestKernelsMatchScalar(bool isQuaternionRotation) {
+	const float maxMoveTolerance{ 8.f };
+	const float scales[]{ 1.f, 8.f, 23.5f };
+	std::vector<FSpellDef> spells{};
+	spells.push_back(MakeTestSpell(FVec3{ 1.f, 1.f, 1.f }, FRot3{ 20.f, 30.f, 25.f }));
+	spells.push_back(MakeTestSpell(FVec3{ 0.f, 0.5f, 1.f }, FRot3{ 0.f, 30.f, 0.f })); // Ignored axes
+	spells.push_back(MakeTestSpell(FVec3{ 2.f, 0.f, 0.f }, FRot3{ 45.f, 0.f, 15.f }));
+
+	struct FLaneInfo {
+		int32_t Spell;
+		int kpID;
+		float Scale;
+		bool isScaleSet;
+	};
+	FToleranceLanes lanes[2]{};
+	std::vector<FLaneInfo> laneInfo{};
+	for (int32_t spellID{ 0 }; spellID < static_cast<int32_t>(spells.size()); spellID++) {
+		for (int kpID{ 0 }; kpID < static_cast<int>(spells[spellID].KeyPoints.size()); kpID++) {
+			for (float scale : scales) {
+				laneInfo.push_back(FLaneInfo{ spellID, kpID, scale, laneInfo.size() % 2 == 0 });
+			}
+		}
+	}
+	const int32_t laneCount{ static_cast<int32_t>(laneInfo.size()) };
+	for (int hand{ 0 }; hand < 2; hand++) {
+		lanes[hand].isQuaternionRotation = isQuaternionRotation;
+		lanes[hand].Resize(laneCount);
+		for (int32_t lane{ 0 }; lane < laneCount; lane++) {
+			const FLaneInfo& info{ laneInfo[lane] };
+			lanes[hand].SetKeyPoint(lane, spells[info.Spell], info.kpID, static_cast<EHand>(hand), maxMoveTolerance);
+			lanes[hand].SetScale(lane, info.Scale, info.isScaleSet);
+		}
+	}
+
+	const int32_t maskWords{ ToleranceMaskWords(laneCount) };
+	std::vector<uint64_t> liveMask(maskWords, 0);
+	for (int32_t lane{ 0 }; lane < laneCount; lane++) {
+		SetLaneBit(liveMask.data(), lane);
+	}
+	std::vector<uint64_t> staticMask(maskWords, 0);
+	std::vector<uint64_t> sweptMask(maskWords, 0);
+	std::vector<uint64_t> moveMask(maskWords, 0);
+
+	int numStaticMismatch{ 0 };
+	int numMoveMismatch{ 0 };
+	int numReferenceMismatch{ 0 };
+	int numSweptMismatch{ 0 };
+	int numStaticPass{ 0 };
+	int numMovePass{ 0 };
+	for (int32_t target{ 0 }; target < laneCount; target++) {
+		for (int hand{ 0 }; hand < 2; hand++) {
+			const EHand eHand{ static_cast<EHand>(hand) };
+			const FLaneInfo& info{ laneInfo[target] };
+			for (int pose{ 0 }; pose < 20; pose++) {
+				FVec3 relativePos{};
+				FRot3 rotation{};
+				MakeRandomPose(spells[info.Spell], info.kpID, eHand, info.Scale, maxMoveTolerance, relativePos, rotation);
+				const FQuat4 orientation{ ToQuat(rotation) };
+				EvaluateStaticTolerance(lanes[hand], relativePos, rotation, orientation, liveMask.data(), staticMask.data());
+				EvaluateSweptStaticTolerance(lanes[hand], relativePos, relativePos, rotation, orientation, liveMask.data(), sweptMask.data());
+				EvaluateMoveTolerance(lanes[hand], relativePos, rotation, orientation, liveMask.data(), moveMask.data());
+
+				// Every lane sees the pose - the target lane's keypoint is the one it was made around, the rest are further off
+				for (int32_t lane{ 0 }; lane < laneCount; lane++) {
+					const bool isStatic{ IsLaneSet(staticMask.data(), lane) };
+					const bool isMove{ IsLaneSet(moveMask.data(), lane) };
+					numStaticMismatch += (isStatic != (ClassifyStaticRejection(lanes[hand], lane, relativePos, rotation, orientation) == ERejectReason::Num)) ? 1 : 0;
+					numMoveMismatch += (isMove != (ClassifyMoveRejection(lanes[hand], lane, relativePos, rotation, orientation) == ERejectReason::Num)) ? 1 : 0;
+					numSweptMismatch += (isStatic != IsLaneSet(sweptMask.data(), lane)) ? 1 : 0;
+					numStaticPass += isStatic ? 1 : 0;
+					numMovePass += isMove ? 1 : 0;
+
+					// Euler rotations with the arc width in use - exactly what the RecognizerMath checks do
+					const FLaneInfo& other{ laneInfo[lane] };
+					if (!isQuaternionRotation && other.isScaleSet) {
+						const FSpellDef& spell{ spells[other.Spell] };
+						numReferenceMismatch += (isStatic != ReferenceStatic(spell, other.kpID, eHand, other.Scale, maxMoveTolerance, relativePos, rotation)) ? 1 : 0;
+						numReferenceMismatch += (isMove != ReferenceMove(spell, other.kpID, eHand, other.Scale, maxMoveTolerance, relativePos, rotation)) ? 1 : 0;
+					}
+				}
+			}
+		}
+	}
+	CHECK(numStaticMismatch == 0);
+	CHECK(numMoveMismatch == 0);
+	CHECK(numSweptMismatch == 0); // Not moving - the swept check is the static check
+	CHECK(numReferenceMismatch == 0);
+	// The poses must land on both sides of the tolerances, or the checks above prove nothing
+	CHECK(numStaticPass > 100);
+	CHECK(numMovePass > 1000);
+}
+
+// Unit space checks, tolerance 0.1 on every axis unless said otherwise
+static void TestLineMoveInTolerance() {
+	const FVec3 tolerance{ 0.1f, 0.1f, 0.1f };
+
+	// Straight up Y
+	const FVec3 start{ 0.f, 0.f, 0.f };
+	const FVec3 up{ 0.f, 1.f, 0.f };
+	CHECK(LineMoveInTolerance(FVec3{ 0.f, 0.5f, 0.f }, start, up, tolerance));
+	CHECK(LineMoveInTolerance(FVec3{ 0.f, 0.5f, 0.1f }, start, up, tolerance)); // Right on the edge passes
+	CHECK(!LineMoveInTolerance(FVec3{ 0.f, 0.5f, 0.11f }, start, up, tolerance));
+	CHECK(!LineMoveInTolerance(FVec3{ -0.11f, 0.5f, 0.f }, start, up, tolerance));
+	CHECK(LineMoveInTolerance(FVec3{ 0.f, 1.09f, 0.f }, start, up, tolerance)); // Tolerance past either end
+	CHECK(!LineMoveInTolerance(FVec3{ 0.f, 1.11f, 0.f }, start, up, tolerance));
+	CHECK(LineMoveInTolerance(FVec3{ 0.f, -0.09f, 0.f }, start, up, tolerance));
+	CHECK(!LineMoveInTolerance(FVec3{ 0.f, -0.11f, 0.f }, start, up, tolerance));
+	CHECK(LineMoveInTolerance(FVec3{ 0.f, 0.5f, 0.f }, up, start, tolerance)); // Either direction
+	CHECK(!LineMoveInTolerance(FVec3{ 0.f, 1.11f, 0.f }, up, start, tolerance));
+
+	// Ignored axes (0) are never checked, however far off
+	CHECK(LineMoveInTolerance(FVec3{ 50.f, 0.5f, 0.f }, start, up, FVec3{ 0.f, 0.1f, 0.1f }));
+	CHECK(LineMoveInTolerance(FVec3{ 0.f, 7.f, 0.f }, start, up, FVec3{ 0.1f, 0.f, 0.1f }));
+	CHECK(!LineMoveInTolerance(FVec3{ 50.f, 7.f, 0.2f }, start, up, FVec3{ 0.f, 0.f, 0.1f }));
+
+	// Diagonal in XY - the width is the perpendicular distance from the line, the length a projection onto it
+	const FVec3 diagonal{ 1.f, 1.f, 0.f };
+	CHECK(LineMoveInTolerance(FVec3{ 0.5f, 0.5f, 0.f }, start, diagonal, tolerance));
+	CHECK(LineMoveInTolerance(FVec3{ 0.55f, 0.45f, 0.f }, start, diagonal, tolerance)); // 0.071 off the line
+	CHECK(!LineMoveInTolerance(FVec3{ 0.6f, 0.4f, 0.f }, start, diagonal, tolerance)); // 0.141 off the line, inside the box
+	CHECK(LineMoveInTolerance(FVec3{ 1.05f, 1.05f, 0.f }, start, diagonal, tolerance)); // 0.071 past the end
+	CHECK(!LineMoveInTolerance(FVec3{ 1.09f, 1.09f, 0.f }, start, diagonal, tolerance)); // 0.127 past the end, inside the box
+	CHECK(!LineMoveInTolerance(FVec3{ -0.09f, -0.09f, 0.f }, start, diagonal, tolerance));
+	CHECK(!LineMoveInTolerance(FVec3{ 0.5f, 0.5f, 0.11f }, start, diagonal, tolerance)); // The third axis is still checked
+
+	// Diagonal with one of its axes ignored - no width to check, the other axis is checked like a straight line
+	CHECK(LineMoveInTolerance(FVec3{ 5.f, 0.4f, 0.f }, start, diagonal, FVec3{ 0.f, 0.1f, 0.1f }));
+	CHECK(!LineMoveInTolerance(FVec3{ 0.5f, 1.11f, 0.f }, start, diagonal, FVec3{ 0.f, 0.1f, 0.1f }));
+
+	// Diagonal in YZ, going down
+	const FVec3 down{ 0.f, 2.f, -2.f };
+	CHECK(LineMoveInTolerance(FVec3{ 0.f, 1.f, -1.f }, start, down, tolerance));
+	CHECK(!LineMoveInTolerance(FVec3{ 0.f, 1.1f, -0.9f }, start, down, tolerance));
+}
+
+static void TestArcMoveInTolerance() {
+	const FVec3 tolerance{ 0.1f, 0.1f, 0.1f };
+	const FVec3 start{ 0.f, 0.f, 0.f };
+	const FVec3 end{ 0.f, 1.f, -1.f };
+
+	// Arc1 sets off along Y - centre (0, 0, -1), radius 1
+	CHECK(ArcMoveInTolerance(start, start, end, tolerance, EMotion::Arc1));
+	CHECK(ArcMoveInTolerance(end, start, end, tolerance, EMotion::Arc1));
+	CHECK(ArcMoveInTolerance(FVec3{ 0.f, 0.7071f, -0.2929f }, start, end, tolerance, EMotion::Arc1)); // Half way round
+	CHECK(ArcMoveInTolerance(FVec3{ 0.f, 0.7707f, -0.2293f }, start, end, tolerance, EMotion::Arc1)); // 0.09 outside the circle
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.f, 0.7849f, -0.2151f }, start, end, tolerance, EMotion::Arc1)); // 0.11 outside the circle
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.f, 0.6293f, -0.3707f }, start, end, tolerance, EMotion::Arc1)); // 0.11 inside the circle
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.f, 0.5f, -0.5f }, start, end, tolerance, EMotion::Arc1)); // On the straight line, not the arc
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.f, 0.7071f, -0.2929f }, start, end, tolerance, EMotion::Arc2)); // Other way round
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.f, -0.5f, -0.134f }, start, end, tolerance, EMotion::Arc1)); // On the circle, wrong quadrant
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.11f, 0.7071f, -0.2929f }, start, end, tolerance, EMotion::Arc1)); // The third axis is still checked
+
+	// Arc2 sets off along Z - centre (0, 1, 0)
+	CHECK(ArcMoveInTolerance(FVec3{ 0.f, 0.2929f, -0.7071f }, start, end, tolerance, EMotion::Arc2));
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.f, 0.5f, -0.5f }, start, end, tolerance, EMotion::Arc2));
+
+	// One moving axis ignored - the width uses the other one's tolerance
+	CHECK(ArcMoveInTolerance(FVec3{ 0.f, 0.7707f, -0.2293f }, start, end, FVec3{ 0.1f, 0.f, 0.1f }, EMotion::Arc1));
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.f, 0.7849f, -0.2151f }, start, end, FVec3{ 0.1f, 0.f, 0.1f }, EMotion::Arc1));
+	// Both moving axes ignored - nothing left to check the width with
+	CHECK(ArcMoveInTolerance(FVec3{ 0.f, 0.5f, -0.5f }, start, end, FVec3{ 0.1f, 0.f, 0.f }, EMotion::Arc1));
+	CHECK(!ArcMoveInTolerance(FVec3{ 0.2f, 0.5f, -0.5f }, start, end, FVec3{ 0.1f, 0.f, 0.f }, EMotion::Arc1));
+}
+
+static bool VecEqual(const FVec3& A, const FVec3& B) {
+	return std::fabs(A.X - B.X) < 1.0e-5f && std::fabs(A.Y - B.Y) < 1.0e-5f && std::fabs(A.Z - B.Z) < 1.0e-5f;
+}
+
+static void TestGetArcCentre() {
+	// YZ - Arc1 is level with the start on Y and with the end on Z, Arc2 the other way round
+	CHECK(VecEqual(GetArcCentre(FVec3{ 0.f, 0.f, 0.f }, FVec3{ 0.f, 1.f, -1.f }, EMotion::Arc1), FVec3{ 0.f, 0.f, -1.f }));
+	CHECK(VecEqual(GetArcCentre(FVec3{ 0.f, 0.f, 0.f }, FVec3{ 0.f, 1.f, -1.f }, EMotion::Arc2), FVec3{ 0.f, 1.f, 0.f }));
+	// XY and XZ, not starting at the origin
+	CHECK(VecEqual(GetArcCentre(FVec3{ 1.f, 2.f, 3.f }, FVec3{ 3.f, 0.f, 3.f }, EMotion::Arc1), FVec3{ 1.f, 0.f, 3.f }));
+	CHECK(VecEqual(GetArcCentre(FVec3{ 1.f, 2.f, 3.f }, FVec3{ 3.f, 0.f, 3.f }, EMotion::Arc2), FVec3{ 3.f, 2.f, 3.f }));
+	CHECK(VecEqual(GetArcCentre(FVec3{ 1.f, 2.f, 3.f }, FVec3{ 0.f, 2.f, 4.f }, EMotion::Arc1), FVec3{ 1.f, 2.f, 4.f }));
+	CHECK(VecEqual(GetArcCentre(FVec3{ 1.f, 2.f, 3.f }, FVec3{ 0.f, 2.f, 4.f }, EMotion::Arc2), FVec3{ 0.f, 2.f, 3.f }));
+
+	// The arc sets off along the axis it is named for and is a quarter circle round the centre
+	const FVec3 start{ 0.f, 0.f, 0.f };
+	const FVec3 end{ 0.f, 1.f, -1.f };
+	const FVec3 arc1Early{ GetArcPosition(start, end, EMotion::Arc1, 0.1f) };
+	const FVec3 arc2Early{ GetArcPosition(start, end, EMotion::Arc2, 0.1f) };
+	CHECK(std::fabs(arc1Early.Y) > std::fabs(arc1Early.Z));
+	CHECK(std::fabs(arc2Early.Z) > std::fabs(arc2Early.Y));
+	CHECK(VecEqual(GetArcPosition(start, end, EMotion::Arc1, 0.f), start));
+	CHECK(VecEqual(GetArcPosition(start, end, EMotion::Arc1, 1.f), end));
+	CHECK(std::fabs((GetArcPosition(start, end, EMotion::Arc2, 0.37f) - GetArcCentre(start, end, EMotion::Arc2)).Size() - 1.f) < 1.0e-5f);
+}
+
+// One spell with one keypoint at (0, 10, 0), scale 1 - static tolerance 2 on every axis unless said otherwise
+static bool IsSweptInTolerance(const FVec3& PositionalTolerance, const FVec3& PrevRelativePos, const FVec3& RelativePos) {
+	FSpellDef spell{};
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 0.f, 10.f, 0.f }, EMotion::Point));
+	spell.PositionalTolerance = PositionalTolerance;
+	FToleranceLanes lanes{};
+	lanes.Resize(1);
+	lanes.SetKeyPoint(0, spell, 0, EHand::Right, 4.f);
+	lanes.SetScale(0, 1.f, true);
+
+	const uint64_t liveMask{ 1 };
+	uint64_t outMask{ 0 };
+	EvaluateSweptStaticTolerance(lanes, PrevRelativePos, RelativePos, FRot3{}, FQuat4{}, &liveMask, &outMask);
+	return IsLaneSet(&outMask, 0);
+}
+
+static void TestSweptStaticTolerance() {
+	const FVec3 tolerance{ 1.f, 1.f, 1.f };
+
+	// Neither sample is in the box, the move between them goes straight through it
+	CHECK(IsSweptInTolerance(tolerance, FVec3{ 0.f, 5.f, 0.f }, FVec3{ 0.f, 15.f, 0.f }));
+	CHECK(IsSweptInTolerance(tolerance, FVec3{ 0.f, 15.f, 0.f }, FVec3{ 0.f, 5.f, 0.f }));
+	CHECK(IsSweptInTolerance(tolerance, FVec3{ -5.f, 5.f, 1.f }, FVec3{ 5.f, 15.f, -1.f }));
+	// Either end in the box
+	CHECK(IsSweptInTolerance(tolerance, FVec3{ 0.f, 0.f, 0.f }, FVec3{ 1.f, 11.f, -1.f }));
+	CHECK(IsSweptInTolerance(tolerance, FVec3{ 1.f, 11.f, -1.f }, FVec3{ 0.f, 30.f, 0.f }));
+	// Passes beside the box, or stops short of it
+	CHECK(!IsSweptInTolerance(tolerance, FVec3{ 0.f, 5.f, 2.5f }, FVec3{ 0.f, 15.f, 2.5f }));
+	CHECK(!IsSweptInTolerance(tolerance, FVec3{ 0.f, 0.f, 0.f }, FVec3{ 0.f, 7.5f, 0.f }));
+	// The bounds of the move overlap the box but it cuts past a corner - only the cross axes catch this
+	CHECK(!IsSweptInTolerance(tolerance, FVec3{ 0.f, 10.5f, 4.f }, FVec3{ 0.f, 14.5f, 0.f }));
+	CHECK(IsSweptInTolerance(tolerance, FVec3{ 0.f, 9.5f, 4.f }, FVec3{ 0.f, 13.5f, 0.f }));
+	CHECK(!IsSweptInTolerance(tolerance, FVec3{ -4.5f, 10.f, 0.5f }, FVec3{ -0.5f, 14.f, 0.5f }));
+
+	// Ignored axes (X here) never reject, however far the hand moves along them - and must not overflow the cross axes
+	const FVec3 ignoreX{ 0.f, 1.f, 1.f };
+	CHECK(IsSweptInTolerance(ignoreX, FVec3{ 1000.f, 5.f, 0.f }, FVec3{ 1000.f, 15.f, 0.f }));
+	CHECK(IsSweptInTolerance(ignoreX, FVec3{ -500.f, 5.f, 0.f }, FVec3{ 500.f, 15.f, 0.f }));
+	CHECK(IsSweptInTolerance(ignoreX, FVec3{ -500.f, 10.f, 0.f }, FVec3{ 500.f, 10.f, 0.f }));
+	CHECK(!IsSweptInTolerance(ignoreX, FVec3{ -500.f, 5.f, 3.f }, FVec3{ 500.f, 15.f, 3.f }));
+	CHECK(!IsSweptInTolerance(ignoreX, FVec3{ 1000.f, 10.5f, 4.f }, FVec3{ -1000.f, 14.5f, 0.f }));
+	CHECK(IsSweptInTolerance(FVec3{ 0.f, 0.f, 0.f }, FVec3{ -1.0e4f, 1.0e4f, 0.f }, FVec3{ 1.0e4f, -1.0e4f, 0.f }));
+
+	// A move that ends in the box passes whichever way it came - a move that never gets close never does
+	int numMismatch{ 0 };
+	for (int i{ 0 }; i < 10000; i++) {
+		const FVec3 prev{ MakeRandom(-20.f, 20.f), MakeRandom(-10.f, 30.f), MakeRandom(-20.f, 20.f) };
+		const FVec3 current{ MakeRandom(-2.f, 2.f), MakeRandom(8.f, 12.f), MakeRandom(-2.f, 2.f) };
+		numMismatch += IsSweptInTolerance(tolerance, prev, current) ? 0 : 1;
+		const FVec3 far{ current + FVec3{ 0.f, 0.f, 4.01f } };
+		numMismatch += IsSweptInTolerance(tolerance, far + FVec3{ prev.X, prev.Y, std::fabs(prev.Z) }, far) ? 1 : 0;
+	}
+	CHECK(numMismatch == 0);
+}
+
+// Right hand cast of Path (relative to its start) through an L shaped spell - returns true if the spell completed
+// Up to (0, 1, 0), right to (1, 1, 0), down to (1, 0, 0) - MaxMoveTolerance 8, so the move tolerance is 8 and keypoints are complete within 4
+static bool IsCastComplete(bool isSweptKeyPoints, const std::vector<FVec3>& Path) {
+	FSpellDef spell{};
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 0.f, 0.f, 0.f }, EMotion::Point));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 0.f, 1.f, 0.f }, EMotion::Line));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 1.f, 1.f, 0.f }, EMotion::Line));
+	spell.KeyPoints.push_back(MakeKeyPoint(FVec3{ 1.f, 0.f, 0.f }, EMotion::Line));
+	spell.PositionalTolerance = FVec3{ 1.f, 1.f, 1.f };
+	spell.isDualOnly = false;
+	spell.ID = 7;
+
+	FRecognizerSettings settings{};
+	settings.isSweptKeyPoints = isSweptKeyPoints;
+	FSpellRecognizer recognizer{ std::vector<FSpellDef>{ spell }, settings };
+	FPoseSample sample{};
+	if (!recognizer.SpellSetup(sample, true, false)) {
+		return false;
+	}
+	for (const FVec3& position : Path) {
+		sample.RH.Position = position;
+		if (recognizer.UpdateSpellStates(sample, true, false)) {
+			return recognizer.GetActiveSpells() == spell.ID;
+		}
+	}
+	return false;
+}
+
+static void TestSweptKeyPoints() {
+	// Up to (0, 20, 0) sets the scale to 20 (it follows the hand until it leaves the first keypoint), then every path turns right
+	// towards (20, 20, 0) and comes back down to (20, 0, 0) - they only differ in the one sample that gets to the corner
+	const auto makePath = [](const FVec3& Corner) {
+		return std::vector<FVec3>{ FVec3{ 0.f, 5.f, 0.f }, FVec3{ 0.f, 10.f, 0.f }, FVec3{ 0.f, 15.f, 0.f }, FVec3{ 0.f, 20.f, 0.f }, FVec3{ 5.f, 20.f, 0.f },
+			Corner, FVec3{ 20.f, 10.f, 0.f }, FVec3{ 20.f, 0.f, 0.f }, FVec3{ 20.f, 0.f, 0.f } };
+	};
+
+	// Samples on the corner - complete either way
+	CHECK(IsCastComplete(false, makePath(FVec3{ 20.f, 20.f, 0.f })));
+	CHECK(IsCastComplete(true, makePath(FVec3{ 20.f, 20.f, 0.f })));
+
+	// The sample before the corner is 15 short of it and the corner sample 6 past it - neither is within 4, the move between them
+	// straddles the corner's tolerance box, and the overshoot is within the move tolerance of 8
+	// Only the swept check completes the corner, without it the hand turns down while still working towards it and leaves the move
+	CHECK(!IsCastComplete(false, makePath(FVec3{ 26.f, 20.f, 0.f })));
+	CHECK(IsCastComplete(true, makePath(FVec3{ 26.f, 20.f, 0.f })));
+	CHECK(IsCastComplete(true, makePath(FVec3{ 26.f, 22.f, 3.f })));
+
+	// Overshoots past the move tolerance - the hand went through the corner but left the move, so the corner does not count
+	// (the next sample would be back in tolerance of the move down, which must not rescue it)
+	CHECK(!IsCastComplete(false, makePath(FVec3{ 32.f, 20.f, 0.f })));
+	CHECK(!IsCastComplete(true, makePath(FVec3{ 32.f, 20.f, 0.f })));
+
+	// Passes just above the corner's box, still in the move tolerance - the sweep back down to (20, 10, 0) does cross the box, but that
+	// sample has left the move, so nothing completes swept or not
+	CHECK(!IsCastComplete(false, makePath(FVec3{ 26.f, 27.9f, 0.f })));
+	CHECK(!IsCastComplete(true, makePath(FVec3{ 26.f, 27.9f, 0.f })));
+
+	// The sweep starts at the previous sample of this cast - the first update sweeps from the start pose
+	CHECK(IsCastComplete(true, std::vector<FVec3>{ FVec3{ 0.f, 20.f, 0.f }, FVec3{ 5.f, 20.f, 0.f }, FVec3{ 26.f, 20.f, 0.f }, FVec3{ 20.f, 10.f, 0.f },
+		FVec3{ 20.f, 0.f, 0.f }, FVec3{ 20.f, 0.f, 0.f } }));
+}
+
+static void TestDualHandInput() {
+	FDualHandInput input{ 0.2 };
+	CHECK(input.GetState() == EDualHandState::Idle);
+	CHECK(input.GetIntent() == EHandIntent::None);
+
+	// Idle -> Waiting -> Dual, decided by the second press
+	CHECK(input.Press(EHand::Right, 1.0) == EHandIntent::None);
+	CHECK(input.IsWaiting());
+	CHECK(input.IsActive(EHand::Right) && !input.IsActive(EHand::Left));
+	CHECK(input.GetWindowEnd() == 1.2);
+	CHECK(input.Update(1.1) == EHandIntent::None);
+	CHECK(input.Press(EHand::Left, 1.19) == EHandIntent::Dual);
+	CHECK(input.GetState() == EDualHandState::Dual);
+	CHECK(input.GetIntent() == EHandIntent::Dual);
+
+	// Dual -> Waiting -> Dual - one hand let go and came back within the window that opened on the release
+	CHECK(input.Release(EHand::Right, 2.0) == EHandIntent::None);
+	CHECK(input.IsWaiting());
+	CHECK(input.GetIntent() == EHandIntent::None);
+	CHECK(input.GetWindowEnd() == 2.2);
+	CHECK(!input.IsActive(EHand::Right) && input.IsActive(EHand::Left));
+	CHECK(input.Press(EHand::Right, 2.15) == EHandIntent::Dual);
+	CHECK(input.IsActive(EHand::Right) && input.IsActive(EHand::Left));
+
+	// Dual -> Waiting -> Single -> Idle - the other hand carries on alone once the window closes
+	CHECK(input.Release(EHand::Left, 3.0) == EHandIntent::None);
+	CHECK(input.IsWaiting());
+	CHECK(input.Update(3.1) == EHandIntent::None);
+	CHECK(input.Update(3.2) == EHandIntent::Right);
+	CHECK(input.GetState() == EDualHandState::Single);
+	CHECK(input.Press(EHand::Left, 3.3) == EHandIntent::None); // Too late to join in again
+	CHECK(input.GetIntent() == EHandIntent::Right);
+	CHECK(!input.IsActive(EHand::Left));
+	CHECK(input.Release(EHand::Right, 4.0) == EHandIntent::None);
+	CHECK(input.GetState() == EDualHandState::Idle);
+	CHECK(input.GetIntent() == EHandIntent::None);
+
+	// Dual -> Waiting -> Idle - both hands let go within the window
+	CHECK(input.Press(EHand::Right, 4.5) == EHandIntent::None);
+	CHECK(input.Press(EHand::Left, 4.55) == EHandIntent::Dual);
+	CHECK(input.Release(EHand::Left, 4.6) == EHandIntent::None);
+	CHECK(input.Release(EHand::Right, 4.65) == EHandIntent::None);
+	CHECK(input.GetState() == EDualHandState::Idle);
+	CHECK(input.Update(5.0) == EHandIntent::None);
+
+	// Waiting -> Single at the window end, however late the next event comes
+	input.Reset();
+	CHECK(input.Press(EHand::Left, 5.0) == EHandIntent::None);
+	CHECK(input.Update(5.2) == EHandIntent::Left);
+	CHECK(input.GetState() == EDualHandState::Single);
+	CHECK(input.Update(5.3) == EHandIntent::None); // Decided once
+	input.Reset();
+	CHECK(input.Press(EHand::Right, 6.0) == EHandIntent::None);
+	CHECK(input.Press(EHand::Left, 6.9) == EHandIntent::Right); // Closes the window first, so the left hand is too late
+	CHECK(input.GetIntent() == EHandIntent::Right);
+	CHECK(!input.IsActive(EHand::Left));
+
+	// Waiting -> Idle - let go before anything was decided
+	input.Reset();
+	CHECK(input.Press(EHand::Right, 8.0) == EHandIntent::None);
+	CHECK(input.Release(EHand::Right, 8.1) == EHandIntent::None);
+	CHECK(input.GetState() == EDualHandState::Idle);
+	CHECK(input.Update(9.0) == EHandIntent::None);
+
+	// Releasing a hand that is not part of the intent does nothing
+	CHECK(input.Press(EHand::Right, 10.0) == EHandIntent::None);
+	CHECK(input.Release(EHand::Left, 10.05) == EHandIntent::None);
+	CHECK(input.IsWaiting());
+	// The same hand again is not the other hand
+	CHECK(input.Press(EHand::Right, 10.1) == EHandIntent::None);
+	CHECK(input.IsWaiting());
+
+	// Reset forgets held buttons
+	input.Reset();
+	CHECK(input.Release(EHand::Right, 11.0) == EHandIntent::None);
+	CHECK(input.GetState() == EDualHandState::Idle);
+}
+
+static void TestStartIndexRejections() {
+	// Start rolls far enough apart that the index (bucketed on Roll, the only axis checked) never lists two together
+	const float startRolls[]{ 0.f, 60.f, 120.f, 180.f };
+	std::vector<FSpellDef> spells{};
+	for (int32_t id{ 0 }; id < 4; id++) {
+		spells.push_back(MakeTestSpell(FVec3{ 1.f, 1.f, 1.f }, FRot3{ 0.f, 0.f, 20.f }));
+		spells.back().KeyPoints[0] = MakeKeyPoint(FVec3{}, EMotion::Point, FRot3{ 0.f, 0.f, startRolls[id] });
+		spells.back().ID = id;
+	}
+	FSpellRecognizer recognizer{ spells };
+
+	FPoseSample pose{};
+	pose.RH.Rotation = FRot3{ 0.f, 0.f, 60.f };
+	pose.LH.Rotation = FRot3{ 0.f, 0.f, -120.f }; // Mirrored, so spell 2
+	for (int i{ 0 }; i < 3; i++) {
+		CHECK(recognizer.SpellSetup(pose, true, false));
+	}
+	CHECK(recognizer.SpellSetup(pose, false, true));
+
+	const auto startRotation = [&recognizer](int32_t ID, ERejectHand Hand) {
+		return recognizer.GetRejectionCounters().Get(ID, Hand, ERejectReason::StartRotation);
+	};
+	CHECK(startRotation(0, ERejectHand::Right) == 3);
+	CHECK(startRotation(1, ERejectHand::Right) == 0);
+	CHECK(startRotation(2, ERejectHand::Right) == 3);
+	CHECK(startRotation(3, ERejectHand::Right) == 3);
+	CHECK(startRotation(0, ERejectHand::Left) == 1);
+	CHECK(startRotation(1, ERejectHand::Left) == 1);
+	CHECK(startRotation(2, ERejectHand::Left) == 0);
+	CHECK(startRotation(3, ERejectHand::Left) == 1);
+
+	// Reading again adds nothing, and the counts carry on across a hot reload
+	CHECK(startRotation(0, ERejectHand::Right) == 3);
+	CHECK(recognizer.SpellSetup(pose, true, false));
+	recognizer.SetSpells(spells);
+	CHECK(startRotation(0, ERejectHand::Right) == 4);
+
+	// Dual - blamed on the right hand if its bucket leaves the spell out, otherwise on the left
+	recognizer.ResetRejectionCounters();
+	pose.LH.Rotation = FRot3{ 0.f, 0.f, -60.f };
+	CHECK(recognizer.SpellSetup(pose, true, true));
+	CHECK(startRotation(1, ERejectHand::Right) == 0);
+	CHECK(startRotation(1, ERejectHand::Left) == 0);
+	CHECK(startRotation(0, ERejectHand::Right) == 1);
+	CHECK(startRotation(0, ERejectHand::Left) == 0);
+}
+
+// One cast of Spell straight from keypoint to keypoint (the path FDtwMatcher builds its templates from), SamplesPerMove samples per move
+static bool MatchDtwCast(FDtwMatcher& Matcher, const FSpellDef& Spell, int SamplesPerMove, FDtwMatch& OutMatch) {
+	const float scale{ 20.f };
+	const auto lerpRotation = [](const FRot3& From, const FRot3& To, float Fraction) {
+		return FRot3{ From.Pitch + (To.Pitch - From.Pitch) * Fraction, From.Yaw + (To.Yaw - From.Yaw) * Fraction, From.Roll + (To.Roll - From.Roll) * Fraction };
+	};
+	const auto makeSample = [&Spell, scale, &lerpRotation](size_t kp, float Fraction) {
+		const FKeyPointDef& from{ Spell.KeyPoints[(kp == 0) ? 0 : kp - 1] };
+		const FKeyPointDef& to{ Spell.KeyPoints[kp] };
+		FPoseSample sample{};
+		sample.RH.Position = (from.RHPosition + (to.RHPosition - from.RHPosition) * Fraction) * scale;
+		sample.LH.Position = (from.LHPosition + (to.LHPosition - from.LHPosition) * Fraction) * scale;
+		sample.RH.Rotation = lerpRotation(from.RHRotation, to.RHRotation, Fraction);
+		sample.LH.Rotation = lerpRotation(from.LHRotation, to.LHRotation, Fraction);
+		return sample;
+	};
+	Matcher.BeginCast(makeSample(0, 0.f), true, true);
+	for (size_t kp{ 1 }; kp < Spell.KeyPoints.size(); kp++) {
+		for (int i{ 1 }; i <= SamplesPerMove; i++) {
+			Matcher.AddSample(makeSample(kp, static_cast<float>(i) / SamplesPerMove));
+		}
+	}
+	return Matcher.Match(OutMatch);
+}
+
+static void TestDtwLongCast() {
+	FSpellDef spell{ MakeTestSpell(FVec3{ 1.f, 1.f, 1.f }, FRot3{ 20.f, 30.f, 25.f }) };
+	spell.ID = 3;
+	FDtwMatcher matcher{ std::vector<FSpellDef>{ spell } };
+
+	FDtwMatch shortMatch{};
+	CHECK(MatchDtwCast(matcher, spell, 20, shortMatch));
+	CHECK(matcher.NumSamples() == 1 + 7 * 20);
+	CHECK(shortMatch.SpellID == 3);
+
+	// Thousands of samples (a 500Hz sampler and a held button) - decimated, never more than DtwMaxSamples
+	FDtwMatch longMatch{};
+	CHECK(MatchDtwCast(matcher, spell, 1500, longMatch));
+	CHECK(matcher.NumSamples() <= DtwMaxSamples);
+	CHECK(matcher.NumSamples() > DtwMaxSamples / 2);
+	CHECK(longMatch.SpellID == 3);
+	CHECK(std::fabs(longMatch.Cost - shortMatch.Cost) < 0.1f);
+}
+
+// Loads Spells through a spell binary - OutSpells is left alone if it is rejected
+static bool LoadThroughBinary(const std::vector<FSpellDef>& Spells, std::vector<FSpellDef>& OutSpells) {
+	std::vector<uint8_t> binary{};
+	WriteSpellBinary(Spells, binary);
+	return LoadSpellBinary(binary.data(), binary.size(), OutSpells);
+}
+
+static void TestSpellBinaryIDs() {
+	std::vector<FSpellDef> spells{};
+	spells.push_back(MakeTestSpell(FVec3{ 1.f, 1.f, 1.f }, FRot3{ 20.f, 30.f, 25.f }));
+	spells.push_back(MakeTestSpell(FVec3{ 1.f, 1.f, 1.f }, FRot3{ 20.f, 30.f, 25.f }));
+	spells[0].ID = 0;
+	spells[1].ID = SpellIDCount - 1;
+	std::vector<FSpellDef> loaded{};
+	CHECK(LoadThroughBinary(spells, loaded));
+	CHECK(loaded.size() == 2);
+	CHECK(HasUniqueSpellIDs(spells));
+
+	// Out of range - the recognizers would size their rejection counters by it
+	for (int32_t badID : { -1, SpellIDCount, 2000000000, 2147483647 }) {
+		std::vector<FSpellDef> badSpells{ spells };
+		badSpells[1].ID = badID;
+		CHECK(!IsValidSpell(badSpells[1]));
+		CHECK(!LoadThroughBinary(badSpells, loaded));
+		CHECK(loaded.size() == 2);
+	}
+
+	// Duplicate
+	std::vector<FSpellDef> duplicates{ spells };
+	duplicates[1].ID = 0;
+	CHECK(IsValidSpell(duplicates[1]));
+	CHECK(!HasUniqueSpellIDs(duplicates));
+	CHECK(!LoadThroughBinary(duplicates, loaded));
+	CHECK(loaded.size() == 2);
+}
+
+static void TestAllocationScopes() {
+	uint64_t total{ 0 };
+	{
+		FAllocationScope scope{ total };
+		CountAllocation();
+		{
+			FUncountedScope uncounted{};
+			CountAllocation();
+			CountAllocation();
+		}
+		CountAllocation();
+	}
+	CHECK(total == 2);
+
+	// Nested counted scopes inside an uncounted one still see their own allocations
+	uint64_t outer{ 0 };
+	uint64_t inner{ 0 };
+	{
+		FAllocationScope scope{ outer };
+		FUncountedScope uncounted{};
+		{
+			FAllocationScope innerScope{ inner };
+			CountAllocation();
+		}
+	}
+	CHECK(inner == 1);
+	CHECK(outer == 0);
+}
+
+int main() {
+	std::printf("Tolerance kernels: %s\n", GetToleranceKernelName());
+
+	TestKernelsMatchScalar(false);
+	TestKernelsMatchScalar(true);
+	TestLineMoveInTolerance();
+	TestArcMoveInTolerance();
+	TestGetArcCentre();
+	TestSweptStaticTolerance();
+	TestSweptKeyPoints();
+	TestDualHandInput();
+	TestStartIndexRejections();
+	TestDtwLongCast();
+	TestSpellBinaryIDs();
+	TestAllocationScopes();
+
+	std::printf("%d checks, %d failed\n", NumChecks, NumFailed);
+	return (NumFailed == 0) ? 0 : 1;
+}
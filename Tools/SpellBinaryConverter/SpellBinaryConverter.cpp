@@ -0,0 +1,156 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Spell binary converter - turns a spell text file into the memory mappable spell binary that USpellContainer hot reloads
+* Lets spells (and their tolerances) be tweaked without recompiling the game
+*
+* Usage: SpellBinaryConverter <Spells.txt> <Spells.spellbin>
+*	Drop the output in Content/Spells/ (see USpellContainer::SpellBinaryFile) - a running game picks it up between casts
+*
+* Build (plain C++14, no engine required):
+*	g++ -std=c++14 -O2 -I../../DevC++Files/SpellCasting/Recognition SpellBinaryConverter.cpp ../../DevC++Files/SpellCasting/Recognition/SpellBinary.cpp ../../DevC++Files/SpellCasting/Recognition/SpellTable.cpp -o SpellBinaryConverter
+*
+* Text format - see Spells.txt for every spell in the game:
+*	# Comment until the end of the line
+*	spell <ID> <single|dual>					Starts a spell, ID is the SpellID value - each once (single == can be cast one handed)
+*	start <X> <Y> <Z>							Relative start direction from LH to RH
+*	postol <X> <Y> <Z>							Positional tolerance (0 == ignore axis)
+*	rottol <Pitch> <Yaw> <Roll>					Rotational tolerance (0 == ignore axis)
+*	<point|line|arc1|arc2> rh <X Y Z> <P Y R> lh <X Y Z> <P Y R>	One keypoint, in order (see EMotion for arc1/arc2)
+*/
+
+#include "SpellBinary.h"
+#include "SpellTable.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace SpellRecognition;
+
+static bool ReadVec(std::istringstream& Line, FVec3& Out) {
+	return static_cast<bool>(Line >> Out.X >> Out.Y >> Out.Z);
+}
+
+static bool ReadRot(std::istringstream& Line, FRot3& Out) {
+	return static_cast<bool>(Line >> Out.Pitch >> Out.Yaw >> Out.Roll);
+}
+
+static bool ReadKeyPoint(std::istringstream& Line, FKeyPointDef& Out) {
+	std::string rh, lh;
+	return (Line >> rh) && rh == "rh" && ReadVec(Line, Out.RHPosition) && ReadRot(Line, Out.RHRotation) &&
+		(Line >> lh) && lh == "lh" && ReadVec(Line, Out.LHPosition) && ReadRot(Line, Out.LHRotation);
+}
+
+// Fills OutSpells from spell text - returns false and prints the offending line if anything is wrong
+static bool ParseSpellText(std::istream& Text, std::vector<FSpellDef>& OutSpells) {
+	std::string line;
+	int lineNumber{ 0 };
+
+	while (std::getline(Text, line)) {
+		lineNumber++;
+		const size_t comment{ line.find('#') };
+		if (comment != std::string::npos) line.erase(comment);
+
+		std::istringstream tokens{ line };
+		std::string command;
+		if (!(tokens >> command)) continue; // Empty line
+
+		bool isValid{ true };
+		if (command == "spell") {
+			std::string hands;
+			OutSpells.emplace_back();
+			isValid = (tokens >> OutSpells.back().ID >> hands) && (hands == "single" || hands == "dual");
+			OutSpells.back().isDualOnly = hands == "dual";
+		}
+		else if (OutSpells.empty()) {
+			isValid = false; // Everything else belongs to a spell
+		}
+		else if (command == "start") {
+			isValid = ReadVec(tokens, OutSpells.back().LtoRRelativeStartPos);
+		}
+		else if (command == "postol") {
+			isValid = ReadVec(tokens, OutSpells.back().PositionalTolerance);
+		}
+		else if (command == "rottol") {
+			isValid = ReadRot(tokens, OutSpells.back().RotationalTolerance);
+		}
+		else if (command == "point" || command == "line" || command == "arc1" || command == "arc2") {
+			FKeyPointDef kp{};
+			kp.Motion = (command == "line") ? EMotion::Line :
+				(command == "arc1") ? EMotion::Arc1 :
+				(command == "arc2") ? EMotion::Arc2 : EMotion::Point;
+			isValid = ReadKeyPoint(tokens, kp);
+			OutSpells.back().KeyPoints.push_back(kp);
+		}
+		else {
+			isValid = false;
+		}
+
+		std::string extra;
+		if (!isValid || (tokens >> extra)) {
+			std::fprintf(stderr, "Line %d: cannot read '%s'\n", lineNumber, line.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::fprintf(stderr, "Usage: SpellBinaryConverter <Spells.txt> <Spells.spellbin>\n");
+		return 1;
+	}
+
+	std::ifstream input{ argv[1] };
+	if (!input) {
+		std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<FSpellDef> spells{};
+	if (!ParseSpellText(input, spells)) {
+		return 1;
+	}
+
+	// Same rules the game checks when it loads the binary - better to find out now
+	bool isValid{ true };
+	for (const FSpellDef& spell : spells) {
+		if (!IsValidSpellID(spell.ID)) {
+			std::fprintf(stderr, "Spell %d: IDs must be 0 to %d (the SpellID values)\n", spell.ID, SpellIDCount - 1);
+			isValid = false;
+		}
+		else if (!IsValidSpell(spell)) {
+			std::fprintf(stderr, "Spell %d breaks the spellcrafting rules (see Recognition/SpellTable.h)\n", spell.ID);
+			isValid = false;
+		}
+	}
+	if (isValid && !HasUniqueSpellIDs(spells)) {
+		std::fprintf(stderr, "Two spells have the same ID - every spell must be in the file exactly once\n");
+		isValid = false;
+	}
+	if (!isValid) {
+		return 1;
+	}
+
+	std::vector<uint8_t> binary{};
+	WriteSpellBinary(spells, binary);
+
+	// Read it back exactly as the game will
+	std::vector<FSpellDef> loaded{};
+	if (!LoadSpellBinary(binary.data(), binary.size(), loaded) || loaded.size() != spells.size()) {
+		std::fprintf(stderr, "Written binary failed to load\n");
+		return 1;
+	}
+
+	std::ofstream output{ argv[2], std::ios::binary };
+	output.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+	if (!output) {
+		std::fprintf(stderr, "Cannot write %s\n", argv[2]);
+		return 1;
+	}
+
+	std::printf("%zu spells, %zu bytes written to %s\n", spells.size(), binary.size(), argv[2]);
+	return 0;
+}
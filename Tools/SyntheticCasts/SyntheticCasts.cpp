@@ -0,0 +1,241 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Synthetic casts - generates a cast of every spell along its ideal path and replays them through the recognizer
+* Every spell is cast at 4 scales, 3 sample rates (samples per keypoint move) and 3 noise levels, with every hand combination it allows
+* The noise comes from a fixed seed, so the same spells and settings always give the same numbers - use it to check recognition changes
+*
+* Usage: SyntheticCasts <Spells.spellbin> [--quaternion] [--swept] [--casts] [--record <Out.spelltraj>]
+*	--quaternion and --swept turn on FRecognizerSettings::isQuaternionRotation and isSweptKeyPoints
+*	--casts prints what every update of every cast was recognised as (the fingerprint is a hash of this)
+*	--record also writes every cast, one after the other, as a trajectory recording for Tools/TrajectoryReplay - one sample per 90 Hz tick
+*	The replay numbers quoted in the commit history were made with BaselineSpells.txt (convert it with Tools/SpellBinaryConverter)
+*	Tools/CMakeLists.txt runs it on BaselineSpells.txt as a test, with the numbers and fingerprints every mode must still give
+*
+* Build (plain C++14, no engine required):
+*	g++ -std=c++14 -O2 -I../../DevC++Files/SpellCasting/Recognition SyntheticCasts.cpp ../../DevC++Files/SpellCasting/Recognition/[A-Z]*.cpp -o SyntheticCasts
+*/
+
+#include "RecognizerMath.h"
+#include "SpellBinary.h"
+#include "SpellRecognizer.h"
+#include "TrajectoryRecording.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace SpellRecognition;
+
+// Same grid of casts every run - changing any of these changes every number the tool prints
+static const float CastScales[]{ 8.f, 15.f, 25.f, 40.f };
+static const int CastSamplesPerMove[]{ 3, 8, 20 };
+static const float CastPosNoise[]{ 0.f, 1.5f, 4.f }; // Rotation noise is 4 times this, in Deg
+constexpr int NumSampleRates{ sizeof(CastSamplesPerMove) / sizeof(CastSamplesPerMove[0]) };
+
+struct FSyntheticCast {
+	std::vector<FPoseSample> Samples{};
+	int32_t SpellID{ 0 };
+	int SampleRate{ 0 }; // Index into CastSamplesPerMove
+	bool isRHCasting{ false };
+	bool isLHCasting{ false };
+};
+
+// Fixed seed LCG - std::rand is not the same everywhere
+static uint32_t NoiseState{ 12345 };
+
+static float MakeNoise(float Amplitude) {
+	NoiseState = NoiseState * 1664525u + 1013904223u;
+	return ((NoiseState >> 8) / static_cast<float>(1 << 24) * 2.f - 1.f) * Amplitude;
+}
+
+static FVec3 GetPathPosition(const FVec3& From, const FVec3& To, EMotion Motion, float Fraction) {
+	return IsArc(Motion) ? GetArcPosition(From, To, Motion, Fraction) : From + (To - From) * Fraction;
+}
+
+static FRot3 LerpRotation(const FRot3& From, const FRot3& To, float Fraction) {
+	return FRot3{ From.Pitch + (To.Pitch - From.Pitch) * Fraction, From.Yaw + (To.Yaw - From.Yaw) * Fraction, From.Roll + (To.Roll - From.Roll) * Fraction };
+}
+
+static FVec3 AddPosNoise(const FVec3& Pos, float Amplitude) {
+	const float x{ MakeNoise(Amplitude) };
+	const float y{ MakeNoise(Amplitude) };
+	return Pos + FVec3{ x, y, MakeNoise(Amplitude) };
+}
+
+static FRot3 AddRotNoise(const FRot3& Rot, float Amplitude) {
+	const float pitch{ MakeNoise(Amplitude) };
+	const float yaw{ MakeNoise(Amplitude) };
+	return FRot3{ Rot.Pitch + pitch, Rot.Yaw + yaw, Rot.Roll + MakeNoise(Amplitude) };
+}
+
+// Both hands Fraction of the way from keypoint From to keypoint To, plus noise
+static FPoseSample MakeSample(const FSpellDef& Spell, const FVec3& LHStart, float Scale, const FKeyPointDef& From, const FKeyPointDef& To, float Fraction, float PosNoise) {
+	const FVec3 RHStart{ LHStart + Spell.LtoRRelativeStartPos * 20.f };
+	FPoseSample sample{};
+	sample.RH.Position = RHStart + GetPathPosition(From.RHPosition, To.RHPosition, To.Motion, Fraction) * Scale;
+	sample.LH.Position = LHStart + GetPathPosition(From.LHPosition, To.LHPosition, To.Motion, Fraction) * Scale;
+	sample.RH.Rotation = LerpRotation(From.RHRotation, To.RHRotation, Fraction);
+	sample.LH.Rotation = LerpRotation(From.LHRotation, To.LHRotation, Fraction);
+	sample.RH.Position = AddPosNoise(sample.RH.Position, PosNoise);
+	sample.LH.Position = AddPosNoise(sample.LH.Position, PosNoise);
+	sample.RH.Rotation = AddRotNoise(sample.RH.Rotation, PosNoise * 4.f);
+	sample.LH.Rotation = AddRotNoise(sample.LH.Rotation, PosNoise * 4.f);
+	return sample;
+}
+
+// The start pose, SamplesPerMove samples along every move, then 5 samples holding the last keypoint
+static FSyntheticCast MakeCast(const FSpellDef& Spell, bool isRHCasting, bool isLHCasting, float Scale, int SampleRate, float PosNoise) {
+	const FVec3 LHStart{ 10.f, -5.f, 3.f };
+	const int samplesPerMove{ CastSamplesPerMove[SampleRate] };
+	FSyntheticCast cast{};
+	cast.SpellID = Spell.ID;
+	cast.SampleRate = SampleRate;
+	cast.isRHCasting = isRHCasting;
+	cast.isLHCasting = isLHCasting;
+	cast.Samples.push_back(MakeSample(Spell, LHStart, Scale, Spell.KeyPoints[0], Spell.KeyPoints[0], 0.f, PosNoise));
+	for (size_t kp{ 1 }; kp < Spell.KeyPoints.size(); kp++) {
+		for (int i{ 1 }; i <= samplesPerMove; i++) {
+			cast.Samples.push_back(MakeSample(Spell, LHStart, Scale, Spell.KeyPoints[kp - 1], Spell.KeyPoints[kp], static_cast<float>(i) / samplesPerMove, PosNoise));
+		}
+	}
+	for (int i{ 0 }; i < 5; i++) {
+		cast.Samples.push_back(MakeSample(Spell, LHStart, Scale, Spell.KeyPoints.back(), Spell.KeyPoints.back(), 1.f, PosNoise));
+	}
+	return cast;
+}
+
+// Every cast as if played one after the other, a sample per tick with a second of idle ticks in between
+static void RecordCasts(const std::vector<FSyntheticCast>& Casts, FTrajectoryRecorder& OutRecorder) {
+	constexpr float tickTime{ 1.f / 90.f };
+	constexpr uint32_t idleTicks{ 90 };
+	uint32_t frame{ 0 };
+	const auto addRecord = [&OutRecorder, &frame](uint16_t Buttons, ETrajectoryEvent Event, const FPoseSample& Pose) {
+		OutRecorder.Add(MakeTrajectoryRecord(frame, frame * tickTime, Buttons, Event, Pose));
+	};
+	for (const FSyntheticCast& cast : Casts) {
+		const uint16_t buttons{ static_cast<uint16_t>((cast.isRHCasting ? TrajectoryRHCast : 0) | (cast.isLHCasting ? TrajectoryLHCast : 0)) };
+		for (size_t i{ 0 }; i < cast.Samples.size(); i++) {
+			addRecord(buttons, i == 0 ? ETrajectoryEvent::SpellSetup : ETrajectoryEvent::SpellUpdate, cast.Samples[i]);
+			addRecord(buttons, ETrajectoryEvent::Frame, cast.Samples[i]);
+			frame++;
+		}
+		for (uint32_t i{ 0 }; i < idleTicks; i++) {
+			addRecord(0, ETrajectoryEvent::Frame, cast.Samples.back());
+			frame++;
+		}
+	}
+}
+
+// Replays Cast - OutLog gets the active spell after setup and after every update ('!' once complete), returns the completed spell or NoSpell
+static int32_t ReplayCast(FSpellRecognizer& Recognizer, const FSyntheticCast& Cast, std::string& OutLog) {
+	const bool isAvailable{ Recognizer.SpellSetup(Cast.Samples[0], Cast.isRHCasting, Cast.isLHCasting) };
+	OutLog += std::to_string(Recognizer.GetActiveSpells()) + ";";
+	if (!isAvailable) {
+		return NoSpell;
+	}
+	for (size_t i{ 1 }; i < Cast.Samples.size(); i++) {
+		const bool isComplete{ Recognizer.UpdateSpellStates(Cast.Samples[i], Cast.isRHCasting, Cast.isLHCasting) };
+		const int32_t activeSpell{ Recognizer.GetActiveSpells() };
+		OutLog += std::to_string(activeSpell) + (isComplete ? "!" : ",");
+		if (isComplete) {
+			return activeSpell;
+		}
+	}
+	return NoSpell;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "Usage: SyntheticCasts <Spells.spellbin> [--quaternion] [--swept] [--casts] [--record <Out.spelltraj>]\n");
+		return 1;
+	}
+	FRecognizerSettings settings{};
+	bool isPrintingCasts{ false };
+	const char* recordPath{ nullptr };
+	for (int i{ 2 }; i < argc; i++) {
+		if (std::strcmp(argv[i], "--quaternion") == 0) settings.isQuaternionRotation = true;
+		else if (std::strcmp(argv[i], "--swept") == 0) settings.isSweptKeyPoints = true;
+		else if (std::strcmp(argv[i], "--casts") == 0) isPrintingCasts = true;
+		else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+		else {
+			std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::ifstream file{ argv[1], std::ios::binary };
+	const std::vector<uint8_t> fileData{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	std::vector<FSpellDef> spells{};
+	if (!file || !LoadSpellBinary(fileData.data(), fileData.size(), spells)) {
+		std::fprintf(stderr, "%s is not a valid spell binary (version %u)\n", argv[1], SpellBinaryVersion);
+		return 1;
+	}
+
+	// Every hand combination the spell allows - one handed casts with either hand, and both
+	std::vector<FSyntheticCast> casts{};
+	for (const FSpellDef& spell : spells) {
+		for (float scale : CastScales) {
+			for (int rate{ 0 }; rate < NumSampleRates; rate++) {
+				for (float noise : CastPosNoise) {
+					casts.push_back(MakeCast(spell, true, spell.isDualOnly, scale, rate, noise));
+					if (!spell.isDualOnly) {
+						casts.push_back(MakeCast(spell, false, true, scale, rate, noise));
+						casts.push_back(MakeCast(spell, true, true, scale, rate, noise));
+					}
+				}
+			}
+		}
+	}
+
+	if (recordPath) {
+		FTrajectoryRecorder recorder{};
+		RecordCasts(casts, recorder);
+		std::vector<uint8_t> recording{};
+		recorder.Write(recording);
+		std::ofstream output{ recordPath, std::ios::binary };
+		output.write(reinterpret_cast<const char*>(recording.data()), static_cast<std::streamsize>(recording.size()));
+		if (!output) {
+			std::fprintf(stderr, "Could not write %s\n", recordPath);
+			return 1;
+		}
+	}
+
+	// A fresh recognizer per cast, so no cast can affect the next
+	const FSharedSpellSet spellSet{ MakeSpellSet(spells) };
+	int numComplete[NumSampleRates]{};
+	int numRight[NumSampleRates]{};
+	int numCasts[NumSampleRates]{};
+	std::string log{};
+	for (const FSyntheticCast& cast : casts) {
+		FSpellRecognizer recognizer{ spellSet, settings };
+		const int32_t spellID{ ReplayCast(recognizer, cast, log) };
+		log += '\n';
+		numCasts[cast.SampleRate]++;
+		numComplete[cast.SampleRate] += (spellID != NoSpell) ? 1 : 0;
+		numRight[cast.SampleRate] += (spellID == cast.SpellID) ? 1 : 0;
+	}
+
+	// FNV-1a
+	uint64_t fingerprint{ 1469598103934665603ull };
+	for (char c : log) {
+		fingerprint ^= static_cast<unsigned char>(c);
+		fingerprint *= 1099511628211ull;
+	}
+
+	if (isPrintingCasts) {
+		std::printf("%s", log.c_str());
+	}
+	int totalComplete{ 0 };
+	int totalRight{ 0 };
+	for (int rate{ 0 }; rate < NumSampleRates; rate++) {
+		std::printf("%2d samples per move: %d/%d complete, %d as the right spell\n", CastSamplesPerMove[rate], numComplete[rate], numCasts[rate], numRight[rate]);
+		totalComplete += numComplete[rate];
+		totalRight += numRight[rate];
+	}
+	std::printf("%zu casts, %d complete, %d as the right spell, fingerprint %016llx\n", casts.size(), totalComplete, totalRight,
+		static_cast<unsigned long long>(fingerprint));
+	return 0;
+}
@@ -0,0 +1,329 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Tolerance calibration - tunes every spell's PositionalTolerance/RotationalTolerance (and MAX_MOVE_TOLERANCE) from recorded casts
+* Does offline what YR_Beam_MotionToleranceLog.txt was read for by hand: every cast is labelled with the spell the player meant,
+* every candidate set of tolerances replays all of them through the recognizer (see Tools/TrajectoryReplay)
+* Each cast ends up one of:
+*	Correct - completed as the spell meant
+*	Confused - completed as some other spell (or completed when no spell was meant)
+*	Missed - never completed
+* Score is Correct - 2 * Confused, so a tolerance only opens up if it gains more casts than it steals from other spells
+*
+* Search - coordinate descent over a grid, repeated until a whole pass finds nothing better:
+*	MAX_MOVE_TOLERANCE, then for every spell its positional and rotational tolerance scaled by every pair of multipliers
+*	Multipliers always scale the original tolerances, an ignored axis (0) stays ignored so the tuned spells keep the spellcrafting rules
+*	Ties go to the tighter tolerances - a looser spell only wins if some recorded cast needs it
+*	Every candidate of a step is replayed on its own thread, each with its own FSpellRecognizer
+*
+* Usage: ToleranceCalibration <Spells.spellbin> <Labels.txt> <Tuned.spellbin> [Threads]
+*	Threads defaults to std::thread::hardware_concurrency()
+*	Prints the before/after results of every spell, and the tuned postol/rottol lines to paste into Spells.txt
+*
+* Labels format (recording paths are relative to the working directory):
+*	# Comment until the end of the line
+*	<Recording.spelltraj> <SpellID>				Every cast in the recording meant SpellID
+*	<Recording.spelltraj> <SpellID> <SpellID>...	One SpellID per cast, in order - -1 for a cast that meant no spell
+*
+* Build (plain C++14, no engine required):
+*	g++ -std=c++14 -O2 -pthread -I../../DevC++Files/SpellCasting/Recognition ToleranceCalibration.cpp ../../DevC++Files/SpellCasting/Recognition/[A-Z]*.cpp -o ToleranceCalibration
+* NOTE: Replays with USpellComponent's default settings - tuning is only as good as the recordings, record every spell a few times by a few players
+*/
+
+#include "SpellBinary.h"
+#include "SpellRecognizer.h"
+#include "TrajectoryRecording.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace SpellRecognition;
+
+static bool ReadFile(const char* Path, std::vector<uint8_t>& Out) {
+	std::ifstream file{ Path, std::ios::binary };
+	if (!file) {
+		return false;
+	}
+	Out.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+	return true;
+}
+
+static constexpr float MoveToleranceGrid[]{ 4.f, 6.f, 8.f, 10.f, 12.f };
+static constexpr float MultiplierGrid[]{ 0.5f, 0.75f, 1.f, 1.25f, 1.5f, 2.f };
+static constexpr int32_t NumMultipliers{ sizeof(MultiplierGrid) / sizeof(MultiplierGrid[0]) };
+static constexpr int32_t ConfusionWeight{ 2 };
+
+// One labelled recording
+struct FLabelledRecording {
+	std::string Path{};
+	std::vector<FTrajectoryRecord> Records{};
+	std::vector<int32_t> Labels{}; // One per cast, or a single label for every cast
+};
+
+// Tolerances being tried - multiplier indices into MultiplierGrid, one pair per spell
+struct FCalibration {
+	int32_t MoveTolerance{ 2 }; // Index into MoveToleranceGrid
+	std::vector<int32_t> PosMultiplier{};
+	std::vector<int32_t> RotMultiplier{};
+
+	// Lower is tighter - used to break ties
+	int32_t GetLooseness() const {
+		int32_t looseness{ MoveTolerance };
+		for (size_t i{ 0 }; i < PosMultiplier.size(); i++) {
+			looseness += PosMultiplier[i] + RotMultiplier[i];
+		}
+		return looseness;
+	}
+};
+
+struct FSpellResult {
+	int32_t NumCorrect{ 0 };
+	int32_t NumConfused{ 0 };
+	int32_t NumMissed{ 0 };
+};
+
+struct FCalibrationResult {
+	std::vector<FSpellResult> Spells{}; // Same order as the spell binary, casts that meant no spell are left out
+	int32_t NumCorrect{ 0 };
+	int32_t NumConfused{ 0 };
+	int32_t NumMissed{ 0 };
+
+	int32_t GetScore() const { return NumCorrect - ConfusionWeight * NumConfused; }
+};
+
+// Fills OutRecordings from the labels file - returns false and prints the offending line if anything is wrong
+static bool LoadLabels(const char* Path, std::vector<FLabelledRecording>& OutRecordings) {
+	std::ifstream text{ Path };
+	if (!text) {
+		std::fprintf(stderr, "Could not open %s\n", Path);
+		return false;
+	}
+	std::string line;
+	int lineNumber{ 0 };
+	std::vector<uint8_t> fileData{};
+	while (std::getline(text, line)) {
+		lineNumber++;
+		const size_t comment{ line.find('#') };
+		if (comment != std::string::npos) line.erase(comment);
+
+		std::istringstream tokens{ line };
+		FLabelledRecording recording{};
+		if (!(tokens >> recording.Path)) continue; // Empty line
+		for (int32_t label{ 0 }; tokens >> label;) {
+			recording.Labels.push_back(label);
+		}
+		if (recording.Labels.empty() || !tokens.eof()) {
+			std::fprintf(stderr, "%s(%d): expected <Recording.spelltraj> <SpellID>...\n", Path, lineNumber);
+			return false;
+		}
+		if (!ReadFile(recording.Path.c_str(), fileData) || !LoadTrajectoryRecording(fileData.data(), fileData.size(), recording.Records)) {
+			std::fprintf(stderr, "%s(%d): %s is not a trajectory recording (version %u)\n", Path, lineNumber, recording.Path.c_str(), TrajectoryVersion);
+			return false;
+		}
+		OutRecordings.push_back(std::move(recording));
+	}
+	return true;
+}
+
+// Original spells with Calibration's tolerances
+static void ApplyCalibration(const std::vector<FSpellDef>& Spells, const FCalibration& Calibration, std::vector<FSpellDef>& OutSpells) {
+	OutSpells = Spells;
+	for (size_t i{ 0 }; i < OutSpells.size(); i++) {
+		const float posScale{ MultiplierGrid[Calibration.PosMultiplier[i]] };
+		const float rotScale{ MultiplierGrid[Calibration.RotMultiplier[i]] };
+		OutSpells[i].PositionalTolerance = Spells[i].PositionalTolerance * posScale;
+		FRot3& rotTolerance{ OutSpells[i].RotationalTolerance };
+		rotTolerance.Pitch *= rotScale;
+		rotTolerance.Yaw *= rotScale;
+		rotTolerance.Roll *= rotScale;
+	}
+}
+
+// Replays every labelled cast with Calibration's tolerances
+static FCalibrationResult EvaluateCalibration(FSpellRecognizer& Recognizer, const std::vector<FSpellDef>& Spells, const std::vector<FLabelledRecording>& Recordings,
+	const FCalibration& Calibration) {
+	std::vector<FSpellDef> tuned{};
+	ApplyCalibration(Spells, Calibration, tuned);
+	FRecognizerSettings settings{};
+	settings.MaxMoveTolerance = MoveToleranceGrid[Calibration.MoveTolerance];
+	Recognizer.SetSettings(settings);
+	Recognizer.SetSpells(std::move(tuned));
+
+	FCalibrationResult result{};
+	result.Spells.resize(Spells.size());
+	std::vector<FReplayCast> casts{};
+	for (const FLabelledRecording& recording : Recordings) {
+		ReplayTrajectory(Recognizer, recording.Records.data(), recording.Records.size(), casts);
+		for (size_t i{ 0 }; i < casts.size(); i++) {
+			const int32_t label{ recording.Labels.size() == 1 ? recording.Labels[0] : (i < recording.Labels.size() ? recording.Labels[i] : NoSpell) };
+			const FReplayCast& cast{ casts[i] };
+			FSpellResult* spellResult{ nullptr };
+			for (size_t s{ 0 }; s < Spells.size(); s++) {
+				spellResult = (Spells[s].ID == label) ? &result.Spells[s] : spellResult;
+			}
+
+			if (cast.isComplete && cast.SpellID == label) {
+				result.NumCorrect++;
+				spellResult->NumCorrect++;
+			}
+			else if (cast.isComplete) {
+				result.NumConfused++;
+				if (spellResult) spellResult->NumConfused++;
+			}
+			else if (spellResult) { // Not casting anything when nothing was meant is not a miss
+				result.NumMissed++;
+				spellResult->NumMissed++;
+			}
+		}
+	}
+	return result;
+}
+
+// Replays every candidate over Threads threads, returns the index of the best one (ties to the tighter, then the earlier candidate)
+static size_t FindBestCalibration(const std::vector<FSpellDef>& Spells, const std::vector<FLabelledRecording>& Recordings, const std::vector<FCalibration>& Candidates,
+	int32_t Threads, std::vector<FCalibrationResult>& OutResults) {
+	OutResults.assign(Candidates.size(), FCalibrationResult{});
+	std::atomic<size_t> nextCandidate{ 0 };
+	auto work{ [&]() {
+		FSpellRecognizer recognizer{}; // Reused for every candidate this thread takes
+		for (size_t i{ nextCandidate++ }; i < Candidates.size(); i = nextCandidate++) {
+			OutResults[i] = EvaluateCalibration(recognizer, Spells, Recordings, Candidates[i]);
+		}
+	} };
+	std::vector<std::thread> threads{};
+	for (int32_t i{ 1 }; i < Threads; i++) {
+		threads.emplace_back(work);
+	}
+	work();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	size_t best{ 0 };
+	for (size_t i{ 1 }; i < Candidates.size(); i++) {
+		const int32_t score{ OutResults[i].GetScore() };
+		const int32_t bestScore{ OutResults[best].GetScore() };
+		if (score > bestScore || (score == bestScore && Candidates[i].GetLooseness() < Candidates[best].GetLooseness())) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+static void PrintResults(const std::vector<FSpellDef>& Spells, const FCalibrationResult& Before, const FCalibrationResult& After) {
+	std::printf("Spell   correct  confused  missed    (before -> after)\n");
+	for (size_t i{ 0 }; i < Spells.size(); i++) {
+		const FSpellResult& before{ Before.Spells[i] };
+		const FSpellResult& after{ After.Spells[i] };
+		std::printf("%5d  %3d -> %-3d %3d -> %-3d %3d -> %d\n", Spells[i].ID, before.NumCorrect, after.NumCorrect,
+			before.NumConfused, after.NumConfused, before.NumMissed, after.NumMissed);
+	}
+	std::printf("Total  %3d -> %-3d %3d -> %-3d %3d -> %-3d  score %d -> %d\n", Before.NumCorrect, After.NumCorrect,
+		Before.NumConfused, After.NumConfused, Before.NumMissed, After.NumMissed, Before.GetScore(), After.GetScore());
+}
+
+int main(int argc, char** argv) {
+	if (argc < 4 || argc > 5) {
+		std::fprintf(stderr, "Usage: ToleranceCalibration <Spells.spellbin> <Labels.txt> <Tuned.spellbin> [Threads]\n");
+		return 1;
+	}
+	const int32_t numThreads{ argc == 5 ? std::atoi(argv[4]) : static_cast<int32_t>(std::thread::hardware_concurrency()) };
+
+	std::vector<uint8_t> fileData{};
+	std::vector<FSpellDef> spells{};
+	if (!ReadFile(argv[1], fileData) || !LoadSpellBinary(fileData.data(), fileData.size(), spells) || spells.empty()) {
+		std::fprintf(stderr, "%s is not a valid spell binary (version %u) or is empty\n", argv[1], SpellBinaryVersion);
+		return 1;
+	}
+	std::vector<FLabelledRecording> recordings{};
+	if (!LoadLabels(argv[2], recordings)) {
+		return 1;
+	}
+	for (const FLabelledRecording& recording : recordings) {
+		for (int32_t label : recording.Labels) {
+			bool isKnown{ label == NoSpell };
+			for (const FSpellDef& spell : spells) {
+				isKnown = isKnown || spell.ID == label;
+			}
+			if (!isKnown) {
+				std::fprintf(stderr, "%s is labelled with spell %d, which is not in %s\n", recording.Path.c_str(), label, argv[1]);
+				return 1;
+			}
+		}
+	}
+
+	FCalibration current{};
+	current.PosMultiplier.assign(spells.size(), 2); // 1x - the spells as they are
+	current.RotMultiplier.assign(spells.size(), 2);
+	std::vector<FCalibrationResult> results{};
+	FindBestCalibration(spells, recordings, std::vector<FCalibration>{ current }, 1, results);
+	const FCalibrationResult original{ results[0] };
+	FCalibrationResult best{ original };
+	std::printf("%zu recordings, %zu spells, %d threads - starting score %d\n", recordings.size(), spells.size(), numThreads > 1 ? numThreads : 1, original.GetScore());
+
+	std::vector<FCalibration> candidates{};
+	bool isImproved{ true };
+	for (int32_t pass{ 1 }; isImproved; pass++) {
+		isImproved = false;
+
+		// MAX_MOVE_TOLERANCE applies to every spell, so it goes first
+		candidates.assign(1, current);
+		for (int32_t i{ 0 }; i < static_cast<int32_t>(sizeof(MoveToleranceGrid) / sizeof(MoveToleranceGrid[0])); i++) {
+			if (i != current.MoveTolerance) {
+				candidates.push_back(current);
+				candidates.back().MoveTolerance = i;
+			}
+		}
+		size_t choice{ FindBestCalibration(spells, recordings, candidates, numThreads, results) };
+		isImproved = isImproved || choice != 0;
+		current = candidates[choice];
+		best = results[choice];
+
+		for (size_t s{ 0 }; s < spells.size(); s++) {
+			candidates.assign(1, current); // The current tolerances come first, so they win a tie with anything as tight
+			for (int32_t pos{ 0 }; pos < NumMultipliers; pos++) {
+				for (int32_t rot{ 0 }; rot < NumMultipliers; rot++) {
+					if (pos != current.PosMultiplier[s] || rot != current.RotMultiplier[s]) {
+						candidates.push_back(current);
+						candidates.back().PosMultiplier[s] = pos;
+						candidates.back().RotMultiplier[s] = rot;
+					}
+				}
+			}
+			choice = FindBestCalibration(spells, recordings, candidates, numThreads, results);
+			isImproved = isImproved || choice != 0;
+			current = candidates[choice];
+			best = results[choice];
+		}
+		std::printf("Pass %d: score %d (%d correct, %d confused, %d missed)\n", pass, best.GetScore(), best.NumCorrect, best.NumConfused, best.NumMissed);
+	}
+
+	std::vector<FSpellDef> tuned{};
+	ApplyCalibration(spells, current, tuned);
+	std::vector<uint8_t> binary{};
+	WriteSpellBinary(tuned, binary);
+	std::vector<FSpellDef> reloaded{};
+	if (!LoadSpellBinary(binary.data(), binary.size(), reloaded)) {
+		std::fprintf(stderr, "Tuned spells do not load back, nothing written\n");
+		return 1;
+	}
+	std::ofstream output{ argv[3], std::ios::binary };
+	if (!output || !output.write(reinterpret_cast<const char*>(binary.data()), binary.size())) {
+		std::fprintf(stderr, "Could not write %s\n", argv[3]);
+		return 1;
+	}
+
+	PrintResults(spells, original, best);
+	std::printf("\nMAX_MOVE_TOLERANCE = %.1ff\n", MoveToleranceGrid[current.MoveTolerance]);
+	for (const FSpellDef& spell : tuned) {
+		std::printf("spell %d\n\tpostol %g %g %g\n\trottol %g %g %g\n", spell.ID, spell.PositionalTolerance.X, spell.PositionalTolerance.Y, spell.PositionalTolerance.Z,
+			spell.RotationalTolerance.Pitch, spell.RotationalTolerance.Yaw, spell.RotationalTolerance.Roll);
+	}
+	return 0;
+}
@@ -0,0 +1,212 @@
+// Copyright 2021 Yacob N. S. Reyneke All Rights Reserved.
+
+/*
+* Trajectory replay - feeds a recorded play session (see USpellComponent::isRecordingTrajectories) back through the recognizer
+* Prints what every cast was recognised as (by the keypoint checks and by DTW matching) and which checks rejected which spells, then replays the whole recording over and over as a repeatable benchmark
+* The benchmark also counts heap allocations - the first replay has already warmed the recognizer up, so it should make none (see AllocationCounter.h)
+*
+* Usage: TrajectoryReplay <Recording.spelltraj> <Spells.spellbin> [Iterations] [EarlyCommitScore]
+*	Recordings are saved to Saved/Trajectories/, spell binaries are made by Tools/SpellBinaryConverter
+*	Iterations defaults to 1000 - use 0 to only print the casts
+*	EarlyCommitScore is FRecognizerSettings::EarlyCommitScore, 0 (off) by default like in game
+*
+* Reproducible numbers - Tools/SyntheticCasts --record writes the synthetic casts as a recording, and Tools/CMakeLists.txt replays it
+* as a test, pinning the leading spell and time to complete figures with and without early commit. Quote those, not a private recording
+* NOTE: The ns/sample and us/cast timings depend on the machine and are never pinned - quote them with the machine and the command:
+*	SyntheticCasts BaselineSpells.spellbin --record BaselineCasts.spelltraj && TrajectoryReplay BaselineCasts.spelltraj BaselineSpells.spellbin
+*
+* Build (plain C++14, no engine required):
+*	g++ -std=c++14 -O2 -pthread -I../../DevC++Files/SpellCasting/Recognition TrajectoryReplay.cpp ../../DevC++Files/SpellCasting/Recognition/[A-Z]*.cpp -o TrajectoryReplay
+* NOTE: Build with the same optimisation and SIMD flags as the game, or the numbers mean nothing
+*/
+
+#include "AllocationCounter.h"
+#include "DtwMatcher.h"
+#include "SpellBinary.h"
+#include "SpellRecognizer.h"
+#include "TrajectoryRecording.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <utility>
+
+using namespace SpellRecognition;
+
+// Every allocation in the tool comes through here, so the benchmark can count them
+void* operator new(std::size_t Size) {
+	CountAllocation();
+	void* memory{ std::malloc(Size != 0 ? Size : 1) };
+	if (memory == nullptr) {
+		throw std::bad_alloc{};
+	}
+	return memory;
+}
+
+void operator delete(void* Memory) noexcept {
+	std::free(Memory);
+}
+
+void operator delete(void* Memory, std::size_t) noexcept {
+	std::free(Memory);
+}
+
+static bool ReadFile(const char* Path, std::vector<uint8_t>& Out) {
+	std::ifstream file{ Path, std::ios::binary };
+	if (!file) {
+		return false;
+	}
+	Out.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+	return true;
+}
+
+// DTW matches every cast in the recording, the way USpellComponent does with isDtwMatchingEnabled - one match per cast, when it ends
+static void ReplayDtw(FDtwMatcher& Matcher, const std::vector<FTrajectoryRecord>& Records, std::vector<FDtwMatch>& OutMatches) {
+	OutMatches.clear();
+	bool isCasting{ false };
+	for (const FTrajectoryRecord& record : Records) {
+		const ETrajectoryEvent event{ static_cast<ETrajectoryEvent>(record.Event) };
+		if (event == ETrajectoryEvent::SpellSetup) {
+			if (isCasting) {
+				OutMatches.emplace_back();
+				Matcher.Match(OutMatches.back());
+			}
+			Matcher.BeginCast(GetTrajectoryPose(record), (record.Buttons & TrajectoryRHCast) != 0, (record.Buttons & TrajectoryLHCast) != 0);
+			isCasting = true;
+		}
+		else if (event == ETrajectoryEvent::SpellUpdate && isCasting) {
+			Matcher.AddSample(GetTrajectoryPose(record));
+		}
+	}
+	if (isCasting) {
+		OutMatches.emplace_back();
+		Matcher.Match(OutMatches.back());
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3 || argc > 5) {
+		std::fprintf(stderr, "Usage: TrajectoryReplay <Recording.spelltraj> <Spells.spellbin> [Iterations] [EarlyCommitScore]\n");
+		return 1;
+	}
+	const int iterations{ argc >= 4 ? std::atoi(argv[3]) : 1000 };
+	FRecognizerSettings settings{};
+	settings.EarlyCommitScore = argc == 5 ? static_cast<float>(std::atof(argv[4])) : 0.f;
+
+	std::vector<uint8_t> fileData{};
+	std::vector<FTrajectoryRecord> records{};
+	if (!ReadFile(argv[1], fileData) || !LoadTrajectoryRecording(fileData.data(), fileData.size(), records)) {
+		std::fprintf(stderr, "%s is not a trajectory recording (version %u)\n", argv[1], TrajectoryVersion);
+		return 1;
+	}
+	std::vector<FSpellDef> spells{};
+	if (!ReadFile(argv[2], fileData) || !LoadSpellBinary(fileData.data(), fileData.size(), spells)) {
+		std::fprintf(stderr, "%s is not a valid spell binary (version %u)\n", argv[2], SpellBinaryVersion);
+		return 1;
+	}
+
+	// Same settings as USpellComponent (bar EarlyCommitScore) - and like it, the recognizer and matcher share one set of definitions
+	const FSharedSpellSet spellSet{ MakeSpellSet(std::move(spells)) };
+	FSpellRecognizer recognizer{ spellSet, settings };
+
+	FDtwMatcher matcher{ spellSet };
+
+	// What the player did
+	std::vector<FReplayCast> casts{};
+	std::vector<FDtwMatch> matches{};
+	const int32_t numSamples{ ReplayTrajectory(recognizer, records.data(), records.size(), casts) };
+	ReplayDtw(matcher, records, matches);
+	int32_t numLed{ 0 }; // Complete casts the right spell was leading before it completed
+	int32_t numMisled{ 0 }; // Casts some other spell was leading when the cast completed or ended
+	float totalLead{ 0.f };
+	int32_t numComplete{ 0 };
+	float totalCompleteTime{ 0.f }; // From SpellSetup() to the sample that completed the spell
+	for (size_t i{ 0 }; i < casts.size(); i++) {
+		const FReplayCast& cast{ casts[i] };
+		std::printf("Cast at frame %u (%.3f s): ", cast.StartFrame, cast.StartTime);
+		if (cast.isComplete && cast.LeadSpellID == cast.SpellID) {
+			std::printf("spell %d complete at frame %u (%.3f s, %d samples), leading from %.3f s\n", cast.SpellID, cast.CompleteFrame, cast.CompleteTime, cast.NumSamples, cast.LeadTime);
+			numLed++;
+			totalLead += cast.CompleteTime - cast.LeadTime;
+		}
+		else if (cast.isComplete) {
+			std::printf("spell %d complete at frame %u (%.3f s, %d samples)\n", cast.SpellID, cast.CompleteFrame, cast.CompleteTime, cast.NumSamples);
+		}
+		else if (cast.SpellID >= 0) {
+			std::printf("spell %d never completed (%d samples)\n", cast.SpellID, cast.NumSamples);
+		}
+		else {
+			std::printf("%s (%d samples)\n", cast.SpellID == MultipleSpells ? "multiple spells, none completed" : "no spell", cast.NumSamples);
+		}
+		if (i < matches.size() && matches[i].SpellID != NoSpell) {
+			std::printf("    DTW: spell %d (cost %.3f, %d spells compared)\n", matches[i].SpellID, matches[i].Cost, matches[i].NumCompared);
+		}
+		else if (i < matches.size()) {
+			std::printf("    DTW: no match (%d spells compared)\n", matches[i].NumCompared);
+		}
+	}
+	for (const FReplayCast& cast : casts) {
+		numMisled += (cast.LeadSpellID != NoSpell && cast.LeadSpellID != cast.SpellID) ? 1 : 0;
+		if (cast.isComplete) {
+			numComplete++;
+			totalCompleteTime += cast.CompleteTime - cast.StartTime;
+		}
+	}
+	std::printf("Leading spell: right in %d complete casts, %.0f ms before completion on average - wrong in %d casts\n",
+		numLed, numLed > 0 ? totalLead * 1000.f / numLed : 0.f, numMisled);
+	std::printf("Complete: %d of %zu casts, %.0f ms after SpellSetup() on average\n", numComplete, casts.size(),
+		numComplete > 0 ? totalCompleteTime * 1000.f / numComplete : 0.f);
+	const float duration{ records.empty() ? 0.f : records.back().Time - records.front().Time };
+	std::printf("%zu records, %d samples fed to the recognizer, %zu casts, %.2f s recorded\n", records.size(), numSamples, casts.size(), duration);
+
+	// Why spells were rejected
+	std::string rejections{};
+	WriteRejectionCounters(recognizer.GetRejectionCounters(), rejections);
+	std::printf("\nRejections:\n%s\n", rejections.c_str());
+
+	if (iterations <= 0 || numSamples == 0) {
+		return 0;
+	}
+
+	// Benchmark - the recognizer is reused, just like in game
+	uint64_t allocations{ 0 };
+	const auto start{ std::chrono::steady_clock::now() };
+	size_t checksum{ 0 };
+	{
+		FAllocationScope allocationScope{ allocations };
+		for (int i{ 0 }; i < iterations; i++) {
+			ReplayTrajectory(recognizer, records.data(), records.size(), casts);
+			checksum += casts.size();
+		}
+	}
+	const double seconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+	const double totalSamples{ static_cast<double>(numSamples) * iterations };
+
+	std::printf("%d replays in %.3f s: %.1f ns/sample, %.0fx realtime, %llu allocations (%zu)\n", iterations, seconds,
+		seconds * 1.0e9 / totalSamples, seconds > 0.0 ? duration * iterations / seconds : 0.0, static_cast<unsigned long long>(allocations), checksum);
+
+	// Same again for DTW matching - recording the samples plus one match per cast
+	if (!matches.empty()) {
+		uint64_t dtwAllocations{ 0 };
+		const auto dtwStart{ std::chrono::steady_clock::now() };
+		{
+			FAllocationScope allocationScope{ dtwAllocations };
+			for (int i{ 0 }; i < iterations; i++) {
+				ReplayDtw(matcher, records, matches);
+				checksum += matches.size();
+			}
+		}
+		const double dtwSeconds{ std::chrono::duration<double>(std::chrono::steady_clock::now() - dtwStart).count() };
+		std::printf("%d DTW replays in %.3f s: %.1f us/cast, %llu allocations (%zu)\n", iterations, dtwSeconds,
+			dtwSeconds * 1.0e6 / (static_cast<double>(matches.size()) * iterations), static_cast<unsigned long long>(dtwAllocations), checksum);
+		allocations += dtwAllocations;
+	}
+	if (allocations > 0) {
+		std::printf("WARNING: The replays allocated - something in the hot path is not reusing its storage\n");
+	}
+	return 0;
+}